@@ -3,6 +3,10 @@
 #include <algorithm> // For sorting and other algorithms
 #include <climits>   // For INT_MAX and INT_MIN
 #include <cmath>     // For mathematical functions
+#include <random>    // For generating benchmark input
+
+#include "benchmark.hpp"      // run_benchmark() reports time and allocations per iteration
+#include "alloc_tracker.hpp"  // Allocation counting (compile with -DENABLE_ALLOC_TRACKER)
 
 using namespace std;
 
@@ -207,7 +211,10 @@ int main() {
 
     // Reset the array
     arr2 = {64, 34, 25, 12, 22, 11, 90};
-    mergeSort(arr2);
+    {
+        alloc_tracker_scope scope("mergeSort of 7 elements", &cout);  // Every merge copies both halves
+        mergeSort(arr2);
+    }
     cout << "\nMerge Sort: ";
     for (int num : arr2) cout << num << " ";
 
@@ -229,5 +236,17 @@ int main() {
     // Factorial
     cout << "\nFactorial of " << n << " is: " << factorial(n) << endl;
 
+    // Allocations per sort: merge() allocates two temporary vectors per call
+    cout << "\nSorting 10000 random integers:" << endl;
+    vector<int> input(10000);
+    mt19937 rng(7);
+    for (int& x : input) x = static_cast<int>(rng() % 100000);
+    vector<int> work;
+    run_benchmark("mergeSort", 50, [&] { work = input; mergeSort(work); });
+    run_benchmark("quickSort", 50, [&] { work = input; quickSort(work, 0, work.size() - 1); });
+    run_benchmark("std::sort", 50, [&] { work = input; sort(work.begin(), work.end()); });
+
+    alloc_tracker_report(cout);
+
     return 0;
 }
\ No newline at end of file
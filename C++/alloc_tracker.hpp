@@ -0,0 +1,446 @@
+#pragma once
+
+// Allocation tracker that replaces the global operator new/delete.
+//
+// Compile a demo with -DENABLE_ALLOC_TRACKER to turn it on, e.g.
+//   g++ -std=c++20 -O2 -DENABLE_ALLOC_TRACKER -rdynamic algorithms.cpp
+// Without the define only the (no-op) reporting API is compiled, so the demos can
+// call it unconditionally. -rdynamic lets backtrace_symbols() print function names.
+//
+// What is recorded:
+//   - per-thread allocation/deallocation counts and bytes (no shared cache lines)
+//   - a power-of-two size histogram per thread
+//   - live bytes for the whole process (the sum of every thread's allocated minus
+//     freed bytes) and an approximate peak of it
+//   - a call stack sampled every `sample interval` bytes allocated per thread
+//
+// The replacement operators are ordinary (non-inline) definitions, so include this
+// header with ENABLE_ALLOC_TRACKER in exactly one translation unit. Every demo in
+// this directory is a single translation unit, so that is automatic.
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <string>
+
+#ifdef ENABLE_ALLOC_TRACKER
+#include <execinfo.h>  // backtrace(), backtrace_symbols()
+#include <malloc.h>    // malloc_usable_size()
+inline constexpr bool alloc_tracker_enabled = true;
+#else
+inline constexpr bool alloc_tracker_enabled = false;
+#endif
+
+// Bucket i counts allocations of [2^(i-1), 2^i) bytes; the last bucket is open-ended
+inline constexpr int alloc_histogram_buckets = 32;
+inline constexpr int alloc_sample_depth = 16;
+inline constexpr int alloc_max_sampled_stacks = 64;
+// A thread re-checks the process-wide peak each time its own net allocation grows
+// by this much, so a spike smaller than this per thread can go unrecorded
+inline constexpr int64_t alloc_peak_check_bytes = 64 * 1024;
+
+struct alloc_stats {
+    uint64_t allocations = 0;
+    uint64_t deallocations = 0;
+    uint64_t bytes_allocated = 0;
+    uint64_t bytes_freed = 0;
+    int64_t live_bytes = 0;       // Process-wide, only filled in by alloc_tracker_totals()
+    int64_t peak_live_bytes = 0;  // Process-wide, only filled in by alloc_tracker_totals()
+};
+
+// --- SECTION 1: Per-Thread Records ---
+
+// Each thread owns one record and is the only writer of its counters, so they are
+// updated with relaxed load+store instead of locked read-modify-write instructions.
+// Readers on other threads may see slightly stale values, which is fine for stats.
+// Records are cache-line aligned so two threads' counters never share a line.
+struct alignas(64) alloc_thread_record {
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> deallocations{0};
+    std::atomic<uint64_t> bytes_allocated{0};
+    std::atomic<uint64_t> bytes_freed{0};
+    std::atomic<uint64_t> size_histogram[alloc_histogram_buckets] = {};
+    std::atomic<bool> in_use{true};
+    int64_t bytes_until_sample = 0;  // Owner thread only
+    int64_t next_peak_check = 0;     // Owner thread only: net bytes that trigger a peak check
+    int index = 0;                   // Order of registration, for reports
+    alloc_thread_record* next = nullptr;
+};
+
+struct alloc_sampled_stack {
+    void* frames[alloc_sample_depth];
+    int depth = 0;
+    uint64_t samples = 0;  // How many times this stack was sampled
+    uint64_t bytes = 0;    // Bytes attributed to it (samples * interval, roughly)
+};
+
+struct alloc_tracker_state {
+    std::atomic<alloc_thread_record*> threads{nullptr};
+    std::atomic<int> thread_count{0};
+    std::atomic<int64_t> peak_live_bytes{0};
+    std::atomic<int64_t> sample_interval{512 * 1024};
+
+    std::mutex samples_mutex;
+    alloc_sampled_stack samples[alloc_max_sampled_stacks];
+    int sample_count = 0;
+};
+
+inline alloc_tracker_state& alloc_tracker_global() {
+    static alloc_tracker_state state;  // Constant-initialized: usable before main()
+    return state;
+}
+
+inline thread_local alloc_thread_record* alloc_tracker_record = nullptr;
+inline thread_local bool alloc_tracker_busy = false;  // Guards against re-entry from backtrace()
+
+inline void alloc_tracker_bump(std::atomic<uint64_t>& counter, uint64_t amount) {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+// Marks the thread's record as reusable when the thread exits
+struct alloc_thread_exit_guard {
+    ~alloc_thread_exit_guard() {
+        if (alloc_tracker_record) {
+            alloc_tracker_record->in_use.store(false, std::memory_order_release);
+            alloc_tracker_record = nullptr;
+        }
+    }
+};
+
+// Records are taken over from exited threads when possible (their counters keep
+// accumulating, so process totals stay correct) and are otherwise malloc'ed and
+// pushed onto a lock-free list. They are never freed. std::aligned_alloc is not
+// routed through operator new, so creating a record is not itself tracked.
+inline alloc_thread_record* alloc_tracker_acquire_record() {
+    alloc_tracker_state& state = alloc_tracker_global();
+    for (alloc_thread_record* r = state.threads.load(std::memory_order_acquire); r; r = r->next) {
+        bool expected = false;
+        if (!r->in_use.load(std::memory_order_relaxed) &&
+            r->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return r;
+        }
+    }
+    void* memory = std::aligned_alloc(alignof(alloc_thread_record), sizeof(alloc_thread_record));
+    if (!memory) return nullptr;
+    auto* record = ::new (memory) alloc_thread_record();
+    record->index = state.thread_count.fetch_add(1, std::memory_order_relaxed);
+    record->bytes_until_sample = state.sample_interval.load(std::memory_order_relaxed);
+    record->next_peak_check = alloc_peak_check_bytes;
+    alloc_thread_record* head = state.threads.load(std::memory_order_relaxed);
+    do {
+        record->next = head;
+    } while (!state.threads.compare_exchange_weak(head, record, std::memory_order_release,
+                                                  std::memory_order_relaxed));
+    return record;
+}
+
+// nullptr while this thread is still acquiring its record
+inline alloc_thread_record* alloc_tracker_thread_record() {
+    if (!alloc_tracker_record) {
+        if (alloc_tracker_busy) return nullptr;
+        alloc_tracker_busy = true;
+        static thread_local alloc_thread_exit_guard exit_guard;
+        (void)exit_guard;
+        alloc_tracker_record = alloc_tracker_acquire_record();
+        alloc_tracker_busy = false;
+    }
+    return alloc_tracker_record;
+}
+
+// Bytes a thread allocated minus bytes it freed. Negative for a thread that frees
+// what others allocated; the sum over all records is the process's live bytes.
+inline int64_t alloc_tracker_net_bytes(const alloc_thread_record& r) {
+    return static_cast<int64_t>(r.bytes_allocated.load(std::memory_order_relaxed) -
+                                r.bytes_freed.load(std::memory_order_relaxed));
+}
+
+inline int64_t alloc_tracker_live_bytes() {
+    int64_t live = 0;
+    for (alloc_thread_record* r = alloc_tracker_global().threads.load(std::memory_order_acquire); r; r = r->next) {
+        live += alloc_tracker_net_bytes(*r);
+    }
+    return live;
+}
+
+// Raises the recorded peak to the current live bytes. Walks every record, so the
+// hooks only call it at peak checks and sample points, not on every allocation.
+inline int64_t alloc_tracker_update_peak() {
+    std::atomic<int64_t>& peak_live_bytes = alloc_tracker_global().peak_live_bytes;
+    int64_t live = alloc_tracker_live_bytes();
+    int64_t peak = peak_live_bytes.load(std::memory_order_relaxed);
+    while (live > peak && !peak_live_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+    return live;
+}
+
+// --- SECTION 2: Recording Hooks ---
+
+#ifdef ENABLE_ALLOC_TRACKER
+
+// Capture the current call stack and merge it with an identical earlier sample.
+// The hooks are kept out of line so the report can skip a fixed number of frames.
+[[gnu::noinline]] inline void alloc_tracker_take_sample(uint64_t bytes) {
+    alloc_sampled_stack sample;
+    sample.depth = backtrace(sample.frames, alloc_sample_depth);
+
+    alloc_tracker_state& state = alloc_tracker_global();
+    std::lock_guard<std::mutex> lock(state.samples_mutex);
+    for (int i = 0; i < state.sample_count; ++i) {
+        alloc_sampled_stack& existing = state.samples[i];
+        if (existing.depth == sample.depth &&
+            std::equal(sample.frames, sample.frames + sample.depth, existing.frames)) {
+            existing.samples++;
+            existing.bytes += bytes;
+            return;
+        }
+    }
+    if (state.sample_count < alloc_max_sampled_stacks) {
+        sample.samples = 1;
+        sample.bytes = bytes;
+        state.samples[state.sample_count++] = sample;
+    }
+}
+
+// Allocations and frees are counted even while alloc_tracker_busy is set (inside
+// backtrace()), so a block is never freed without having been counted; being busy
+// only defers the next stack sample.
+[[gnu::noinline]] inline void alloc_tracker_on_allocate(void* p) {
+    if (!p) return;
+    alloc_thread_record* record = alloc_tracker_thread_record();
+    if (!record) return;
+
+    // Count the usable size so that frees (which may not know the size) match
+    uint64_t size = malloc_usable_size(p);
+    alloc_tracker_bump(record->allocations, 1);
+    alloc_tracker_bump(record->bytes_allocated, size);
+    int bucket = std::min<int>(std::bit_width(size), alloc_histogram_buckets - 1);
+    alloc_tracker_bump(record->size_histogram[bucket], 1);
+
+    int64_t net = alloc_tracker_net_bytes(*record);
+    if (net >= record->next_peak_check) {
+        alloc_tracker_update_peak();
+        record->next_peak_check = net + alloc_peak_check_bytes;
+    }
+
+    // Sample one stack per `interval` bytes, so big allocators show up more often
+    record->bytes_until_sample -= static_cast<int64_t>(size);
+    if (record->bytes_until_sample <= 0 && !alloc_tracker_busy) {
+        alloc_tracker_state& state = alloc_tracker_global();
+        int64_t interval = state.sample_interval.load(std::memory_order_relaxed);
+        record->bytes_until_sample += interval;
+        if (record->bytes_until_sample <= 0) record->bytes_until_sample = interval;
+        alloc_tracker_busy = true;
+        alloc_tracker_take_sample(static_cast<uint64_t>(interval));
+        alloc_tracker_update_peak();
+        alloc_tracker_busy = false;
+    }
+}
+
+inline void alloc_tracker_on_free(void* p) {
+    if (!p) return;
+    alloc_thread_record* record = alloc_tracker_thread_record();
+    if (!record) return;
+    uint64_t size = malloc_usable_size(p);
+    alloc_tracker_bump(record->deallocations, 1);
+    alloc_tracker_bump(record->bytes_freed, size);
+
+    // After the net shrinks, growing back by one step triggers a check again
+    int64_t net = alloc_tracker_net_bytes(*record);
+    if (net + alloc_peak_check_bytes < record->next_peak_check) record->next_peak_check = net + alloc_peak_check_bytes;
+}
+
+[[gnu::noinline]] inline void* alloc_tracker_malloc(std::size_t size, std::size_t alignment, bool nothrow) {
+    if (size == 0) size = 1;
+    for (;;) {
+        void* p = nullptr;
+        if (alignment <= alignof(std::max_align_t)) {
+            p = std::malloc(size);
+        } else if (posix_memalign(&p, alignment, size) != 0) {
+            p = nullptr;
+        }
+        if (p) {
+            alloc_tracker_on_allocate(p);
+            return p;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            if (nothrow) return nullptr;
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+inline void alloc_tracker_free(void* p) noexcept {
+    alloc_tracker_on_free(p);
+    std::free(p);
+}
+
+#endif  // ENABLE_ALLOC_TRACKER
+
+// --- SECTION 3: Queries and Reports ---
+
+inline alloc_stats alloc_tracker_stats_of(const alloc_thread_record& r) {
+    alloc_stats stats;
+    stats.allocations = r.allocations.load(std::memory_order_relaxed);
+    stats.deallocations = r.deallocations.load(std::memory_order_relaxed);
+    stats.bytes_allocated = r.bytes_allocated.load(std::memory_order_relaxed);
+    stats.bytes_freed = r.bytes_freed.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// Sum over every thread that ever allocated; also folds the current live bytes
+// into the peak, so peak_live_bytes >= live_bytes in the result
+inline alloc_stats alloc_tracker_totals() {
+    alloc_tracker_state& state = alloc_tracker_global();
+    alloc_stats total;
+    for (alloc_thread_record* r = state.threads.load(std::memory_order_acquire); r; r = r->next) {
+        alloc_stats s = alloc_tracker_stats_of(*r);
+        total.allocations += s.allocations;
+        total.deallocations += s.deallocations;
+        total.bytes_allocated += s.bytes_allocated;
+        total.bytes_freed += s.bytes_freed;
+    }
+    total.live_bytes = alloc_tracker_update_peak();
+    total.peak_live_bytes = state.peak_live_bytes.load(std::memory_order_relaxed);
+    return total;
+}
+
+inline alloc_stats alloc_tracker_this_thread() {
+    if (!alloc_tracker_enabled) return {};
+    alloc_thread_record* record = alloc_tracker_thread_record();
+    return record ? alloc_tracker_stats_of(*record) : alloc_stats{};
+}
+
+// Start a new peak measurement from the current live size
+inline void alloc_tracker_reset_peak() {
+    alloc_tracker_state& state = alloc_tracker_global();
+    state.peak_live_bytes.store(alloc_tracker_live_bytes(), std::memory_order_relaxed);
+}
+
+inline void alloc_tracker_set_sample_interval(int64_t bytes) {
+    alloc_tracker_global().sample_interval.store(std::max<int64_t>(bytes, 1), std::memory_order_relaxed);
+}
+
+inline void alloc_tracker_report(std::ostream& out, int max_stacks = 5) {
+    if (!alloc_tracker_enabled) {
+        out << "Allocation tracking is disabled (compile with -DENABLE_ALLOC_TRACKER)\n";
+        return;
+    }
+    alloc_tracker_state& state = alloc_tracker_global();
+    alloc_stats total = alloc_tracker_totals();
+    out << "--- Allocation report ---\n"
+        << "Allocations: " << total.allocations << " (" << total.bytes_allocated << " bytes), "
+        << "deallocations: " << total.deallocations << " (" << total.bytes_freed << " bytes)\n"
+        << "Live bytes: " << total.live_bytes << ", peak live bytes: " << total.peak_live_bytes << "\n";
+
+    uint64_t histogram[alloc_histogram_buckets] = {};
+    for (alloc_thread_record* r = state.threads.load(std::memory_order_acquire); r; r = r->next) {
+        alloc_stats s = alloc_tracker_stats_of(*r);
+        if (s.allocations == 0) continue;
+        out << "  thread #" << r->index << ": " << s.allocations << " allocations, " << s.bytes_allocated
+            << " bytes\n";
+        for (int b = 0; b < alloc_histogram_buckets; ++b) {
+            histogram[b] += r->size_histogram[b].load(std::memory_order_relaxed);
+        }
+    }
+
+    out << "Size histogram:\n";
+    for (int b = 0; b < alloc_histogram_buckets; ++b) {
+        if (histogram[b] == 0) continue;
+        uint64_t low = b == 0 ? 0 : uint64_t(1) << (b - 1);
+        out << "  " << std::setw(10) << low << " .. " << std::left << std::setw(10)
+            << (b == alloc_histogram_buckets - 1 ? std::string("inf") : std::to_string((uint64_t(1) << b) - 1))
+            << std::right << " bytes: " << histogram[b] << "\n";
+    }
+
+#ifdef ENABLE_ALLOC_TRACKER
+    std::lock_guard<std::mutex> lock(state.samples_mutex);
+    std::sort(state.samples, state.samples + state.sample_count,
+              [](const alloc_sampled_stack& a, const alloc_sampled_stack& b) { return a.bytes > b.bytes; });
+    out << "Top sampled allocation stacks (one sample per "
+        << state.sample_interval.load(std::memory_order_relaxed) << " bytes):\n";
+    for (int i = 0; i < std::min(max_stacks, state.sample_count); ++i) {
+        const alloc_sampled_stack& sample = state.samples[i];
+        out << "  ~" << sample.bytes << " bytes (" << sample.samples << " samples)\n";
+        char** symbols = backtrace_symbols(sample.frames, sample.depth);
+        // Skip the tracker's own frames (sample, hook, malloc wrapper, operator new)
+        for (int f = 4; f < sample.depth; ++f) {
+            out << "      " << (symbols ? symbols[f] : "?") << "\n";
+        }
+        std::free(symbols);
+    }
+#else
+    (void)max_stacks;
+#endif
+}
+
+// Prints how much a block of code allocated, e.g.
+//   { alloc_tracker_scope scope("mergeSort"); mergeSort(data); }
+class alloc_tracker_scope {
+public:
+    explicit alloc_tracker_scope(const char* name, std::ostream* out = nullptr)
+        : name_(name), out_(out), start_(alloc_tracker_totals()) {}
+
+    ~alloc_tracker_scope() {
+        if (!alloc_tracker_enabled || !out_) return;
+        alloc_stats now = alloc_tracker_totals();
+        *out_ << "[alloc] " << name_ << ": " << now.allocations - start_.allocations << " allocations, "
+              << now.bytes_allocated - start_.bytes_allocated << " bytes\n";
+    }
+
+    alloc_tracker_scope(const alloc_tracker_scope&) = delete;
+    alloc_tracker_scope& operator=(const alloc_tracker_scope&) = delete;
+
+private:
+    const char* name_;
+    std::ostream* out_;
+    alloc_stats start_;
+};
+
+// --- SECTION 4: Replacement Operators ---
+
+#ifdef ENABLE_ALLOC_TRACKER
+
+void* operator new(std::size_t size) { return alloc_tracker_malloc(size, 0, false); }
+void* operator new[](std::size_t size) { return alloc_tracker_malloc(size, 0, false); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return alloc_tracker_malloc(size, 0, true);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return alloc_tracker_malloc(size, 0, true);
+}
+void* operator new(std::size_t size, std::align_val_t al) {
+    return alloc_tracker_malloc(size, static_cast<std::size_t>(al), false);
+}
+void* operator new[](std::size_t size, std::align_val_t al) {
+    return alloc_tracker_malloc(size, static_cast<std::size_t>(al), false);
+}
+void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return alloc_tracker_malloc(size, static_cast<std::size_t>(al), true);
+}
+void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return alloc_tracker_malloc(size, static_cast<std::size_t>(al), true);
+}
+
+void operator delete(void* p) noexcept { alloc_tracker_free(p); }
+void operator delete[](void* p) noexcept { alloc_tracker_free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { alloc_tracker_free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { alloc_tracker_free(p); }
+void operator delete(void* p, std::size_t) noexcept { alloc_tracker_free(p); }
+void operator delete[](void* p, std::size_t) noexcept { alloc_tracker_free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { alloc_tracker_free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { alloc_tracker_free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { alloc_tracker_free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { alloc_tracker_free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { alloc_tracker_free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { alloc_tracker_free(p); }
+
+#endif  // ENABLE_ALLOC_TRACKER
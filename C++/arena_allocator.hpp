@@ -0,0 +1,239 @@
+#pragma once
+
+// Arena allocation for node-based containers (std::map, std::set, std::list,
+// std::unordered_map, ...), which otherwise call operator new once per element
+// and operator delete once per element on destruction.
+//
+//   monotonic_arena      - bump allocator over a chain of growing blocks;
+//                          individual deallocation is a no-op, release() frees
+//                          everything at once
+//   pool_arena           - per-size-class free lists carved out of a monotonic
+//                          arena, so erased nodes are reused
+//   arena_resource,
+//   pool_resource        - std::pmr::memory_resource adapters, usable with every
+//                          std::pmr container
+//   arena_allocator<T>   - classic allocator for non-pmr container types
+//   make_in_arena<C>()   - builds a container inside the arena; it is never
+//                          destroyed node by node, so teardown is O(1)
+//
+// None of these types are thread-safe: use one arena per thread or per task.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+// --- SECTION 1: Monotonic (Bump) Arena ---
+
+class monotonic_arena {
+public:
+    explicit monotonic_arena(std::size_t initial_block_size = 64 * 1024)
+        : next_block_size_(std::max<std::size_t>(initial_block_size, 256)) {}
+
+    monotonic_arena(const monotonic_arena&) = delete;
+    monotonic_arena& operator=(const monotonic_arena&) = delete;
+
+    ~monotonic_arena() { release(); }
+
+    // Bump the pointer inside the current block; start a bigger block when full
+    void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t)) {
+        std::uintptr_t aligned = (reinterpret_cast<std::uintptr_t>(cursor_) + alignment - 1) & ~(alignment - 1);
+        if (aligned + bytes > reinterpret_cast<std::uintptr_t>(end_) || cursor_ == nullptr) {
+            add_block(bytes + alignment);
+            aligned = (reinterpret_cast<std::uintptr_t>(cursor_) + alignment - 1) & ~(alignment - 1);
+        }
+        cursor_ = reinterpret_cast<std::byte*>(aligned + bytes);
+        bytes_allocated_ += bytes;
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    // Memory is only reclaimed by release(); this exists for allocator symmetry
+    void deallocate(void*, std::size_t, std::size_t = alignof(std::max_align_t)) noexcept {}
+
+    // Free every block. O(number of blocks), independent of how many objects were
+    // allocated. Objects living in the arena are not destroyed.
+    void release() noexcept {
+        block_header* block = blocks_;
+        while (block) {
+            block_header* previous = block->previous;
+            std::free(block);
+            block = previous;
+        }
+        blocks_ = nullptr;
+        cursor_ = end_ = nullptr;
+        bytes_allocated_ = 0;
+        bytes_reserved_ = 0;
+    }
+
+    std::size_t bytes_allocated() const noexcept { return bytes_allocated_; }
+    std::size_t bytes_reserved() const noexcept { return bytes_reserved_; }
+
+private:
+    struct block_header {
+        block_header* previous;
+        std::size_t size;
+    };
+
+    // Blocks grow geometrically so the number of blocks stays logarithmic
+    void add_block(std::size_t min_bytes) {
+        std::size_t size = std::max(next_block_size_, min_bytes + sizeof(block_header));
+        auto* block = static_cast<block_header*>(std::malloc(size));
+        if (!block) throw std::bad_alloc();
+        block->previous = blocks_;
+        block->size = size;
+        blocks_ = block;
+        cursor_ = reinterpret_cast<std::byte*>(block + 1);
+        end_ = reinterpret_cast<std::byte*>(block) + size;
+        bytes_reserved_ += size;
+        next_block_size_ = std::min(size * 2, max_block_size);
+    }
+
+    static constexpr std::size_t max_block_size = std::size_t(64) << 20;
+
+    block_header* blocks_ = nullptr;
+    std::byte* cursor_ = nullptr;
+    std::byte* end_ = nullptr;
+    std::size_t next_block_size_;
+    std::size_t bytes_allocated_ = 0;
+    std::size_t bytes_reserved_ = 0;
+};
+
+// --- SECTION 2: Size-Class Pool ---
+
+// Requests are rounded up to a multiple of 16 bytes. Freed chunks go onto the free
+// list for their size class, so containers that erase and insert repeatedly do not
+// keep growing the arena. Requests above max_pooled_size go straight to the arena.
+class pool_arena {
+public:
+    static constexpr std::size_t granularity = 16;
+    static constexpr std::size_t max_pooled_size = 512;
+    static constexpr std::size_t class_count = max_pooled_size / granularity;
+
+    explicit pool_arena(std::size_t initial_block_size = 64 * 1024) : arena_(initial_block_size) {}
+
+    void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t)) {
+        if (bytes > max_pooled_size || alignment > granularity) {
+            return arena_.allocate(bytes, alignment);
+        }
+        std::size_t index = size_class(bytes);
+        if (free_chunk* chunk = free_lists_[index]) {
+            free_lists_[index] = chunk->next;
+            return chunk;
+        }
+        return arena_.allocate((index + 1) * granularity, granularity);
+    }
+
+    void deallocate(void* p, std::size_t bytes, std::size_t alignment = alignof(std::max_align_t)) noexcept {
+        if (bytes > max_pooled_size || alignment > granularity) {
+            return;  // Large blocks are reclaimed with the arena
+        }
+        std::size_t index = size_class(bytes);
+        auto* chunk = static_cast<free_chunk*>(p);
+        chunk->next = free_lists_[index];
+        free_lists_[index] = chunk;
+    }
+
+    void release() noexcept {
+        arena_.release();
+        std::fill(std::begin(free_lists_), std::end(free_lists_), nullptr);
+    }
+
+    std::size_t bytes_reserved() const noexcept { return arena_.bytes_reserved(); }
+
+private:
+    struct free_chunk {
+        free_chunk* next;
+    };
+
+    static std::size_t size_class(std::size_t bytes) noexcept {
+        return bytes == 0 ? 0 : (bytes - 1) / granularity;
+    }
+
+    monotonic_arena arena_;
+    free_chunk* free_lists_[class_count] = {};
+};
+
+// --- SECTION 3: std::pmr Adapters ---
+
+class arena_resource : public std::pmr::memory_resource {
+public:
+    explicit arena_resource(std::size_t initial_block_size = 64 * 1024) : arena_(initial_block_size) {}
+
+    void release() noexcept { arena_.release(); }
+    monotonic_arena& arena() noexcept { return arena_; }
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        return arena_.allocate(bytes, alignment);
+    }
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    monotonic_arena arena_;
+};
+
+class pool_resource : public std::pmr::memory_resource {
+public:
+    explicit pool_resource(std::size_t initial_block_size = 64 * 1024) : pool_(initial_block_size) {}
+
+    void release() noexcept { pool_.release(); }
+    pool_arena& pool() noexcept { return pool_; }
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        return pool_.allocate(bytes, alignment);
+    }
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        pool_.deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    pool_arena pool_;
+};
+
+// --- SECTION 4: Classic Allocator Adapter ---
+
+// For container types that cannot be switched to std::pmr, e.g.
+//   std::map<int, int, std::less<int>, arena_allocator<std::pair<const int, int>>>
+template <typename T, typename Arena = monotonic_arena>
+class arena_allocator {
+public:
+    using value_type = T;
+
+    explicit arena_allocator(Arena& arena) noexcept : arena_(&arena) {}
+
+    template <typename U>
+    arena_allocator(const arena_allocator<U, Arena>& other) noexcept : arena_(other.arena_) {}
+
+    T* allocate(std::size_t n) { return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T))); }
+    // The alignment tells pool_arena that an over-aligned block came from its bump
+    // arena, not a size class, so it is not put on a free list
+    void deallocate(T* p, std::size_t n) noexcept { arena_->deallocate(p, n * sizeof(T), alignof(T)); }
+
+    template <typename U>
+    bool operator==(const arena_allocator<U, Arena>& other) const noexcept { return arena_ == other.arena_; }
+    template <typename U>
+    bool operator!=(const arena_allocator<U, Arena>& other) const noexcept { return arena_ != other.arena_; }
+
+private:
+    template <typename, typename>
+    friend class arena_allocator;
+
+    Arena* arena_;
+};
+
+// --- SECTION 5: O(1) Teardown ---
+
+// Construct a pmr container (or any pmr-aware object) inside the resource itself.
+// The returned pointer is never deleted: releasing the resource frees the object
+// and all of its nodes in one go, without visiting them. Only use this when the
+// elements own no memory outside the arena (ints, PODs, other pmr containers on
+// the same resource), since their destructors never run.
+template <typename Container, typename Resource, typename... Args>
+Container* make_in_arena(Resource& resource, Args&&... args) {
+    void* storage = resource.allocate(sizeof(Container), alignof(Container));
+    return ::new (storage) Container(std::forward<Args>(args)..., std::pmr::polymorphic_allocator<>(&resource));
+}
@@ -0,0 +1,828 @@
+#pragma once
+
+// Asynchronous file I/O on io_uring, with a thread-pool fallback.
+//
+// A synchronous read costs a syscall and a blocked thread per operation.
+// io_uring shares two rings with the kernel: operations are written into the
+// submission ring and handed over in batches with one io_uring_enter, and
+// results are read from the completion ring without any syscall at all.
+//
+//   read / write       - pread/pwrite-style, absolute offsets, short reads possible
+//   read_fixed /
+//   write_fixed        - into buffers registered once with register_buffers(), so
+//                        the kernel does not pin and unpin the pages per operation
+//   fsync / fdatasync
+//   openat / close
+//   register_files()   - fixed files: fixed_file(i) instead of an fd skips the
+//                        per-operation file table lookup and refcount
+//
+// Each operation either takes a callback fn(int result) or, without one, returns
+// an awaitable: `int n = co_await io.read(fd, buf, len, offset);`. Results follow
+// the kernel convention: bytes / fd / 0 on success, -errno on failure.
+//
+// Operations are queued until submit(), poll() or wait() (which also submit),
+// so a loop that queues 64 reads costs one syscall. Callbacks and coroutine
+// resumptions always run on the thread calling poll()/wait()/drain()/run():
+// an async_io belongs to one thread. Callbacks may queue further operations
+// but must not throw (that terminates, as on a std::thread).
+//
+// Without io_uring (old kernels, containers with io_uring_disabled, seccomp),
+// the same interface is served by a thread_pool running pread/pwrite/...;
+// completions are still delivered on the owning thread.
+//
+// Usage:
+//   async_io io;                                     // io_uring if available
+//   for (std::size_t i = 0; i < 64; ++i)
+//       io.read(fd, buffers[i], 4096, offsets[i], [&](int n) { total += n; });
+//   io.drain();                                      // One submit, then reap
+//
+//   task<int> copy_header(async_io& io, int in, int out) {
+//       char header[512];
+//       int n = co_await io.read(in, header, sizeof header, 0);
+//       if (n > 0) n = co_await io.write(out, header, n, 0);
+//       co_return n;
+//   }
+//   int written = io.run(copy_header(io, in, out));  // Drives the ring until done
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "coroutine_runtime.hpp"  // task, coro_detail::detached_task, thread_pool
+#include "futex.hpp"              // futex_wait, futex_wake
+
+enum class async_io_backend { automatic, io_uring, thread_pool };
+
+inline const char* async_io_backend_name(async_io_backend backend) {
+    switch (backend) {
+        case async_io_backend::io_uring: return "io_uring";
+        case async_io_backend::thread_pool: return "thread pool";
+        default: return "automatic";
+    }
+}
+
+struct async_io_options {
+    unsigned queue_depth = 256;              // Submission ring entries (rounded up to a power of two)
+    async_io_backend backend = async_io_backend::automatic;
+    std::size_t fallback_threads = 4;        // thread_pool workers when io_uring is not used
+};
+
+struct async_io_stats {
+    uint64_t submitted = 0;
+    uint64_t completed = 0;
+    uint64_t batches = 0;  // io_uring_enter calls that submitted something, or pool hand-offs
+};
+
+// An fd, or an index into the table given to register_files()
+struct io_file {
+    io_file(int fd) noexcept : value(fd) {}  // Implicit: plain fds work everywhere
+    int value;
+    bool fixed = false;
+};
+
+inline io_file fixed_file(int index) noexcept {
+    io_file file(index);
+    file.fixed = true;
+    return file;
+}
+
+// --- SECTION 1: Raw io_uring Ring ---
+
+namespace async_io_detail {
+
+inline int sys_io_uring_setup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+inline int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+inline int sys_io_uring_register(int fd, unsigned opcode, const void* arg, unsigned count) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+// The three shared mappings of one ring and the index arithmetic on them.
+// Only the owning thread touches it; the kernel is the other party.
+class uring {
+public:
+    explicit uring(unsigned entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof params);
+        params.flags = IORING_SETUP_CLAMP;
+        fd_ = sys_io_uring_setup(entries, &params);
+        if (fd_ < 0) throw std::system_error(errno, std::generic_category(), "async_io: io_uring_setup");
+        try {
+            map(params);
+        } catch (...) {
+            release();
+            throw;
+        }
+    }
+
+    ~uring() { release(); }
+
+    uring(const uring&) = delete;
+    uring& operator=(const uring&) = delete;
+
+    int fd() const noexcept { return fd_; }
+    unsigned sq_entries() const noexcept { return sq_entries_; }
+    unsigned cq_entries() const noexcept { return cq_entries_; }
+    unsigned pending() const noexcept { return pending_; }
+
+    // True if the kernel implements every opcode in `ops` (IORING_REGISTER_PROBE, 5.6+)
+    bool supports(std::initializer_list<uint8_t> ops) const {
+        constexpr unsigned probe_ops = 256;
+        std::vector<unsigned char> storage(sizeof(io_uring_probe) + probe_ops * sizeof(io_uring_probe_op));
+        auto* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+        if (sys_io_uring_register(fd_, IORING_REGISTER_PROBE, probe, probe_ops) < 0) return false;
+        for (uint8_t op : ops) {
+            if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) return false;
+        }
+        return true;
+    }
+
+    // A zeroed entry, or nullptr if the submission ring is full (submit first)
+    io_uring_sqe* next_sqe() noexcept {
+        unsigned head = std::atomic_ref<unsigned>(*sq_head_).load(std::memory_order_acquire);
+        if (sq_tail_ - head >= sq_entries_) return nullptr;
+        unsigned index = sq_tail_ & sq_mask_;
+        sq_array_[index] = index;
+        ++sq_tail_;
+        ++pending_;
+        io_uring_sqe* sqe = &sqes_[index];
+        std::memset(sqe, 0, sizeof *sqe);
+        return sqe;
+    }
+
+    // Publishes the pending entries and enters the kernel: submits them and, with
+    // min_complete > 0, waits for that many completions. Returns entries submitted.
+    unsigned enter(unsigned min_complete) {
+        std::atomic_ref<unsigned>(*sq_tail_shared_).store(sq_tail_, std::memory_order_release);
+        unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+        for (;;) {
+            int n = sys_io_uring_enter(fd_, pending_, min_complete, flags);
+            if (n >= 0) {
+                pending_ -= static_cast<unsigned>(n);
+                return static_cast<unsigned>(n);
+            }
+            if (errno == EINTR) {
+                if (min_complete == 0) continue;
+                return 0;  // Interrupted while waiting: the caller re-checks the completion ring
+            }
+            if (errno == EAGAIN || errno == EBUSY) return 0;  // Kernel short on resources: reap, then retry
+            throw std::system_error(errno, std::generic_category(), "async_io: io_uring_enter");
+        }
+    }
+
+    // fn(user_data, result) for every available completion; returns how many
+    template <typename Fn>
+    unsigned reap(Fn&& fn) {
+        unsigned head = *cq_head_;  // Only we write it
+        unsigned tail = std::atomic_ref<unsigned>(*cq_tail_).load(std::memory_order_acquire);
+        unsigned count = tail - head;
+        // Copy the batch out and hand the slots back to the kernel before running
+        // callbacks, which may submit (and wait for) more work
+        constexpr unsigned batch = 64;
+        std::pair<uint64_t, int> done[batch];
+        count = std::min(count, batch);
+        for (unsigned i = 0; i < count; ++i) {
+            const io_uring_cqe& cqe = cqes_[(head + i) & cq_mask_];
+            done[i] = {cqe.user_data, cqe.res};
+        }
+        std::atomic_ref<unsigned>(*cq_head_).store(head + count, std::memory_order_release);
+        for (unsigned i = 0; i < count; ++i) fn(done[i].first, done[i].second);
+        return count;
+    }
+
+    // Registration calls; throw std::system_error
+    void register_call(unsigned opcode, const void* arg, unsigned count, const char* what) {
+        if (sys_io_uring_register(fd_, opcode, arg, count) < 0) {
+            throw std::system_error(errno, std::generic_category(), std::string("async_io: ") + what);
+        }
+    }
+
+    void unregister_call(unsigned opcode) noexcept { sys_io_uring_register(fd_, opcode, nullptr, 0); }
+
+private:
+    void map(const io_uring_params& params) {
+        sq_entries_ = params.sq_entries;
+        cq_entries_ = params.cq_entries;
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = params.features & IORING_FEAT_SINGLE_MMAP;  // 5.4+: both rings in one mapping
+        if (single) sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+
+        sq_ring_ = map_region(sq_ring_size_, IORING_OFF_SQ_RING);
+        cq_ring_ = single ? sq_ring_ : map_region(cq_ring_size_, IORING_OFF_CQ_RING);
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(map_region(sqes_size_, IORING_OFF_SQES));
+
+        char* sq = static_cast<char*>(sq_ring_);
+        sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sq_tail_shared_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        sq_tail_ = *sq_tail_shared_;
+
+        char* cq = static_cast<char*>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    void* map_region(std::size_t size, off_t offset) {
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, offset);
+        if (p == MAP_FAILED) throw std::system_error(errno, std::generic_category(), "async_io: mmap ring");
+        return p;
+    }
+
+    void release() noexcept {
+        if (sqes_) munmap(sqes_, sqes_size_);
+        if (cq_ring_ && cq_ring_ != sq_ring_) munmap(cq_ring_, cq_ring_size_);
+        if (sq_ring_) munmap(sq_ring_, sq_ring_size_);
+        if (fd_ >= 0) ::close(fd_);
+        sqes_ = nullptr;
+        sq_ring_ = cq_ring_ = nullptr;
+        fd_ = -1;
+    }
+
+    int fd_ = -1;
+    void* sq_ring_ = nullptr;
+    void* cq_ring_ = nullptr;
+    io_uring_sqe* sqes_ = nullptr;
+    std::size_t sq_ring_size_ = 0;
+    std::size_t cq_ring_size_ = 0;
+    std::size_t sqes_size_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned cq_entries_ = 0;
+
+    unsigned* sq_head_ = nullptr;         // Advanced by the kernel as it consumes entries
+    unsigned* sq_tail_shared_ = nullptr;  // Published by enter()
+    unsigned* sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_tail_ = 0;                // Local tail, ahead of the shared one by pending_
+    unsigned pending_ = 0;
+
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;  // Advanced by the kernel as it posts completions
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+};
+
+// --- SECTION 2: Operations ---
+
+enum class io_opcode : uint8_t { read, write, read_fixed, write_fixed, fsync, fdatasync, openat, close };
+
+struct io_request {
+    io_opcode op = io_opcode::read;
+    io_file file = -1;  // openat: the directory fd
+    void* buffer = nullptr;
+    uint32_t length = 0;
+    uint64_t offset = 0;
+    int buffer_index = 0;  // read_fixed / write_fixed
+    int open_flags = 0;
+    mode_t mode = 0;
+    const char* path = nullptr;
+};
+
+// Largest single transfer Linux performs (MAX_RW_COUNT); longer requests complete short
+inline uint32_t clamp_length(std::size_t length) noexcept {
+    return static_cast<uint32_t>(std::min<std::size_t>(length, 0x7ffff000));
+}
+
+// One in-flight operation. The callback lives inline when it is small enough
+// (every lambda capturing a few pointers is), so queuing does not allocate.
+struct io_op {
+    static constexpr std::size_t inline_size = 48;
+
+    io_request request;
+    std::string path;  // openat: owned copy, must outlive the submission
+    void* target = nullptr;
+    void (*invoke)(void* target, int result) = nullptr;
+    void (*destroy)(void* target, bool heap) noexcept = nullptr;
+    bool heap = false;
+    uint32_t next_free = 0;
+    alignas(std::max_align_t) unsigned char storage[inline_size];
+
+    template <typename Fn>
+    void set_callback(Fn&& fn) {
+        using F = std::decay_t<Fn>;
+        if constexpr (sizeof(F) <= inline_size && alignof(F) <= alignof(std::max_align_t) &&
+                      std::is_nothrow_move_constructible_v<F>) {
+            target = new (storage) F(std::forward<Fn>(fn));
+            heap = false;
+        } else {
+            target = new F(std::forward<Fn>(fn));
+            heap = true;
+        }
+        invoke = [](void* p, int result) { (*static_cast<F*>(p))(result); };
+        destroy = [](void* p, bool on_heap) noexcept {
+            if (on_heap) {
+                delete static_cast<F*>(p);
+            } else {
+                static_cast<F*>(p)->~F();
+            }
+        };
+    }
+
+    void complete(int result) noexcept {  // A throwing callback terminates
+        invoke(target, result);
+        destroy(target, heap);
+        target = nullptr;
+    }
+};
+
+// The synchronous equivalent of a request, for the thread-pool backend
+inline int execute_blocking(const io_request& request, int fd) {
+    ssize_t n = -1;
+    switch (request.op) {
+        case io_opcode::read:
+        case io_opcode::read_fixed:
+            n = pread(fd, request.buffer, request.length, static_cast<off_t>(request.offset));
+            break;
+        case io_opcode::write:
+        case io_opcode::write_fixed:
+            n = pwrite(fd, request.buffer, request.length, static_cast<off_t>(request.offset));
+            break;
+        case io_opcode::fsync: n = ::fsync(fd); break;
+        case io_opcode::fdatasync: n = ::fdatasync(fd); break;
+        case io_opcode::openat: n = ::openat(fd, request.path, request.open_flags, request.mode); break;
+        case io_opcode::close: n = ::close(fd); break;
+    }
+    return n < 0 ? -errno : static_cast<int>(n);
+}
+
+}  // namespace async_io_detail
+
+// --- SECTION 3: The Engine ---
+
+class async_io {
+public:
+    explicit async_io(async_io_options options = {}) : options_(options) {
+        options_.queue_depth = std::max(options_.queue_depth, 1u);
+        if (options_.backend != async_io_backend::thread_pool) {
+            try {
+                ring_ = std::make_unique<async_io_detail::uring>(options_.queue_depth);
+                if (!ring_->supports({IORING_OP_READ, IORING_OP_WRITE, IORING_OP_READ_FIXED, IORING_OP_WRITE_FIXED,
+                                      IORING_OP_FSYNC, IORING_OP_OPENAT, IORING_OP_CLOSE})) {
+                    ring_.reset();
+                    throw std::system_error(ENOSYS, std::generic_category(), "async_io: io_uring lacks needed ops");
+                }
+            } catch (const std::system_error&) {
+                if (options_.backend == async_io_backend::io_uring) throw;
+            }
+        }
+        if (ring_) {
+            backend_ = async_io_backend::io_uring;
+            init_slots(ring_->cq_entries());  // In flight <= CQ size: the completion ring never overflows
+        } else {
+            backend_ = async_io_backend::thread_pool;
+            pool_ = std::make_unique<thread_pool>(std::max<std::size_t>(options_.fallback_threads, 1));
+            init_slots(options_.queue_depth * 2);
+        }
+    }
+
+    // Waits for everything still in flight (running its callbacks): the kernel
+    // or a pool thread may still be writing into the caller's buffers
+    ~async_io() {
+        try {
+            drain();
+        } catch (...) {
+        }
+        pool_.reset();
+    }
+
+    async_io(const async_io&) = delete;
+    async_io& operator=(const async_io&) = delete;
+
+    async_io_backend backend() const noexcept { return backend_; }
+    std::size_t in_flight() const noexcept { return in_flight_; }
+    const async_io_stats& stats() const noexcept { return stats_; }
+
+    // Register buffers for read_fixed/write_fixed (replacing earlier ones).
+    // The memory counts against RLIMIT_MEMLOCK on older kernels. Throws std::system_error.
+    void register_buffers(std::span<const iovec> buffers) {
+        if (!ring_) return;  // The pool backend reads into any buffer
+        if (buffers_registered_) ring_->unregister_call(IORING_UNREGISTER_BUFFERS);
+        buffers_registered_ = false;
+        ring_->register_call(IORING_REGISTER_BUFFERS, buffers.data(), static_cast<unsigned>(buffers.size()),
+                             "register buffers");
+        buffers_registered_ = true;
+    }
+
+    // Register fds for fixed_file(i), replacing earlier ones. The fds stay owned by the caller.
+    void register_files(std::span<const int> fds) {
+        files_.assign(fds.begin(), fds.end());
+        if (!ring_) return;
+        if (files_registered_) ring_->unregister_call(IORING_UNREGISTER_FILES);
+        files_registered_ = false;
+        ring_->register_call(IORING_REGISTER_FILES, fds.data(), static_cast<unsigned>(fds.size()), "register files");
+        files_registered_ = true;
+    }
+
+    // Queue operations. With a callback fn(int result) they return nothing;
+    // without one they return an awaitable yielding the result.
+    template <typename Fn>
+    void read(io_file file, void* buffer, std::size_t length, uint64_t offset, Fn&& fn) {
+        queue(rw(async_io_detail::io_opcode::read, file, buffer, length, offset), std::forward<Fn>(fn));
+    }
+
+    template <typename Fn>
+    void write(io_file file, const void* buffer, std::size_t length, uint64_t offset, Fn&& fn) {
+        queue(rw(async_io_detail::io_opcode::write, file, const_cast<void*>(buffer), length, offset),
+              std::forward<Fn>(fn));
+    }
+
+    // `buffer` must lie inside registered buffer `buffer_index`
+    template <typename Fn>
+    void read_fixed(io_file file, void* buffer, std::size_t length, uint64_t offset, int buffer_index, Fn&& fn) {
+        queue(rw(async_io_detail::io_opcode::read_fixed, file, buffer, length, offset, buffer_index),
+              std::forward<Fn>(fn));
+    }
+
+    template <typename Fn>
+    void write_fixed(io_file file, const void* buffer, std::size_t length, uint64_t offset, int buffer_index,
+                     Fn&& fn) {
+        queue(rw(async_io_detail::io_opcode::write_fixed, file, const_cast<void*>(buffer), length, offset,
+                 buffer_index),
+              std::forward<Fn>(fn));
+    }
+
+    template <typename Fn>
+    void fsync(io_file file, Fn&& fn) {
+        queue(simple(async_io_detail::io_opcode::fsync, file), std::forward<Fn>(fn));
+    }
+
+    template <typename Fn>
+    void fdatasync(io_file file, Fn&& fn) {
+        queue(simple(async_io_detail::io_opcode::fdatasync, file), std::forward<Fn>(fn));
+    }
+
+    // The path is copied; the result is the new fd
+    template <typename Fn>
+    void openat(int dirfd, const char* path, int flags, mode_t mode, Fn&& fn) {
+        queue(open_request(dirfd, path, flags, mode), std::forward<Fn>(fn));
+    }
+
+    template <typename Fn>
+    void close(int fd, Fn&& fn) {
+        queue(simple(async_io_detail::io_opcode::close, fd), std::forward<Fn>(fn));
+    }
+
+    class awaitable;
+
+    awaitable read(io_file file, void* buffer, std::size_t length, uint64_t offset);
+    awaitable write(io_file file, const void* buffer, std::size_t length, uint64_t offset);
+    awaitable read_fixed(io_file file, void* buffer, std::size_t length, uint64_t offset, int buffer_index);
+    awaitable write_fixed(io_file file, const void* buffer, std::size_t length, uint64_t offset, int buffer_index);
+    awaitable fsync(io_file file);
+    awaitable fdatasync(io_file file);
+    awaitable openat(int dirfd, const char* path, int flags, mode_t mode = 0);
+    awaitable close(int fd);
+
+    // Hand queued operations to the kernel (or the pool); returns how many
+    std::size_t submit() {
+        if (ring_) {
+            std::size_t total = 0;
+            while (ring_->pending() > 0) {
+                unsigned n = ring_->enter(0);
+                if (n == 0) break;  // EAGAIN: retried by the next submit or wait
+                total += n;
+                ++stats_.batches;
+            }
+            return total;
+        }
+        std::size_t n = pending_.size();
+        for (uint32_t slot : pending_) {
+            pool_->post([this, slot] {
+                async_io_detail::io_op& op = ops_[slot];
+                int result = async_io_detail::execute_blocking(op.request, resolve(op.request.file));
+                {
+                    std::lock_guard<std::mutex> lock(completed_mutex_);
+                    completed_.emplace_back(slot, result);
+                }
+                completed_signal_.fetch_add(1, std::memory_order_release);
+                futex_wake(completed_signal_);
+            });
+        }
+        if (n > 0) ++stats_.batches;
+        pending_.clear();
+        return n;
+    }
+
+    // Submit, then run the callbacks of whatever has completed; never blocks
+    std::size_t poll() {
+        submit();
+        return reap();
+    }
+
+    // Submit, then block until at least `min` operations completed (fewer if
+    // fewer are in flight); returns how many callbacks ran
+    std::size_t wait(std::size_t min = 1) {
+        std::size_t done = 0;
+        for (;;) {
+            submit();
+            done += reap();
+            if (done >= min || in_flight_ == 0) return done;
+            if (ring_) {
+                if (ring_->enter(1) > 0) ++stats_.batches;  // Callbacks above may have queued more
+            } else {
+                uint32_t seen = completed_signal_.load(std::memory_order_acquire);
+                bool empty;
+                {
+                    std::lock_guard<std::mutex> lock(completed_mutex_);
+                    empty = completed_.empty();
+                }
+                if (empty) futex_wait(completed_signal_, seen);
+            }
+        }
+    }
+
+    // Wait until nothing is in flight
+    void drain() {
+        while (in_flight_ > 0) wait(in_flight_);
+    }
+
+    // Drive the engine on this thread until `work` finishes; returns its result.
+    // The task must only wait on this engine's I/O (throws std::logic_error
+    // if it suspends with nothing in flight).
+    template <typename T>
+    T run(task<T> work) {
+        bool finished = false;
+        std::optional<coro_detail::non_void_t<T>> result;
+        std::exception_ptr error;
+        [](task<T>& work, std::optional<coro_detail::non_void_t<T>>& result, std::exception_ptr& error,
+           bool& finished) -> coro_detail::detached_task {
+            try {
+                if constexpr (std::is_void_v<T>) {
+                    co_await work;
+                    result.emplace();
+                } else {
+                    result.emplace(co_await work);
+                }
+            } catch (...) {
+                error = std::current_exception();
+            }
+            finished = true;
+        }(work, result, error, finished);
+
+        while (!finished) {
+            if (in_flight_ == 0) throw std::logic_error("async_io::run: task suspended without pending I/O");
+            wait(1);
+        }
+        if (error) std::rethrow_exception(error);
+        if constexpr (!std::is_void_v<T>) return std::move(*result);
+    }
+
+    // Start a task that progresses whenever this engine is polled or waited on.
+    // Exceptions escaping it terminate.
+    void spawn(task<void> work) {
+        [](task<void> work) -> coro_detail::detached_task { co_await work; }(std::move(work));
+    }
+
+private:
+    using io_opcode = async_io_detail::io_opcode;
+    using io_request = async_io_detail::io_request;
+
+    static io_request rw(io_opcode op, io_file file, void* buffer, std::size_t length, uint64_t offset,
+                         int buffer_index = 0) {
+        io_request request;
+        request.op = op;
+        request.file = file;
+        request.buffer = buffer;
+        request.length = async_io_detail::clamp_length(length);
+        request.offset = offset;
+        request.buffer_index = buffer_index;
+        return request;
+    }
+
+    static io_request simple(io_opcode op, io_file file) {
+        io_request request;
+        request.op = op;
+        request.file = file;
+        return request;
+    }
+
+    static io_request open_request(int dirfd, const char* path, int flags, mode_t mode) {
+        io_request request;
+        request.op = io_opcode::openat;
+        request.file = dirfd;
+        request.path = path;
+        request.open_flags = flags | O_CLOEXEC;
+        request.mode = mode;
+        return request;
+    }
+
+    void init_slots(std::size_t count) {
+        ops_.reset(new async_io_detail::io_op[count]);
+        for (std::size_t i = 0; i < count; ++i) ops_[i].next_free = static_cast<uint32_t>(i + 1);
+        slot_count_ = count;
+        free_slot_ = 0;
+    }
+
+    template <typename Fn>
+    void queue(io_request request, Fn&& fn) {
+        // Making room runs callbacks, which may queue too: pick the slot only
+        // once both a slot and a submission entry are free
+        io_uring_sqe* sqe = nullptr;
+        for (;;) {
+            if (free_slot_ == slot_count_) {  // Every slot in flight
+                wait(1);
+                continue;
+            }
+            if (!ring_ || (sqe = ring_->next_sqe()) != nullptr) break;
+            if (submit() == 0) wait(1);  // Submission ring full
+        }
+        uint32_t slot = static_cast<uint32_t>(free_slot_);
+        async_io_detail::io_op& op = ops_[slot];
+        if (request.op == io_opcode::openat) {
+            op.path = request.path;
+            request.path = op.path.c_str();
+        }
+        op.request = request;
+        if (sqe) {
+            prepare(*sqe, op.request, slot);
+        } else {
+            pending_.push_back(slot);
+        }
+        op.set_callback(std::forward<Fn>(fn));
+        free_slot_ = op.next_free;
+        ++in_flight_;
+        ++stats_.submitted;
+    }
+
+    static void prepare(io_uring_sqe& sqe, const io_request& request, uint32_t slot) {
+        sqe.user_data = slot;
+        sqe.fd = request.file.value;
+        if (request.file.fixed) sqe.flags |= IOSQE_FIXED_FILE;
+        switch (request.op) {
+            case io_opcode::read:
+            case io_opcode::write:
+            case io_opcode::read_fixed:
+            case io_opcode::write_fixed:
+                sqe.opcode = request.op == io_opcode::read          ? IORING_OP_READ
+                             : request.op == io_opcode::write       ? IORING_OP_WRITE
+                             : request.op == io_opcode::read_fixed  ? IORING_OP_READ_FIXED
+                                                                    : IORING_OP_WRITE_FIXED;
+                sqe.addr = reinterpret_cast<uint64_t>(request.buffer);
+                sqe.len = request.length;
+                sqe.off = request.offset;
+                sqe.buf_index = static_cast<uint16_t>(request.buffer_index);
+                break;
+            case io_opcode::fsync:
+            case io_opcode::fdatasync:
+                sqe.opcode = IORING_OP_FSYNC;
+                sqe.fsync_flags = request.op == io_opcode::fdatasync ? IORING_FSYNC_DATASYNC : 0;
+                break;
+            case io_opcode::openat:
+                sqe.opcode = IORING_OP_OPENAT;
+                sqe.addr = reinterpret_cast<uint64_t>(request.path);
+                sqe.len = request.mode;
+                sqe.open_flags = static_cast<uint32_t>(request.open_flags);
+                break;
+            case io_opcode::close:
+                sqe.opcode = IORING_OP_CLOSE;
+                break;
+        }
+    }
+
+    int resolve(io_file file) const {
+        if (!file.fixed) return file.value;
+        return file.value >= 0 && static_cast<std::size_t>(file.value) < files_.size()
+                   ? files_[static_cast<std::size_t>(file.value)]
+                   : -1;
+    }
+
+    void complete(uint32_t slot, int result) {
+        async_io_detail::io_op& op = ops_[slot];
+        --in_flight_;
+        ++stats_.completed;
+        op.complete(result);
+        op.next_free = static_cast<uint32_t>(free_slot_);
+        free_slot_ = slot;
+    }
+
+    std::size_t reap() {
+        std::size_t done = 0;
+        if (ring_) {
+            while (unsigned n = ring_->reap([this](uint64_t slot, int result) {
+                       complete(static_cast<uint32_t>(slot), result);
+                   })) {
+                done += n;
+            }
+            return done;
+        }
+        for (;;) {
+            {
+                std::lock_guard<std::mutex> lock(completed_mutex_);
+                if (completed_.empty()) return done;
+                reaping_.swap(completed_);
+            }
+            for (auto [slot, result] : reaping_) complete(slot, result);
+            done += reaping_.size();
+            reaping_.clear();
+        }
+    }
+
+    async_io_options options_;
+    async_io_backend backend_ = async_io_backend::io_uring;
+    async_io_stats stats_;
+
+    std::unique_ptr<async_io_detail::io_op[]> ops_;
+    std::size_t slot_count_ = 0;
+    std::size_t free_slot_ = 0;  // Head of the free list; slot_count_ when every slot is in flight
+    std::size_t in_flight_ = 0;
+    std::vector<int> files_;
+
+    // io_uring backend
+    std::unique_ptr<async_io_detail::uring> ring_;
+    bool buffers_registered_ = false;
+    bool files_registered_ = false;
+
+    // Thread-pool backend: queued slots, and results coming back from the workers
+    std::vector<uint32_t> pending_;
+    std::mutex completed_mutex_;
+    std::vector<std::pair<uint32_t, int>> completed_;
+    std::vector<std::pair<uint32_t, int>> reaping_;
+    std::atomic<uint32_t> completed_signal_{0};
+    std::unique_ptr<thread_pool> pool_;  // Last: its workers finish before the members they touch go away
+};
+
+// --- SECTION 4: Coroutine Awaitable ---
+
+// co_await queues the operation and suspends; the coroutine resumes inside
+// poll()/wait() on the engine's thread with the result
+class async_io::awaitable {
+public:
+    awaitable(async_io& io, async_io_detail::io_request request) noexcept : io_(&io), request_(request) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        io_->queue(request_, [this, handle](int result) {
+            result_ = result;
+            handle.resume();
+        });
+    }
+
+    int await_resume() const noexcept { return result_; }
+
+private:
+    async_io* io_;
+    async_io_detail::io_request request_;
+    int result_ = 0;
+};
+
+inline async_io::awaitable async_io::read(io_file file, void* buffer, std::size_t length, uint64_t offset) {
+    return {*this, rw(io_opcode::read, file, buffer, length, offset)};
+}
+
+inline async_io::awaitable async_io::write(io_file file, const void* buffer, std::size_t length, uint64_t offset) {
+    return {*this, rw(io_opcode::write, file, const_cast<void*>(buffer), length, offset)};
+}
+
+inline async_io::awaitable async_io::read_fixed(io_file file, void* buffer, std::size_t length, uint64_t offset,
+                                                 int buffer_index) {
+    return {*this, rw(io_opcode::read_fixed, file, buffer, length, offset, buffer_index)};
+}
+
+inline async_io::awaitable async_io::write_fixed(io_file file, const void* buffer, std::size_t length,
+                                                  uint64_t offset, int buffer_index) {
+    return {*this, rw(io_opcode::write_fixed, file, const_cast<void*>(buffer), length, offset, buffer_index)};
+}
+
+inline async_io::awaitable async_io::fsync(io_file file) { return {*this, simple(io_opcode::fsync, file)}; }
+
+inline async_io::awaitable async_io::fdatasync(io_file file) { return {*this, simple(io_opcode::fdatasync, file)}; }
+
+// The path is copied when the operation is queued, i.e. at co_await
+inline async_io::awaitable async_io::openat(int dirfd, const char* path, int flags, mode_t mode) {
+    return {*this, open_request(dirfd, path, flags, mode)};
+}
+
+inline async_io::awaitable async_io::close(int fd) { return {*this, simple(io_opcode::close, fd)}; }
@@ -0,0 +1,591 @@
+#pragma once
+
+// Asynchronous logger: callers copy their arguments into a per-thread buffer
+// and return; one background thread formats and writes everything.
+//
+//   - one lock-free single-producer ring of bytes per (thread, logger); the
+//     caller never takes a lock, formats or makes a system call
+//   - arguments are stored in binary (numbers as their bytes, strings as a
+//     length and the characters) together with a pointer to the format string
+//     and to a decoder instantiated for the argument types
+//   - timestamps are raw TSC reads (rdtsc on x86, steady_clock elsewhere),
+//     converted to wall-clock time on the backend
+//   - the backend drains every ring, merges the records by timestamp, formats
+//     them into one string and writes it to the sink in a single call
+//   - bounded memory: a full ring either drops the record (counted, and
+//     reported in the output) or blocks the caller until the backend catches up
+//
+// Format strings use "{}" placeholders and must be string literals: only the
+// pointer is stored, and it is read later on another thread. Arguments may be
+// integers, floating point, bool, char, enums, pointers and strings
+// (const char*, std::string, std::string_view).
+//
+// Usage:
+//   async_logger& log = default_logger();
+//   log.info("worker {} finished {} items in {} ms", id, count, elapsed_ms);
+//   log.flush();  // Wait until everything logged so far has been written
+//
+//   async_logger_options options;
+//   options.overflow = log_overflow::block;
+//   options.sink = &file;
+//   async_logger file_log(options);
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "futex.hpp"  // cpu_relax, cache_line_size, default_spin_iterations
+
+// --- SECTION 1: TSC Timestamps ---
+
+// Cycle counter as a cheap timestamp. On current x86 CPUs the TSC ticks at a
+// constant rate and is synchronized across cores, so reads from different
+// threads can be compared. It costs ~20 cycles against ~25 ns for a
+// clock_gettime through the vDSO.
+struct tsc_clock {
+    static uint64_t now() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    // Nanoseconds per tick, measured once against steady_clock (about 10 ms)
+    static double ns_per_tick() {
+        static const double ratio = calibrate();
+        return ratio;
+    }
+
+private:
+    static double calibrate() {
+#if defined(__x86_64__) || defined(__i386__)
+        auto start_time = std::chrono::steady_clock::now();
+        uint64_t start_ticks = now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        auto end_time = std::chrono::steady_clock::now();
+        uint64_t end_ticks = now();
+        double ns = std::chrono::duration<double, std::nano>(end_time - start_time).count();
+        return end_ticks > start_ticks ? ns / static_cast<double>(end_ticks - start_ticks) : 1.0;
+#else
+        return 1e9 * std::chrono::steady_clock::period::num / std::chrono::steady_clock::period::den;
+#endif
+    }
+};
+
+// --- SECTION 2: Binary Argument Encoding ---
+
+enum class log_level : uint8_t { debug, info, warning, error };
+
+enum class log_overflow {
+    drop,   // A full buffer discards the record and counts it
+    block,  // A full buffer makes the caller wait for the backend
+};
+
+namespace async_logger_detail {
+
+// Every record starts with this header, 8-byte aligned
+struct record_header {
+    uint32_t size;   // Whole record including the header, a multiple of 8
+    uint8_t level;   // log_level, or wrap_marker
+    uint8_t unused[3];
+    uint64_t timestamp;
+    const char* format;
+    void (*decode)(const char* format, const std::byte* args, std::string& out);
+};
+
+inline constexpr uint8_t wrap_marker = 0xFF;  // "Skip to the start of the ring"
+inline constexpr std::size_t record_alignment = 8;
+
+template <typename T>
+inline constexpr bool is_string_arg =
+    std::is_same_v<std::decay_t<T>, const char*> || std::is_same_v<std::decay_t<T>, char*> ||
+    std::is_same_v<std::decay_t<T>, std::string> || std::is_same_v<std::decay_t<T>, std::string_view>;
+
+// What the decoder reads back: strings become views into the record
+template <typename T>
+using stored_t = std::conditional_t<is_string_arg<T>, std::string_view, std::decay_t<T>>;
+
+inline std::string_view as_view(const char* s) { return s ? std::string_view(s) : std::string_view("(null)"); }
+inline std::string_view as_view(std::string_view s) { return s; }
+
+template <typename T>
+std::size_t encoded_size(const T& value) {
+    if constexpr (is_string_arg<T>) {
+        return sizeof(uint32_t) + as_view(value).size();
+    } else {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>,
+                      "log arguments must be numbers, enums, pointers or strings");
+        return sizeof(T);
+    }
+}
+
+template <typename T>
+std::byte* encode(std::byte* out, const T& value) {
+    if constexpr (is_string_arg<T>) {
+        std::string_view text = as_view(value);
+        uint32_t length = static_cast<uint32_t>(text.size());
+        std::memcpy(out, &length, sizeof(length));
+        std::memcpy(out + sizeof(length), text.data(), text.size());
+        return out + sizeof(length) + text.size();
+    } else {
+        std::memcpy(out, &value, sizeof(T));
+        return out + sizeof(T);
+    }
+}
+
+template <typename T>
+T decode_one(const std::byte*& in) {
+    if constexpr (std::is_same_v<T, std::string_view>) {
+        uint32_t length;
+        std::memcpy(&length, in, sizeof(length));
+        std::string_view text(reinterpret_cast<const char*>(in + sizeof(length)), length);
+        in += sizeof(length) + length;
+        return text;
+    } else {
+        T value;
+        std::memcpy(&value, in, sizeof(T));
+        in += sizeof(T);
+        return value;
+    }
+}
+
+template <typename T>
+void append_value(std::string& out, const T& value) {
+    if constexpr (std::is_same_v<T, std::string_view>) {
+        out.append(value);
+    } else if constexpr (std::is_same_v<T, bool>) {
+        out.append(value ? "true" : "false");
+    } else if constexpr (std::is_same_v<T, char>) {
+        out.push_back(value);
+    } else if constexpr (std::is_enum_v<T>) {
+        append_value(out, static_cast<std::underlying_type_t<T>>(value));
+    } else if constexpr (std::is_pointer_v<T>) {
+        char buffer[2 + 16];
+        buffer[0] = '0';
+        buffer[1] = 'x';
+        auto result = std::to_chars(buffer + 2, buffer + sizeof(buffer), reinterpret_cast<uintptr_t>(value), 16);
+        out.append(buffer, result.ptr);
+    } else {
+        char buffer[64];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, result.ptr);
+    }
+}
+
+// Copy literal text up to the next "{}" and step past it. At the end of the
+// format the remaining arguments are appended separated by spaces.
+inline void copy_to_placeholder(const char*& format, std::string& out) {
+    const char* brace = std::strstr(format, "{}");
+    if (!brace) {
+        out.append(format);
+        format += std::strlen(format);
+        out.push_back(' ');
+        return;
+    }
+    out.append(format, brace);
+    format = brace + 2;
+}
+
+template <typename... Args>
+void decode_record(const char* format, const std::byte* args, std::string& out) {
+    // The comma fold evaluates left to right, in argument order
+    ((copy_to_placeholder(format, out), append_value(out, decode_one<Args>(args))), ...);
+    out.append(format);
+}
+
+// --- SECTION 3: Per-Thread Byte Ring ---
+
+// Single-producer / single-consumer ring of variable-size records. A record
+// never wraps: if it does not fit before the end, the producer writes a wrap
+// marker there and starts the record at offset 0.
+class log_buffer {
+public:
+    log_buffer(std::size_t capacity, uint32_t thread_number)
+        : capacity_(round_up(capacity)), mask_(capacity_ - 1), data_(new std::byte[capacity_]),
+          thread_number_(thread_number) {}
+
+    // --- Producer side ---
+
+    // Contiguous space for `bytes` (a multiple of 8), or nullptr if the ring is full
+    std::byte* reserve(std::size_t bytes) noexcept {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t offset = tail & mask_;
+        std::size_t until_end = capacity_ - offset;
+        skip_ = until_end < bytes ? until_end : 0;
+        std::size_t needed = bytes + skip_;
+        if (capacity_ - (tail - head_cache_) < needed) {
+            head_cache_ = head_.load(std::memory_order_acquire);  // Only now touch the consumer's line
+            if (capacity_ - (tail - head_cache_) < needed) return nullptr;
+        }
+        if (skip_) {
+            record_header marker{};
+            marker.size = static_cast<uint32_t>(skip_);
+            marker.level = wrap_marker;
+            std::memcpy(data_.get() + offset, &marker, sizeof(uint32_t) + 1);  // size and level only
+            return data_.get();
+        }
+        return data_.get() + offset;
+    }
+
+    void commit(std::size_t bytes) noexcept {
+        tail_.store(tail_.load(std::memory_order_relaxed) + skip_ + bytes, std::memory_order_release);
+    }
+
+    // --- Consumer side ---
+
+    std::size_t head() const noexcept { return head_.load(std::memory_order_relaxed); }
+    std::size_t tail() const noexcept { return tail_.load(std::memory_order_acquire); }
+    const std::byte* at(std::size_t position) const noexcept { return data_.get() + (position & mask_); }
+    void release_to(std::size_t position) noexcept { head_.store(position, std::memory_order_release); }
+
+    std::size_t capacity() const noexcept { return capacity_; }
+    uint32_t thread_number() const noexcept { return thread_number_; }
+
+    std::atomic<uint64_t> dropped{0};     // Written by the producer, read by the backend
+    std::atomic<bool> retired{false};     // The producing thread has exited
+
+private:
+    static std::size_t round_up(std::size_t capacity) {
+        std::size_t size = 4096;
+        while (size < capacity) size <<= 1;
+        return size;
+    }
+
+    const std::size_t capacity_;
+    const std::size_t mask_;
+    std::unique_ptr<std::byte[]> data_;
+    const uint32_t thread_number_;
+
+    alignas(cache_line_size) std::atomic<std::size_t> tail_{0};
+    std::size_t head_cache_ = 0;  // Producer's copy of head_
+    std::size_t skip_ = 0;        // Wrap padding of the pending reservation
+    alignas(cache_line_size) std::atomic<std::size_t> head_{0};
+};
+
+}  // namespace async_logger_detail
+
+// --- SECTION 4: The Logger ---
+
+struct async_logger_options {
+    std::size_t buffer_bytes = std::size_t(1) << 20;  // Per thread; rounded up to a power of two
+    log_overflow overflow = log_overflow::drop;
+    log_level min_level = log_level::info;
+    std::ostream* sink = &std::cout;                   // Only the backend thread writes to it
+    std::chrono::microseconds poll_interval{500};      // Backend sleep when every buffer is empty
+};
+
+class async_logger {
+public:
+    explicit async_logger(async_logger_options options = {})
+        : options_(options), min_level_(options.min_level), id_(next_logger_id()) {
+        start_ticks_ = tsc_clock::now();
+        start_time_ = std::chrono::system_clock::now();
+        backend_ = std::thread([this] { backend_loop(); });
+    }
+
+    ~async_logger() {
+        stopping_.store(true, std::memory_order_release);
+        backend_.join();  // The backend drains everything before it exits
+    }
+
+    async_logger(const async_logger&) = delete;
+    async_logger& operator=(const async_logger&) = delete;
+
+    template <std::size_t N, typename... Args>
+    bool debug(const char (&format)[N], const Args&... args) {
+        return log(log_level::debug, format, args...);
+    }
+    template <std::size_t N, typename... Args>
+    bool info(const char (&format)[N], const Args&... args) {
+        return log(log_level::info, format, args...);
+    }
+    template <std::size_t N, typename... Args>
+    bool warning(const char (&format)[N], const Args&... args) {
+        return log(log_level::warning, format, args...);
+    }
+    template <std::size_t N, typename... Args>
+    bool error(const char (&format)[N], const Args&... args) {
+        return log(log_level::error, format, args...);
+    }
+
+    // Hot path: a timestamp, a few stores into this thread's ring and one
+    // release store. False if the record was dropped or filtered out.
+    template <std::size_t N, typename... Args>
+    bool log(log_level level, const char (&format)[N], const Args&... args) {
+        namespace detail = async_logger_detail;
+        if (level < min_level_.load(std::memory_order_relaxed)) return false;
+        uint64_t timestamp = tsc_clock::now();
+        std::size_t size = sizeof(detail::record_header) + (std::size_t(0) + ... + detail::encoded_size(args));
+        size = (size + detail::record_alignment - 1) & ~(detail::record_alignment - 1);
+
+        detail::log_buffer& buffer = local_buffer();
+        if (size > buffer.capacity() / 4) {  // Could never be guaranteed room
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        std::byte* out = buffer.reserve(size);
+        for (std::size_t spin = 0; !out; ++spin) {
+            if (options_.overflow == log_overflow::drop) {
+                buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (spin < default_spin_iterations()) {
+                cpu_relax();
+            } else {
+                std::this_thread::yield();
+            }
+            out = buffer.reserve(size);
+        }
+
+        detail::record_header header{};
+        header.size = static_cast<uint32_t>(size);
+        header.level = static_cast<uint8_t>(level);
+        header.timestamp = timestamp;
+        header.format = format;
+        header.decode = &detail::decode_record<detail::stored_t<Args>...>;
+        std::memcpy(out, &header, sizeof(header));
+        std::byte* cursor = out + sizeof(header);
+        ((cursor = detail::encode(cursor, args)), ...);
+        buffer.commit(size);
+        return true;
+    }
+
+    void set_min_level(log_level level) noexcept { min_level_.store(level, std::memory_order_relaxed); }
+
+    // Block until everything logged before the call has been written to the sink
+    void flush() {
+        uint64_t target = passes_.load(std::memory_order_acquire) + 2;  // The pass in progress may have missed it
+        flush_requested_.store(true, std::memory_order_release);
+        while (passes_.load(std::memory_order_acquire) < target) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    uint64_t written() const noexcept { return written_.load(std::memory_order_relaxed); }
+
+    uint64_t dropped() const {
+        std::lock_guard<std::mutex> lock(registry_mutex_);
+        uint64_t total = retired_dropped_;
+        for (const auto& buffer : buffers_) total += buffer->dropped.load(std::memory_order_relaxed);
+        return total;
+    }
+
+private:
+    using buffer_ptr = std::shared_ptr<async_logger_detail::log_buffer>;
+
+    // A thread's buffers, one per logger it has used. When the thread exits
+    // they are marked retired; the backend drains and frees them.
+    struct thread_buffers {
+        std::vector<std::pair<uint64_t, buffer_ptr>> entries;  // (logger id, buffer)
+        ~thread_buffers() {
+            for (auto& entry : entries) entry.second->retired.store(true, std::memory_order_release);
+        }
+    };
+
+    static uint64_t next_logger_id() {
+        static std::atomic<uint64_t> next{1};
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    async_logger_detail::log_buffer& local_buffer() {
+        thread_local thread_buffers local;
+        for (auto& [id, buffer] : local.entries) {
+            if (id == id_) return *buffer;
+        }
+        auto buffer = std::make_shared<async_logger_detail::log_buffer>(
+            options_.buffer_bytes, next_thread_number_.fetch_add(1, std::memory_order_relaxed));
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex_);
+            buffers_.push_back(buffer);
+            registry_version_.fetch_add(1, std::memory_order_release);
+        }
+        local.entries.emplace_back(id_, buffer);
+        return *buffer;
+    }
+
+    // --- Backend ---
+
+    struct pending_record {
+        uint64_t timestamp;
+        uint32_t thread_number;
+        const async_logger_detail::record_header* header;
+    };
+
+    void backend_loop() {
+        ns_per_tick_ = tsc_clock::ns_per_tick();  // Calibrating sleeps; keep it out of the first caller's way
+        for (;;) {
+            bool stopping = stopping_.load(std::memory_order_acquire);
+            std::size_t records = drain();
+            passes_.fetch_add(1, std::memory_order_release);
+            if (stopping) {
+                // Threads may still have logged between the load and the drain
+                while (drain() > 0) {
+                }
+                passes_.fetch_add(1, std::memory_order_release);
+                return;
+            }
+            if (records == 0 && !flush_requested_.exchange(false, std::memory_order_acq_rel)) {
+                std::this_thread::sleep_for(options_.poll_interval);
+            }
+        }
+    }
+
+    // One pass: collect what every ring holds, sort it by time, format it into
+    // a single batch, write the batch, then hand the space back
+    std::size_t drain() {
+        namespace detail = async_logger_detail;
+        uint64_t version = registry_version_.load(std::memory_order_acquire);
+        if (version != seen_version_) {
+            std::lock_guard<std::mutex> lock(registry_mutex_);
+            snapshot_ = buffers_;
+            seen_version_ = version;
+        }
+
+        pending_.clear();
+        ends_.assign(snapshot_.size(), 0);
+        for (std::size_t b = 0; b < snapshot_.size(); ++b) {
+            detail::log_buffer& buffer = *snapshot_[b];
+            std::size_t position = buffer.head();
+            std::size_t tail = buffer.tail();
+            while (position != tail) {
+                const auto* header = reinterpret_cast<const detail::record_header*>(buffer.at(position));
+                if (header->level != detail::wrap_marker) {
+                    pending_.push_back({header->timestamp, buffer.thread_number(), header});
+                }
+                position += header->size;
+            }
+            ends_[b] = position;
+        }
+        // Each ring is already in time order; a stable sort merges them
+        std::stable_sort(pending_.begin(), pending_.end(),
+                         [](const pending_record& a, const pending_record& b) { return a.timestamp < b.timestamp; });
+
+        batch_.clear();
+        for (const pending_record& record : pending_) {
+            format_prefix(record);
+            record.header->decode(record.header->format,
+                                  reinterpret_cast<const std::byte*>(record.header + 1), batch_);
+            batch_.push_back('\n');
+        }
+        report_drops();
+        if (!batch_.empty()) {
+            options_.sink->write(batch_.data(), static_cast<std::streamsize>(batch_.size()));
+            options_.sink->flush();
+        }
+        for (std::size_t b = 0; b < snapshot_.size(); ++b) snapshot_[b]->release_to(ends_[b]);
+        written_.fetch_add(pending_.size(), std::memory_order_relaxed);
+        remove_retired();
+        return pending_.size();
+    }
+
+    // "HH:MM:SS.uuuuuu LEVEL [Tn] "; the broken-down time is cached per second
+    void format_prefix(const pending_record& record) {
+        static constexpr const char* level_names[] = {"DEBUG ", "INFO  ", "WARN  ", "ERROR "};
+        int64_t elapsed_ns =
+            static_cast<int64_t>(static_cast<double>(record.timestamp - start_ticks_) * ns_per_tick_);
+        auto when = start_time_ + std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                                      std::chrono::nanoseconds(elapsed_ns));
+        auto since_epoch = std::chrono::duration_cast<std::chrono::microseconds>(when.time_since_epoch()).count();
+        std::time_t seconds = static_cast<std::time_t>(since_epoch / 1000000);
+        if (seconds != cached_second_) {
+            std::tm parts{};
+            localtime_r(&seconds, &parts);
+            std::strftime(cached_clock_, sizeof(cached_clock_), "%H:%M:%S.", &parts);
+            cached_second_ = seconds;
+        }
+        batch_.append(cached_clock_);
+        char micros[8];
+        long fraction = static_cast<long>(since_epoch % 1000000);
+        for (int digit = 5; digit >= 0; --digit, fraction /= 10) micros[digit] = static_cast<char>('0' + fraction % 10);
+        batch_.append(micros, 6);
+        batch_.push_back(' ');
+        batch_.append(level_names[record.header->level]);
+        batch_.append("[T");
+        async_logger_detail::append_value(batch_, record.thread_number);
+        batch_.append("] ");
+    }
+
+    // Dropped records cannot be shown, but their number can
+    void report_drops() {
+        uint64_t total = retired_dropped_;
+        for (const auto& buffer : snapshot_) total += buffer->dropped.load(std::memory_order_relaxed);
+        if (total > reported_dropped_) {
+            batch_.append("[async_logger] dropped ");
+            async_logger_detail::append_value(batch_, total - reported_dropped_);
+            batch_.append(" records (buffer full)\n");
+            reported_dropped_ = total;
+        }
+    }
+
+    // Free buffers of exited threads once they are empty
+    void remove_retired() {
+        bool any = false;
+        for (const auto& buffer : snapshot_) {
+            any = any || (buffer->retired.load(std::memory_order_acquire) && buffer->head() == buffer->tail());
+        }
+        if (!any) return;
+        std::lock_guard<std::mutex> lock(registry_mutex_);
+        auto done = [this](const buffer_ptr& buffer) {
+            if (!buffer->retired.load(std::memory_order_acquire) || buffer->head() != buffer->tail()) return false;
+            retired_dropped_ += buffer->dropped.load(std::memory_order_relaxed);
+            return true;
+        };
+        buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(), done), buffers_.end());
+        snapshot_ = buffers_;
+        seen_version_ = registry_version_.fetch_add(1, std::memory_order_acq_rel) + 1;
+    }
+
+    async_logger_options options_;
+    std::atomic<log_level> min_level_;
+    const uint64_t id_;
+    std::atomic<uint32_t> next_thread_number_{1};
+
+    mutable std::mutex registry_mutex_;  // Taken on a thread's first log call, never on the hot path
+    std::vector<buffer_ptr> buffers_;
+    uint64_t retired_dropped_ = 0;       // Drops of buffers already freed
+    std::atomic<uint64_t> registry_version_{0};
+
+    // Backend state
+    uint64_t start_ticks_ = 0;
+    std::chrono::system_clock::time_point start_time_;
+    double ns_per_tick_ = 1.0;
+    uint64_t seen_version_ = ~uint64_t(0);
+    std::vector<buffer_ptr> snapshot_;
+    std::vector<std::size_t> ends_;
+    std::vector<pending_record> pending_;
+    std::string batch_;
+    std::time_t cached_second_ = -1;
+    char cached_clock_[16] = {};
+    uint64_t reported_dropped_ = 0;
+
+    std::atomic<uint64_t> written_{0};
+    std::atomic<uint64_t> passes_{0};
+    std::atomic<bool> flush_requested_{false};
+    std::atomic<bool> stopping_{false};
+    std::thread backend_;
+};
+
+// Process-wide logger writing to std::cout, started on first use
+inline async_logger& default_logger() {
+    static async_logger logger;
+    return logger;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+// Small benchmarking helpers shared by the performance demos.
+// Each demo is still a single translation unit, so this header is simply included
+// and compiled along with it (e.g. g++ -std=c++20 -O2 -pthread performance_tuning.cpp).
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "alloc_tracker.hpp"  // Allocation counts per iteration (with -DENABLE_ALLOC_TRACKER)
+
+// Prevent the optimizer from discarding a value that is computed but never used
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Prevent the optimizer from assuming memory has not changed between iterations
+inline void clobber_memory() {
+    asm volatile("" : : : "memory");
+}
+
+// Result of one benchmark run
+struct benchmark_result {
+    std::string name;
+    std::size_t iterations = 0;
+    double seconds = 0.0;
+    uint64_t allocations = 0;      // Only counted when the allocation tracker is enabled
+    uint64_t bytes_allocated = 0;
+
+    double nanoseconds_per_iteration() const {
+        return iterations ? seconds * 1e9 / static_cast<double>(iterations) : 0.0;
+    }
+    double allocations_per_iteration() const {
+        return iterations ? static_cast<double>(allocations) / static_cast<double>(iterations) : 0.0;
+    }
+};
+
+// Print a benchmark result in the same "X took: N seconds" style used by the demos
+inline void print_benchmark_result(const benchmark_result& result, double bytes_per_iteration = 0.0) {
+    std::cout << "  " << std::left << std::setw(40) << result.name << std::right
+              << std::fixed << std::setprecision(6) << result.seconds << " seconds, "
+              << std::setprecision(2) << std::setw(10) << result.nanoseconds_per_iteration() << " ns/iter";
+    if (bytes_per_iteration > 0.0 && result.seconds > 0.0) {
+        double gigabytes = bytes_per_iteration * static_cast<double>(result.iterations) / 1e9;
+        std::cout << ", " << std::setw(7) << gigabytes / result.seconds << " GB/s";
+    }
+    if (alloc_tracker_enabled) {
+        std::cout << ", " << std::setw(8) << result.allocations_per_iteration() << " allocs/iter ("
+                  << std::setprecision(0) << static_cast<double>(result.bytes_allocated) / result.iterations
+                  << " B)";
+    }
+    std::cout << std::defaultfloat << "\n";
+}
+
+// Run fn() once to warm caches, then time `iterations` calls of it
+template <typename Fn>
+benchmark_result run_benchmark(const std::string& name, std::size_t iterations, Fn&& fn,
+                               double bytes_per_iteration = 0.0) {
+    fn();  // Warm-up run (page faults, caches, lazy initialization)
+
+    alloc_stats allocs_before = alloc_tracker_totals();
+    auto start = std::chrono::high_resolution_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        fn();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    alloc_stats allocs_after = alloc_tracker_totals();
+
+    benchmark_result result;
+    result.name = name;
+    result.iterations = iterations;
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.allocations = allocs_after.allocations - allocs_before.allocations;
+    result.bytes_allocated = allocs_after.bytes_allocated - allocs_before.bytes_allocated;
+    print_benchmark_result(result, bytes_per_iteration);
+    return result;
+}
@@ -0,0 +1,320 @@
+#pragma once
+
+// Block-buffered byte input for checksums and scanners.
+//
+// istream::get(ch) runs the sentry, a virtual underflow check and the stream
+// state bookkeeping for every single byte. byte_reader hands out whole blocks
+// instead: the caller looks at a contiguous span, consumes what it used and
+// asks for more.
+//
+//   peek()             - the unconsumed bytes, refilling first if there are none
+//   consume(n)         - mark n of them as used
+//   refill()           - append more input to the unconsumed bytes
+//   ensure(n)          - refill until at least n bytes are available (or EOF)
+//   for_each_byte(fn)  - fn(uint8_t) for every remaining byte; fn is a template
+//                        argument, so the compiler inlines it into the loop
+//   for_each_chunk(fn) - fn(span) for every block
+//
+// Read-ahead, so the disk works while the caller computes:
+//   none     - plain read() calls of buffer_size bytes
+//   fadvise  - POSIX_FADV_SEQUENTIAL on open, then POSIX_FADV_WILLNEED for the
+//              next few buffers after each read; the kernel reads ahead async
+//   thread   - a background thread read()s into a ring of blocks; a block the
+//              caller has fully consumed goes back to it without any copy.
+//              Works on pipes too; destroying the reader waits for a read()
+//              that is still blocked.
+//
+// Usage:
+//   byte_reader reader("data.bin");
+//   uint32_t crc = 0;
+//   reader.for_each_byte([&](uint8_t b) { crc = update(crc, b); });
+//
+//   while (!(bytes = reader.peek()).empty()) {     // Block at a time
+//       std::size_t used = parse(bytes);           // May stop mid-record...
+//       if (used == 0 && !reader.refill()) break;  // ...and ask for more
+//       reader.consume(used);
+//   }
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "futex.hpp"  // futex_wait, futex_wake
+
+// --- SECTION 1: Options ---
+
+enum class byte_read_ahead { none, fadvise, thread };
+
+struct byte_reader_options {
+    std::size_t buffer_size = 256 * 1024;  // Bytes per read()
+    byte_read_ahead read_ahead = byte_read_ahead::fadvise;
+    std::size_t read_ahead_buffers = 4;    // fadvise: how far ahead to ask; thread: blocks in the ring
+};
+
+namespace byte_reader_detail {
+
+// read() that retries on EINTR and throws on failure
+inline std::size_t read_some(int fd, uint8_t* out, std::size_t size) {
+    ssize_t n;
+    do {
+        n = ::read(fd, out, size);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) throw std::system_error(errno, std::generic_category(), "byte_reader: read");
+    return static_cast<std::size_t>(n);
+}
+
+}  // namespace byte_reader_detail
+
+// --- SECTION 2: Byte Reader ---
+
+class byte_reader {
+public:
+    // Opens `path`; throws std::system_error if it cannot be opened
+    explicit byte_reader(const std::string& path, byte_reader_options options = {}) : options_(options) {
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0) throw std::system_error(errno, std::generic_category(), "byte_reader: open " + path);
+        try {
+            init();
+        } catch (...) {
+            ::close(fd_);
+            throw;
+        }
+        owns_fd_ = true;
+    }
+
+    // Reads from an already open descriptor without closing it
+    explicit byte_reader(int fd, byte_reader_options options = {}) : options_(options), fd_(fd) { init(); }
+
+    byte_reader(const byte_reader&) = delete;
+    byte_reader& operator=(const byte_reader&) = delete;
+
+    ~byte_reader() {
+        if (reader_.joinable()) {
+            stopping_.store(true, std::memory_order_relaxed);
+            for (block& b : blocks_) {
+                b.state.store(block_empty, std::memory_order_release);
+                futex_wake(b.state);
+            }
+            reader_.join();
+        }
+        if (owns_fd_) ::close(fd_);
+    }
+
+    // Unconsumed bytes; valid until the next refill(), ensure() or peek()
+    std::span<const uint8_t> buffered() const noexcept { return {view_ + pos_, end_ - pos_}; }
+
+    // Unconsumed bytes, refilling first if there are none. Empty only at the end.
+    std::span<const uint8_t> peek() {
+        if (pos_ == end_) refill();
+        return buffered();
+    }
+
+    void consume(std::size_t n) noexcept {
+        n = std::min(n, end_ - pos_);
+        pos_ += n;
+        consumed_ += n;
+    }
+
+    // Appends more input behind the unconsumed bytes; false at the end of input
+    // (the unconsumed bytes stay available). Throws std::system_error on read errors.
+    bool refill() {
+        if (eof_) return false;
+        return options_.read_ahead == byte_read_ahead::thread ? refill_from_ring() : refill_direct();
+    }
+
+    // Refills until at least n bytes are buffered or the input ends
+    std::span<const uint8_t> ensure(std::size_t n) {
+        while (end_ - pos_ < n && refill()) {
+        }
+        return buffered();
+    }
+
+    template <typename Fn>
+    void for_each_byte(Fn&& fn) {
+        for (std::span<const uint8_t> bytes = peek(); !bytes.empty(); bytes = peek()) {
+            const uint8_t* p = bytes.data();
+            const uint8_t* end = p + bytes.size();
+            for (; p != end; ++p) fn(*p);
+            consume(bytes.size());
+        }
+    }
+
+    template <typename Fn>
+    void for_each_chunk(Fn&& fn) {
+        for (std::span<const uint8_t> bytes = peek(); !bytes.empty(); bytes = peek()) {
+            fn(bytes);
+            consume(bytes.size());
+        }
+    }
+
+    uint64_t consumed() const noexcept { return consumed_; }
+
+private:
+    static constexpr uint32_t block_empty = 0;  // Owned by the background thread
+    static constexpr uint32_t block_full = 1;   // Owned by the caller
+
+    struct block {
+        std::unique_ptr<uint8_t[]> data;
+        std::size_t size = 0;  // 0 = end of input
+        int error = 0;
+        std::atomic<uint32_t> state{block_empty};
+    };
+
+    void init() {
+        options_.buffer_size = std::max<std::size_t>(options_.buffer_size, 4096);
+        options_.read_ahead_buffers = std::max<std::size_t>(options_.read_ahead_buffers, 2);
+        struct stat st;
+        bool regular = fstat(fd_, &st) == 0 && S_ISREG(st.st_mode);
+
+        if (options_.read_ahead == byte_read_ahead::thread) {
+            blocks_ = std::vector<block>(options_.read_ahead_buffers);
+            for (block& b : blocks_) b.data.reset(new uint8_t[options_.buffer_size]);
+            reader_ = std::thread([this] { read_ahead_loop(); });
+            return;
+        }
+        if (options_.read_ahead == byte_read_ahead::fadvise) {
+            off_t offset = regular ? lseek(fd_, 0, SEEK_CUR) : -1;
+            if (offset >= 0) {
+                posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+                file_offset_ = offset;
+            } else {
+                options_.read_ahead = byte_read_ahead::none;  // Pipes have nothing to advise
+            }
+        }
+        capacity_ = options_.buffer_size;
+        buffer_.reset(new uint8_t[capacity_]);
+        view_ = buffer_.get();
+    }
+
+    bool refill_direct() {
+        if (pos_ > 0) {
+            std::memmove(buffer_.get(), buffer_.get() + pos_, end_ - pos_);
+            end_ -= pos_;
+            pos_ = 0;
+        }
+        if (capacity_ - end_ < options_.buffer_size / 2) {  // Mostly unconsumed: grow instead of reading a sliver
+            std::unique_ptr<uint8_t[]> bigger(new uint8_t[capacity_ * 2]);
+            std::memcpy(bigger.get(), buffer_.get(), end_);
+            buffer_ = std::move(bigger);
+            capacity_ *= 2;
+            view_ = buffer_.get();
+        }
+        std::size_t n = byte_reader_detail::read_some(fd_, buffer_.get() + end_, capacity_ - end_);
+        if (n == 0) {
+            eof_ = true;
+            return false;
+        }
+        end_ += n;
+        if (options_.read_ahead == byte_read_ahead::fadvise) {
+            file_offset_ += static_cast<off_t>(n);
+            posix_fadvise(fd_, file_offset_, static_cast<off_t>(options_.buffer_size * options_.read_ahead_buffers),
+                          POSIX_FADV_WILLNEED);
+        }
+        return true;
+    }
+
+    // Background thread: fill the ring in order, one block per read()
+    void read_ahead_loop() {
+        for (std::size_t i = 0;; i = (i + 1) % blocks_.size()) {
+            block& b = blocks_[i];
+            for (;;) {
+                if (stopping_.load(std::memory_order_relaxed)) return;
+                if (b.state.load(std::memory_order_acquire) == block_empty) break;
+                futex_wait(b.state, block_full);
+            }
+            try {
+                b.size = byte_reader_detail::read_some(fd_, b.data.get(), options_.buffer_size);
+            } catch (const std::system_error& e) {
+                b.size = 0;
+                b.error = e.code().value();
+            }
+            b.state.store(block_full, std::memory_order_release);
+            futex_wake(b.state);
+            if (b.size == 0) return;  // End of input (or an error) is the last block
+        }
+    }
+
+    bool refill_from_ring() {
+        block& next = blocks_[next_block_];
+        while (next.state.load(std::memory_order_acquire) != block_full) futex_wait(next.state, block_empty);
+        if (next.error != 0) throw std::system_error(next.error, std::generic_category(), "byte_reader: read");
+        if (next.size == 0) {
+            eof_ = true;
+            return false;
+        }
+
+        std::size_t leftover = end_ - pos_;
+        if (leftover == 0) {
+            // Everything consumed: hand out the block itself
+            release_current();
+            view_ = next.data.get();
+            end_ = next.size;
+            current_block_ = static_cast<int>(next_block_);
+        } else {
+            // Unconsumed tail: stitch it and the new block together (a copy, but
+            // only when the caller stopped mid-record)
+            if (view_ == stitch_.data()) {
+                std::memmove(stitch_.data(), stitch_.data() + pos_, leftover);
+                stitch_.resize(leftover + next.size);
+            } else {
+                stitch_.resize(leftover + next.size);
+                std::memcpy(stitch_.data(), view_ + pos_, leftover);
+            }
+            std::memcpy(stitch_.data() + leftover, next.data.get(), next.size);
+            release_current();
+            release(next);
+            view_ = stitch_.data();
+            end_ = stitch_.size();
+        }
+        pos_ = 0;
+        next_block_ = (next_block_ + 1) % blocks_.size();
+        return true;
+    }
+
+    void release_current() {
+        if (current_block_ >= 0) release(blocks_[static_cast<std::size_t>(current_block_)]);
+        current_block_ = -1;
+    }
+
+    static void release(block& b) {
+        b.state.store(block_empty, std::memory_order_release);
+        futex_wake(b.state);
+    }
+
+    byte_reader_options options_;
+    int fd_ = -1;
+    bool owns_fd_ = false;
+    bool eof_ = false;
+
+    const uint8_t* view_ = nullptr;  // Buffered bytes are view_[pos_, end_)
+    std::size_t pos_ = 0;
+    std::size_t end_ = 0;
+    uint64_t consumed_ = 0;
+
+    // none / fadvise
+    std::unique_ptr<uint8_t[]> buffer_;
+    std::size_t capacity_ = 0;
+    off_t file_offset_ = 0;
+
+    // thread
+    std::vector<block> blocks_;
+    std::size_t next_block_ = 0;
+    int current_block_ = -1;
+    std::vector<uint8_t> stitch_;
+    std::atomic<bool> stopping_{false};
+    std::thread reader_;
+};
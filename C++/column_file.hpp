@@ -0,0 +1,706 @@
+#pragma once
+
+// Chunked, checksummed, compressed column files.
+//
+// A raw dump of an int array has no header, no byte order, no length and no
+// integrity check: the reader has to know how many values there are, and a
+// flipped bit or a truncated copy reads back as silently wrong numbers. A
+// column file stores one column of integers (int32/uint32/int64/uint64) or of
+// fixed-width records:
+//
+//   header    32 bytes: magic "COLCHUNK", version, codec, kind, value width,
+//             values per chunk, CRC32C of the header
+//   chunk*    16-byte chunk header (payload bytes, value count, CRC32C of the
+//             payload, CRC32C of the chunk header), then the encoded payload.
+//             Every chunk but the last holds exactly `values_per_chunk` values.
+//   footer    per chunk: file offset and index of its first value, so any
+//             chunk (and so any value) is reachable without reading the others
+//   trailer   32 bytes at the very end: footer offset, value count, chunk
+//             count, footer CRC32C, trailer CRC32C, "CEND"
+//
+// All numbers are little-endian, whatever the host. Codecs for integers:
+//
+//   raw            - values as they are
+//   delta_varint   - zigzag-encoded differences as LEB128 varints (1 byte for
+//                    a difference in [-64, 63])
+//   delta_bitpack  - zigzag differences bit-packed in blocks of 128 at the width
+//                    of the block's largest one: sorted or slowly changing data
+//                    (timestamps, ids, counters) shrinks to a few bits a value,
+//                    and decoding is one unaligned load and shift per value
+//
+// Record columns are stored raw. CRC32C uses the SSE4.2 crc32 instruction
+// when the CPU has it (8 bytes per instruction) and slice-by-8 tables otherwise.
+//
+// Chunks are encoded, written, checked and decoded independently, so the writer
+// and read_all() spread them over a thread_pool (the shared one by default).
+// Damage is reported as std::runtime_error; asking for the wrong value type
+// as std::invalid_argument.
+//
+// Usage:
+//   std::vector<int64_t> timestamps = ...;
+//   write_column_file<int64_t>("ts.col", timestamps);
+//
+//   column_file_reader reader("ts.col");
+//   std::vector<int64_t> all = reader.read_all<int64_t>();   // Parallel decode
+//   int64_t last = reader.at<int64_t>(reader.size() - 1);    // Decodes one chunk
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "line_reader.hpp"   // mapped_file
+#include "parallel_for.hpp"  // parallel_for, shared_thread_pool
+#include "simd_kernels.hpp"  // detect_cpu_features
+
+enum class column_codec : uint16_t { raw = 0, delta_varint = 1, delta_bitpack = 2 };
+
+enum class column_kind : uint8_t { signed_int = 1, unsigned_int = 2, record = 3 };
+
+inline const char* column_codec_name(column_codec codec) {
+    switch (codec) {
+        case column_codec::raw: return "raw";
+        case column_codec::delta_varint: return "delta+varint";
+        case column_codec::delta_bitpack: return "delta+bitpack";
+    }
+    return "unknown";
+}
+
+struct column_file_options {
+    column_codec codec = column_codec::delta_bitpack;
+    uint32_t values_per_chunk = 64 * 1024;
+};
+
+struct column_chunk_info {
+    uint64_t offset = 0;       // Of the chunk header
+    uint64_t first_value = 0;  // Index of the chunk's first value in the column
+    uint32_t value_count = 0;
+    uint32_t stored_bytes = 0;  // Encoded payload size
+};
+
+// --- SECTION 1: CRC32C ---
+
+namespace column_file_detail {
+
+template <typename U>
+inline U to_little_endian(U value) noexcept {
+    if constexpr (std::endian::native == std::endian::big && sizeof(U) == 8) return __builtin_bswap64(value);
+    if constexpr (std::endian::native == std::endian::big && sizeof(U) == 4) return __builtin_bswap32(value);
+    if constexpr (std::endian::native == std::endian::big && sizeof(U) == 2) return __builtin_bswap16(value);
+    return value;
+}
+
+template <typename U>
+inline U load_le(const uint8_t* p) noexcept {
+    U value;
+    std::memcpy(&value, p, sizeof value);
+    return to_little_endian(value);
+}
+
+template <typename U>
+inline void store_le(uint8_t* p, U value) noexcept {
+    value = to_little_endian(value);
+    std::memcpy(p, &value, sizeof value);
+}
+
+// Slice-by-8: table k advances the CRC over a byte followed by k zero bytes
+struct crc32c_tables {
+    uint32_t t[8][256];
+};
+
+constexpr crc32c_tables make_crc32c_tables() {
+    crc32c_tables tables{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1)));  // Reflected Castagnoli
+        tables.t[0][i] = crc;
+    }
+    for (int k = 1; k < 8; ++k) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t previous = tables.t[k - 1][i];
+            tables.t[k][i] = (previous >> 8) ^ tables.t[0][previous & 0xff];
+        }
+    }
+    return tables;
+}
+
+inline constexpr crc32c_tables crc32c_table = make_crc32c_tables();
+
+inline uint32_t crc32c_software(uint32_t crc, const uint8_t* p, std::size_t n) noexcept {
+    const auto& t = crc32c_table.t;
+    crc = ~crc;
+    for (; n >= 8; p += 8, n -= 8) {
+        uint64_t word = load_le<uint64_t>(p) ^ crc;
+        crc = t[7][word & 0xff] ^ t[6][(word >> 8) & 0xff] ^ t[5][(word >> 16) & 0xff] ^ t[4][(word >> 24) & 0xff] ^
+              t[3][(word >> 32) & 0xff] ^ t[2][(word >> 40) & 0xff] ^ t[1][(word >> 48) & 0xff] ^ t[0][word >> 56];
+    }
+    for (; n > 0; ++p, --n) crc = t[0][(crc ^ *p) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+#ifdef SIMD_KERNELS_X86
+__attribute__((target("sse4.2"))) inline uint32_t crc32c_hardware(uint32_t crc, const uint8_t* p,
+                                                                  std::size_t n) noexcept {
+    uint64_t c = ~crc;
+    for (; n >= 8; p += 8, n -= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        c = _mm_crc32_u64(c, word);
+    }
+    for (; n > 0; ++p, --n) c = _mm_crc32_u8(static_cast<uint32_t>(c), *p);
+    return ~static_cast<uint32_t>(c);
+}
+#endif
+
+}  // namespace column_file_detail
+
+// CRC32C (Castagnoli) of n bytes; pass a previous result as `crc` to continue it
+inline uint32_t crc32c(const void* data, std::size_t n, uint32_t crc = 0) noexcept {
+    const auto* p = static_cast<const uint8_t*>(data);
+#ifdef SIMD_KERNELS_X86
+    static const bool hardware = detect_cpu_features().sse42;
+    if (hardware) return column_file_detail::crc32c_hardware(crc, p, n);
+#endif
+    return column_file_detail::crc32c_software(crc, p, n);
+}
+
+// --- SECTION 2: Codecs ---
+
+namespace column_file_detail {
+
+inline constexpr std::size_t bitpack_block = 128;
+
+template <typename U>
+inline U zigzag(U delta) noexcept {
+    using S = std::make_signed_t<U>;
+    return static_cast<U>(delta << 1) ^ static_cast<U>(static_cast<S>(delta) >> (sizeof(U) * 8 - 1));
+}
+
+template <typename U>
+inline U unzigzag(U z) noexcept {
+    return static_cast<U>(z >> 1) ^ static_cast<U>(U(0) - (z & 1));
+}
+
+[[noreturn]] inline void corrupt(const std::string& what) {
+    throw std::runtime_error("column_file: " + what);
+}
+
+template <typename U>
+void encode_raw(const U* values, std::size_t n, std::vector<uint8_t>& out) {
+    std::size_t start = out.size();
+    out.resize(start + n * sizeof(U));
+    if constexpr (std::endian::native == std::endian::little) {
+        std::memcpy(out.data() + start, values, n * sizeof(U));
+    } else {
+        for (std::size_t i = 0; i < n; ++i) store_le(out.data() + start + i * sizeof(U), values[i]);
+    }
+}
+
+template <typename U>
+void decode_raw(const uint8_t* p, std::size_t size, std::size_t n, U* out) {
+    if (size != n * sizeof(U)) corrupt("raw chunk has the wrong size");
+    if constexpr (std::endian::native == std::endian::little) {
+        std::memcpy(out, p, size);
+    } else {
+        for (std::size_t i = 0; i < n; ++i) out[i] = load_le<U>(p + i * sizeof(U));
+    }
+}
+
+template <typename U>
+void encode_delta_varint(const U* values, std::size_t n, std::vector<uint8_t>& out) {
+    U previous = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        U z = zigzag(static_cast<U>(values[i] - previous));
+        previous = values[i];
+        while (z >= 0x80) {
+            out.push_back(static_cast<uint8_t>(z | 0x80));
+            z >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(z));
+    }
+}
+
+template <typename U>
+void decode_delta_varint(const uint8_t* p, std::size_t size, std::size_t n, U* out) {
+    const uint8_t* end = p + size;
+    U previous = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        U z = 0;
+        for (unsigned shift = 0;; shift += 7) {
+            if (p == end || shift >= sizeof(U) * 8) corrupt("truncated varint");
+            uint8_t byte = *p++;
+            z |= static_cast<U>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) break;
+        }
+        previous += unzigzag(z);
+        out[i] = previous;
+    }
+    if (p != end) corrupt("varint chunk has trailing bytes");
+}
+
+// Widths above 56 would not fit the 64-bit load-and-shift; they are stored as 64
+inline unsigned bitpack_width(uint64_t bits_or) noexcept {
+    unsigned width = bits_or == 0 ? 0 : 64 - static_cast<unsigned>(__builtin_clzll(bits_or));
+    return width > 56 ? 64 : width;
+}
+
+// Payload: the first value, then per block of up to 128 differences one width
+// byte and ceil(count * width / 8) packed bytes
+template <typename U>
+void encode_delta_bitpack(const U* values, std::size_t n, std::vector<uint8_t>& out) {
+    if (n == 0) return;
+    std::size_t start = out.size();
+    out.resize(start + sizeof(U));
+    store_le(out.data() + start, values[0]);
+
+    U z[bitpack_block];
+    for (std::size_t base = 1; base < n; base += bitpack_block) {
+        std::size_t count = std::min(bitpack_block, n - base);
+        uint64_t bits_or = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            z[i] = zigzag(static_cast<U>(values[base + i] - values[base + i - 1]));
+            bits_or |= z[i];
+        }
+        unsigned width = bitpack_width(bits_or);
+        out.push_back(static_cast<uint8_t>(width));
+        std::size_t bytes = (count * width + 7) / 8;
+        std::size_t at = out.size();
+        out.resize(at + bytes + 8);  // Slack for the last 64-bit store
+        uint8_t* packed = out.data() + at;
+        std::memset(packed, 0, bytes + 8);
+        if (width == 64) {
+            for (std::size_t i = 0; i < count; ++i) store_le<uint64_t>(packed + i * 8, z[i]);
+        } else if (width > 0) {
+            for (std::size_t i = 0; i < count; ++i) {
+                std::size_t bit = i * width;
+                uint64_t word = load_le<uint64_t>(packed + bit / 8);
+                store_le<uint64_t>(packed + bit / 8, word | (static_cast<uint64_t>(z[i]) << (bit % 8)));
+            }
+        }
+        out.resize(at + bytes);
+    }
+}
+
+// Reads up to 7 bytes past the payload: the caller guarantees they are mapped
+// (a payload is always followed by another chunk or by the footer and trailer)
+template <typename U>
+void decode_delta_bitpack(const uint8_t* p, std::size_t size, std::size_t n, U* out) {
+    if (n == 0) {
+        if (size != 0) corrupt("bitpack chunk has trailing bytes");
+        return;
+    }
+    const uint8_t* end = p + size;
+    if (size < sizeof(U)) corrupt("truncated bitpack chunk");
+    U previous = load_le<U>(p);
+    p += sizeof(U);
+    out[0] = previous;
+    for (std::size_t base = 1; base < n; base += bitpack_block) {
+        std::size_t count = std::min(bitpack_block, n - base);
+        if (p == end) corrupt("truncated bitpack chunk");
+        unsigned width = *p++;
+        std::size_t bytes = (count * width + 7) / 8;
+        if ((width > 56 && width != 64) || static_cast<std::size_t>(end - p) < bytes) {
+            corrupt("bad bitpack block");
+        }
+        U* block = out + base;
+        if (width == 0) {
+            for (std::size_t i = 0; i < count; ++i) block[i] = previous;
+        } else if (width == 64) {
+            for (std::size_t i = 0; i < count; ++i) {
+                previous += unzigzag(static_cast<U>(load_le<uint64_t>(p + i * 8)));
+                block[i] = previous;
+            }
+        } else {
+            const uint64_t mask = (uint64_t(1) << width) - 1;
+            for (std::size_t i = 0; i < count; ++i) {
+                std::size_t bit = i * width;
+                uint64_t z = (load_le<uint64_t>(p + bit / 8) >> (bit % 8)) & mask;
+                previous += unzigzag(static_cast<U>(z));
+                block[i] = previous;
+            }
+        }
+        p += bytes;
+    }
+    if (p != end) corrupt("bitpack chunk has trailing bytes");
+}
+
+// --- SECTION 3: Layout ---
+
+inline constexpr char file_magic[8] = {'C', 'O', 'L', 'C', 'H', 'U', 'N', 'K'};
+inline constexpr char trailer_magic[4] = {'C', 'E', 'N', 'D'};
+inline constexpr uint16_t format_version = 1;
+inline constexpr std::size_t header_size = 32;
+inline constexpr std::size_t chunk_header_size = 16;
+inline constexpr std::size_t footer_entry_size = 16;
+inline constexpr std::size_t trailer_size = 32;
+
+struct file_header {
+    uint16_t version = format_version;
+    column_codec codec = column_codec::raw;
+    column_kind kind = column_kind::record;
+    uint32_t value_width = 0;
+    uint32_t values_per_chunk = 0;
+};
+
+inline void encode_header(const file_header& h, uint8_t* out) {
+    std::memset(out, 0, header_size);
+    std::memcpy(out, file_magic, 8);
+    store_le<uint16_t>(out + 8, h.version);
+    store_le<uint16_t>(out + 10, static_cast<uint16_t>(h.codec));
+    out[12] = static_cast<uint8_t>(h.kind);
+    store_le<uint32_t>(out + 16, h.value_width);
+    store_le<uint32_t>(out + 20, h.values_per_chunk);
+    store_le<uint32_t>(out + 24, crc32c(out, 24));
+}
+
+inline void pwrite_all(int fd, const uint8_t* data, std::size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t n = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::system_error(errno, std::generic_category(), "column_file: write");
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+}
+
+// encode(first_value, value_count, out) appends one chunk's payload to out.
+// Chunks are encoded and written in parallel at offsets known once all are encoded.
+template <typename Encode>
+void write_chunked(const std::string& path, const file_header& header, uint64_t value_count, Encode&& encode,
+                   thread_pool& pool) {
+    uint64_t per_chunk = header.values_per_chunk;
+    std::size_t chunks = static_cast<std::size_t>((value_count + per_chunk - 1) / per_chunk);
+    std::vector<std::vector<uint8_t>> encoded(chunks);
+    parallel_for(
+        index_range{0, chunks}, 1,
+        [&](std::size_t c) {
+            uint64_t first = c * per_chunk;
+            auto count = static_cast<uint32_t>(std::min(per_chunk, value_count - first));
+            std::vector<uint8_t>& out = encoded[c];
+            out.resize(chunk_header_size);
+            encode(first, count, out);
+            std::size_t payload = out.size() - chunk_header_size;
+            if (payload > UINT32_MAX) throw std::invalid_argument("column_file: chunk larger than 4 GiB");
+            store_le<uint32_t>(out.data(), static_cast<uint32_t>(payload));
+            store_le<uint32_t>(out.data() + 4, count);
+            store_le<uint32_t>(out.data() + 8, crc32c(out.data() + chunk_header_size, payload));
+            store_le<uint32_t>(out.data() + 12, crc32c(out.data(), 12));
+        },
+        loop_schedule::dynamic, pool);
+
+    std::vector<uint64_t> offsets(chunks);
+    uint64_t offset = header_size;
+    for (std::size_t c = 0; c < chunks; ++c) {
+        offsets[c] = offset;
+        offset += encoded[c].size();
+    }
+    std::vector<uint8_t> tail(chunks * footer_entry_size + trailer_size);
+    for (std::size_t c = 0; c < chunks; ++c) {
+        store_le<uint64_t>(tail.data() + c * footer_entry_size, offsets[c]);
+        store_le<uint64_t>(tail.data() + c * footer_entry_size + 8, c * per_chunk);
+    }
+    uint8_t* trailer = tail.data() + chunks * footer_entry_size;
+    store_le<uint64_t>(trailer, offset);  // Footer offset
+    store_le<uint64_t>(trailer + 8, value_count);
+    store_le<uint32_t>(trailer + 16, static_cast<uint32_t>(chunks));
+    store_le<uint32_t>(trailer + 20, crc32c(tail.data(), chunks * footer_entry_size));
+    store_le<uint32_t>(trailer + 24, crc32c(trailer, 24));
+    std::memcpy(trailer + 28, trailer_magic, 4);
+
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) throw std::system_error(errno, std::generic_category(), "column_file: open " + path);
+    try {
+        uint8_t head[header_size];
+        encode_header(header, head);
+        pwrite_all(fd, head, header_size, 0);
+        parallel_for(
+            index_range{0, chunks}, 1,
+            [&](std::size_t c) { pwrite_all(fd, encoded[c].data(), encoded[c].size(), offsets[c]); },
+            loop_schedule::dynamic, pool);
+        pwrite_all(fd, tail.data(), tail.size(), offset);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    if (::close(fd) != 0) throw std::system_error(errno, std::generic_category(), "column_file: close " + path);
+}
+
+template <typename T>
+constexpr column_kind kind_of() {
+    return std::is_signed_v<T> ? column_kind::signed_int : column_kind::unsigned_int;
+}
+
+template <typename T>
+constexpr bool is_column_integer =
+    std::is_integral_v<T> && !std::is_same_v<T, bool> && (sizeof(T) == 4 || sizeof(T) == 8);
+
+}  // namespace column_file_detail
+
+// --- SECTION 4: Writer ---
+
+// Write `values` as a column file, replacing `path`. Throws std::system_error
+// on I/O errors and std::invalid_argument for bad options.
+template <typename T>
+void write_column_file(const std::string& path, std::span<const T> values, column_file_options options = {},
+                       thread_pool& pool = shared_thread_pool()) {
+    static_assert(column_file_detail::is_column_integer<T>, "columns hold 32- or 64-bit integers");
+    using U = std::make_unsigned_t<T>;
+    if (options.values_per_chunk == 0) throw std::invalid_argument("column_file: values_per_chunk must be > 0");
+
+    column_file_detail::file_header header;
+    header.codec = options.codec;
+    header.kind = column_file_detail::kind_of<T>();
+    header.value_width = sizeof(T);
+    header.values_per_chunk = options.values_per_chunk;
+    const U* data = reinterpret_cast<const U*>(values.data());
+    column_file_detail::write_chunked(
+        path, header, values.size(),
+        [&](uint64_t first, uint32_t count, std::vector<uint8_t>& out) {
+            switch (options.codec) {
+                case column_codec::raw: column_file_detail::encode_raw(data + first, count, out); break;
+                case column_codec::delta_varint:
+                    column_file_detail::encode_delta_varint(data + first, count, out);
+                    break;
+                case column_codec::delta_bitpack:
+                    column_file_detail::encode_delta_bitpack(data + first, count, out);
+                    break;
+                default: throw std::invalid_argument("column_file: unknown codec");
+            }
+        },
+        pool);
+}
+
+// Write `count` records of `record_size` bytes each. Records are opaque bytes,
+// so only column_codec::raw is accepted.
+inline void write_record_file(const std::string& path, const void* records, std::size_t count, uint32_t record_size,
+                              column_file_options options = {column_codec::raw},
+                              thread_pool& pool = shared_thread_pool()) {
+    if (options.codec != column_codec::raw) throw std::invalid_argument("column_file: records are stored raw");
+    if (record_size == 0 || options.values_per_chunk == 0) {
+        throw std::invalid_argument("column_file: record_size and values_per_chunk must be > 0");
+    }
+    column_file_detail::file_header header;
+    header.codec = column_codec::raw;
+    header.kind = column_kind::record;
+    header.value_width = record_size;
+    header.values_per_chunk = options.values_per_chunk;
+    const auto* bytes = static_cast<const uint8_t*>(records);
+    column_file_detail::write_chunked(
+        path, header, count,
+        [&](uint64_t first, uint32_t n, std::vector<uint8_t>& out) {
+            out.insert(out.end(), bytes + first * record_size, bytes + (first + n) * record_size);
+        },
+        pool);
+}
+
+// --- SECTION 5: Reader ---
+
+// Maps a column file and validates its header, chunk headers, footer and
+// trailer up front; payload checksums are verified as chunks are read.
+class column_file_reader {
+public:
+    // Throws std::system_error if the file cannot be opened or mapped and
+    // std::runtime_error if it is not an intact column file
+    explicit column_file_reader(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw std::system_error(errno, std::generic_category(), "column_file: open " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "column_file: stat " + path);
+        }
+        try {
+            map_ = mapped_file(fd, static_cast<std::size_t>(st.st_size));
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+        ::close(fd);
+        parse();
+    }
+
+    uint16_t version() const noexcept { return header_.version; }
+    column_codec codec() const noexcept { return header_.codec; }
+    column_kind kind() const noexcept { return header_.kind; }
+    uint32_t value_width() const noexcept { return header_.value_width; }
+    uint32_t values_per_chunk() const noexcept { return header_.values_per_chunk; }
+    uint64_t size() const noexcept { return value_count_; }
+    uint64_t file_bytes() const noexcept { return map_.size(); }
+
+    std::size_t chunk_count() const noexcept { return chunks_.size(); }
+    const column_chunk_info& chunk(std::size_t i) const { return chunks_.at(i); }
+
+    // The chunk holding value `index`
+    std::size_t chunk_of(uint64_t index) const {
+        if (index >= value_count_) throw std::out_of_range("column_file: value index out of range");
+        return static_cast<std::size_t>(index / header_.values_per_chunk);
+    }
+
+    // Decode chunk i into out[0, chunk(i).value_count). Verifies its checksum.
+    template <typename T>
+    void read_chunk(std::size_t i, T* out) const {
+        check_type<T>();
+        using U = std::make_unsigned_t<T>;
+        const column_chunk_info& info = chunks_.at(i);
+        const uint8_t* payload = verified_payload(i);
+        U* values = reinterpret_cast<U*>(out);
+        switch (header_.codec) {
+            case column_codec::raw:
+                column_file_detail::decode_raw(payload, info.stored_bytes, info.value_count, values);
+                break;
+            case column_codec::delta_varint:
+                column_file_detail::decode_delta_varint(payload, info.stored_bytes, info.value_count, values);
+                break;
+            case column_codec::delta_bitpack:
+                column_file_detail::decode_delta_bitpack(payload, info.stored_bytes, info.value_count, values);
+                break;
+        }
+    }
+
+    // Record columns: copy chunk i's records to out (value_count * value_width bytes)
+    void read_chunk_records(std::size_t i, void* out) const {
+        if (header_.kind != column_kind::record) throw std::invalid_argument("column_file: not a record column");
+        const column_chunk_info& info = chunks_.at(i);
+        std::memcpy(out, verified_payload(i), info.stored_bytes);
+    }
+
+    // Every value, decoding chunks in parallel
+    template <typename T>
+    std::vector<T> read_all(thread_pool& pool = shared_thread_pool()) const {
+        std::vector<T> values(static_cast<std::size_t>(value_count_));
+        read_into<T>(values, pool);
+        return values;
+    }
+
+    // Same into a caller-owned buffer of exactly size() values (reusing one
+    // saves faulting in fresh pages on every read)
+    template <typename T>
+    void read_into(std::span<T> out, thread_pool& pool = shared_thread_pool()) const {
+        check_type<T>();
+        if (out.size() != value_count_) throw std::invalid_argument("column_file: output size does not match");
+        parallel_for(
+            index_range{0, chunks_.size()}, 1,
+            [&](std::size_t c) { read_chunk(c, out.data() + chunks_[c].first_value); }, loop_schedule::dynamic, pool);
+    }
+
+    // One value: decodes (and checks) the chunk that holds it
+    template <typename T>
+    T at(uint64_t index) const {
+        std::size_t c = chunk_of(index);
+        std::vector<T> values(chunks_[c].value_count);
+        read_chunk(c, values.data());
+        return values[static_cast<std::size_t>(index - chunks_[c].first_value)];
+    }
+
+private:
+    template <typename T>
+    void check_type() const {
+        static_assert(column_file_detail::is_column_integer<T>, "columns hold 32- or 64-bit integers");
+        if (header_.kind != column_file_detail::kind_of<T>() || header_.value_width != sizeof(T)) {
+            throw std::invalid_argument("column_file: value type does not match the file");
+        }
+    }
+
+    const uint8_t* bytes() const noexcept { return reinterpret_cast<const uint8_t*>(map_.data()); }
+
+    const uint8_t* verified_payload(std::size_t i) const {
+        const column_chunk_info& info = chunks_[i];
+        const uint8_t* payload = bytes() + info.offset + column_file_detail::chunk_header_size;
+        uint32_t expected = column_file_detail::load_le<uint32_t>(bytes() + info.offset + 8);
+        if (crc32c(payload, info.stored_bytes) != expected) {
+            column_file_detail::corrupt("chunk " + std::to_string(i) + " checksum mismatch");
+        }
+        return payload;
+    }
+
+    void parse() {
+        using namespace column_file_detail;
+        const std::size_t size = map_.size();
+        if (size < header_size + trailer_size) corrupt("file too small");
+        const uint8_t* p = bytes();
+
+        if (std::memcmp(p, file_magic, 8) != 0) corrupt("not a column file");
+        if (load_le<uint32_t>(p + 24) != crc32c(p, 24)) corrupt("header checksum mismatch");
+        header_.version = load_le<uint16_t>(p + 8);
+        if (header_.version != format_version) corrupt("unsupported version " + std::to_string(header_.version));
+        uint16_t codec = load_le<uint16_t>(p + 10);
+        if (codec > static_cast<uint16_t>(column_codec::delta_bitpack)) corrupt("unknown codec");
+        header_.codec = static_cast<column_codec>(codec);
+        if (p[12] < 1 || p[12] > 3) corrupt("unknown value kind");
+        header_.kind = static_cast<column_kind>(p[12]);
+        header_.value_width = load_le<uint32_t>(p + 16);
+        header_.values_per_chunk = load_le<uint32_t>(p + 20);
+        if (header_.value_width == 0 || header_.values_per_chunk == 0) corrupt("bad header");
+
+        const uint8_t* trailer = p + size - trailer_size;
+        if (std::memcmp(trailer + 28, trailer_magic, 4) != 0 || load_le<uint32_t>(trailer + 24) != crc32c(trailer, 24)) {
+            corrupt("bad trailer (truncated file?)");
+        }
+        uint64_t footer_offset = load_le<uint64_t>(trailer);
+        value_count_ = load_le<uint64_t>(trailer + 8);
+        uint64_t chunk_count = load_le<uint32_t>(trailer + 16);
+        // Every bound below is checked by subtraction: offsets come from the file, and
+        // an addition could wrap around and pass the check with a pointer out of the map
+        const uint64_t footer_end = size - trailer_size;
+        if (footer_offset < header_size || footer_offset > footer_end ||
+            footer_end - footer_offset != chunk_count * footer_entry_size) {
+            corrupt("bad footer position");
+        }
+        uint64_t full_chunks = value_count_ / header_.values_per_chunk;
+        if (chunk_count != full_chunks + (value_count_ % header_.values_per_chunk != 0)) {
+            corrupt("chunk count does not match value count");
+        }
+        const uint8_t* footer = p + footer_offset;
+        if (load_le<uint32_t>(trailer + 20) != crc32c(footer, chunk_count * footer_entry_size)) {
+            corrupt("footer checksum mismatch");
+        }
+
+        chunks_.resize(static_cast<std::size_t>(chunk_count));
+        for (std::size_t c = 0; c < chunks_.size(); ++c) {
+            column_chunk_info& info = chunks_[c];
+            info.offset = load_le<uint64_t>(footer + c * footer_entry_size);
+            info.first_value = load_le<uint64_t>(footer + c * footer_entry_size + 8);
+            if (info.offset < header_size || info.offset > footer_offset ||
+                footer_offset - info.offset < chunk_header_size) {
+                corrupt("bad chunk offset");
+            }
+            const uint8_t* chunk_header = p + info.offset;
+            if (load_le<uint32_t>(chunk_header + 12) != crc32c(chunk_header, 12)) {
+                corrupt("chunk " + std::to_string(c) + " header checksum mismatch");
+            }
+            info.stored_bytes = load_le<uint32_t>(chunk_header);
+            info.value_count = load_le<uint32_t>(chunk_header + 4);
+            uint64_t expected_first = c * uint64_t(header_.values_per_chunk);
+            uint64_t expected_count = std::min<uint64_t>(header_.values_per_chunk, value_count_ - expected_first);
+            if (info.first_value != expected_first || info.value_count != expected_count ||
+                info.stored_bytes > footer_offset - info.offset - chunk_header_size) {
+                corrupt("chunk " + std::to_string(c) + " does not fit the index");
+            }
+            if (header_.kind == column_kind::record &&
+                info.stored_bytes != uint64_t(info.value_count) * header_.value_width) {
+                corrupt("chunk " + std::to_string(c) + " has the wrong size");
+            }
+        }
+    }
+
+    mapped_file map_;
+    column_file_detail::file_header header_;
+    uint64_t value_count_ = 0;
+    std::vector<column_chunk_info> chunks_;
+};
@@ -0,0 +1,866 @@
+#pragma once
+
+// C++20 coroutine runtime: thousands of in-flight operations without a thread
+// (or a blocked thread) per operation.
+//
+//   task<T>            - lazy coroutine: starts when awaited, resumes its awaiter
+//                        by symmetric transfer (no stack growth on long chains)
+//   sync_wait(task)    - block an ordinary thread until a task finishes
+//   when_all(...)      - run several tasks concurrently, resume once all finished
+//   when_any(tasks)    - resume as soon as the first of several tasks finished
+//   pool_scheduler     - co_await sched.schedule() moves the coroutine onto a
+//                        thread_pool worker; spawn() starts a detached task there
+//   timer_service      - co_await timers.sleep_for(10ms) suspends, no thread sleeps
+//   async_mutex,
+//   async_semaphore    - waiters are suspended coroutines, not blocked threads;
+//                        waking them never nests resumes, however many queue up
+//
+// Coroutine frames are allocated from per-thread size-class free lists, so
+// creating and finishing a task normally costs no malloc/free.
+//
+// Usage:
+//   task<int> answer(pool_scheduler& sched) {
+//       co_await sched.schedule();           // continue on a pool thread
+//       co_return 42;
+//   }
+//   int value = sync_wait(answer(sched));
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+template <typename T = void>
+class task;
+
+namespace coro_detail {
+
+// --- SECTION 1: Pooled Frame Allocation ---
+
+// Frames are rounded up to 64 bytes; sizes up to 1 KiB are recycled through
+// thread-local free lists. A frame freed on another thread than the one that
+// allocated it simply joins that thread's list.
+inline constexpr std::size_t frame_granularity = 64;
+inline constexpr std::size_t max_pooled_frame = 1024;
+inline constexpr std::size_t frame_classes = max_pooled_frame / frame_granularity;
+inline constexpr std::size_t max_cached_per_class = 256;
+
+struct frame_cache {
+    struct free_frame {
+        free_frame* next;
+    };
+
+    free_frame* lists[frame_classes] = {};
+    std::size_t counts[frame_classes] = {};
+    bool alive = true;
+
+    ~frame_cache() {
+        alive = false;
+        for (free_frame*& head : lists) {
+            while (head) {
+                free_frame* next = head->next;
+                ::operator delete(head);
+                head = next;
+            }
+        }
+    }
+};
+
+inline thread_local frame_cache thread_frame_cache;
+
+inline void* allocate_frame(std::size_t size) {
+    if (size > max_pooled_frame) return ::operator new(size);
+    std::size_t index = (size - 1) / frame_granularity;
+    frame_cache& cache = thread_frame_cache;
+    if (frame_cache::free_frame* frame = cache.lists[index]) {
+        cache.lists[index] = frame->next;
+        --cache.counts[index];
+        return frame;
+    }
+    return ::operator new((index + 1) * frame_granularity);
+}
+
+inline void deallocate_frame(void* p, std::size_t size) noexcept {
+    if (size <= max_pooled_frame) {
+        std::size_t index = (size - 1) / frame_granularity;
+        frame_cache& cache = thread_frame_cache;
+        if (cache.alive && cache.counts[index] < max_cached_per_class) {
+            auto* frame = static_cast<frame_cache::free_frame*>(p);
+            frame->next = cache.lists[index];
+            cache.lists[index] = frame;
+            ++cache.counts[index];
+            return;
+        }
+    }
+    ::operator delete(p);
+}
+
+struct pooled_frame {
+    static void* operator new(std::size_t size) { return allocate_frame(size); }
+    static void operator delete(void* p, std::size_t size) noexcept { deallocate_frame(p, size); }
+};
+
+// void results are carried around as std::monostate
+template <typename T>
+using non_void_t = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+// --- SECTION 2: task<T> Promise ---
+
+struct task_promise_base : pooled_frame {
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+    std::exception_ptr exception;
+
+    // Lazy: nothing runs until the task is awaited
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    // Symmetric transfer: return the awaiting coroutine's handle so the compiler
+    // jumps to it (a tail call) instead of resuming it from inside this frame.
+    // Compilers only emit the tail call with optimization on; unoptimized builds
+    // still grow the stack on very long chains of synchronously completing tasks.
+    struct final_awaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> self) noexcept {
+            return self.promise().continuation;
+        }
+        void await_resume() noexcept {}
+    };
+    final_awaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() noexcept { exception = std::current_exception(); }
+};
+
+template <typename T>
+struct task_promise : task_promise_base {
+    std::optional<T> value;
+
+    task<T> get_return_object() noexcept;
+
+    template <typename U>
+    void return_value(U&& result) {
+        value.emplace(std::forward<U>(result));
+    }
+
+    T take_result() {
+        if (exception) std::rethrow_exception(exception);
+        return std::move(*value);
+    }
+};
+
+template <>
+struct task_promise<void> : task_promise_base {
+    task<void> get_return_object() noexcept;
+    void return_void() noexcept {}
+
+    void take_result() {
+        if (exception) std::rethrow_exception(exception);
+    }
+};
+
+}  // namespace coro_detail
+
+// --- SECTION 3: task<T> ---
+
+template <typename T>
+class [[nodiscard]] task {
+    static_assert(!std::is_reference_v<T>, "task<T&> is not supported; return a pointer or std::reference_wrapper");
+
+public:
+    using promise_type = coro_detail::task_promise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    task() noexcept = default;
+    explicit task(handle_type handle) noexcept : handle_(handle) {}
+    task(task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    task& operator=(task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+    ~task() {
+        if (handle_) handle_.destroy();
+    }
+
+    bool valid() const noexcept { return static_cast<bool>(handle_); }
+    bool done() const noexcept { return !handle_ || handle_.done(); }
+
+    // Awaiting starts the task and transfers straight into it; when it finishes,
+    // its final_awaiter transfers straight back to us
+    auto operator co_await() noexcept {
+        struct awaiter {
+            handle_type handle;
+            bool await_ready() noexcept { return !handle || handle.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+            T await_resume() { return handle.promise().take_result(); }
+        };
+        return awaiter{handle_};
+    }
+
+private:
+    handle_type handle_ = nullptr;
+};
+
+namespace coro_detail {
+
+template <typename T>
+task<T> task_promise<T>::get_return_object() noexcept {
+    return task<T>(std::coroutine_handle<task_promise<T>>::from_promise(*this));
+}
+
+inline task<void> task_promise<void>::get_return_object() noexcept {
+    return task<void>(std::coroutine_handle<task_promise<void>>::from_promise(*this));
+}
+
+// Eagerly started, self-destroying coroutine used to bridge into the
+// non-coroutine world (sync_wait, spawn, when_any children)
+struct detached_task {
+    struct promise_type : pooled_frame {
+        detached_task get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+// --- SECTION 4: when_all Machinery ---
+
+// Counts finished children. It starts at children + 1: the extra count belongs
+// to the awaiting coroutine until it has started every child, so a child that
+// finishes synchronously cannot resume the parent while it is still inside
+// await_suspend.
+struct when_all_latch {
+    explicit when_all_latch(std::size_t children) : remaining(children + 1) {}
+    std::atomic<std::size_t> remaining;
+    std::coroutine_handle<> waiter;
+
+    bool arrive() noexcept { return remaining.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+};
+
+// Lazily started wrapper around one awaited task; on completion it hands control
+// to the parent if it was the last one to finish
+class when_all_child {
+public:
+    struct promise_type : pooled_frame {
+        when_all_latch* latch = nullptr;
+
+        when_all_child get_return_object() noexcept {
+            return when_all_child(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        struct final_awaiter {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> self) noexcept {
+                when_all_latch* latch = self.promise().latch;
+                if (latch->arrive()) return latch->waiter;
+                return std::noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+        final_awaiter final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }  // Children catch everything
+    };
+
+    explicit when_all_child(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+    when_all_child(when_all_child&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    when_all_child(const when_all_child&) = delete;
+    ~when_all_child() {
+        if (handle_) handle_.destroy();
+    }
+
+    void start(when_all_latch& latch) noexcept {
+        handle_.promise().latch = &latch;
+        handle_.resume();
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template <typename T>
+when_all_child make_when_all_child(task<T>& child, std::optional<non_void_t<T>>& result, std::exception_ptr& error) {
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await child;
+            result.emplace();
+        } else {
+            result.emplace(co_await child);
+        }
+    } catch (...) {
+        error = std::current_exception();
+    }
+}
+
+struct when_all_awaitable {
+    std::vector<when_all_child>& children;
+    when_all_latch latch;
+
+    explicit when_all_awaitable(std::vector<when_all_child>& c) : children(c), latch(c.size()) {}
+
+    bool await_ready() noexcept { return children.empty(); }
+    bool await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        latch.waiter = awaiting;
+        for (auto& child : children) {
+            child.start(latch);
+        }
+        return !latch.arrive();  // All children already done: do not suspend at all
+    }
+    void await_resume() noexcept {}
+};
+
+}  // namespace coro_detail
+
+// --- SECTION 5: sync_wait, when_all, when_any ---
+
+// Block the calling (non-pool) thread until the task has finished
+template <typename T>
+T sync_wait(task<T> work) {
+    std::mutex m;
+    std::condition_variable cv;
+    bool finished = false;
+    std::optional<coro_detail::non_void_t<T>> result;
+    std::exception_ptr error;
+
+    [](task<T>& work, std::optional<coro_detail::non_void_t<T>>& result, std::exception_ptr& error, std::mutex& m,
+       std::condition_variable& cv, bool& finished) -> coro_detail::detached_task {
+        try {
+            if constexpr (std::is_void_v<T>) {
+                co_await work;
+                result.emplace();
+            } else {
+                result.emplace(co_await work);
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+        std::lock_guard<std::mutex> lock(m);  // Notify under the lock: the waiter owns m and cv
+        finished = true;
+        cv.notify_one();
+    }(work, result, error, m, cv, finished);
+
+    std::unique_lock<std::mutex> lock(m);
+    cv.wait(lock, [&] { return finished; });
+    if (error) std::rethrow_exception(error);
+    if constexpr (!std::is_void_v<T>) return std::move(*result);
+}
+
+// Await every task concurrently; results come back in the same order.
+// void tasks contribute std::monostate. The first exception is rethrown after
+// all tasks have finished.
+template <typename T>
+task<std::vector<coro_detail::non_void_t<T>>> when_all(std::vector<task<T>> tasks) {
+    std::vector<std::optional<coro_detail::non_void_t<T>>> results(tasks.size());
+    std::vector<std::exception_ptr> errors(tasks.size());
+    std::vector<coro_detail::when_all_child> children;
+    children.reserve(tasks.size());
+    for (std::size_t i = 0; i < tasks.size(); ++i) {
+        children.push_back(coro_detail::make_when_all_child(tasks[i], results[i], errors[i]));
+    }
+    co_await coro_detail::when_all_awaitable(children);
+
+    for (auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+    std::vector<coro_detail::non_void_t<T>> values;
+    values.reserve(results.size());
+    for (auto& result : results) {
+        values.push_back(std::move(*result));
+    }
+    co_return values;
+}
+
+template <typename... Ts>
+task<std::tuple<coro_detail::non_void_t<Ts>...>> when_all(task<Ts>... tasks) {
+    static_assert(sizeof...(Ts) > 0, "when_all needs at least one task");
+    std::tuple<std::optional<coro_detail::non_void_t<Ts>>...> results;
+    std::exception_ptr errors[sizeof...(Ts)];
+    std::vector<coro_detail::when_all_child> children;
+    children.reserve(sizeof...(Ts));
+
+    auto refs = std::tie(tasks...);
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+        (children.push_back(coro_detail::make_when_all_child(std::get<I>(refs), std::get<I>(results), errors[I])), ...);
+    }(std::index_sequence_for<Ts...>{});
+    co_await coro_detail::when_all_awaitable(children);
+
+    for (auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+    co_return std::apply([](auto&... result) { return std::make_tuple(std::move(*result)...); }, results);
+}
+
+// Resume with (index, value) of the first task to finish (or rethrow its
+// exception). The others keep running to completion in the background, so they
+// must not refer to anything that dies with the awaiting coroutine.
+template <typename T>
+task<std::pair<std::size_t, coro_detail::non_void_t<T>>> when_any(std::vector<task<T>> tasks) {
+    struct state {
+        std::vector<task<T>> tasks;
+        std::atomic<bool> decided{false};
+        std::atomic<int> resume_guard{2};  // First finisher + end of await_suspend
+        std::coroutine_handle<> waiter;
+        std::size_t index = 0;
+        std::optional<coro_detail::non_void_t<T>> value;
+        std::exception_ptr error;
+
+        void finish() {
+            if (resume_guard.fetch_sub(1, std::memory_order_acq_rel) == 1) waiter.resume();
+        }
+    };
+
+    struct awaitable {
+        std::shared_ptr<state> shared;
+
+        static coro_detail::detached_task run_child(std::shared_ptr<state> s, std::size_t i) {
+            try {
+                if constexpr (std::is_void_v<T>) {
+                    co_await s->tasks[i];
+                    if (!s->decided.exchange(true)) {
+                        s->index = i;
+                        s->value.emplace();
+                        s->finish();
+                    }
+                } else {
+                    auto result = co_await s->tasks[i];
+                    if (!s->decided.exchange(true)) {
+                        s->index = i;
+                        s->value.emplace(std::move(result));
+                        s->finish();
+                    }
+                }
+            } catch (...) {
+                if (!s->decided.exchange(true)) {
+                    s->index = i;
+                    s->error = std::current_exception();
+                    s->finish();
+                }
+            }
+        }
+
+        bool await_ready() noexcept { return shared->tasks.empty(); }
+        bool await_suspend(std::coroutine_handle<> awaiting) {
+            shared->waiter = awaiting;
+            for (std::size_t i = 0; i < shared->tasks.size(); ++i) {
+                run_child(shared, i);
+                if (shared->decided.load(std::memory_order_acquire)) break;  // No point starting the rest
+            }
+            return shared->resume_guard.fetch_sub(1, std::memory_order_acq_rel) != 1;
+        }
+        void await_resume() noexcept {}
+    };
+
+    if (tasks.empty()) throw std::invalid_argument("when_any needs at least one task");
+    auto shared = std::make_shared<state>();
+    shared->tasks = std::move(tasks);
+    awaitable first_finished{shared};  // Named: GCC 12 destroys non-trivial co_await temporaries twice
+    co_await first_finished;
+    if (shared->error) std::rethrow_exception(shared->error);
+    co_return std::pair<std::size_t, coro_detail::non_void_t<T>>(shared->index, std::move(*shared->value));
+}
+
+// --- SECTION 6: Thread-Pool Scheduler ---
+
+class pool_scheduler {
+public:
+    explicit pool_scheduler(thread_pool& pool) noexcept : pool_(&pool) {}
+
+    // co_await sched.schedule() continues the coroutine on a pool worker
+    auto schedule() noexcept {
+        struct awaiter {
+            thread_pool* pool;
+            bool await_ready() noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) {
+                pool->post([handle] { handle.resume(); });
+            }
+            void await_resume() noexcept {}
+        };
+        return awaiter{pool_};
+    }
+
+    // Start a task on the pool without waiting for it. Exceptions terminate.
+    void spawn(task<void> work) {
+        [](pool_scheduler& sched, task<void> work) -> coro_detail::detached_task {
+            co_await sched.schedule();
+            co_await work;
+        }(*this, std::move(work));
+    }
+
+    thread_pool& pool() noexcept { return *pool_; }
+
+private:
+    thread_pool* pool_;
+};
+
+// --- SECTION 7: Timers ---
+
+// Thrown from co_await sleep_for/sleep_until when the timer_service is
+// destroyed before the deadline
+class timer_cancelled : public std::runtime_error {
+public:
+    timer_cancelled() : std::runtime_error("timer_service destroyed before the deadline") {}
+};
+
+// One background thread keeps a min-heap of deadlines. Expired coroutines are
+// collected in a batch and resumed on the scheduler (or on the timer thread
+// when there is none, which is fine for coroutines that only hand work off).
+//
+// Destroying the service stops the thread, then resumes every sleeper that is
+// still pending on the destroying thread, in deadline order; their co_await
+// throws timer_cancelled. Nothing is left suspended, so awaiting chains finish
+// (or unwind) and their frames are freed.
+class timer_service {
+public:
+    using clock = std::chrono::steady_clock;
+
+    explicit timer_service(pool_scheduler* scheduler = nullptr)
+        : scheduler_(scheduler), thread_([this] { run(); }) {}
+
+    ~timer_service() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_one();
+        thread_.join();
+
+        // No other thread touches the heap now. A cancelled sleeper that sleeps
+        // again while it unwinds does not suspend (add() sees stopping_).
+        while (!heap_.empty()) {
+            entry pending = heap_.top();
+            heap_.pop();
+            *pending.cancelled = true;
+            pending.handle.resume();
+        }
+    }
+
+    timer_service(const timer_service&) = delete;
+    timer_service& operator=(const timer_service&) = delete;
+
+    // Throws timer_cancelled if the service is destroyed first
+    auto sleep_until(clock::time_point deadline) noexcept {
+        struct awaiter {
+            timer_service* timers;
+            clock::time_point deadline;
+            bool cancelled = false;
+            bool await_ready() noexcept { return deadline <= clock::now(); }
+            bool await_suspend(std::coroutine_handle<> handle) { return timers->add(deadline, handle, &cancelled); }
+            void await_resume() {
+                if (cancelled) throw timer_cancelled();
+            }
+        };
+        return awaiter{this, deadline};
+    }
+
+    template <typename Rep, typename Period>
+    auto sleep_for(std::chrono::duration<Rep, Period> delay) noexcept {
+        return sleep_until(clock::now() + std::chrono::duration_cast<clock::duration>(delay));
+    }
+
+    std::size_t pending() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return heap_.size();
+    }
+
+private:
+    struct entry {
+        clock::time_point deadline;
+        uint64_t sequence;  // FIFO among equal deadlines
+        std::coroutine_handle<> handle;
+        bool* cancelled;    // In the sleeper's awaiter
+        bool operator>(const entry& other) const {
+            return deadline != other.deadline ? deadline > other.deadline : sequence > other.sequence;
+        }
+    };
+
+    // Returns false (resume at once) if the service is already shutting down
+    bool add(clock::time_point deadline, std::coroutine_handle<> handle, bool* cancelled) {
+        bool earliest;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) {
+                *cancelled = true;
+                return false;
+            }
+            earliest = heap_.empty() || deadline < heap_.top().deadline;
+            heap_.push({deadline, next_sequence_++, handle, cancelled});
+        }
+        if (earliest) cv_.notify_one();  // Only a new earliest deadline changes the wait
+        return true;
+    }
+
+    void run() {
+        std::vector<std::coroutine_handle<>> expired;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            if (heap_.empty()) {
+                cv_.wait(lock);
+                continue;
+            }
+            auto now = clock::now();
+            while (!heap_.empty() && heap_.top().deadline <= now) {
+                expired.push_back(heap_.top().handle);
+                heap_.pop();
+            }
+            if (expired.empty()) {
+                clock::time_point next = heap_.top().deadline;  // A copy: add() may reallocate the heap while we wait
+                cv_.wait_until(lock, next);
+                continue;
+            }
+            lock.unlock();
+            for (auto handle : expired) {
+                if (scheduler_) {
+                    scheduler_->pool().post([handle] { handle.resume(); });
+                } else {
+                    handle.resume();
+                }
+            }
+            expired.clear();
+            lock.lock();
+        }
+    }
+
+    pool_scheduler* scheduler_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::priority_queue<entry, std::vector<entry>, std::greater<entry>> heap_;
+    uint64_t next_sequence_ = 0;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+// --- SECTION 8: Async Mutex and Semaphore ---
+
+namespace coro_detail {
+
+// A waiter to resume, linked into the resuming thread's ready list. It lives
+// in the waiter's awaiter (in the suspended frame), so queueing allocates nothing.
+struct resume_node {
+    std::coroutine_handle<> handle{};
+    resume_node* next_ready = nullptr;
+};
+
+struct ready_list {
+    resume_node* head = nullptr;
+    resume_node* tail = nullptr;
+    bool draining = false;
+};
+
+inline thread_local ready_list thread_ready_list;
+
+// Resumes `node` on this thread, but never from inside another such resume:
+// a waiter that unlocks while it runs only appends the next waiter, and the
+// outermost call resumes them one after another. Without this, handing a
+// lock down a queue of N waiters would nest N frames deep on one stack.
+inline void resume_without_nesting(resume_node* node) {
+    ready_list& ready = thread_ready_list;
+    node->next_ready = nullptr;
+    if (ready.tail) {
+        ready.tail->next_ready = node;
+    } else {
+        ready.head = node;
+    }
+    ready.tail = node;
+    if (ready.draining) return;
+
+    struct drain_guard {
+        ready_list& ready;
+        ~drain_guard() { ready.draining = false; }
+    } guard{ready};
+    ready.draining = true;
+    while (resume_node* next = ready.head) {
+        ready.head = next->next_ready;
+        if (!ready.head) ready.tail = nullptr;
+        next->handle.resume();  // `next` may be gone afterwards: it lives in the resumed frame
+    }
+}
+
+}  // namespace coro_detail
+
+// Waiters form an intrusive FIFO list of awaiters that live in the suspended
+// coroutines' frames, so waiting allocates nothing. unlock() hands ownership
+// directly to the first waiter and resumes it on the unlocking thread (after
+// the current resume, if unlock() itself runs inside one).
+class async_mutex {
+public:
+    class lock_guard {
+    public:
+        explicit lock_guard(async_mutex& m) noexcept : mutex_(&m) {}
+        lock_guard(lock_guard&& other) noexcept : mutex_(std::exchange(other.mutex_, nullptr)) {}
+        lock_guard(const lock_guard&) = delete;
+        ~lock_guard() {
+            if (mutex_) mutex_->unlock();
+        }
+
+    private:
+        async_mutex* mutex_;
+    };
+
+    struct lock_awaiter {
+        async_mutex& mutex;
+        lock_awaiter* next = nullptr;
+        coro_detail::resume_node resume{};
+
+        bool await_ready() noexcept { return mutex.try_lock(); }
+        bool await_suspend(std::coroutine_handle<> awaiting) {
+            resume.handle = awaiting;
+            return mutex.enqueue(this);
+        }
+        void await_resume() noexcept {}
+    };
+
+    struct scoped_lock_awaiter : lock_awaiter {
+        lock_guard await_resume() noexcept { return lock_guard(this->mutex); }
+    };
+
+    bool try_lock() {
+        std::lock_guard<std::mutex> lock(state_);
+        if (locked_) return false;
+        locked_ = true;
+        return true;
+    }
+
+    // co_await m.lock(); ... m.unlock();
+    lock_awaiter lock() noexcept { return lock_awaiter{*this}; }
+
+    // auto guard = co_await m.scoped_lock();  (unlocks when guard goes out of scope)
+    scoped_lock_awaiter scoped_lock() noexcept { return scoped_lock_awaiter{{*this}}; }
+
+    void unlock() {
+        lock_awaiter* next;
+        {
+            std::lock_guard<std::mutex> lock(state_);
+            next = head_;
+            if (!next) {
+                locked_ = false;
+                return;
+            }
+            head_ = next->next;
+            if (!head_) tail_ = nullptr;
+        }
+        coro_detail::resume_without_nesting(&next->resume);  // Still locked: ownership passes to the waiter
+    }
+
+private:
+    // Returns false (do not suspend) if the mutex became free in the meantime
+    bool enqueue(lock_awaiter* waiter) {
+        std::lock_guard<std::mutex> lock(state_);
+        if (!locked_) {
+            locked_ = true;
+            return false;
+        }
+        if (tail_) {
+            tail_->next = waiter;
+        } else {
+            head_ = waiter;
+        }
+        tail_ = waiter;
+        return true;
+    }
+
+    std::mutex state_;  // Guards the few instructions below, never held while user code runs
+    bool locked_ = false;
+    lock_awaiter* head_ = nullptr;
+    lock_awaiter* tail_ = nullptr;
+};
+
+class async_semaphore {
+public:
+    explicit async_semaphore(std::size_t initial) noexcept : available_(initial) {}
+
+    struct acquire_awaiter {
+        async_semaphore& semaphore;
+        acquire_awaiter* next = nullptr;
+        coro_detail::resume_node resume{};
+
+        bool await_ready() noexcept { return semaphore.try_acquire(); }
+        bool await_suspend(std::coroutine_handle<> awaiting) {
+            resume.handle = awaiting;
+            return semaphore.enqueue(this);
+        }
+        void await_resume() noexcept {}
+    };
+
+    bool try_acquire() {
+        std::lock_guard<std::mutex> lock(state_);
+        if (available_ == 0) return false;
+        --available_;
+        return true;
+    }
+
+    acquire_awaiter acquire() noexcept { return acquire_awaiter{*this}; }
+
+    void release(std::size_t count = 1) {
+        acquire_awaiter* woken = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(state_);
+            // Hand permits straight to waiters; leftovers go back to the pool
+            acquire_awaiter** tail = &woken;
+            while (count > 0 && head_) {
+                acquire_awaiter* waiter = head_;
+                head_ = waiter->next;
+                waiter->next = nullptr;
+                *tail = waiter;
+                tail = &waiter->next;
+                --count;
+            }
+            if (!head_) tail_ = nullptr;
+            available_ += count;
+        }
+        while (woken) {
+            acquire_awaiter* waiter = woken;
+            woken = woken->next;  // Read before resuming: the awaiter dies with its frame
+            coro_detail::resume_without_nesting(&waiter->resume);
+        }
+    }
+
+    std::size_t available() {
+        std::lock_guard<std::mutex> lock(state_);
+        return available_;
+    }
+
+private:
+    bool enqueue(acquire_awaiter* waiter) {
+        std::lock_guard<std::mutex> lock(state_);
+        if (available_ > 0) {
+            --available_;
+            return false;
+        }
+        if (tail_) {
+            tail_->next = waiter;
+        } else {
+            head_ = waiter;
+        }
+        tail_ = waiter;
+        return true;
+    }
+
+    std::mutex state_;
+    std::size_t available_;
+    acquire_awaiter* head_ = nullptr;
+    acquire_awaiter* tail_ = nullptr;
+};
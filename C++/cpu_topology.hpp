@@ -0,0 +1,344 @@
+#pragma once
+
+// CPU topology and thread placement.
+//
+//   cpu_topology::system()  - logical CPUs with their core, package and NUMA node,
+//                             read once from /sys/devices/system/{cpu,node}
+//   thread_placement        - none / compact / spread policy for a set of threads
+//   placement_order()       - the CPU each successive thread should be pinned to
+//   pin_current_thread()    - pthread_setaffinity_np to one CPU
+//   current_cpu()           - CPU the caller runs on right now (sched_getcpu)
+//   first_touch_buffer<T>   - array whose pages are faulted in by the thread that
+//                             constructs it, so Linux places them on its node
+//
+// Only CPUs in the process's affinity mask are listed, so `taskset` and cgroup
+// cpusets are respected. Without /sys (or off Linux) every CPU reported by
+// std::thread::hardware_concurrency() is treated as its own core on node 0,
+// and pinning is a no-op.
+//
+// Usage:
+//   const cpu_topology& topo = cpu_topology::system();
+//   std::vector<int> cpus = placement_order(topo, thread_placement::spread);
+//   pin_current_thread(cpus[worker_index % cpus.size()]);
+//   first_touch_buffer<double> local(1 << 20);  // Pages land on this thread's node
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <set>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+
+// --- SECTION 1: Topology ---
+
+struct cpu_info {
+    int cpu = 0;      // Logical CPU number, as used by affinity masks
+    int core = 0;     // Physical core id, unique within a package
+    int package = 0;  // Socket
+    int node = 0;     // NUMA node
+};
+
+namespace cpu_topology_detail {
+
+inline bool read_int(const std::string& path, int& value) {
+    std::ifstream in(path);
+    return static_cast<bool>(in >> value);
+}
+
+// Parse the kernel's list format, e.g. "0-3,8-11" (used for CPUs and nodes)
+inline std::vector<int> parse_cpu_list(const std::string& text) {
+    std::vector<int> cpus;
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        std::size_t end = text.find(',', pos);
+        if (end == std::string::npos) end = text.size();
+        std::string part = text.substr(pos, end - pos);
+        std::size_t dash = part.find('-');
+        try {
+            int first = std::stoi(part.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(part.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+        } catch (const std::exception&) {
+            // Blank or malformed piece (e.g. the trailing newline): skip it
+        }
+        pos = end + 1;
+    }
+    return cpus;
+}
+
+inline std::vector<int> read_cpu_list(const std::string& path) {
+    std::ifstream in(path);
+    std::string text;
+    std::getline(in, text);
+    return parse_cpu_list(text);
+}
+
+}  // namespace cpu_topology_detail
+
+class cpu_topology {
+public:
+    // The machine this process runs on, read once
+    static const cpu_topology& system() {
+        static const cpu_topology topology = detect();
+        return topology;
+    }
+
+    const std::vector<cpu_info>& cpus() const noexcept { return cpus_; }
+    std::size_t cpu_count() const noexcept { return cpus_.size(); }
+    std::size_t node_count() const noexcept { return node_count_; }
+    std::size_t core_count() const noexcept { return core_count_; }
+
+    // NUMA node of a logical CPU, or 0 if it is unknown
+    int node_of(int cpu) const noexcept {
+        for (const cpu_info& info : cpus_) {
+            if (info.cpu == cpu) return info.node;
+        }
+        return 0;
+    }
+
+    static cpu_topology detect() {
+        namespace detail = cpu_topology_detail;
+        cpu_topology topology;
+        std::vector<int> allowed = allowed_cpus();
+        const std::string base = "/sys/devices/system/";
+
+        // Node membership comes from the node directories; no libnuma needed.
+        // A kernel without NUMA support has none, and everything is node 0.
+        std::vector<int> node_of_cpu;
+        for (int node : detail::read_cpu_list(base + "node/online")) {
+            for (int cpu : detail::read_cpu_list(base + "node/node" + std::to_string(node) + "/cpulist")) {
+                if (cpu >= static_cast<int>(node_of_cpu.size())) node_of_cpu.resize(cpu + 1, 0);
+                node_of_cpu[cpu] = node;
+            }
+        }
+
+        for (int cpu : allowed) {
+            cpu_info info;
+            info.cpu = cpu;
+            info.core = cpu;
+            std::string topo = base + "cpu/cpu" + std::to_string(cpu) + "/topology/";
+            detail::read_int(topo + "core_id", info.core);
+            detail::read_int(topo + "physical_package_id", info.package);
+            if (info.package < 0) info.package = 0;  // Some VMs report -1
+            info.node = cpu < static_cast<int>(node_of_cpu.size()) ? node_of_cpu[cpu] : 0;
+            topology.cpus_.push_back(info);
+        }
+
+        std::set<int> nodes;
+        std::set<std::pair<int, int>> cores;
+        for (const cpu_info& info : topology.cpus_) {
+            nodes.insert(info.node);
+            cores.insert({info.package, info.core});
+        }
+        topology.node_count_ = std::max<std::size_t>(1, nodes.size());
+        topology.core_count_ = std::max<std::size_t>(1, cores.size());
+        return topology;
+    }
+
+private:
+    // CPUs this process may run on (its affinity mask), ascending
+    static std::vector<int> allowed_cpus() {
+        std::vector<int> cpus;
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+            }
+        }
+#endif
+        if (cpus.empty()) {
+            unsigned count = std::max(1u, std::thread::hardware_concurrency());
+            for (unsigned cpu = 0; cpu < count; ++cpu) cpus.push_back(static_cast<int>(cpu));
+        }
+        return cpus;
+    }
+
+    std::vector<cpu_info> cpus_;
+    std::size_t node_count_ = 1;
+    std::size_t core_count_ = 1;
+};
+
+// --- SECTION 2: Placement ---
+
+enum class thread_placement {
+    none,     // Leave threads to the scheduler
+    compact,  // Fill a node before the next one, hyperthread siblings next to each other
+    spread,   // One thread per physical core first, alternating between nodes; siblings last
+};
+
+// CPUs in the order threads should take them under a policy; thread i uses
+// entry i % size(). Empty for thread_placement::none.
+inline std::vector<int> placement_order(const cpu_topology& topology, thread_placement placement) {
+    std::vector<cpu_info> cpus = topology.cpus();
+    std::vector<int> order;
+    if (placement == thread_placement::none) return order;
+
+    auto by_location = [](const cpu_info& a, const cpu_info& b) {
+        if (a.node != b.node) return a.node < b.node;
+        if (a.package != b.package) return a.package < b.package;
+        if (a.core != b.core) return a.core < b.core;
+        return a.cpu < b.cpu;
+    };
+    std::sort(cpus.begin(), cpus.end(), by_location);
+    if (placement == thread_placement::compact) {
+        for (const cpu_info& info : cpus) order.push_back(info.cpu);
+        return order;
+    }
+
+    // spread: rank each CPU among the hyperthreads of its core (0 = first
+    // sibling) and among the cores of its node, then deal out rank 0 of every
+    // core round-robin across nodes before any second sibling
+    struct ranked {
+        int sibling;
+        int core_in_node;
+        int node;
+        int cpu;
+    };
+    std::vector<ranked> ranks;
+    int sibling = 0, core_in_node = -1;
+    for (std::size_t i = 0; i < cpus.size(); ++i) {
+        bool same_node = i > 0 && cpus[i].node == cpus[i - 1].node;
+        bool same_core = same_node && cpus[i].package == cpus[i - 1].package && cpus[i].core == cpus[i - 1].core;
+        if (!same_node) core_in_node = -1;
+        if (same_core) {
+            ++sibling;
+        } else {
+            sibling = 0;
+            ++core_in_node;
+        }
+        ranks.push_back({sibling, core_in_node, cpus[i].node, cpus[i].cpu});
+    }
+    std::sort(ranks.begin(), ranks.end(), [](const ranked& a, const ranked& b) {
+        if (a.sibling != b.sibling) return a.sibling < b.sibling;
+        if (a.core_in_node != b.core_in_node) return a.core_in_node < b.core_in_node;
+        return a.node < b.node;
+    });
+    for (const ranked& r : ranks) order.push_back(r.cpu);
+    return order;
+}
+
+// Restrict the calling thread to one CPU. False if the kernel refused (CPU
+// offline or outside our cpuset) or pinning is unsupported.
+inline bool pin_current_thread(int cpu) {
+#if defined(__linux__)
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+// Undo pin_current_thread: allow every CPU the process may use
+inline bool unpin_current_thread() {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const cpu_info& info : cpu_topology::system().cpus()) CPU_SET(info.cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+// The CPU the caller is running on at this instant (-1 if unknown). Unless the
+// thread is pinned the answer can be stale by the time it is used.
+inline int current_cpu() {
+#if defined(__linux__)
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+// --- SECTION 3: First-Touch Memory ---
+
+// Linux backs a page with memory from the node of the thread that first
+// writes it, not the one that called malloc. first_touch_buffer maps fresh
+// pages and has the constructing thread zero them, so a pinned worker that
+// builds its own buffer gets node-local memory without libnuma or mbind().
+// Construct it on the thread that will use it.
+template <typename T>
+class first_touch_buffer {
+    static_assert(std::is_trivially_copyable_v<T>, "the buffer is zero-filled, not constructed");
+
+public:
+    first_touch_buffer() = default;
+
+    explicit first_touch_buffer(std::size_t count) : size_(count) {
+        if (count == 0) return;
+        bytes_ = count * sizeof(T);
+#if defined(__linux__)
+        void* memory = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) throw std::bad_alloc();
+        data_ = static_cast<T*>(memory);
+        // Fresh anonymous pages are unbacked until written; write one byte per
+        // page so the fault (and the placement decision) happens here
+        auto* bytes = static_cast<volatile unsigned char*>(memory);
+        for (std::size_t offset = 0; offset < bytes_; offset += 4096) bytes[offset] = 0;
+#else
+        data_ = static_cast<T*>(::operator new(bytes_));
+        std::fill_n(reinterpret_cast<unsigned char*>(data_), bytes_, 0);
+#endif
+    }
+
+    ~first_touch_buffer() { release(); }
+
+    first_touch_buffer(first_touch_buffer&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr)),
+          size_(std::exchange(other.size_, 0)),
+          bytes_(std::exchange(other.bytes_, 0)) {}
+
+    first_touch_buffer& operator=(first_touch_buffer&& other) noexcept {
+        if (this != &other) {
+            release();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            bytes_ = std::exchange(other.bytes_, 0);
+        }
+        return *this;
+    }
+
+    T* data() noexcept { return data_; }
+    const T* data() const noexcept { return data_; }
+    std::size_t size() const noexcept { return size_; }
+    T& operator[](std::size_t i) noexcept { return data_[i]; }
+    const T& operator[](std::size_t i) const noexcept { return data_[i]; }
+    T* begin() noexcept { return data_; }
+    T* end() noexcept { return data_ + size_; }
+    const T* begin() const noexcept { return data_; }
+    const T* end() const noexcept { return data_ + size_; }
+
+private:
+    void release() noexcept {
+        if (!data_) return;
+#if defined(__linux__)
+        munmap(data_, bytes_);
+#else
+        ::operator delete(data_);
+#endif
+        data_ = nullptr;
+    }
+
+    T* data_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t bytes_ = 0;
+};
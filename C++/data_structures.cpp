@@ -5,6 +5,11 @@
 #include <queue>
 #include <map>
 #include <set>
+#include <unordered_map>
+#include <deque>
+#include <memory_resource>  // std::pmr containers
+
+#include "arena_allocator.hpp"  // Arena and pool memory resources
 
 using namespace std;
 
@@ -132,5 +137,60 @@ int main() {
         cout << "Deque element: " << num << endl;
     }
 
+    // 12. **Arena-Allocated Containers**: Node-based containers (list, map, set, unordered_map)
+    //     normally allocate every node separately. std::pmr versions take a memory resource,
+    //     so all their nodes can come from one arena and be freed together.
+    cout << "\nArena-Allocated Containers Example: " << endl;
+    {
+        arena_resource arena;  // Bump allocator: every node is carved out of a few large blocks
+
+        pmr::list<int> arenaList(&arena);
+        arenaList.push_back(1);
+        arenaList.push_back(2);
+
+        pmr::map<int, int> arenaMap(&arena);
+        arenaMap[1] = 100;
+        arenaMap[2] = 200;
+
+        pmr::set<int> arenaSet({3, 1, 2}, &arena);
+
+        pmr::unordered_map<int, int> arenaUnorderedMap(&arena);
+        arenaUnorderedMap[7] = 70;
+
+        for (int num : arenaList) {
+            cout << "Arena list element: " << num << endl;
+        }
+        for (const auto& pair : arenaMap) {
+            cout << "Arena map: " << pair.first << " -> " << pair.second << endl;
+        }
+        for (int num : arenaSet) {
+            cout << "Arena set element: " << num << endl;
+        }
+        cout << "Arena unordered_map[7] = " << arenaUnorderedMap[7] << endl;
+        cout << "Bytes handed out by the arena: " << arena.arena().bytes_allocated() << endl;
+    }  // Containers are destroyed first, then the arena frees its blocks
+
+    // A size-class pool reuses the nodes of erased elements instead of growing
+    {
+        pool_resource pool;
+        pmr::map<int, int> scores(&pool);
+        for (int i = 0; i < 1000; ++i) {
+            scores[i] = i;
+        }
+        scores.clear();  // Nodes go back to the pool's free lists
+        for (int i = 0; i < 1000; ++i) {
+            scores[i] = i * 2;  // ...and are reused here
+        }
+        cout << "Pool map size: " << scores.size() << ", memory reserved: "
+             << pool.pool().bytes_reserved() << " bytes" << endl;
+
+        // O(1) teardown: build the container inside the arena and drop everything at once
+        auto* lookup = make_in_arena<pmr::unordered_map<int, int>>(pool);
+        (*lookup)[42] = 1;
+        cout << "Arena-owned unordered_map size: " << lookup->size() << endl;
+        scores.clear();
+        pool.release();  // Frees every node of `lookup` without visiting them
+    }
+
     return 0;  // End of the program
 }
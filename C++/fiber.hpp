@@ -0,0 +1,1006 @@
+#pragma once
+
+// User-space fibers (stackful coroutines) on a per-core work-stealing scheduler.
+//
+// A blocked OS thread costs a kernel task, an 8 MiB stack reservation and a
+// microsecond-scale context switch through the scheduler. A fiber is a small
+// mmap'ed stack plus a saved stack pointer: switching is a handful of register
+// pushes in user space, so a program can keep 10^5 blocked "threads" and
+// still write plain blocking code (lock, wait, pop) instead of callbacks.
+//
+//   - context switch: hand-written x86-64 (saves the callee-saved registers,
+//     MXCSR and the x87 control word, swaps rsp); ucontext fallback elsewhere
+//     or with -DFIBER_USE_UCONTEXT
+//   - fiber_stack_pool: mmap'ed stacks with a PROT_NONE guard page below each
+//     one, recycled through per-worker caches so spawn rarely makes a syscall
+//   - fiber_scheduler: one worker thread per core (optionally pinned), each
+//     with a FIFO run queue; idle workers steal from the others and park on
+//     a futex when there is nothing to run
+//   - fiber_mutex, fiber_condition_variable, fiber_channel<T>: blocking only
+//     suspends the fiber and the worker runs the next one. Plain threads may
+//     use them too and then sleep on a futex.
+//   - this_fiber::yield() / sleep_for() (sleeps are timers on a timer_wheel)
+//
+// Fibers move between workers, so a fiber must not hold thread-affine state
+// (a std::mutex, a thread_local reference) across a call that may suspend it.
+//
+// Usage:
+//   fiber_scheduler scheduler;                     // one worker per hardware thread
+//   fiber_channel<int> channel(64);
+//   scheduler.spawn([&] { for (int i = 0; i < 100; ++i) channel.push(i); channel.close(); });
+//   scheduler.spawn([&] { while (auto v = channel.pop()) consume(*v); });
+//   scheduler.wait();                              // until every fiber has finished
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if !defined(__x86_64__) || defined(FIBER_USE_UCONTEXT)
+#define FIBER_CONTEXT_UCONTEXT 1
+#include <ucontext.h>
+#endif
+
+#if defined(__SANITIZE_ADDRESS__)
+#include <sanitizer/common_interface_defs.h>  // __sanitizer_start/finish_switch_fiber
+#endif
+
+#include "cpu_topology.hpp"  // thread_placement, placement_order, pin_current_thread
+#include "futex.hpp"         // cpu_relax, cache_line_size, futex_wait, futex_wake
+#include "mpmc_queue.hpp"    // per-worker run queues
+#include "timer_wheel.hpp"   // this_fiber::sleep_for
+
+class fiber_scheduler;
+
+// --- SECTION 1: Context Switching ---
+
+namespace fiber_detail {
+
+#if defined(FIBER_CONTEXT_UCONTEXT)
+
+struct context {
+    ucontext_t uc;
+    const void* stack_bottom = nullptr;  // Lowest usable address (for the sanitizer)
+    std::size_t stack_size = 0;
+};
+
+// makecontext only passes int arguments, so pointers travel as two halves
+inline void ucontext_entry(unsigned entry_hi, unsigned entry_lo, unsigned arg_hi, unsigned arg_lo) {
+    auto join = [](unsigned hi, unsigned lo) { return (uintptr_t(hi) << 32) | uintptr_t(lo); };
+    auto entry = reinterpret_cast<void (*)(void*)>(join(entry_hi, entry_lo));
+    entry(reinterpret_cast<void*>(join(arg_hi, arg_lo)));
+    std::terminate();  // entry never returns: a fiber leaves by switching away
+}
+
+inline void make_context(context& ctx, void* stack_bottom, std::size_t stack_size, void (*entry)(void*), void* arg) {
+    getcontext(&ctx.uc);
+    ctx.uc.uc_stack.ss_sp = stack_bottom;
+    ctx.uc.uc_stack.ss_size = stack_size;
+    ctx.uc.uc_link = nullptr;
+    auto e = reinterpret_cast<uintptr_t>(entry);
+    auto a = reinterpret_cast<uintptr_t>(arg);
+    makecontext(&ctx.uc, reinterpret_cast<void (*)()>(&ucontext_entry), 4, unsigned(uint64_t(e) >> 32), unsigned(e),
+                unsigned(uint64_t(a) >> 32), unsigned(a));
+    ctx.stack_bottom = stack_bottom;
+    ctx.stack_size = stack_size;
+}
+
+inline void switch_context(context& from, context& to) { swapcontext(&from.uc, &to.uc); }
+
+#else
+
+struct context {
+    void* sp = nullptr;                  // Saved stack pointer; everything else is on the stack
+    const void* stack_bottom = nullptr;  // Lowest usable address (for the sanitizer)
+    std::size_t stack_size = 0;
+};
+
+// Saves the callee-saved registers and the FP control words on the current
+// stack, stores rsp to *save_sp, loads load_sp and pops the same frame off the
+// other stack. Everything else is caller-saved, so the compiler has already
+// spilled what it needs around this (opaque, never inlined) call.
+[[gnu::naked, gnu::noinline]] inline void switch_stack(void** /*save_sp*/, void* /*load_sp*/) {
+    asm("pushq %rbp\n\t"
+        "pushq %rbx\n\t"
+        "pushq %r12\n\t"
+        "pushq %r13\n\t"
+        "pushq %r14\n\t"
+        "pushq %r15\n\t"
+        "subq $8, %rsp\n\t"
+        "stmxcsr (%rsp)\n\t"
+        "fnstcw 4(%rsp)\n\t"
+        "movq %rsp, (%rdi)\n\t"
+        "movq %rsi, %rsp\n\t"
+        "ldmxcsr (%rsp)\n\t"
+        "fldcw 4(%rsp)\n\t"
+        "addq $8, %rsp\n\t"
+        "popq %r15\n\t"
+        "popq %r14\n\t"
+        "popq %r13\n\t"
+        "popq %r12\n\t"
+        "popq %rbx\n\t"
+        "popq %rbp\n\t"
+        "ret\n\t");
+}
+
+// First "return" of a new fiber lands here with the argument in r12 and the
+// entry point in r13 (see make_context). rsp is 16-byte aligned, so the call
+// leaves the entry point with the alignment the ABI expects.
+[[gnu::naked, gnu::noinline]] inline void fiber_trampoline() {
+    asm("movq %r12, %rdi\n\t"
+        "callq *%r13\n\t"
+        "ud2\n\t");
+}
+
+// Lays out the frame switch_stack pops: FP control words, r15..rbp, return address
+inline void make_context(context& ctx, void* stack_bottom, std::size_t stack_size, void (*entry)(void*), void* arg) {
+    uintptr_t top = (reinterpret_cast<uintptr_t>(stack_bottom) + stack_size) & ~uintptr_t(15);
+    auto* frame = reinterpret_cast<uint64_t*>(top) - 8;
+    frame[0] = 0x037F'0000'1F80ull;  // MXCSR default (low half), x87 control word default (high half)
+    frame[1] = 0;                    // r15
+    frame[2] = 0;                    // r14
+    frame[3] = reinterpret_cast<uint64_t>(entry);  // r13
+    frame[4] = reinterpret_cast<uint64_t>(arg);    // r12
+    frame[5] = 0;                                  // rbx
+    frame[6] = 0;                                  // rbp
+    frame[7] = reinterpret_cast<uint64_t>(&fiber_trampoline);  // return address
+    ctx.sp = frame;
+    ctx.stack_bottom = stack_bottom;
+    ctx.stack_size = stack_size;
+}
+
+inline void switch_context(context& from, context& to) { switch_stack(&from.sp, to.sp); }
+
+#endif
+
+// Switches to `to`, returns when something switches back to `from`. AddressSanitizer
+// must be told about stack switches or it reports the other stack as overflow;
+// `exiting` says `from` will never be resumed, so its fake stack can be freed.
+inline void jump(context& from, context& to, bool exiting = false) {
+#if defined(__SANITIZE_ADDRESS__)
+    void* fake_stack = nullptr;
+    __sanitizer_start_switch_fiber(exiting ? nullptr : &fake_stack, to.stack_bottom, to.stack_size);
+    switch_context(from, to);
+    __sanitizer_finish_switch_fiber(fake_stack, nullptr, nullptr);
+#else
+    (void)exiting;
+    switch_context(from, to);
+#endif
+}
+
+// First thing a new fiber runs: completes the switch jump() started
+inline void enter_context() {
+#if defined(__SANITIZE_ADDRESS__)
+    __sanitizer_finish_switch_fiber(nullptr, nullptr, nullptr);
+#endif
+}
+
+// Bounds of the calling thread's own stack, so fibers can switch back to it
+inline void init_thread_context(context& ctx) {
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0) return;
+    void* addr = nullptr;
+    std::size_t size = 0;
+    if (pthread_attr_getstack(&attr, &addr, &size) == 0) {
+        ctx.stack_bottom = addr;
+        ctx.stack_size = size;
+    }
+    pthread_attr_destroy(&attr);
+}
+
+}  // namespace fiber_detail
+
+// --- SECTION 2: Stack Pool ---
+
+struct fiber_stack {
+    void* base = nullptr;         // Start of the mapping (the guard page, if any)
+    std::size_t mapped = 0;       // Bytes mapped including the guard page
+    std::size_t guard = 0;        // 0 or one page
+    void* bottom() const noexcept { return static_cast<char*>(base) + guard; }
+    std::size_t size() const noexcept { return mapped - guard; }
+};
+
+// Stacks are reserved with MAP_NORESERVE, so only the pages a fiber actually
+// touches cost memory. A guard page splits its stack into two mappings and
+// Linux caps a process at vm.max_map_count of them (65530 by default); at the
+// cap every mmap fails, thread stacks and malloc arenas included. The pool
+// therefore guards at most a quarter of that many stacks, hands out unguarded
+// ones (which the kernel merges into a single mapping) after that, and
+// counts both.
+class fiber_stack_pool {
+public:
+    explicit fiber_stack_pool(std::size_t stack_size = 64 * 1024, bool guard_pages = true)
+        : page_(static_cast<std::size_t>(sysconf(_SC_PAGESIZE))),
+          stack_size_((std::max<std::size_t>(stack_size, 16 * 1024) + page_ - 1) / page_ * page_),
+          guard_pages_(guard_pages),
+          max_guarded_(max_map_count() / 4) {}
+
+    ~fiber_stack_pool() {
+        for (const fiber_stack& s : free_) munmap(s.base, s.mapped);
+    }
+
+    fiber_stack_pool(const fiber_stack_pool&) = delete;
+    fiber_stack_pool& operator=(const fiber_stack_pool&) = delete;
+
+    fiber_stack acquire() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!free_.empty()) {
+                fiber_stack s = free_.back();
+                free_.pop_back();
+                return s;
+            }
+        }
+        return map_stack();
+    }
+
+    void release(fiber_stack s) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(s);
+    }
+
+    std::size_t stack_size() const noexcept { return stack_size_; }
+    std::size_t guarded() const noexcept { return guarded_.load(std::memory_order_relaxed); }
+    std::size_t unguarded() const noexcept { return unguarded_.load(std::memory_order_relaxed); }
+
+private:
+    fiber_stack map_stack() {
+        fiber_stack s;
+        bool guard = guard_pages_ && guarded_.load(std::memory_order_relaxed) < max_guarded_;
+        s.guard = guard ? page_ : 0;
+        s.mapped = stack_size_ + s.guard;
+        s.base = mmap(nullptr, s.mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK,
+                      -1, 0);
+        if (s.base == MAP_FAILED) throw std::bad_alloc();
+        if (s.guard != 0 && mprotect(s.base, s.guard, PROT_NONE) != 0) {
+            s.guard = 0;  // Out of mappings: keep the stack, lose the guard
+        }
+        (s.guard != 0 ? guarded_ : unguarded_).fetch_add(1, std::memory_order_relaxed);
+        return s;
+    }
+
+    static std::size_t max_map_count() {
+        int value = 0;
+        return cpu_topology_detail::read_int("/proc/sys/vm/max_map_count", value) && value > 0 ? std::size_t(value)
+                                                                                               : 65530;
+    }
+
+    const std::size_t page_;
+    const std::size_t stack_size_;
+    const bool guard_pages_;
+    const std::size_t max_guarded_;
+    std::mutex mutex_;
+    std::vector<fiber_stack> free_;
+    std::atomic<std::size_t> guarded_{0};
+    std::atomic<std::size_t> unguarded_{0};
+};
+
+// --- SECTION 3: Scheduler ---
+
+namespace fiber_detail {
+
+// Guards the wait queues of the primitives below; held only for a few
+// instructions. Past the spin budget it yields, since on a uniprocessor the
+// holder cannot make progress while we spin.
+class spinlock {
+public:
+    void lock() noexcept {
+        std::size_t spin = 0;
+        while (locked_.exchange(true, std::memory_order_acquire)) {
+            while (locked_.load(std::memory_order_relaxed)) {
+                if (spin++ < default_spin_iterations()) {
+                    cpu_relax();
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    void unlock() noexcept { locked_.store(false, std::memory_order_release); }
+
+private:
+    std::atomic<bool> locked_{false};
+};
+
+// What the worker does right after a fiber has switched back to it. These
+// steps cannot run on the fiber itself: as soon as another worker can see the
+// fiber (requeued, lock released, timer armed) it may resume it, so the fiber
+// must already be off its stack.
+enum class after_switch { none, requeue, unlock, sleep, finish };
+
+struct fiber {
+    virtual ~fiber() = default;
+    virtual void run() = 0;
+
+    context ctx;
+    fiber_scheduler* owner = nullptr;
+    fiber_stack stack;
+    std::size_t last_worker = 0;  // Remote wake-ups go back to this worker's queue
+    after_switch after = after_switch::none;
+    void* after_arg = nullptr;
+};
+
+// The callable lives in the fiber's control block at the top of its own stack
+template <typename Fn>
+struct fiber_impl final : fiber {
+    explicit fiber_impl(Fn&& f) : fn(std::move(f)) {}
+    explicit fiber_impl(const Fn& f) : fn(f) {}
+
+    // Destroys the callable on the fiber, so its destructor may still block
+    void run() override {
+        (*fn)();
+        fn.reset();
+    }
+
+    std::optional<Fn> fn;
+};
+
+struct thread_state {
+    fiber_scheduler* scheduler = nullptr;  // Set on worker threads
+    void* worker = nullptr;
+    fiber* current = nullptr;              // Fiber running on this thread, if any
+};
+
+// A fiber can suspend on one worker and resume on another, and the compiler
+// may keep the address of a thread_local in a register across what it thinks
+// is an ordinary call. Every access goes through this opaque function instead,
+// and callers on a fiber must not keep the reference across a suspension.
+[[gnu::noinline]] inline thread_state& this_thread_state() noexcept {
+    static thread_local thread_state state;
+    asm volatile("" ::: "memory");
+    return state;
+}
+
+}  // namespace fiber_detail
+
+struct fiber_scheduler_options {
+    std::size_t threads = 0;                // 0 = one worker per hardware thread
+    std::size_t stack_size = 64 * 1024;     // Per fiber, rounded up to whole pages
+    bool guard_pages = true;                // PROT_NONE page below each stack
+    thread_placement placement = thread_placement::none;  // Pin worker i to placement_order()[i]
+    std::size_t run_queue_capacity = 1024;  // Per worker; overflow goes to a shared queue
+    std::size_t stack_cache = 64;           // Stacks each worker keeps for reuse
+};
+
+class fiber_scheduler {
+public:
+    struct statistics {
+        uint64_t spawned = 0;
+        uint64_t switches = 0;  // Fiber resumptions (each is two context switches)
+        uint64_t stolen = 0;    // Fibers taken from another worker's queue
+        uint64_t parked = 0;    // Times a worker went to sleep
+        std::size_t stacks_guarded = 0;
+        std::size_t stacks_unguarded = 0;
+    };
+
+    explicit fiber_scheduler(fiber_scheduler_options options = {})
+        : options_(options), stacks_(options.stack_size, options.guard_pages) {
+        std::size_t count = options_.threads;
+        if (count == 0) count = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<int> cpus = placement_order(cpu_topology::system(), options_.placement);
+        for (std::size_t i = 0; i < count; ++i) {
+            workers_.push_back(std::make_unique<worker>(options_.run_queue_capacity));
+            if (!cpus.empty()) workers_[i]->cpu = cpus[i % cpus.size()];
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            workers_[i]->thread = std::thread([this, i] { worker_loop(i); });
+        }
+    }
+
+    explicit fiber_scheduler(std::size_t threads) : fiber_scheduler(with_threads(threads)) {}
+
+    // Waits for every fiber, then stops the workers
+    ~fiber_scheduler() {
+        wait();
+        stopping_.store(true, std::memory_order_seq_cst);
+        wake_all();
+        for (auto& w : workers_) {
+            if (w->thread.joinable()) w->thread.join();
+        }
+        for (auto& w : workers_) {
+            for (const fiber_stack& s : w->stack_cache) stacks_.release(s);
+        }
+        timers_.reset();
+    }
+
+    fiber_scheduler(const fiber_scheduler&) = delete;
+    fiber_scheduler& operator=(const fiber_scheduler&) = delete;
+
+    // Starts fn() on a new fiber. From a worker the fiber is queued locally,
+    // from any other thread it is spread round-robin over the workers.
+    // An exception escaping fn terminates the program, as for std::thread.
+    template <typename Fn>
+    void spawn(Fn&& fn) {
+        using impl = fiber_detail::fiber_impl<std::decay_t<Fn>>;
+        fiber_stack stack = acquire_stack();
+        std::size_t room = stack.size() / 4;
+        if (sizeof(impl) + alignof(impl) > room) {
+            release_stack(stack);
+            throw std::invalid_argument("fiber_scheduler: callable too large for the fiber stack");
+        }
+
+        // Control block at the very top, the usable stack below it
+        uintptr_t top = reinterpret_cast<uintptr_t>(stack.bottom()) + stack.size();
+        uintptr_t block = (top - sizeof(impl)) & ~(uintptr_t(std::max<std::size_t>(alignof(impl), 16)) - 1);
+        impl* f = new (reinterpret_cast<void*>(block)) impl(std::forward<Fn>(fn));
+        f->owner = this;
+        f->stack = stack;
+        std::size_t usable = block - reinterpret_cast<uintptr_t>(stack.bottom());
+        fiber_detail::make_context(f->ctx, stack.bottom(), usable, &fiber_main, static_cast<fiber_detail::fiber*>(f));
+
+        live_.fetch_add(1, std::memory_order_relaxed);
+        spawned_.fetch_add(1, std::memory_order_relaxed);
+        fiber_detail::thread_state& ts = fiber_detail::this_thread_state();
+        if (ts.scheduler != this) {
+            f->last_worker = next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+        }
+        make_ready(f);
+    }
+
+    // Blocks the calling thread until no fiber is left. Must not be called on
+    // a fiber of this scheduler (it would block the worker running it).
+    void wait() {
+        for (uint32_t n = live_.load(std::memory_order_acquire); n != 0; n = live_.load(std::memory_order_acquire)) {
+            futex_wait(live_, n);
+        }
+    }
+
+    std::size_t size() const noexcept { return workers_.size(); }
+    std::size_t live() const noexcept { return live_.load(std::memory_order_relaxed); }
+
+    statistics stats() const {
+        statistics s;
+        s.spawned = spawned_.load(std::memory_order_relaxed);
+        for (const auto& w : workers_) {
+            s.switches += w->switches.load(std::memory_order_relaxed);
+            s.stolen += w->stolen.load(std::memory_order_relaxed);
+            s.parked += w->parked.load(std::memory_order_relaxed);
+        }
+        s.stacks_guarded = stacks_.guarded();
+        s.stacks_unguarded = stacks_.unguarded();
+        return s;
+    }
+
+    // --- Used by this_fiber and the synchronization primitives ---
+
+    // Makes a suspended fiber runnable again; callable from any thread.
+    // `wake_idle` = false skips waking a parked worker (and the fence that
+    // costs) when the caller's own worker is about to run the fiber anyway.
+    void make_ready(fiber_detail::fiber* f, bool wake_idle = true) {
+        fiber_detail::thread_state& ts = fiber_detail::this_thread_state();
+        worker* target = ts.scheduler == this ? static_cast<worker*>(ts.worker) : workers_[f->last_worker].get();
+        if (!target->run_queue.try_push(f)) {
+            std::lock_guard<std::mutex> lock(injection_mutex_);
+            injection_.push_back(f);
+            injection_size_.fetch_add(1, std::memory_order_relaxed);
+            wake_idle = true;
+        }
+        if (wake_idle) notify();
+    }
+
+    // Switches the current fiber out; the worker then performs `action`.
+    // Returns when the fiber is resumed, possibly on another worker.
+    static void suspend(fiber_detail::after_switch action, void* arg = nullptr) {
+        fiber_detail::thread_state& ts = fiber_detail::this_thread_state();
+        fiber_detail::fiber* f = ts.current;
+        worker* w = static_cast<worker*>(ts.worker);
+        f->after = action;
+        f->after_arg = arg;
+        fiber_detail::jump(f->ctx, w->main, action == fiber_detail::after_switch::finish);
+    }
+
+    timer_wheel& timers() {
+        std::call_once(timers_once_, [this] { timers_ = std::make_unique<timer_wheel>(); });
+        return *timers_;
+    }
+
+private:
+    struct worker {
+        explicit worker(std::size_t capacity) : run_queue(capacity) {}
+
+        mpmc_queue<fiber_detail::fiber*> run_queue;  // FIFO: a yielding fiber goes behind the others
+        fiber_detail::context main;                  // The worker thread's own stack
+        std::vector<fiber_stack> stack_cache;        // Touched by the owning worker only
+        std::thread thread;
+        int cpu = -1;
+        alignas(cache_line_size) std::atomic<uint64_t> switches{0};
+        std::atomic<uint64_t> stolen{0};
+        std::atomic<uint64_t> parked{0};
+    };
+
+    static fiber_scheduler_options with_threads(std::size_t threads) {
+        fiber_scheduler_options options;
+        options.threads = threads;
+        return options;
+    }
+
+    static void fiber_main(void* arg) {
+        fiber_detail::enter_context();
+        auto* f = static_cast<fiber_detail::fiber*>(arg);
+        try {
+            f->run();
+        } catch (...) {
+            std::terminate();
+        }
+        suspend(fiber_detail::after_switch::finish);
+    }
+
+    fiber_stack acquire_stack() {
+        fiber_detail::thread_state& ts = fiber_detail::this_thread_state();
+        if (ts.scheduler == this) {
+            auto& cache = static_cast<worker*>(ts.worker)->stack_cache;
+            if (!cache.empty()) {
+                fiber_stack s = cache.back();
+                cache.pop_back();
+                return s;
+            }
+        }
+        return stacks_.acquire();
+    }
+
+    void release_stack(fiber_stack s) {
+        fiber_detail::thread_state& ts = fiber_detail::this_thread_state();
+        if (ts.scheduler == this) {
+            auto& cache = static_cast<worker*>(ts.worker)->stack_cache;
+            if (cache.size() < options_.stack_cache) {
+                cache.push_back(s);
+                return;
+            }
+        }
+        stacks_.release(s);
+    }
+
+    void worker_loop(std::size_t index) {
+        worker& self = *workers_[index];
+        // The worker thread itself never migrates, so holding this reference is fine
+        fiber_detail::thread_state& ts = fiber_detail::this_thread_state();
+        ts.scheduler = this;
+        ts.worker = &self;
+        fiber_detail::init_thread_context(self.main);
+        if (self.cpu >= 0) pin_current_thread(self.cpu);
+
+        for (;;) {
+            fiber_detail::fiber* f = nullptr;
+            if (find_fiber(index, f)) {
+                resume(self, index, f, ts);
+                continue;
+            }
+
+            bool found = false;
+            std::size_t spins = default_spin_iterations(4096);
+            for (std::size_t spin = 0; spin < spins && !found; ++spin) {
+                cpu_relax();
+                if ((spin & 63) == 63) found = has_visible_work();
+            }
+            if (found) continue;
+
+            if (stopping_.load(std::memory_order_acquire) && !has_visible_work()) return;
+            park(self);
+        }
+    }
+
+    void resume(worker& self, std::size_t index, fiber_detail::fiber* f, fiber_detail::thread_state& ts) {
+        ts.current = f;
+        f->last_worker = index;
+        self.switches.fetch_add(1, std::memory_order_relaxed);
+        fiber_detail::jump(self.main, f->ctx);
+        ts.current = nullptr;
+
+        fiber_detail::after_switch action = f->after;
+        f->after = fiber_detail::after_switch::none;
+        switch (action) {
+        case fiber_detail::after_switch::none:
+            break;
+        case fiber_detail::after_switch::requeue:
+            make_ready(f, false);  // A yield: this worker is awake and will get back to it
+            break;
+        case fiber_detail::after_switch::unlock:
+            static_cast<fiber_detail::spinlock*>(f->after_arg)->unlock();
+            break;
+        case fiber_detail::after_switch::sleep:
+            timers().schedule_after(*static_cast<std::chrono::nanoseconds*>(f->after_arg), [this, f] { make_ready(f); });
+            break;
+        case fiber_detail::after_switch::finish:
+            finish(f);
+            break;
+        }
+    }
+
+    void finish(fiber_detail::fiber* f) {
+        fiber_stack stack = f->stack;
+        f->~fiber();
+        release_stack(stack);
+        if (live_.fetch_sub(1, std::memory_order_acq_rel) == 1) futex_wake_all(live_);
+    }
+
+    bool find_fiber(std::size_t self, fiber_detail::fiber*& f) {
+        if (workers_[self]->run_queue.try_pop(f)) return true;
+        if (pop_injection(f)) return true;
+        std::size_t n = workers_.size();
+        std::size_t start = next_random() % n;
+        for (std::size_t k = 0; k < n; ++k) {
+            std::size_t victim = (start + k) % n;
+            if (victim != self && workers_[victim]->run_queue.try_pop(f)) {
+                workers_[self]->stolen.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool pop_injection(fiber_detail::fiber*& f) {
+        if (injection_size_.load(std::memory_order_relaxed) == 0) return false;
+        std::lock_guard<std::mutex> lock(injection_mutex_);
+        if (injection_.empty()) return false;
+        f = injection_.front();
+        injection_.pop_front();
+        injection_size_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool has_visible_work() const {
+        if (injection_size_.load(std::memory_order_relaxed) > 0) return true;
+        for (const auto& w : workers_) {
+            if (w->run_queue.size_approx() > 0) return true;
+        }
+        return false;
+    }
+
+    // Same eventcount protocol as thread_pool::park / notify
+    void park(worker& self) {
+        uint32_t epoch = wake_epoch_.load(std::memory_order_acquire);
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (has_visible_work() || stopping_.load(std::memory_order_seq_cst)) {
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+            return;
+        }
+        self.parked.fetch_add(1, std::memory_order_relaxed);
+        futex_wait(wake_epoch_, epoch);
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_relaxed) == 0) return;
+        wake_epoch_.fetch_add(1, std::memory_order_release);
+        futex_wake(wake_epoch_, 1);
+    }
+
+    void wake_all() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        wake_epoch_.fetch_add(1, std::memory_order_release);
+        futex_wake_all(wake_epoch_);
+    }
+
+    static std::size_t next_random() {
+        static thread_local uint64_t state =
+            0x9E3779B97F4A7C15ull ^ std::hash<std::thread::id>{}(std::this_thread::get_id());
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return static_cast<std::size_t>(state);
+    }
+
+    fiber_scheduler_options options_;
+    fiber_stack_pool stacks_;
+    std::vector<std::unique_ptr<worker>> workers_;
+
+    std::mutex injection_mutex_;
+    std::deque<fiber_detail::fiber*> injection_;
+    alignas(cache_line_size) std::atomic<std::size_t> injection_size_{0};
+
+    alignas(cache_line_size) std::atomic<uint32_t> wake_epoch_{0};
+    std::atomic<uint32_t> sleepers_{0};
+    std::atomic<bool> stopping_{false};
+
+    alignas(cache_line_size) std::atomic<uint32_t> live_{0};
+    std::atomic<uint64_t> spawned_{0};
+    std::atomic<std::size_t> next_worker_{0};
+
+    std::once_flag timers_once_;
+    std::unique_ptr<timer_wheel> timers_;
+};
+
+// --- SECTION 4: Fiber-Aware Synchronization ---
+
+namespace this_fiber {
+
+// True on a fiber, false on an ordinary thread
+inline bool on_fiber() noexcept { return fiber_detail::this_thread_state().current != nullptr; }
+
+// Lets the other runnable fibers of this worker run first; on a plain thread
+// it is std::this_thread::yield()
+inline void yield() {
+    if (on_fiber()) {
+        fiber_scheduler::suspend(fiber_detail::after_switch::requeue);
+    } else {
+        std::this_thread::yield();
+    }
+}
+
+// Suspends only the fiber: the worker keeps running others until the timer fires
+template <typename Rep, typename Period>
+void sleep_for(std::chrono::duration<Rep, Period> duration) {
+    if (!on_fiber()) {
+        std::this_thread::sleep_for(duration);
+        return;
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration);
+    if (ns <= std::chrono::nanoseconds::zero()) {
+        yield();
+        return;
+    }
+    fiber_scheduler::suspend(fiber_detail::after_switch::sleep, &ns);
+}
+
+}  // namespace this_fiber
+
+namespace fiber_detail {
+
+// Lives on the waiter's stack while it is queued. A fiber is woken by making
+// it runnable; an ordinary thread sleeps on `ready` with a futex.
+struct waiter {
+    fiber* f = nullptr;
+    std::atomic<uint32_t> ready{0};
+    waiter* next = nullptr;
+};
+
+// Intrusive FIFO; every operation runs under the owner's spinlock
+class waiter_queue {
+public:
+    bool empty() const noexcept { return head_ == nullptr; }
+
+    void push(waiter* w) noexcept {
+        w->next = nullptr;
+        if (tail_) {
+            tail_->next = w;
+        } else {
+            head_ = w;
+        }
+        tail_ = w;
+    }
+
+    waiter* pop() noexcept {
+        waiter* w = head_;
+        if (w) {
+            head_ = w->next;
+            if (!head_) tail_ = nullptr;
+        }
+        return w;
+    }
+
+    // Detaches the whole list; walk it with next
+    waiter* take_all() noexcept {
+        waiter* w = head_;
+        head_ = tail_ = nullptr;
+        return w;
+    }
+
+private:
+    waiter* head_ = nullptr;
+    waiter* tail_ = nullptr;
+};
+
+// Called with `lock` held: queues the caller, releases `lock` and sleeps until
+// wake(). A fiber keeps the lock until it is off its stack, so a waker that
+// pops it under the same lock can never resume a fiber that is still running.
+inline void block(spinlock& lock, waiter_queue& queue) {
+    waiter w;
+    w.f = this_thread_state().current;
+    queue.push(&w);
+    if (w.f) {
+        fiber_scheduler::suspend(after_switch::unlock, &lock);
+        return;
+    }
+    lock.unlock();
+    while (w.ready.load(std::memory_order_acquire) == 0) futex_wait(w.ready, 0);
+}
+
+// Call after releasing the lock the waiter was popped under. Nothing is read
+// from `w` after it is released: the owner may return and reuse the stack
+// slot at once (a futex_wake on a dead address is at worst a spurious wake-up).
+inline void wake(waiter* w) {
+    if (fiber* f = w->f) {
+        f->owner->make_ready(f);
+        return;
+    }
+    w->ready.store(1, std::memory_order_release);
+    futex_wake(w->ready);
+}
+
+inline void wake_list(waiter* w) {
+    while (w) {
+        waiter* next = w->next;
+        wake(w);
+        w = next;
+    }
+}
+
+}  // namespace fiber_detail
+
+// Mutex that suspends the fiber instead of the worker thread. Ownership is
+// handed directly to the longest waiter on unlock (FIFO, no barging), which
+// keeps 10^5 contending fibers from starving each other.
+class fiber_mutex {
+public:
+    void lock() {
+        lock_.lock();
+        if (!locked_) {
+            locked_ = true;
+            lock_.unlock();
+            return;
+        }
+        fiber_detail::block(lock_, waiters_);  // unlock() handed the mutex over to us
+    }
+
+    bool try_lock() {
+        std::lock_guard<fiber_detail::spinlock> guard(lock_);
+        if (locked_) return false;
+        locked_ = true;
+        return true;
+    }
+
+    void unlock() {
+        lock_.lock();
+        fiber_detail::waiter* next = waiters_.pop();
+        if (!next) locked_ = false;
+        lock_.unlock();
+        if (next) fiber_detail::wake(next);
+    }
+
+private:
+    fiber_detail::spinlock lock_;
+    bool locked_ = false;
+    fiber_detail::waiter_queue waiters_;
+};
+
+class fiber_condition_variable {
+public:
+    // The waiter is queued before `lock` is released, so a notify issued after
+    // the caller's predicate check cannot be lost
+    void wait(std::unique_lock<fiber_mutex>& lock) {
+        lock_.lock();
+        lock.unlock();
+        fiber_detail::block(lock_, waiters_);
+        lock.lock();
+    }
+
+    template <typename Predicate>
+    void wait(std::unique_lock<fiber_mutex>& lock, Predicate pred) {
+        while (!pred()) wait(lock);
+    }
+
+    void notify_one() {
+        lock_.lock();
+        fiber_detail::waiter* w = waiters_.pop();
+        lock_.unlock();
+        if (w) fiber_detail::wake(w);
+    }
+
+    void notify_all() {
+        lock_.lock();
+        fiber_detail::waiter* list = waiters_.take_all();
+        lock_.unlock();
+        fiber_detail::wake_list(list);
+    }
+
+private:
+    fiber_detail::spinlock lock_;
+    fiber_detail::waiter_queue waiters_;
+};
+
+// Bounded multi-producer / multi-consumer channel. push() suspends while the
+// channel is full (backpressure), pop() while it is empty. After close()
+// pushes fail and pops drain what is left, then return std::nullopt.
+template <typename T>
+class fiber_channel {
+public:
+    explicit fiber_channel(std::size_t capacity) : capacity_(std::max<std::size_t>(capacity, 1)) {}
+
+    fiber_channel(const fiber_channel&) = delete;
+    fiber_channel& operator=(const fiber_channel&) = delete;
+
+    // False if the channel is closed
+    bool push(T value) {
+        lock_.lock();
+        for (;;) {
+            if (closed_) {
+                lock_.unlock();
+                return false;
+            }
+            if (buffer_.size() < capacity_) break;
+            fiber_detail::block(lock_, senders_);
+            lock_.lock();
+        }
+        buffer_.push_back(std::move(value));
+        fiber_detail::waiter* receiver = receivers_.pop();
+        lock_.unlock();
+        if (receiver) fiber_detail::wake(receiver);
+        return true;
+    }
+
+    bool try_push(T value) {
+        lock_.lock();
+        if (closed_ || buffer_.size() >= capacity_) {
+            lock_.unlock();
+            return false;
+        }
+        buffer_.push_back(std::move(value));
+        fiber_detail::waiter* receiver = receivers_.pop();
+        lock_.unlock();
+        if (receiver) fiber_detail::wake(receiver);
+        return true;
+    }
+
+    // std::nullopt once the channel is closed and drained
+    std::optional<T> pop() {
+        lock_.lock();
+        while (buffer_.empty()) {
+            if (closed_) {
+                lock_.unlock();
+                return std::nullopt;
+            }
+            fiber_detail::block(lock_, receivers_);
+            lock_.lock();
+        }
+        return take_front();
+    }
+
+    std::optional<T> try_pop() {
+        lock_.lock();
+        if (buffer_.empty()) {
+            lock_.unlock();
+            return std::nullopt;
+        }
+        return take_front();
+    }
+
+    // Wakes every waiter: blocked pushes fail, blocked pops drain then end
+    void close() {
+        lock_.lock();
+        closed_ = true;
+        fiber_detail::waiter* senders = senders_.take_all();
+        fiber_detail::waiter* receivers = receivers_.take_all();
+        lock_.unlock();
+        fiber_detail::wake_list(senders);
+        fiber_detail::wake_list(receivers);
+    }
+
+    std::size_t capacity() const noexcept { return capacity_; }
+
+private:
+    // Called with lock_ held and a non-empty buffer; releases lock_
+    std::optional<T> take_front() {
+        std::optional<T> value(std::move(buffer_.front()));
+        buffer_.pop_front();
+        fiber_detail::waiter* sender = senders_.pop();
+        lock_.unlock();
+        if (sender) fiber_detail::wake(sender);
+        return value;
+    }
+
+    const std::size_t capacity_;
+    fiber_detail::spinlock lock_;
+    bool closed_ = false;
+    std::deque<T> buffer_;
+    fiber_detail::waiter_queue senders_;
+    fiber_detail::waiter_queue receivers_;
+};
@@ -4,8 +4,25 @@
 #include <sstream>
 #include <cstring>
 #include <cstdlib>
-#include <sys/stat.h>   // For checking if file exists
+#include <sys/stat.h>   // For checking if file exists (and mkdir)
+#include <fcntl.h>      // For posix_fadvise (dropping the page cache)
+#include <unistd.h>     // For fdatasync, pread and close
 #include <vector>        // For using vectors with files
+#include <chrono>        // For timing the line reading benchmark
+#include <cstdio>        // For popen (reading through a pipe)
+#include <random>        // For generating test data
+#include <algorithm>     // For sorting latencies
+#include <iomanip>       // For aligning the benchmark tables
+#include <thread>        // For hardware_concurrency
+
+#include "line_reader.hpp"  // Zero-copy mmap/read() line reader
+#include "byte_reader.hpp"  // Block-buffered byte reader
+#include "async_io.hpp"     // io_uring engine with a thread-pool fallback
+#include "column_file.hpp"  // Chunked, checksummed binary columns
+#include "parallel_text.hpp"  // Line-aligned parallel text processing
+#include "tokenizer.hpp"  // Allocation-free SIMD tokenizer and CSV reader
+
+#include "alloc_tracker.hpp"  // Allocation counting (compile with -DENABLE_ALLOC_TRACKER)
 
 using namespace std;
 
@@ -51,14 +68,14 @@ void readFileLineByLine() {
 void readFileCharacterByCharacter() {
     cout << "--- SECTION 3: Reading Character by Character ---" << endl;
 
-    ifstream inFile("output.txt");  // Open the file for reading
-    if (inFile.is_open()) {
-        char ch;
-        while (inFile.get(ch)) {  // Read each character
-            cout << ch;  // Print the character
-        }
-        inFile.close();  // Close the file after reading
-    } else {
+    // inFile.get(ch) pays for a stream sentry per character; byte_reader reads
+    // whole blocks and calls back for each byte (see SECTION 11 for the cost)
+    try {
+        byte_reader reader("output.txt");  // Open the file for reading
+        reader.for_each_byte([](uint8_t ch) {
+            cout << static_cast<char>(ch);  // Print the character
+        });
+    } catch (const system_error& e) {
         cerr << "Error opening file for reading!" << endl;
     }
     cout << endl;
@@ -71,13 +88,13 @@ void readFileCharacterByCharacter() {
 void writeBinaryFile() {
     cout << "--- SECTION 4: Writing to a Binary File ---" << endl;
 
-    ofstream outFile("binary_output.dat", ios::binary);  // Open a file in binary mode
-    if (outFile.is_open()) {
-        int data[] = {10, 20, 30, 40, 50};  // Sample data to write
-        outFile.write(reinterpret_cast<char*>(data), sizeof(data));  // Write raw data (binary)
-        outFile.close();
+    int data[] = {10, 20, 30, 40, 50};  // Sample data to write
+    // A column file stores the count, byte order and a checksum along with the
+    // values, so the reader needs no outside knowledge (see SECTION 13)
+    try {
+        write_column_file<int32_t>("binary_output.dat", data);
         cout << "Binary data has been written to 'binary_output.dat'." << endl;
-    } else {
+    } catch (const system_error& e) {
         cerr << "Error opening binary file for writing!" << endl;
     }
     cout << endl;
@@ -87,16 +104,14 @@ void writeBinaryFile() {
 void readBinaryFile() {
     cout << "--- SECTION 5: Reading from a Binary File ---" << endl;
 
-    ifstream inFile("binary_output.dat", ios::binary);  // Open file in binary mode
-    if (inFile.is_open()) {
-        int data[5];  // Array to store the data read
-        inFile.read(reinterpret_cast<char*>(data), sizeof(data));  // Read raw binary data
-        for (int i = 0; i < 5; i++) {
+    try {
+        column_file_reader reader("binary_output.dat");  // Checks the header, index and trailer
+        vector<int32_t> data = reader.read_all<int32_t>();  // However many values were written
+        for (size_t i = 0; i < data.size(); i++) {
             cout << "Data[" << i << "]: " << data[i] << endl;  // Print the binary data
         }
-        inFile.close();
-    } else {
-        cerr << "Error opening binary file for reading!" << endl;
+    } catch (const exception& e) {
+        cerr << "Error reading binary file: " << e.what() << endl;
     }
     cout << endl;
 }
@@ -184,15 +199,636 @@ void stringStreamOperations() {
     string content = ss.str();  // Convert stringstream to a string
     cout << "Content in stringstream:\n" << content << endl;
 
-    // Example of reading from a stringstream like file reading
-    ss.str(content);  // Reset the stringstream with content
-    string word;
-    while (ss >> word) {
+    // Split the content into words without copying: each word is a view into
+    // `content`, where ss >> word would build a new string (see SECTION 15)
+    for (string_view word : tokenizer(content)) {
         cout << "Word: " << word << endl;  // Print each word
     }
     cout << endl;
 }
 
+// --- SECTION 7: Zero-Copy Line Reading ---
+// This section compares getline with line_reader on a large file.
+
+// Write roughly `megabytes` MiB of text lines of 10 to 150 characters
+void generateTextFile(const string& path, size_t megabytes) {
+    ofstream outFile(path, ios::binary);
+    mt19937 rng(42);
+    string block;
+    const size_t target = megabytes << 20;
+    size_t written = 0;
+    while (written < target) {
+        block.clear();
+        while (block.size() < (1 << 20)) {
+            size_t length = 10 + rng() % 141;
+            for (size_t i = 0; i < length; ++i) {
+                block += static_cast<char>('a' + (i * 7 + length) % 26);
+            }
+            block += '\n';
+        }
+        outFile.write(block.data(), static_cast<streamsize>(block.size()));
+        written += block.size();
+    }
+}
+
+// Read every line with `readLines`, which calls back with each line's length,
+// and print the throughput. All variants must agree on lines and bytes.
+template <typename ReadLines>
+void timeLineReading(const string& name, size_t fileBytes, ReadLines readLines) {
+    size_t lines = 0, lineBytes = 0;
+    auto start = chrono::steady_clock::now();
+    readLines([&](size_t length) {
+        ++lines;
+        lineBytes += length;
+    });
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    cout << "  " << name << ": " << elapsed.count() << " s, " << fileBytes / elapsed.count() / 1e9 << " GB/s, "
+         << lines << " lines, " << lineBytes << " bytes of text" << endl;
+}
+
+void lineReaderBenchmark(size_t megabytes) {
+    cout << "--- SECTION 10: Zero-Copy Line Reading ---" << endl;
+
+    const string path = "lines_benchmark.txt";
+    generateTextFile(path, megabytes);
+    struct stat info;
+    stat(path.c_str(), &info);
+    size_t fileBytes = static_cast<size_t>(info.st_size);
+    cout << "Reading " << fileBytes / (1 << 20) << " MiB (page cache warm, newline search: "
+         << isa_name(simd_kernels().isa) << ")" << endl;
+
+    // The readFileLineByLine approach: every line copied into a std::string
+    timeLineReading("ifstream + getline", fileBytes, [&](auto onLine) {
+        ifstream inFile(path);
+        string line;
+        while (getline(inFile, line)) onLine(line.size());
+    });
+
+    // Views straight into the mapped file
+    timeLineReading("line_reader (mmap)", fileBytes, [&](auto onLine) {
+        line_reader reader(path);
+        for (string_view line : reader) onLine(line.size());
+    });
+
+    // The fallback path: 1 MiB read() calls, views into the buffer
+    timeLineReading("line_reader (read)", fileBytes, [&](auto onLine) {
+        line_reader_options options;
+        options.use_mmap = false;
+        line_reader reader(path, options);
+        for (string_view line : reader) onLine(line.size());
+    });
+
+    // A pipe cannot be mapped, so this always takes the read() path
+    timeLineReading("line_reader (pipe)", fileBytes, [&](auto onLine) {
+        FILE* pipe = popen(("cat " + path).c_str(), "r");
+        if (!pipe) return;
+        {
+            line_reader reader(fileno(pipe));
+            for (string_view line : reader) onLine(line.size());
+        }
+        pclose(pipe);
+    });
+
+    remove(path.c_str());
+    cout << endl;
+}
+
+// --- SECTION 8: Block-Buffered Byte Reading ---
+// This section compares inFile.get(ch) with byte_reader for a byte-at-a-time scan.
+
+// Evict the file from the page cache so every variant starts cold
+void dropFromPageCache(const string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+// A checksum-style scan: every byte feeds `onByte`. Prints the throughput;
+// all variants must agree on the sum and the newline count.
+template <typename ReadBytes>
+void timeByteReading(const string& name, const string& path, size_t fileBytes, bool cold, ReadBytes readBytes) {
+    if (cold) dropFromPageCache(path);
+    uint64_t sum = 0, newlines = 0;
+    auto start = chrono::steady_clock::now();
+    readBytes([&](uint8_t b) {
+        sum += b;
+        newlines += b == '\n';
+    });
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    cout << "  " << name << ": " << elapsed.count() << " s, " << fileBytes / elapsed.count() / 1e6 << " MB/s, sum "
+         << sum << ", " << newlines << " newlines" << endl;
+}
+
+void byteReaderBenchmark(size_t megabytes) {
+    cout << "--- SECTION 11: Block-Buffered Byte Reading ---" << endl;
+
+    const string path = "bytes_benchmark.txt";
+    generateTextFile(path, megabytes);
+    struct stat info;
+    stat(path.c_str(), &info);
+    size_t fileBytes = static_cast<size_t>(info.st_size);
+
+    for (bool cold : {false, true}) {
+        cout << "Scanning " << fileBytes / (1 << 20) << " MiB, page cache " << (cold ? "cold" : "warm") << endl;
+
+        // The readFileCharacterByCharacter loop
+        timeByteReading("ifstream::get(ch)", path, fileBytes, cold, [&](auto onByte) {
+            ifstream inFile(path, ios::binary);
+            char ch;
+            while (inFile.get(ch)) onByte(static_cast<uint8_t>(ch));
+        });
+
+        for (byte_read_ahead mode : {byte_read_ahead::none, byte_read_ahead::fadvise, byte_read_ahead::thread}) {
+            const char* names[] = {"byte_reader (no read-ahead)", "byte_reader (fadvise)", "byte_reader (thread)"};
+            timeByteReading(names[static_cast<int>(mode)], path, fileBytes, cold, [&](auto onByte) {
+                byte_reader_options options;
+                options.read_ahead = mode;
+                byte_reader reader(path, options);
+                reader.for_each_byte(onByte);  // onByte is inlined into the block loop
+            });
+        }
+
+        // Span at a time: the caller owns the inner loop
+        timeByteReading("byte_reader (peek/consume)", path, fileBytes, cold, [&](auto onByte) {
+            byte_reader reader(path);
+            for (span<const uint8_t> bytes = reader.peek(); !bytes.empty(); bytes = reader.peek()) {
+                for (uint8_t b : bytes) onByte(b);
+                reader.consume(bytes.size());
+            }
+        });
+    }
+
+    remove(path.c_str());
+    cout << endl;
+}
+
+// --- SECTION 9: Asynchronous File I/O ---
+// This section measures random-read IOPS and latency, and reading many small
+// files, with synchronous calls, io_uring and the thread-pool fallback.
+
+// Median and 99th percentile of the per-read latencies, in microseconds
+void printLatencies(vector<double>& micros) {
+    sort(micros.begin(), micros.end());
+    cout << ", p50 " << micros[micros.size() / 2] << " us, p99 " << micros[micros.size() * 99 / 100] << " us" << endl;
+}
+
+// Keeps `depth` random 4 KiB reads in flight until `reads` have completed
+struct RandomReader {
+    async_io& io;
+    int fd;
+    size_t blocks;
+    size_t reads;
+    bool fixed;  // Registered buffer and fixed file
+    vector<char>& buffers;
+    mt19937_64 rng{7};
+    size_t issued = 0;
+    vector<double> micros{};
+
+    void issue(size_t slot) {
+        ++issued;
+        char* buffer = buffers.data() + slot * 4096;
+        uint64_t offset = rng() % blocks * 4096;
+        auto start = chrono::steady_clock::now();
+        auto done = [this, slot, start](int result) {
+            if (result != 4096) cerr << "short read: " << result << endl;
+            micros.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+            if (issued < reads) issue(slot);  // Reuse the buffer for the next read
+        };
+        if (fixed) {
+            io.read_fixed(fixed_file(0), buffer, 4096, offset, 0, done);
+        } else {
+            io.read(fd, buffer, 4096, offset, done);
+        }
+    }
+};
+
+// Forcing async_io_backend::io_uring throws std::system_error where the kernel,
+// container or seccomp profile does not allow it; that row is reported, not fatal
+void timeRandomReads(const string& path, size_t fileBytes, size_t reads, bool cold, async_io_backend backend,
+                     size_t depth, bool fixed) {
+    if (cold) dropFromPageCache(path);
+    async_io_options options;
+    options.backend = backend;
+    options.queue_depth = static_cast<unsigned>(depth);
+    try {
+        async_io io(options);
+        int fd = open(path.c_str(), O_RDONLY);
+        vector<char> buffers(depth * 4096);
+        if (fixed) {
+            try {
+                iovec region{buffers.data(), buffers.size()};
+                io.register_buffers({&region, 1});  // Counts against RLIMIT_MEMLOCK on older kernels
+                io.register_files({&fd, 1});
+            } catch (const system_error&) {
+                close(fd);
+                throw;
+            }
+        }
+
+        RandomReader reader{io, fd, fileBytes / 4096, reads, fixed, buffers};
+        reader.micros.reserve(reads);
+        auto start = chrono::steady_clock::now();
+        for (size_t slot = 0; slot < depth && slot < reads; ++slot) reader.issue(slot);
+        io.drain();
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        close(fd);
+
+        cout << "  " << async_io_backend_name(io.backend()) << (fixed ? " (fixed)" : "") << ", depth " << depth
+             << ": " << static_cast<size_t>(reads / elapsed.count()) << " IOPS, "
+             << static_cast<double>(io.stats().submitted) / static_cast<double>(max<uint64_t>(io.stats().batches, 1))
+             << " reads per submit";
+        printLatencies(reader.micros);
+    } catch (const system_error& e) {
+        cout << "  " << async_io_backend_name(backend) << (fixed ? " (fixed)" : "") << ", depth " << depth
+             << ": io_uring unavailable (" << e.what() << ")" << endl;
+    }
+}
+
+// The synchronous baseline: one pread at a time
+void timeSyncReads(const string& path, size_t fileBytes, size_t reads, bool cold) {
+    if (cold) dropFromPageCache(path);
+    int fd = open(path.c_str(), O_RDONLY);
+    char buffer[4096];
+    mt19937_64 rng(7);
+    vector<double> micros;
+    micros.reserve(reads);
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < reads; ++i) {
+        auto readStart = chrono::steady_clock::now();
+        if (pread(fd, buffer, sizeof buffer, static_cast<off_t>(rng() % (fileBytes / 4096) * 4096)) != 4096) {
+            cerr << "short read" << endl;
+        }
+        micros.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - readStart).count());
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    close(fd);
+    cout << "  pread, depth 1: " << static_cast<size_t>(reads / elapsed.count()) << " IOPS";
+    printLatencies(micros);
+}
+
+// Open, read and close every file, keeping up to 64 files in flight. Each
+// completion queues the next step of its file: openat -> read -> close.
+struct ManyFileReader {
+    async_io& io;
+    const vector<string>& paths;
+    size_t next = 0;
+    size_t bytes = 0;
+    vector<char> buffers = vector<char>(64 * 8192);
+
+    void start(size_t slot) {
+        if (next == paths.size()) return;
+        io.openat(AT_FDCWD, paths[next++].c_str(), O_RDONLY, 0, [this, slot](int fd) {
+            if (fd < 0) return start(slot);
+            io.read(fd, buffers.data() + slot * 8192, 8192, 0, [this, slot, fd](int n) {
+                if (n > 0) bytes += static_cast<size_t>(n);
+                io.close(fd, [this, slot](int) { start(slot); });
+            });
+        });
+    }
+};
+
+void asyncIoBenchmark(size_t megabytes, size_t files) {
+    cout << "--- SECTION 12: Asynchronous File I/O ---" << endl;
+
+    const string path = "async_benchmark.bin";
+    generateTextFile(path, megabytes);
+    struct stat info;
+    stat(path.c_str(), &info);
+    size_t fileBytes = static_cast<size_t>(info.st_size);
+
+    for (bool cold : {false, true}) {
+        size_t reads = cold ? 20000 : 200000;
+        cout << reads << " random 4 KiB reads from " << fileBytes / (1 << 20) << " MiB, page cache "
+             << (cold ? "cold" : "warm") << endl;
+        timeSyncReads(path, fileBytes, reads, cold);
+        for (async_io_backend backend : {async_io_backend::io_uring, async_io_backend::thread_pool}) {
+            for (size_t depth : {1, 32}) timeRandomReads(path, fileBytes, reads, cold, backend, depth, false);
+        }
+        timeRandomReads(path, fileBytes, reads, cold, async_io_backend::io_uring, 32, true);
+    }
+    remove(path.c_str());
+
+    // Many small files: the "thousands of files" case
+    const string directory = "async_benchmark_files";
+    mkdir(directory.c_str(), 0755);
+    vector<string> paths;
+    string contents(4096, 'x');
+    for (size_t i = 0; i < files; ++i) {
+        paths.push_back(directory + "/file" + to_string(i) + ".txt");
+        ofstream(paths.back(), ios::binary) << contents;
+    }
+    cout << "Reading " << files << " files of 4 KiB (page cache warm)" << endl;
+
+    auto start = chrono::steady_clock::now();
+    size_t bytes = 0;
+    for (const string& file : paths) {
+        ifstream inFile(file, ios::binary);
+        char buffer[8192];
+        inFile.read(buffer, sizeof buffer);
+        bytes += static_cast<size_t>(inFile.gcount());
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    cout << "  ifstream, one file at a time: " << static_cast<size_t>(files / elapsed.count()) << " files/s, "
+         << bytes << " bytes" << endl;
+
+    for (async_io_backend backend : {async_io_backend::io_uring, async_io_backend::thread_pool}) {
+        async_io_options options;
+        options.backend = backend;
+        try {
+            async_io io(options);
+            ManyFileReader reader{io, paths};
+            start = chrono::steady_clock::now();
+            for (size_t slot = 0; slot < 64; ++slot) reader.start(slot);
+            io.drain();
+            elapsed = chrono::steady_clock::now() - start;
+            cout << "  " << async_io_backend_name(io.backend()) << ", 64 files in flight: "
+                 << static_cast<size_t>(files / elapsed.count()) << " files/s, " << reader.bytes << " bytes" << endl;
+        } catch (const system_error& e) {
+            cout << "  " << async_io_backend_name(backend) << ", 64 files in flight: io_uring unavailable ("
+                 << e.what() << ")" << endl;
+        }
+    }
+
+    for (const string& file : paths) remove(file.c_str());
+    rmdir(directory.c_str());
+    cout << endl;
+}
+
+// --- SECTION 10: Chunked Binary Columns ---
+// This section compares raw binary dumps with column files: size, write time
+// and decode throughput for each codec.
+
+// Write `values` with every codec (and as a raw ofstream dump) and read them back
+template <typename T>
+void timeColumnCodecs(const string& name, const vector<T>& values) {
+    const string path = "column_benchmark.col";
+    double rawBytes = static_cast<double>(values.size() * sizeof(T));
+    cout << name << ": " << values.size() << " x " << sizeof(T) * 8 << "-bit" << endl;
+
+    auto start = chrono::steady_clock::now();
+    {
+        ofstream outFile(path, ios::binary);
+        outFile.write(reinterpret_cast<const char*>(values.data()), static_cast<streamsize>(rawBytes));
+    }
+    chrono::duration<double> writeTime = chrono::steady_clock::now() - start;
+    vector<T> back(values.size());
+    start = chrono::steady_clock::now();
+    {
+        ifstream inFile(path, ios::binary);
+        inFile.read(reinterpret_cast<char*>(back.data()), static_cast<streamsize>(rawBytes));
+    }
+    chrono::duration<double> readTime = chrono::steady_clock::now() - start;
+    cout << "  raw dump (no checks):  ratio 1.00, write " << writeTime.count() << " s, read "
+         << rawBytes / readTime.count() / 1e9 << " GB/s" << endl;
+
+    for (column_codec codec : {column_codec::raw, column_codec::delta_varint, column_codec::delta_bitpack}) {
+        column_file_options options;
+        options.codec = codec;
+        start = chrono::steady_clock::now();
+        write_column_file<T>(path, values, options);
+        writeTime = chrono::steady_clock::now() - start;
+
+        column_file_reader reader(path);
+        double best = 0.0;
+        for (int run = 0; run < 3; ++run) {
+            start = chrono::steady_clock::now();
+            reader.read_into<T>(back);  // Checksums verified, chunks decoded in parallel
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (run == 0 || seconds < best) best = seconds;
+        }
+        if (back != values) cerr << "  " << column_codec_name(codec) << " round trip failed!" << endl;
+        cout << "  " << left << setw(22) << (string(column_codec_name(codec)) + ":") << right << "ratio " << fixed
+             << setprecision(2) << rawBytes / static_cast<double>(reader.file_bytes()) << defaultfloat
+             << setprecision(6) << ", write " << writeTime.count() << " s, decode " << rawBytes / best / 1e9
+             << " GB/s" << endl;
+    }
+    remove(path.c_str());
+}
+
+void columnFileBenchmark(size_t count) {
+    cout << "--- SECTION 13: Chunked Binary Columns ---" << endl;
+    cout << "Decoding on " << shared_thread_pool().size() + 1 << " threads, CRC32C in "
+         << (detect_cpu_features().sse42 ? "hardware" : "software") << endl;
+    mt19937_64 rng(11);
+
+    vector<int64_t> timestamps(count);  // Milliseconds, about one event per second with jitter
+    int64_t now = 1700000000000;
+    for (int64_t& t : timestamps) t = now += 990 + static_cast<int64_t>(rng() % 20);
+    timeColumnCodecs("timestamps", timestamps);
+
+    vector<int32_t> readings(count);  // A slowly drifting sensor
+    int32_t level = 20000;
+    for (int32_t& r : readings) r = level += static_cast<int32_t>(rng() % 41) - 20;
+    timeColumnCodecs("sensor readings", readings);
+
+    vector<uint32_t> noise(count);  // Incompressible: delta coding can only lose
+    for (uint32_t& n : noise) n = static_cast<uint32_t>(rng());
+    timeColumnCodecs("random ids", noise);
+
+    // A flipped bit is caught by the chunk checksum instead of read as data
+    const string path = "column_benchmark.col";
+    write_column_file<int64_t>(path, timestamps);
+    {
+        fstream file(path, ios::in | ios::out | ios::binary);
+        file.seekg(4096);
+        char byte = static_cast<char>(file.get());
+        file.seekp(4096);
+        file.put(static_cast<char>(byte ^ 1));
+    }
+    try {
+        column_file_reader(path).read_all<int64_t>();
+        cout << "Corruption went unnoticed!" << endl;
+    } catch (const runtime_error& e) {
+        cout << "Corrupted file rejected: " << e.what() << endl;
+    }
+    remove(path.c_str());
+    cout << endl;
+}
+
+// --- SECTION 11: Parallel Text Processing ---
+// This section counts the lines and words of a large file on every core.
+
+// Write roughly `megabytes` MiB of lines of 5 to 15 words. Words come from a
+// 1000-word vocabulary, skewed so a few of them are much more common.
+void generateWordFile(const string& path, size_t megabytes) {
+    mt19937 rng(7);
+    vector<string> vocabulary;
+    for (size_t i = 0; i < 1000; ++i) {
+        string word;
+        for (size_t length = 2 + rng() % 9, j = 0; j < length; ++j) word += static_cast<char>('a' + rng() % 26);
+        vocabulary.push_back(word);
+    }
+    ofstream outFile(path, ios::binary);
+    string block;
+    const size_t target = megabytes << 20;
+    size_t written = 0;
+    while (written < target) {
+        block.clear();
+        while (block.size() < (1 << 20)) {
+            size_t words = 5 + rng() % 11;
+            for (size_t i = 0; i < words; ++i) {
+                size_t index = (rng() % 1000) * (rng() % 1000) / 1000;
+                block += vocabulary[index];
+                block += i + 1 < words ? ' ' : '\n';
+            }
+        }
+        outFile.write(block.data(), static_cast<streamsize>(block.size()));
+        written += block.size();
+    }
+}
+
+// Time `count`, which returns the file's text_counts, and print the throughput
+template <typename Count>
+void timeTextCounting(const string& name, size_t fileBytes, Count count) {
+    auto start = chrono::steady_clock::now();
+    text_counts counts = count();
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    cout << "  " << name << ": " << elapsed.count() << " s, " << fileBytes / elapsed.count() / 1e9 << " GB/s, "
+         << counts.lines << " lines, " << counts.words << " words" << endl;
+}
+
+void parallelTextBenchmark(size_t megabytes) {
+    cout << "--- SECTION 14: Parallel Text Processing ---" << endl;
+
+    const string path = "words_benchmark.txt";
+    generateWordFile(path, megabytes);
+    struct stat info;
+    stat(path.c_str(), &info);
+    size_t fileBytes = static_cast<size_t>(info.st_size);
+    cout << "Counting " << fileBytes / (1 << 20) << " MiB on up to " << shared_thread_pool().size() + 1
+         << " threads" << endl;
+
+    // The stringStreamOperations approach, one line at a time
+    timeTextCounting("getline + stringstream >> word", fileBytes, [&] {
+        text_counts counts;
+        ifstream inFile(path);
+        string line, word;
+        while (getline(inFile, line)) {
+            ++counts.lines;
+            istringstream words(line);
+            while (words >> word) ++counts.words;
+        }
+        return counts;
+    });
+
+    text_source source(path);
+    timeTextCounting("count_text (1 thread)", fileBytes, [&] { return count_text(source.text()); });
+    timeTextCounting("parallel_count_text", fileBytes, [&] { return parallel_count_text(source.text()); });
+
+    // Cold: the workers fault the mapping in parallel, so this is bounded by the disk
+    dropFromPageCache(path);
+    timeTextCounting("parallel_count_text (cold)", fileBytes, [&] {
+        text_source coldSource(path);
+        return parallel_count_text(coldSource.text());
+    });
+
+    cout << "Scaling of parallel_count_text (page cache warm):" << endl;
+    auto points = measure_scaling(max(2u, thread::hardware_concurrency()),
+                                  [&](thread_pool& pool) { parallel_count_text(source.text(), {}, pool); });
+    print_scaling_report(cout, points);
+
+    // A heavier result: one map per thread, merged at the end
+    auto start = chrono::steady_clock::now();
+    word_frequency_map frequencies = parallel_word_frequencies(source.text());
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    vector<pair<string_view, uint64_t>> top(frequencies.begin(), frequencies.end());
+    size_t shown = min<size_t>(5, top.size());
+    partial_sort(top.begin(), top.begin() + static_cast<ptrdiff_t>(shown), top.end(),
+                 [](const auto& a, const auto& b) { return a.second > b.second; });
+    cout << "Word frequencies: " << elapsed.count() << " s, " << frequencies.size() << " distinct words, top:";
+    for (size_t i = 0; i < shown; ++i) cout << " " << top[i].first << " (" << top[i].second << ")";
+    cout << endl;
+
+    remove(path.c_str());
+    cout << endl;
+}
+
+// --- SECTION 12: Tokenizing Without Allocations ---
+// This section compares stringstream word extraction with the SIMD tokenizer.
+
+// Time `tokenize`, which calls back with every token, and print the throughput
+// and the speedup over `baseline` seconds (0 for the baseline itself)
+template <typename Tokenize>
+double timeTokenizing(const string& name, size_t textBytes, double baseline, Tokenize tokenize) {
+    uint64_t tokens = 0, tokenBytes = 0;
+    auto start = chrono::steady_clock::now();
+    tokenize([&](size_t length) {
+        ++tokens;
+        tokenBytes += length;
+    });
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    cout << "  " << left << setw(36) << name << right << fixed << setprecision(4) << elapsed.count() << " s, "
+         << setprecision(2) << setw(5) << textBytes / elapsed.count() / 1e9 << " GB/s, " << setw(6)
+         << (baseline > 0 ? baseline / elapsed.count() : 1.0) << "x, " << tokens << " tokens, " << tokenBytes
+         << " bytes" << defaultfloat << setprecision(6) << endl;
+    return elapsed.count();
+}
+
+void tokenizerBenchmark(size_t megabytes) {
+    cout << "--- SECTION 15: Tokenizing Without Allocations ---" << endl;
+
+    const string path = "tokens_benchmark.txt";
+    generateWordFile(path, megabytes);
+    text_source source(path);
+    string_view text = source.text();
+    cout << "Splitting " << text.size() / (1 << 20) << " MiB into words (classification: "
+         << isa_name(simd_kernels().isa) << ")" << endl;
+
+    // The stringStreamOperations approach: copy the text into the stream, then
+    // one std::string per word
+    double baseline = timeTokenizing("stringstream >> word", text.size(), 0.0, [&](auto onToken) {
+        istringstream ss{string(text)};
+        string word;
+        while (ss >> word) onToken(word.size());
+    });
+    timeTokenizing("tokenizer (range-for)", text.size(), baseline, [&](auto onToken) {
+        for (string_view word : tokenizer(text)) onToken(word.size());
+    });
+    timeTokenizing("tokenizer::for_each", text.size(), baseline, [&](auto onToken) {
+        tokenizer(text).for_each([&](string_view word) { onToken(word.size()); });
+    });
+    timeTokenizing("count_tokens (no views)", text.size(), baseline, [&](auto onToken) {
+        for (uint64_t n = count_tokens(text); n > 0; --n) onToken(0);
+    });
+
+    // The same words as comma-separated records
+    string csv(text);
+    replace(csv.begin(), csv.end(), ' ', ',');
+    cout << "Splitting the same text as CSV:" << endl;
+    baseline = timeTokenizing("getline + getline(ss, field, ',')", csv.size(), 0.0, [&](auto onToken) {
+        istringstream lines{csv};
+        string line, field;
+        while (getline(lines, line)) {
+            istringstream fields(line);
+            while (getline(fields, field, ',')) onToken(field.size());
+        }
+    });
+    timeTokenizing("tokenizer (\",\\n\", keep empty)", csv.size(), baseline, [&](auto onToken) {
+        tokenizer(csv, delimiter_set(",\n"), {.skip_empty = false}).for_each([&](string_view field) {
+            if (!field.empty()) onToken(field.size());  // The text ends with '\n': skip the empty last field
+        });
+    });
+    timeTokenizing("csv_reader", csv.size(), baseline, [&](auto onToken) {
+        csv_reader reader(csv);
+        for (csv_field field; reader.next(field);) onToken(field.text.size());
+    });
+
+    // Quoted fields keep their separators, newlines and (collapsed) quotes
+    string quoted = "id,comment\n1,\"fast, and \"\"zero-copy\"\"\"\n2,\"two\nlines\"\n";
+    csv_reader reader(quoted);
+    string scratch;
+    cout << "Quoted CSV fields:";
+    for (csv_field field; reader.next(field);) {
+        cout << " [" << reader.value(field, scratch) << "]" << (field.end_of_record ? " |" : "");
+    }
+    cout << endl;
+
+    remove(path.c_str());
+    cout << endl;
+}
+
 // --- MAIN FUNCTION ---
 
 int main() {
@@ -217,7 +853,31 @@ int main() {
     checkIfFileExists();
 
     // Section 7: StringStream Operations
-    stringStreamOperations();
+    {
+        alloc_tracker_scope scope("stringStreamOperations", &cout);  // str() copies once; the words are views
+        stringStreamOperations();
+    }
+
+    // Section 8: Zero-Copy Line Reading (2 GiB file)
+    lineReaderBenchmark(2048);
+
+    // Section 9: Block-Buffered Byte Reading (256 MiB file)
+    byteReaderBenchmark(256);
+
+    // Section 10: Asynchronous File I/O (256 MiB file, 5000 small files)
+    asyncIoBenchmark(256, 5000);
+
+    // Section 11: Chunked Binary Columns (16M values per column)
+    columnFileBenchmark(16 << 20);
+
+    // Section 12: Parallel Text Processing (512 MiB file)
+    parallelTextBenchmark(512);
+
+    // Section 13: Tokenizing Without Allocations (256 MiB file)
+    tokenizerBenchmark(256);
+
+    // Allocation summary (only with -DENABLE_ALLOC_TRACKER)
+    alloc_tracker_report(cout);
 
     return 0;
 }
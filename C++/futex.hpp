@@ -0,0 +1,274 @@
+#pragma once
+
+// Low-level waiting helpers shared by the concurrency headers.
+//
+//   cpu_relax()        - pause hint for spin-wait loops
+//   default_spin_iterations() - how long to spin before sleeping (0 on one CPU)
+//   cache_line_size    - keeps independently written atomics on separate lines
+//   futex_wait()       - sleep while a 32-bit atomic still holds an expected value
+//   futex_wake()       - wake up to `count` threads sleeping on that atomic
+//   futex_wait_for()   - futex_wait with a timeout
+//   futex_mutex        - mutex that spins (adaptively) before parking in the kernel
+//   futex_event        - one-shot (manual reset) or auto-reset event
+//
+// On Linux these are direct futex(2) system calls (private futexes). Elsewhere
+// they fall back to std::atomic::wait / notify, which is built on the same idea.
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// --- SECTION 1: Futex Calls ---
+
+// Tell the CPU we are in a spin-wait loop (saves power, frees the sibling hyperthread)
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Spinning only pays off when the thread we wait for runs on another CPU at the
+// same time; on a uniprocessor it just burns the timeslice that thread needs
+inline std::size_t default_spin_iterations(std::size_t multiprocessor_spins = 1024) {
+    static const bool uniprocessor = std::thread::hardware_concurrency() == 1;
+    return uniprocessor ? 0 : multiprocessor_spins;
+}
+
+// Typical cache line size; used to keep independently written data apart
+inline constexpr std::size_t cache_line_size = 64;
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain 32-bit integer");
+
+// Block while word == expected. May return spuriously: always re-check the condition.
+inline void futex_wait(std::atomic<uint32_t>& word, uint32_t expected) {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+    word.wait(expected, std::memory_order_acquire);
+#endif
+}
+
+// Wake at most `count` waiters (pass INT_MAX, or use futex_wake_all, for everyone)
+inline void futex_wake(std::atomic<uint32_t>& word, int count = 1) {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+#else
+    if (count == 1) {
+        word.notify_one();
+    } else {
+        word.notify_all();
+    }
+#endif
+}
+
+inline void futex_wake_all(std::atomic<uint32_t>& word) {
+    futex_wake(word, INT_MAX);
+}
+
+// Like futex_wait, but gives up after `timeout`. Returns false only on timeout;
+// true means woken, changed or spurious, so the caller re-checks either way.
+inline bool futex_wait_for(std::atomic<uint32_t>& word, uint32_t expected, std::chrono::nanoseconds timeout) {
+    if (timeout <= std::chrono::nanoseconds::zero()) return word.load(std::memory_order_acquire) != expected;
+#if defined(__linux__)
+    timespec relative{};
+    relative.tv_sec = static_cast<time_t>(timeout.count() / 1000000000);
+    relative.tv_nsec = static_cast<long>(timeout.count() % 1000000000);
+    long result = syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, &relative,
+                          nullptr, 0);
+    return !(result == -1 && errno == ETIMEDOUT);
+#else
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (word.load(std::memory_order_acquire) == expected) {
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::yield();
+    }
+    return true;
+#endif
+}
+
+// --- SECTION 2: Adaptive Mutex ---
+
+// Three-state futex mutex ("Futexes Are Tricky", Drepper, mutex #2):
+//   0 unlocked, 1 locked, 2 locked and maybe someone is parked
+// Uncontended lock and unlock are one atomic instruction each, with no system
+// call. unlock() only enters the kernel when the state says a thread may be
+// parked.
+//
+// A contended lock() spins first, with exponentially growing pause bursts,
+// because for short critical sections the holder is usually about to release.
+// The spin budget adapts like glibc's PTHREAD_MUTEX_ADAPTIVE_NP: a running
+// average of the spins that past acquisitions needed, times two. Mutexes whose
+// holders sleep stop spinning; ones with tiny critical sections spin just long
+// enough. On a uniprocessor the budget is zero (see default_spin_iterations).
+//
+// Satisfies Lockable, so it works with lock_guard, unique_lock, scoped_lock
+// and std::condition_variable_any.
+class futex_mutex {
+public:
+    constexpr futex_mutex() noexcept = default;
+
+    futex_mutex(const futex_mutex&) = delete;
+    futex_mutex& operator=(const futex_mutex&) = delete;
+
+    void lock() {
+        uint32_t expected = unlocked;
+        if (state_.compare_exchange_strong(expected, locked, std::memory_order_acquire, std::memory_order_relaxed)) {
+            return;
+        }
+        lock_contended();
+    }
+
+    bool try_lock() noexcept {
+        uint32_t expected = unlocked;
+        return state_.compare_exchange_strong(expected, locked, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void unlock() noexcept {
+        if (state_.exchange(unlocked, std::memory_order_release) == contended) {
+            futex_wake(state_, 1);
+        }
+    }
+
+private:
+    static constexpr uint32_t unlocked = 0;
+    static constexpr uint32_t locked = 1;
+    static constexpr uint32_t contended = 2;
+    static constexpr uint32_t max_pause_burst = 64;
+    static constexpr std::size_t max_spin_pauses = 1000;  // Tens of microseconds with a slow pause
+
+    [[gnu::noinline]] void lock_contended() {
+        uint32_t estimate = spin_estimate_.load(std::memory_order_relaxed);
+        uint32_t limit = static_cast<uint32_t>(
+            std::min<std::size_t>(default_spin_iterations(max_spin_pauses), std::size_t(estimate) * 2 + 16));
+
+        uint32_t spins = 0;
+        for (uint32_t burst = 1; spins < limit; burst = std::min(burst * 2, max_pause_burst)) {
+            uint32_t state = state_.load(std::memory_order_relaxed);
+            if (state == unlocked && state_.compare_exchange_weak(state, locked, std::memory_order_acquire,
+                                                                  std::memory_order_relaxed)) {
+                adapt(estimate, spins);
+                return;
+            }
+            for (uint32_t i = 0; i < burst; ++i) cpu_relax();
+            spins += burst;
+        }
+        adapt(estimate, limit);
+
+        // Park. Taking the lock with state 2 (not 1) is deliberate: we cannot
+        // know whether other threads are still parked, so our unlock must wake.
+        uint32_t state = state_.exchange(contended, std::memory_order_acquire);
+        while (state != unlocked) {
+            futex_wait(state_, contended);
+            state = state_.exchange(contended, std::memory_order_acquire);
+        }
+    }
+
+    // Move the estimate 1/8 of the way toward this acquisition's spin count
+    void adapt(uint32_t estimate, uint32_t spins) noexcept {
+        int32_t delta = (static_cast<int32_t>(spins) - static_cast<int32_t>(estimate)) / 8;
+        spin_estimate_.store(static_cast<uint32_t>(static_cast<int32_t>(estimate) + delta), std::memory_order_relaxed);
+    }
+
+    std::atomic<uint32_t> state_{unlocked};
+    std::atomic<uint32_t> spin_estimate_{0};  // Approximate; races between lockers only blur it
+};
+
+// --- SECTION 3: Events ---
+
+enum class event_reset {
+    manual,     // One-shot: set() releases every waiter, and the event stays set until reset()
+    automatic,  // Each set() releases one waiter; a wait consumes the signal
+};
+
+// Binary event on one futex word (0 clear, 1 set) plus a waiter count.
+//
+// Lost wakeups are ruled out by a store/load pair on both sides: a waiter
+// increments `waiters` and then sleeps only if the word is still 0 (the kernel
+// re-checks it atomically); set() stores 1 and then enters the kernel only if
+// `waiters` is non-zero. With sequentially consistent operations either the
+// setter sees the waiter, or the waiter's futex call sees the 1.
+//
+// An auto-reset event does not count signals: two set() calls with no waiter
+// in between leave it set once, like a Windows auto-reset event.
+class futex_event {
+public:
+    explicit futex_event(event_reset mode = event_reset::manual, bool initially_set = false) noexcept
+        : state_(initially_set ? 1 : 0), mode_(mode) {}
+
+    futex_event(const futex_event&) = delete;
+    futex_event& operator=(const futex_event&) = delete;
+
+    void set() noexcept {
+        state_.store(1, std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_seq_cst) > 0) {
+            futex_wake(state_, mode_ == event_reset::automatic ? 1 : INT_MAX);
+        }
+    }
+
+    void reset() noexcept { state_.store(0, std::memory_order_relaxed); }
+
+    bool is_set() const noexcept { return state_.load(std::memory_order_acquire) == 1; }
+
+    // Consume (automatic) or observe (manual) the signal without blocking
+    bool try_wait() noexcept {
+        if (mode_ == event_reset::manual) return state_.load(std::memory_order_acquire) == 1;
+        uint32_t expected = 1;
+        return state_.compare_exchange_strong(expected, 0, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void wait() noexcept {
+        if (spin_for_signal()) return;
+        for (;;) {
+            waiters_.fetch_add(1, std::memory_order_seq_cst);
+            futex_wait(state_, 0);
+            waiters_.fetch_sub(1, std::memory_order_relaxed);
+            if (try_wait()) return;  // Otherwise spurious, or another waiter took the signal
+        }
+    }
+
+    // False if the event was not signalled within `timeout`
+    template <typename Rep, typename Period>
+    bool wait_for(std::chrono::duration<Rep, Period> timeout) noexcept {
+        if (spin_for_signal()) return true;
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        for (;;) {
+            auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - std::chrono::steady_clock::now());
+            if (remaining <= std::chrono::nanoseconds::zero()) return try_wait();
+            waiters_.fetch_add(1, std::memory_order_seq_cst);
+            futex_wait_for(state_, 0, remaining);
+            waiters_.fetch_sub(1, std::memory_order_relaxed);
+            if (try_wait()) return true;
+        }
+    }
+
+private:
+    bool spin_for_signal() noexcept {
+        for (std::size_t spin = 0; spin < default_spin_iterations(); ++spin) {
+            if (try_wait()) return true;
+            cpu_relax();
+        }
+        return try_wait();
+    }
+
+    std::atomic<uint32_t> state_;
+    std::atomic<uint32_t> waiters_{0};
+    const event_reset mode_;
+};
@@ -0,0 +1,313 @@
+#pragma once
+
+// Zero-copy line reading.
+//
+// getline(stream, string) copies every byte from the stream buffer into the
+// string (and reallocates it on long lines); the stream buffer itself was
+// already a copy out of the page cache. line_reader avoids both copies:
+//
+//   - regular files are mmap'ed read-only with MADV_SEQUENTIAL, so the kernel
+//     reads ahead aggressively and reclaims pages behind us; every line is a
+//     std::string_view straight into the page cache
+//   - newlines are found 4 KiB at a time with simd_byte_mask (one vector
+//     compare per 16-64 bytes) into a bitmap; each line then costs a
+//     count-trailing-zeros instead of a memchr call
+//   - pipes, sockets, terminals and /proc files (which cannot be mapped or
+//     report size 0) are read with large read() calls into one buffer; lines
+//     are views into that buffer, which only grows for a line longer than it
+//
+// Lines are split on '\n' exactly like getline: the newline is not part of the
+// line, a '\r' before it is kept, and a last line without a newline is still
+// returned. A view stays valid for the reader's lifetime when the file is
+// mapped, and until the next call to next() otherwise.
+//
+// Usage:
+//   line_reader reader("access.log");
+//   for (std::string_view line : reader) count += line.size();
+//
+//   line_reader input(STDIN_FILENO);              // Not owned: left open
+//   std::string_view line;
+//   while (input.next(line)) handle(line);
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "simd_kernels.hpp"  // simd_kernels().byte_mask
+
+struct line_reader_options {
+    bool use_mmap = true;                    // false: always use the read() loop
+    std::size_t buffer_size = 1 << 20;       // Initial read() buffer (grows for longer lines)
+};
+
+// --- SECTION 1: Mapped Files ---
+
+// Read-only private mapping of a whole file; move-only
+class mapped_file {
+public:
+    mapped_file() = default;
+
+    // Maps fd's contents (the fd may be closed afterwards). Empty files map to
+    // nothing; throws std::system_error if mmap fails.
+    explicit mapped_file(int fd, std::size_t size) : size_(size) {
+        if (size_ == 0) return;
+        void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) throw std::system_error(errno, std::generic_category(), "mapped_file: mmap");
+        data_ = static_cast<const char*>(p);
+        madvise(p, size_, MADV_SEQUENTIAL);  // Advice only: read ahead harder, reclaim pages behind us sooner
+    }
+
+    mapped_file(mapped_file&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+    mapped_file& operator=(mapped_file&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+        }
+        return *this;
+    }
+
+    ~mapped_file() { unmap(); }
+
+    const char* data() const noexcept { return data_; }
+    std::size_t size() const noexcept { return size_; }
+    std::string_view view() const noexcept { return {data_, size_}; }
+
+private:
+    void unmap() {
+        if (data_) munmap(const_cast<char*>(data_), size_);
+        data_ = nullptr;
+    }
+
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+// --- SECTION 2: Newline Index ---
+
+namespace line_reader_detail {
+
+// Newline positions of a byte range, computed one window at a time. Short
+// lines make a memchr per line expensive: the call, its setup and a
+// mispredicted exit per line cost more than the compares. Here the compares
+// run in one batch per window and finding the next line is bit arithmetic.
+class newline_index {
+public:
+    static constexpr std::size_t window = 4096;
+
+    newline_index() : byte_mask_(simd_kernels().byte_mask) {}  // Resolve the dispatch once
+
+    // Forget everything: call whenever the bytes or their address change
+    void reset(const char* data, std::size_t size) noexcept {
+        data_ = data;
+        size_ = size;
+        begin_ = end_ = 0;
+    }
+
+    // Position of the first '\n' at or after `from`, or size if there is none
+    std::size_t find(std::size_t from) {
+        while (from < size_) {
+            if (from < begin_ || from >= end_) build(from);
+            std::size_t offset = from - begin_;
+            std::size_t w = offset / 64;
+            uint64_t word = bits_[w] & (~uint64_t(0) << (offset % 64));
+            for (;;) {
+                if (word != 0) return begin_ + w * 64 + static_cast<std::size_t>(__builtin_ctzll(word));
+                if (++w == words_) break;
+                word = bits_[w];
+            }
+            from = end_;
+        }
+        return size_;
+    }
+
+private:
+    void build(std::size_t from) {
+        begin_ = from;
+        end_ = std::min(size_, from + window);
+        words_ = (end_ - begin_ + 63) / 64;
+        byte_mask_(reinterpret_cast<const uint8_t*>(data_ + begin_), end_ - begin_, '\n', bits_);
+    }
+
+    void (*byte_mask_)(const uint8_t*, std::size_t, uint8_t, uint64_t*);
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t begin_ = 0;  // bits_ describes data_[begin_, end_)
+    std::size_t end_ = 0;
+    std::size_t words_ = 0;
+    uint64_t bits_[window / 64];
+};
+
+}  // namespace line_reader_detail
+
+// --- SECTION 3: Line Reader ---
+
+class line_reader {
+public:
+    // Opens and reads `path`; throws std::system_error if it cannot be opened
+    explicit line_reader(const std::string& path, line_reader_options options = {}) : options_(options) {
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0) throw std::system_error(errno, std::generic_category(), "line_reader: open " + path);
+        try {
+            init();
+        } catch (...) {
+            ::close(fd_);
+            throw;
+        }
+        owns_fd_ = true;
+    }
+
+    // Reads from an already open descriptor (a pipe, stdin, ...) without closing it
+    explicit line_reader(int fd, line_reader_options options = {}) : options_(options), fd_(fd) { init(); }
+
+    line_reader(const line_reader&) = delete;
+    line_reader& operator=(const line_reader&) = delete;
+
+    ~line_reader() {
+        if (owns_fd_) ::close(fd_);
+    }
+
+    // The next line without its '\n'; false at the end of the input.
+    // Throws std::system_error if read() fails.
+    bool next(std::string_view& line) {
+        if (mapped_) {
+            if (pos_ >= map_.size()) return false;
+            line = cut_line(map_.data(), index_.find(pos_), map_.size());
+            return true;
+        }
+        return next_buffered(line);
+    }
+
+    // True if the input is mapped (views live as long as the reader)
+    bool mapped() const noexcept { return mapped_; }
+
+    uint64_t lines() const noexcept { return lines_; }
+
+    // Bytes consumed so far, newlines included
+    uint64_t bytes() const noexcept { return bytes_; }
+
+    // Input iterator over the remaining lines, for range-for
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view*;
+        using reference = const std::string_view&;
+
+        iterator() = default;
+        explicit iterator(line_reader* reader) : reader_(reader) { ++*this; }
+
+        reference operator*() const noexcept { return line_; }
+        pointer operator->() const noexcept { return &line_; }
+
+        iterator& operator++() {
+            if (reader_ && !reader_->next(line_)) reader_ = nullptr;
+            return *this;
+        }
+
+        bool operator==(const iterator& other) const noexcept { return reader_ == other.reader_; }
+        bool operator!=(const iterator& other) const noexcept { return reader_ != other.reader_; }
+
+    private:
+        line_reader* reader_ = nullptr;
+        std::string_view line_;
+    };
+
+    iterator begin() { return iterator(this); }
+    iterator end() { return iterator(); }
+
+private:
+    void init() {
+        struct stat st;
+        if (options_.use_mmap && fstat(fd_, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            map_ = mapped_file(fd_, static_cast<std::size_t>(st.st_size));
+            mapped_ = true;
+            index_.reset(map_.data(), map_.size());
+            return;
+        }
+        capacity_ = std::max<std::size_t>(options_.buffer_size, 1);
+        buffer_.reset(new char[capacity_]);
+    }
+
+    // The line from pos_ to `newline` (== size for a last line without one); moves pos_ past it
+    std::string_view cut_line(const char* data, std::size_t newline, std::size_t size) {
+        std::string_view line(data + pos_, newline - pos_);
+        std::size_t next = newline < size ? newline + 1 : size;
+        bytes_ += next - pos_;
+        ++lines_;
+        pos_ = next;
+        return line;
+    }
+
+    bool next_buffered(std::string_view& line) {
+        for (;;) {
+            std::size_t newline = index_.find(pos_);
+            if (newline < end_) {
+                line = cut_line(buffer_.get(), newline, end_);
+                return true;
+            }
+            if (eof_) {
+                if (pos_ == end_) return false;
+                line = cut_line(buffer_.get(), end_, end_);  // Last line without a newline
+                return true;
+            }
+            fill();
+        }
+    }
+
+    // Keeps the partial line, moves it to the front and appends one read()
+    void fill() {
+        if (pos_ > 0) {
+            std::memmove(buffer_.get(), buffer_.get() + pos_, end_ - pos_);
+            end_ -= pos_;
+            pos_ = 0;
+        }
+        if (end_ == capacity_) {  // One line fills the whole buffer: double it
+            std::unique_ptr<char[]> bigger(new char[capacity_ * 2]);
+            std::memcpy(bigger.get(), buffer_.get(), end_);
+            buffer_ = std::move(bigger);
+            capacity_ *= 2;
+        }
+        ssize_t n;
+        do {
+            n = ::read(fd_, buffer_.get() + end_, capacity_ - end_);
+        } while (n < 0 && errno == EINTR);
+        if (n < 0) throw std::system_error(errno, std::generic_category(), "line_reader: read");
+        if (n == 0) eof_ = true;
+        end_ += static_cast<std::size_t>(n);
+        index_.reset(buffer_.get(), end_);
+    }
+
+    line_reader_options options_;
+    int fd_ = -1;
+    bool owns_fd_ = false;
+    line_reader_detail::newline_index index_;
+
+    bool mapped_ = false;
+    mapped_file map_;
+
+    std::unique_ptr<char[]> buffer_;  // read() mode only
+    std::size_t capacity_ = 0;
+    std::size_t end_ = 0;  // Valid bytes in buffer_
+    bool eof_ = false;
+
+    std::size_t pos_ = 0;  // Start of the next line (in the mapping or buffer_)
+    uint64_t lines_ = 0;
+    uint64_t bytes_ = 0;
+};
@@ -0,0 +1,299 @@
+#pragma once
+
+// Lock-free bounded multi-producer / multi-consumer FIFO queue.
+//
+// The design is Dmitry Vyukov's bounded MPMC queue: a power-of-two ring of
+// slots, each carrying a sequence number that says whose turn it is.
+//
+//   slot.sequence == ticket       -> free, the producer holding `ticket` may fill it
+//   slot.sequence == ticket + 1   -> full, the consumer holding `ticket` may empty it
+//   slot.sequence == ticket + cap -> free again for the producer one lap later
+//
+// Producers claim tickets by CAS on tail_, consumers on head_, so each operation
+// costs one CAS plus one release store and no locks. head_ and tail_ live on
+// their own cache lines so producers and consumers do not false-share.
+//
+//   try_push / try_emplace / try_pop       - never block, return false when full/empty
+//   try_push_bulk / try_pop_bulk           - claim a run of consecutive slots with one CAS
+//   push / pop / push_bulk / pop_bulk      - spin for a while, then sleep on a futex
+//
+// Usage:
+//   mpmc_queue<int> queue(1024);
+//   queue.push(42);                 // producer threads
+//   int value = queue.pop();        // consumer threads, FIFO order
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "futex.hpp"
+
+template <typename T>
+class mpmc_queue {
+public:
+    // capacity is rounded up to a power of two so the slot index is a mask
+    explicit mpmc_queue(std::size_t capacity, std::size_t spin_iterations = default_spin_iterations())
+        : capacity_(round_up_capacity(capacity)),
+          mask_(capacity_ - 1),
+          spin_iterations_(spin_iterations),
+          slots_(new slot[capacity_]) {
+        for (std::size_t i = 0; i < capacity_; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    mpmc_queue(const mpmc_queue&) = delete;
+    mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+    // Destroys whatever is still queued; no other thread may be using the queue
+    ~mpmc_queue() {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        for (std::size_t pos = head_.load(std::memory_order_relaxed); pos != tail; ++pos) {
+            slot& s = slots_[pos & mask_];
+            if (s.sequence.load(std::memory_order_relaxed) == pos + 1) s.element()->~T();
+        }
+    }
+
+    std::size_t capacity() const noexcept { return capacity_; }
+
+    // Only a snapshot: other threads may change it immediately
+    std::size_t size_approx() const noexcept {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        return tail > head ? std::min(tail - head, capacity_) : 0;
+    }
+
+    // --- Non-blocking operations ---
+
+    template <typename... Args>
+    bool try_emplace(Args&&... args) {
+        std::size_t pos = tail_.load(std::memory_order_relaxed);
+        slot* s;
+        for (;;) {
+            s = &slots_[pos & mask_];
+            std::size_t sequence = s->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;  // The slot still holds last lap's element: full
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);  // Another producer got there first
+            }
+        }
+        ::new (s->storage()) T(std::forward<Args>(args)...);
+        s->sequence.store(pos + 1, std::memory_order_release);
+        wake(not_empty_);
+        return true;
+    }
+
+    bool try_push(const T& value) { return try_emplace(value); }
+    bool try_push(T&& value) { return try_emplace(std::move(value)); }
+
+    bool try_pop(T& out) {
+        std::size_t pos = head_.load(std::memory_order_relaxed);
+        slot* s;
+        for (;;) {
+            s = &slots_[pos & mask_];
+            std::size_t sequence = s->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(sequence - (pos + 1));
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;  // The producer for this ticket has not published yet: empty
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        take(*s, pos, out);
+        wake(not_full_);
+        return true;
+    }
+
+    std::optional<T> try_pop() {
+        T value;
+        if (!try_pop(value)) return std::nullopt;
+        return value;
+    }
+
+    // Push up to `count` elements from `first` with a single CAS on tail_.
+    // Returns how many were pushed; they keep their relative order.
+    template <typename InputIt>
+    std::size_t try_push_bulk(InputIt first, std::size_t count) {
+        if (count == 0) return 0;
+        std::size_t pos = tail_.load(std::memory_order_relaxed);
+        std::size_t claimed;
+        for (;;) {
+            claimed = ready_run(pos, count, 0);
+            if (claimed == 0) {
+                auto diff = static_cast<std::ptrdiff_t>(slots_[pos & mask_].sequence.load(std::memory_order_acquire) - pos);
+                if (diff < 0) return 0;
+                pos = tail_.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (tail_.compare_exchange_weak(pos, pos + claimed, std::memory_order_relaxed)) break;
+        }
+        for (std::size_t i = 0; i < claimed; ++i, ++first) {
+            slot& s = slots_[(pos + i) & mask_];
+            ::new (s.storage()) T(*first);
+            s.sequence.store(pos + i + 1, std::memory_order_release);
+        }
+        wake(not_empty_);
+        return claimed;
+    }
+
+    // Pop up to `max_count` elements into `out` with a single CAS on head_
+    template <typename OutputIt>
+    std::size_t try_pop_bulk(OutputIt out, std::size_t max_count) {
+        if (max_count == 0) return 0;
+        std::size_t pos = head_.load(std::memory_order_relaxed);
+        std::size_t claimed;
+        for (;;) {
+            claimed = ready_run(pos, max_count, 1);
+            if (claimed == 0) {
+                auto diff = static_cast<std::ptrdiff_t>(slots_[pos & mask_].sequence.load(std::memory_order_acquire) -
+                                                        (pos + 1));
+                if (diff < 0) return 0;
+                pos = head_.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (head_.compare_exchange_weak(pos, pos + claimed, std::memory_order_relaxed)) break;
+        }
+        for (std::size_t i = 0; i < claimed; ++i, ++out) {
+            slot& s = slots_[(pos + i) & mask_];
+            T* element = s.element();
+            *out = std::move(*element);
+            element->~T();
+            s.sequence.store(pos + i + capacity_, std::memory_order_release);
+        }
+        wake(not_full_);
+        return claimed;
+    }
+
+    // --- Blocking operations ---
+
+    void push(const T& value) {
+        wait_until(not_full_, [&] { return try_push(value); });
+    }
+    void push(T&& value) {
+        wait_until(not_full_, [&] { return try_push(std::move(value)); });
+    }
+
+    T pop() {
+        T value;
+        wait_until(not_empty_, [&] { return try_pop(value); });
+        return value;
+    }
+
+    // Blocks until all `count` elements are in the queue
+    template <typename ForwardIt>
+    void push_bulk(ForwardIt first, std::size_t count) {
+        while (count > 0) {
+            std::size_t pushed = 0;
+            wait_until(not_full_, [&] { return (pushed = try_push_bulk(first, count)) > 0; });
+            std::advance(first, pushed);
+            count -= pushed;
+        }
+    }
+
+    // Blocks until at least one element is available, then takes up to max_count
+    template <typename OutputIt>
+    std::size_t pop_bulk(OutputIt out, std::size_t max_count) {
+        std::size_t popped = 0;
+        if (max_count == 0) return 0;
+        wait_until(not_empty_, [&] { return (popped = try_pop_bulk(out, max_count)) > 0; });
+        return popped;
+    }
+
+private:
+    struct slot {
+        std::atomic<std::size_t> sequence;
+        alignas(T) unsigned char bytes[sizeof(T)];
+
+        void* storage() noexcept { return bytes; }
+        T* element() noexcept { return std::launder(reinterpret_cast<T*>(bytes)); }
+    };
+
+    // Sleepers on one side of the queue ("not empty" for consumers, "not full"
+    // for producers). The epoch is the futex word; waiters lets the other side
+    // skip the system call entirely when nobody sleeps.
+    struct alignas(cache_line_size) wait_gate {
+        std::atomic<uint32_t> epoch{0};
+        std::atomic<uint32_t> waiters{0};
+    };
+
+    static std::size_t round_up_capacity(std::size_t capacity) {
+        std::size_t result = 2;
+        while (result < capacity) result <<= 1;
+        return result;
+    }
+
+    // Number of consecutive slots starting at ticket `pos` whose sequence equals
+    // ticket + offset (offset 0: free for producers, 1: full for consumers)
+    std::size_t ready_run(std::size_t pos, std::size_t max_count, std::size_t offset) const {
+        std::size_t n = 0;
+        std::size_t limit = std::min(max_count, capacity_);
+        while (n < limit &&
+               slots_[(pos + n) & mask_].sequence.load(std::memory_order_acquire) == pos + n + offset) {
+            ++n;
+        }
+        return n;
+    }
+
+    void take(slot& s, std::size_t pos, T& out) {
+        T* element = s.element();
+        out = std::move(*element);
+        element->~T();
+        s.sequence.store(pos + capacity_, std::memory_order_release);  // Free for the next lap
+    }
+
+    // Spin on the non-blocking operation first: under load the other side
+    // usually frees a slot within a few hundred nanoseconds. Then sleep with an
+    // eventcount: read the epoch, register, retry once more, and only wait if
+    // the epoch has not moved since. wake() bumps the epoch after its own
+    // update, so a wake-up between our retry and the futex call is not lost.
+    template <typename Attempt>
+    void wait_until(wait_gate& gate, Attempt&& attempt) {
+        for (std::size_t spin = 0; spin < spin_iterations_; ++spin) {
+            if (attempt()) return;
+            cpu_relax();
+        }
+        for (;;) {
+            uint32_t epoch = gate.epoch.load(std::memory_order_acquire);
+            gate.waiters.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);  // Pairs with the fence in wake()
+            if (attempt()) return;  // A stale registration only costs one extra wake later
+            futex_wait(gate.epoch, epoch);
+            if (attempt()) return;
+        }
+    }
+
+    // The waker claims every registered sleeper at once and wakes them all. A
+    // woken thread that loses the race simply registers again. Waking only one
+    // per operation would need a system call for every push while the woken
+    // thread is still waiting for a CPU, because it has not deregistered yet.
+    void wake(wait_gate& gate) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (gate.waiters.load(std::memory_order_relaxed) == 0) return;
+        if (gate.waiters.exchange(0, std::memory_order_relaxed) == 0) return;
+        gate.epoch.fetch_add(1, std::memory_order_release);
+        futex_wake_all(gate.epoch);
+    }
+
+    const std::size_t capacity_;
+    const std::size_t mask_;
+    const std::size_t spin_iterations_;
+    std::unique_ptr<slot[]> slots_;
+
+    alignas(cache_line_size) std::atomic<std::size_t> tail_{0};  // Next ticket for producers
+    alignas(cache_line_size) std::atomic<std::size_t> head_{0};  // Next ticket for consumers
+    wait_gate not_empty_;                                        // Consumers sleep here
+    wait_gate not_full_;                                         // Producers sleep here
+};
@@ -5,6 +5,17 @@
 #include <atomic>
 #include <condition_variable>
 #include <chrono>
+#include <deque>
+#include <algorithm>
+#include <string>
+#include <memory>
+#include <pthread.h>
+
+#include "spsc_ring.hpp"  // Wait-free single-producer/single-consumer ring buffer
+#include "sharded_counter.hpp"  // Contention-free counters
+#include "profiled_mutex.hpp"  // Contention profiling (compile with -DENABLE_MUTEX_PROFILING)
+#include "parallel_for.hpp"  // parallel_for / parallel_invoke / parallel_reduce on a shared pool
+#include "async_logger.hpp"  // Logging without holding locks across console I/O
 
 using namespace std;
 
@@ -47,11 +58,13 @@ void threadsWithArgumentsDemo() {
 }
 
 // --- SECTION 3: Mutexes and Locks (Thread Synchronization) ---
-std::mutex mtx;  // Mutex to protect shared resource
+profiled_mutex mtx{"mtx"};  // Mutex to protect shared resource (a spin-then-park futex_mutex unless profiling is enabled)
 
 void printWithMutex(int id) {
     mtx.lock();  // Lock mutex to access shared resource
-    cout << "Thread ID: " << id << " is printing with a mutex lock!" << endl;
+    // The async logger only copies `id` into a per-thread buffer, so the lock is
+    // held for nanoseconds instead of for a console write
+    default_logger().info("Thread ID: {} is printing with a mutex lock!", id);
     mtx.unlock();  // Unlock mutex after accessing shared resource
 }
 
@@ -65,6 +78,7 @@ void mutexDemo() {
     // Wait for both threads to finish
     t1.join();
     t2.join();
+    default_logger().flush();  // Wait until the logger's thread has written their lines
     
     cout << "Main thread after joining threads with mutexes!" << endl;
     cout << endl;
@@ -72,7 +86,7 @@ void mutexDemo() {
 
 // --- SECTION 4: Mutexes with std::lock_guard (RAII) ---
 void printWithLockGuard(int id) {
-    std::lock_guard<std::mutex> lock(mtx);  // Lock is automatically acquired and released
+    std::lock_guard<profiled_mutex> lock(mtx);  // Lock is automatically acquired and released
     cout << "Thread ID: " << id << " is printing with std::lock_guard!" << endl;
 }
 
@@ -106,7 +120,12 @@ void waitForWork(int id) {
 
 void notifyThreads() {
     std::this_thread::sleep_for(std::chrono::seconds(1));  // Simulate work
-    ready = true;  // Set ready flag to true
+    {
+        // The flag must be written under cv_mtx: unlocked, it is a data race, and a
+        // waiter between its `while (!ready)` check and cv.wait() misses the notify
+        std::lock_guard<std::mutex> lck(cv_mtx);
+        ready = true;  // Set ready flag to true
+    }
     cv.notify_all();  // Notify all waiting threads
 }
 
@@ -129,11 +148,14 @@ void conditionVariableDemo() {
 }
 
 // --- SECTION 6: Atomic Variables (Thread-Safe Operations) ---
-std::atomic<int> counter(0);  // Atomic variable for thread-safe operations
+// A plain std::atomic<int> shared by every thread makes all of them fight over
+// one cache line. For counters that are written often and read rarely, a
+// sharded counter keeps one slot per thread and sums the slots when read.
+sharded_counter counter;  // Thread-safe counter, one cache line per thread
 
 void incrementCounter() {
     for (int i = 0; i < 1000; ++i) {
-        counter++;  // Atomic increment operation
+        counter.increment();  // Relaxed atomic add on this thread's own slot
     }
 }
 
@@ -148,7 +170,7 @@ void atomicDemo() {
     t1.join();
     t2.join();
     
-    cout << "Counter after both threads incrementing: " << counter.load() << endl;  // Thread-safe access to atomic variable
+    cout << "Counter after both threads incrementing: " << counter.read() << endl;  // Sum of all the per-thread slots
     cout << endl;
 }
 
@@ -156,22 +178,347 @@ void atomicDemo() {
 void parallelDemo() {
     cout << "--- SECTION 7: Parallel Algorithms (Concurrent Tasks) ---" << endl;
 
-    // Parallelizing the execution of a function using a vector of threads
-    std::vector<std::thread> threads;
+    // Run the same task for 5 ids on the shared worker pool instead of creating
+    // (and joining) a thread per id; the calling thread takes part as well
+    parallel_for({0, 5}, 1, [](size_t id) {
+        lock_guard<profiled_mutex> lock(mtx);
+        cout << "Task ID: " << id << " is performing work in parallel!" << endl;
+    });
+
+    // Two different jobs side by side; returns when both are done
+    vector<int> evens, odds;
+    parallel_invoke([&] { for (int i = 0; i < 10; i += 2) evens.push_back(i); },
+                    [&] { for (int i = 1; i < 10; i += 2) odds.push_back(i); });
+    cout << "parallel_invoke filled " << evens.size() << " evens and " << odds.size() << " odds" << endl;
+
+    // Sum of 1/i^2 over ten million terms. The deterministic reduction combines
+    // fixed chunks in order, so the result is the same bit for bit on every run.
+    const size_t N = 10000000;
+    auto partialSum = [](index_range r, double sum) {
+        for (size_t i = r.begin; i < r.end; ++i) sum += 1.0 / (double(i + 1) * double(i + 1));
+        return sum;
+    };
+    double sum = parallel_reduce({0, N}, 1 << 16, 0.0, partialSum, plus<>());
+    cout.precision(15);
+    cout << "Sum of 1/i^2 (deterministic): " << sum << " (pi^2/6 = 1.64493406684823)" << endl;
+    cout.precision(6);
+
+    // How well the same reduction scales with more threads
+    cout << "Scaling of the reduction:" << endl;
+    print_scaling_report(cout, measure_scaling(max(4u, thread::hardware_concurrency()), [&](thread_pool& pool) {
+        volatile double result = parallel_reduce({0, N}, 1 << 16, 0.0, partialSum, plus<>(),
+                                                 reduce_mode::deterministic, pool);
+        (void)result;
+    }));
+
+    cout << "Main thread after all parallel work finished!" << endl;
+    cout << endl;
+}
+
+// --- SECTION 8: SPSC Ring Buffer (Lock-Free Pipeline Stage) ---
+// When exactly one thread produces and one consumes, a mutex + condition
+// variable per item (as in waitForWork/notifyThreads) is far more machinery than
+// needed: a ring buffer with two atomic indices hands items over without locks.
+
+// Pin a thread to one CPU so the "same core" and "different cores" cases are real
+bool pinThreadToCpu(std::thread& t, int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(t.native_handle(), sizeof(set), &set) == 0;
+}
+
+// The mutex + condition_variable queue the ring buffer replaces
+struct LockedQueue {
+    std::mutex m;
+    std::condition_variable cv;
+    std::deque<long long> items;
+
+    void push(long long value) {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            items.push_back(value);
+        }
+        cv.notify_one();
+    }
+
+    long long pop() {
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [this] { return !items.empty(); });
+        long long value = items.front();
+        items.pop_front();
+        return value;
+    }
+};
+
+// Throughput: the producer sends ITEMS values, the consumer adds them up
+template <typename Producer, typename Consumer>
+void measureThroughput(const string& name, int producerCpu, int consumerCpu, long long items, Producer produce,
+                       Consumer consume) {
+    long long sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::thread consumerThread([&] { sum = consume(); });
+    std::thread producerThread(produce);
+    pinThreadToCpu(consumerThread, consumerCpu);
+    pinThreadToCpu(producerThread, producerCpu);
+    producerThread.join();
+    consumerThread.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    cout << "  " << name << ": " << static_cast<long long>(items / elapsed.count()) << " items/sec"
+         << (sum == items * (items - 1) / 2 ? "" : "  (CHECKSUM MISMATCH)") << endl;
+}
+
+// Latency: ping-pong one value through a pair of rings; half a round trip is one hand-over
+void measureLatency(int cpuA, int cpuB) {
+    const int ROUND_TRIPS = 20000;
+    spsc_ring<long long> ping(64), pong(64);
+    std::vector<long long> nanoseconds;
+    nanoseconds.reserve(ROUND_TRIPS);
+
+    std::thread echo([&] {
+        for (int i = 0; i < ROUND_TRIPS; ++i) {
+            pong.push(ping.pop());
+        }
+    });
+    std::thread sender([&] {
+        for (int i = 0; i < ROUND_TRIPS; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            ping.push(i);
+            pong.pop();
+            nanoseconds.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                      std::chrono::steady_clock::now() - start).count() / 2);
+        }
+    });
+    pinThreadToCpu(echo, cpuB);
+    pinThreadToCpu(sender, cpuA);
+    sender.join();
+    echo.join();
+
+    std::sort(nanoseconds.begin(), nanoseconds.end());
+    cout << "  one-way latency: median " << nanoseconds[ROUND_TRIPS / 2] << " ns, p99 "
+         << nanoseconds[ROUND_TRIPS * 99 / 100] << " ns" << endl;
+}
+
+void spscRingBenchmark(int producerCpu, int consumerCpu) {
+    const long long ITEMS = 5000000;
+    const std::size_t BATCH = 64;
+
+    LockedQueue locked;
+    measureThroughput("mutex + condition_variable", producerCpu, consumerCpu, ITEMS,
+                      [&] { for (long long i = 0; i < ITEMS; ++i) locked.push(i); },
+                      [&] { long long sum = 0; for (long long i = 0; i < ITEMS; ++i) sum += locked.pop(); return sum; });
+
+    spsc_ring<long long> ring(4096);
+    measureThroughput("spsc_ring push/pop", producerCpu, consumerCpu, ITEMS,
+                      [&] { for (long long i = 0; i < ITEMS; ++i) ring.push(i); },
+                      [&] { long long sum = 0; for (long long i = 0; i < ITEMS; ++i) sum += ring.pop(); return sum; });
+
+    // Batched: construct up to BATCH values in place, publish them with one store
+    measureThroughput("spsc_ring reserve/commit x64", producerCpu, consumerCpu, ITEMS,
+                      [&] {
+                          for (long long next = 0; next < ITEMS;) {
+                              auto slots = ring.reserve(std::min<std::size_t>(BATCH, ITEMS - next));
+                              for (std::size_t i = 0; i < slots.size; ++i) {
+                                  ::new (slots.data + i) long long(next + static_cast<long long>(i));
+                              }
+                              ring.commit(slots.size);
+                              next += static_cast<long long>(slots.size);
+                              if (slots.size == 0) std::this_thread::yield();
+                          }
+                      },
+                      [&] {
+                          long long sum = 0;
+                          for (long long taken = 0; taken < ITEMS;) {
+                              auto ready = ring.peek(BATCH);
+                              for (std::size_t i = 0; i < ready.size; ++i) sum += ready.data[i];
+                              ring.release(ready.size);
+                              taken += static_cast<long long>(ready.size);
+                              if (ready.size == 0) std::this_thread::yield();
+                          }
+                          return sum;
+                      });
+
+    measureLatency(producerCpu, consumerCpu);
+}
+
+void spscRingDemo() {
+    cout << "--- SECTION 8: SPSC Ring Buffer ---" << endl;
 
-    // Creating 5 threads that execute the same task concurrently
-    for (int i = 0; i < 5; ++i) {
-        threads.push_back(std::thread([](int id) {
-            cout << "Thread ID: " << id << " is performing work in parallel!" << endl;
-        }, i));
+    // Zero-copy hand-over: the string is built directly inside the ring's slot
+    spsc_ring<string> messages(8);
+    std::thread consumerThread([&messages] {
+        for (int i = 0; i < 3; ++i) {
+            cout << "Consumer received: " << messages.pop() << endl;
+        }
+    });
+    for (int i = 0; i < 3; ++i) {
+        messages.emplace(5, static_cast<char>('a' + i));  // Constructs string(5, 'a' + i) in place
     }
+    consumerThread.join();
 
-    // Waiting for all threads to finish
+    unsigned cpus = std::thread::hardware_concurrency();
+    cout << "Both threads pinned to CPU 0:" << endl;
+    spscRingBenchmark(0, 0);
+    if (cpus > 1) {
+        cout << "Threads pinned to CPU 0 and CPU 1:" << endl;
+        spscRingBenchmark(0, 1);
+    } else {
+        cout << "(only one CPU available, skipping the cross-core run)" << endl;
+    }
+    cout << endl;
+}
+
+// --- SECTION 9: Futex Mutex and Events ---
+// The mutex, condition variable and flag of Section 5 all guard one bit of
+// state: "start now". A futex_event is that bit with the waiting built in, and
+// a futex_mutex spins briefly before it sleeps, so tiny critical sections
+// rarely reach the kernel.
+
+futex_event startSignal;  // One-shot: once set, every wait() returns at once
+
+void waitForSignal(int id) {
+    startSignal.wait();
+    default_logger().info("Thread ID: {} is working!", id);
+}
+
+// Lock throughput with a tiny critical section, as around mtx
+template <typename Mutex>
+void measureLockThroughput(const string& name, int threads) {
+    const int LOCKS = 200000;  // Per thread
+    Mutex m;
+    long long counter = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            for (int i = 0; i < LOCKS; ++i) {
+                std::lock_guard<Mutex> lock(m);
+                counter++;
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    cout << "  " << name << ": " << static_cast<long long>(counter / elapsed.count()) << " locks/sec" << endl;
+}
+
+// Wakeup latency: two threads take turns, each one waking the other. Half a
+// round trip is one wakeup (including the context switch when either sleeps).
+template <typename Ping, typename Pong>
+void measurePingPong(const string& name, Ping ping, Pong pong) {
+    const int ROUND_TRIPS = 20000;
+    auto start = std::chrono::steady_clock::now();
+    std::thread echo([&] {
+        for (int i = 0; i < ROUND_TRIPS; ++i) pong();
+    });
+    for (int i = 0; i < ROUND_TRIPS; ++i) ping();
+    echo.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    cout << "  " << name << ": " << static_cast<long long>(elapsed.count() * 1e9 / (2 * ROUND_TRIPS))
+         << " ns per wakeup" << endl;
+}
+
+// Broadcast latency: time from the signal until each sleeping waiter runs
+template <typename Wait, typename Signal>
+void measureBroadcast(const string& name, int waiters, Wait wait, Signal signal) {
+    const int ROUNDS = 200;
+    std::atomic<long long> signalledAt{0};
+    std::atomic<long long> totalNs{0};
+    std::atomic<int> woken{0};
+    auto now = [] {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+    };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < waiters; ++t) {
+        threads.emplace_back([&] {
+            for (int round = 0; round < ROUNDS; ++round) {
+                wait(round);
+                totalNs.fetch_add(now() - signalledAt.load(), std::memory_order_relaxed);
+                woken.fetch_add(1);
+            }
+        });
+    }
+    for (int round = 0; round < ROUNDS; ++round) {
+        std::this_thread::sleep_for(std::chrono::microseconds(500));  // Let the waiters fall asleep
+        signalledAt.store(now());
+        signal(round);
+        while (woken.load() < (round + 1) * waiters) {
+            std::this_thread::yield();
+        }
+    }
     for (auto& t : threads) {
         t.join();
     }
+    cout << "  " << name << ": " << totalNs.load() / (ROUNDS * waiters) << " ns from signal to running, on average"
+         << endl;
+}
+
+void futexSyncDemo() {
+    cout << "--- SECTION 9: Futex Mutex and Events ---" << endl;
+
+    std::thread t1(waitForSignal, 1);
+    std::thread t2(waitForSignal, 2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));  // Simulate work
+    startSignal.set();  // No lock and no separate flag needed
+    t1.join();
+    t2.join();
+    default_logger().flush();
 
-    cout << "Main thread after joining all parallel threads!" << endl;
+    cout << "Lock throughput, 4 threads:" << endl;
+    measureLockThroughput<std::mutex>("std::mutex", 4);
+    measureLockThroughput<futex_mutex>("futex_mutex", 4);
+
+    cout << "Ping-pong between two threads:" << endl;
+    {
+        std::mutex m;
+        std::condition_variable turnChanged;
+        int turn = 0;  // 0: ping's turn, 1: pong's turn
+        auto take = [&](int mine) {
+            std::unique_lock<std::mutex> lock(m);
+            turnChanged.wait(lock, [&] { return turn == mine; });
+            turn = 1 - mine;
+            lock.unlock();
+            turnChanged.notify_one();
+        };
+        measurePingPong("mutex + condition_variable", [&] { take(0); }, [&] { take(1); });
+    }
+    {
+        futex_event toPong(event_reset::automatic), toPing(event_reset::automatic);
+        measurePingPong(
+            "two auto-reset futex_events", [&] { toPong.set(); toPing.wait(); },
+            [&] { toPong.wait(); toPing.set(); });
+    }
+
+    cout << "Waking 4 sleeping threads at once:" << endl;
+    {
+        std::mutex m;
+        std::condition_variable go;
+        int generation = 0;
+        measureBroadcast(
+            "condition_variable::notify_all", 4,
+            [&](int round) {
+                std::unique_lock<std::mutex> lock(m);
+                go.wait(lock, [&] { return generation > round; });
+            },
+            [&](int) {
+                {
+                    std::lock_guard<std::mutex> lock(m);
+                    generation++;
+                }
+                go.notify_all();
+            });
+    }
+    {
+        std::vector<std::unique_ptr<futex_event>> rounds;
+        for (int i = 0; i < 200; ++i) rounds.push_back(std::make_unique<futex_event>());
+        measureBroadcast(
+            "one-shot futex_event::set", 4, [&](int round) { rounds[round]->wait(); },
+            [&](int round) { rounds[round]->set(); });
+    }
     cout << endl;
 }
 
@@ -198,5 +545,14 @@ int main() {
     // Parallel Algorithms demo
     parallelDemo();
 
+    // SPSC ring buffer demo
+    spscRingDemo();
+
+    // Futex-based mutex and event demo
+    futexSyncDemo();
+
+    // How often the threads above waited for mtx, and for how long
+    profiled_mutex_report(cout);
+
     return 0;
 }
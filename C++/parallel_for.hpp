@@ -0,0 +1,380 @@
+#pragma once
+
+// Loop-level parallelism on top of thread_pool.
+//
+//   shared_thread_pool()  - process-wide pool with one worker per hardware
+//                           thread minus one (the calling thread joins in)
+//   task_group            - run(fn) tasks on the pool, wait() for all of them
+//   parallel_invoke       - run a few callables in parallel and wait
+//   parallel_for          - split an index range into chunks of >= grain
+//                           indices; static, dynamic or guided scheduling
+//   parallel_reduce       - map-reduce over a range; the deterministic mode
+//                           gives bit-identical results for any thread count
+//   measure_scaling       - time a workload on 1..N threads and report
+//                           speedup and parallel efficiency
+//
+// Nothing here creates threads. The calling thread always works on its own
+// loop, and a thread that waits for helper tasks runs queued pool work in the
+// meantime instead of blocking. A parallel_for nested inside another one
+// (or inside any pool task) therefore only spreads onto workers that are idle.
+// It never oversubscribes the machine and never deadlocks waiting for a worker
+// that is itself waiting.
+//
+// Usage:
+//   parallel_for({0, n}, 1024, [&](std::size_t i) { out[i] = f(in[i]); });
+//   parallel_for({0, n}, 64, [&](index_range r) { ... }, loop_schedule::guided);
+//   double sum = parallel_reduce({0, n}, 4096, 0.0,
+//       [&](index_range r, double acc) { for (auto i = r.begin; i < r.end; ++i) acc += x[i]; return acc; },
+//       std::plus<>());
+//   parallel_invoke([&] { sort(left); }, [&] { sort(right); });
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <ostream>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "futex.hpp"
+#include "thread_pool.hpp"
+
+// Half-open range of loop indices [begin, end)
+struct index_range {
+    std::size_t begin = 0;
+    std::size_t end = 0;
+
+    std::size_t size() const noexcept { return end > begin ? end - begin : 0; }
+};
+
+enum class loop_schedule {
+    static_blocks,  // One equal block per participant: least overhead, for uniform work
+    dynamic,        // Chunks of `grain` handed out on demand: balances uneven work
+    guided,         // Large chunks first, shrinking towards `grain`: fewer claims than dynamic
+};
+
+enum class reduce_mode {
+    deterministic,  // Fixed chunk boundaries, combined in index order: same result on any run
+    fast,           // One accumulator per participant, combined in arbitrary order
+};
+
+// The pool the parallel algorithms use unless told otherwise. Started on first use.
+inline thread_pool& shared_thread_pool() {
+    static thread_pool pool(std::max(2u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+// --- SECTION 1: Task Groups ---
+
+// Tasks posted to a pool that one thread waits for. wait() runs other queued
+// pool work while the group is unfinished and only sleeps once there is
+// nothing left to help with. The first exception thrown by a task is rethrown
+// from wait().
+class task_group {
+public:
+    explicit task_group(thread_pool& pool = shared_thread_pool()) : pool_(pool) {}
+
+    // Waits for the remaining tasks; they reference this object
+    ~task_group() {
+        wait_quietly();
+    }
+
+    task_group(const task_group&) = delete;
+    task_group& operator=(const task_group&) = delete;
+
+    template <typename Fn>
+    void run(Fn&& fn) {
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        pool_.post([this, fn = std::forward<Fn>(fn)]() mutable {
+            try {
+                fn();
+            } catch (...) {
+                record(std::current_exception());
+            }
+            finish_one();
+        });
+    }
+
+    void wait() {
+        wait_quietly();
+        if (error_) {
+            std::exception_ptr error = std::exchange(error_, nullptr);
+            failed_.store(false, std::memory_order_relaxed);
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Lets the caller's own loop body report an exception through the group
+    void record(std::exception_ptr error) {
+        if (!failed_.exchange(true, std::memory_order_acq_rel)) error_ = std::move(error);
+    }
+
+    bool failed() const noexcept { return failed_.load(std::memory_order_relaxed); }
+
+    thread_pool& pool() noexcept { return pool_; }
+
+private:
+    // The wake-up may reach the word after the waiter has already returned;
+    // the kernel treats that like any other spurious wake-up
+    void finish_one() {
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            futex_wake_all(pending_);
+        }
+    }
+
+    void wait_quietly() {
+        for (std::size_t spin = 0;;) {
+            uint32_t pending = pending_.load(std::memory_order_acquire);
+            if (pending == 0) return;
+            if (pool_.try_run_one()) {
+                spin = 0;
+                continue;
+            }
+            if (spin++ < default_spin_iterations()) {
+                cpu_relax();
+                continue;
+            }
+            // Nothing to help with: every task of ours is running on some worker
+            futex_wait(pending_, pending);
+            spin = 0;
+        }
+    }
+
+    thread_pool& pool_;
+    std::atomic<uint32_t> pending_{0};
+    std::atomic<bool> failed_{false};
+    std::exception_ptr error_;
+};
+
+// Run every callable, the first one on the calling thread, and wait for all
+template <typename First, typename... Rest>
+void parallel_invoke(First&& first, Rest&&... rest) {
+    task_group group;
+    (group.run(std::forward<Rest>(rest)), ...);
+    try {
+        std::forward<First>(first)();
+    } catch (...) {
+        group.record(std::current_exception());
+    }
+    group.wait();
+}
+
+// --- SECTION 2: parallel_for ---
+
+namespace parallel_detail {
+
+// Number of threads (caller included) worth using for `chunks` chunks
+inline std::size_t participants_for(thread_pool& pool, std::size_t chunks) {
+    std::size_t available = pool.size() + (pool.current_worker_index() < 0 ? 1 : 0);
+    return std::max<std::size_t>(1, std::min(available, chunks));
+}
+
+// Calls fn for one chunk, either once with the whole range or once per index
+template <typename Fn>
+void run_chunk(Fn& fn, index_range chunk) {
+    if constexpr (std::is_invocable_v<Fn&, index_range>) {
+        fn(chunk);
+    } else {
+        for (std::size_t i = chunk.begin; i < chunk.end; ++i) fn(i);
+    }
+}
+
+// Shared by all participants of one loop; lives on the caller's stack
+class chunk_dispenser {
+public:
+    chunk_dispenser(index_range range, std::size_t grain, loop_schedule schedule, std::size_t participants)
+        : end_(range.end), grain_(grain), schedule_(schedule), participants_(participants), next_(range.begin) {
+        std::size_t per_participant = (range.size() + participants - 1) / participants;
+        block_ = std::max(grain_, (per_participant + grain_ - 1) / grain_ * grain_);
+    }
+
+    // Claim the next chunk; false once the range is used up
+    bool claim(index_range& chunk) {
+        std::size_t begin;
+        std::size_t size;
+        switch (schedule_) {
+        case loop_schedule::static_blocks:
+            begin = next_.fetch_add(block_, std::memory_order_relaxed);
+            size = block_;
+            break;
+        case loop_schedule::dynamic:
+            begin = next_.fetch_add(grain_, std::memory_order_relaxed);
+            size = grain_;
+            break;
+        case loop_schedule::guided:
+        default:
+            begin = next_.load(std::memory_order_relaxed);
+            do {
+                if (begin >= end_) return false;
+                size = std::max(grain_, (end_ - begin) / (2 * participants_));
+            } while (!next_.compare_exchange_weak(begin, begin + size, std::memory_order_relaxed));
+            break;
+        }
+        if (begin >= end_) return false;
+        chunk = {begin, std::min(end_, begin + size)};
+        return true;
+    }
+
+private:
+    const std::size_t end_;
+    const std::size_t grain_;
+    const loop_schedule schedule_;
+    const std::size_t participants_;
+    std::size_t block_;
+    alignas(cache_line_size) std::atomic<std::size_t> next_;
+};
+
+}  // namespace parallel_detail
+
+// fn is called either as fn(std::size_t index) for every index, or as
+// fn(index_range chunk) once per chunk (cheaper for tiny bodies). Chunks hold
+// at least `grain` indices (except the last one); grain 0 means 1.
+template <typename Fn>
+void parallel_for(index_range range, std::size_t grain, Fn&& fn, loop_schedule schedule = loop_schedule::dynamic,
+                  thread_pool& pool = shared_thread_pool()) {
+    std::size_t count = range.size();
+    if (count == 0) return;
+    grain = std::max<std::size_t>(grain, 1);
+    std::size_t chunks = (count + grain - 1) / grain;
+    std::size_t participants = parallel_detail::participants_for(pool, chunks);
+    if (participants == 1) {
+        parallel_detail::run_chunk(fn, range);
+        return;
+    }
+
+    parallel_detail::chunk_dispenser dispenser(range, grain, schedule, participants);
+    task_group group(pool);
+    auto work = [&] {
+        index_range chunk;
+        while (!group.failed() && dispenser.claim(chunk)) {
+            parallel_detail::run_chunk(fn, chunk);
+        }
+    };
+    for (std::size_t i = 1; i < participants; ++i) {
+        group.run(work);  // A helper that starts after the range is used up returns at once
+    }
+    try {
+        work();
+    } catch (...) {
+        group.record(std::current_exception());
+    }
+    group.wait();
+}
+
+// --- SECTION 3: parallel_reduce ---
+
+// body(index_range, T accumulator) -> T folds one chunk into an accumulator;
+// combine(T, T) -> T merges two partial results and must be associative.
+//
+// deterministic: chunk boundaries depend only on range and grain, every chunk
+// starts from `identity`, and the per-chunk results are combined left to right
+// in index order. Floating-point sums come out bit-identical whatever the
+// thread count or timing, at the cost of one stored partial per chunk.
+// fast: one accumulator per participant, combined in slot order; the grouping
+// of indices into accumulators depends on timing.
+template <typename T, typename Body, typename Combine>
+T parallel_reduce(index_range range, std::size_t grain, T identity, Body&& body, Combine&& combine,
+                  reduce_mode mode = reduce_mode::deterministic, thread_pool& pool = shared_thread_pool()) {
+    std::size_t count = range.size();
+    if (count == 0) return identity;
+    grain = std::max<std::size_t>(grain, 1);
+    std::size_t chunks = (count + grain - 1) / grain;
+
+    if (mode == reduce_mode::deterministic) {
+        std::vector<T> partials(chunks, identity);
+        parallel_for(
+            index_range{0, chunks}, 1,
+            [&](std::size_t c) {
+                std::size_t begin = range.begin + c * grain;
+                partials[c] = body(index_range{begin, std::min(range.end, begin + grain)}, identity);
+            },
+            loop_schedule::dynamic, pool);
+        T result = identity;
+        for (T& partial : partials) result = combine(std::move(result), std::move(partial));
+        return result;
+    }
+
+    // Each participant takes a slot on entry and keeps folding into it
+    struct alignas(cache_line_size) slot {
+        T value;
+    };
+    std::size_t participants = parallel_detail::participants_for(pool, chunks);
+    std::vector<slot> slots(participants, slot{identity});
+    std::atomic<std::size_t> next_slot{0};
+    parallel_detail::chunk_dispenser dispenser(range, grain, loop_schedule::dynamic, participants);
+    task_group group(pool);
+    auto work = [&] {
+        std::size_t index = next_slot.fetch_add(1, std::memory_order_relaxed);
+        T& accumulator = slots[index].value;
+        index_range chunk;
+        while (!group.failed() && dispenser.claim(chunk)) {
+            accumulator = body(chunk, std::move(accumulator));
+        }
+    };
+    for (std::size_t i = 1; i < participants; ++i) {
+        group.run(work);
+    }
+    try {
+        work();
+    } catch (...) {
+        group.record(std::current_exception());
+    }
+    group.wait();
+    T result = identity;
+    for (slot& s : slots) result = combine(std::move(result), std::move(s.value));
+    return result;
+}
+
+// --- SECTION 4: Scaling Reports ---
+
+struct scaling_point {
+    std::size_t threads = 0;
+    double seconds = 0.0;
+    double speedup = 0.0;     // Relative to the 1-thread run
+    double efficiency = 0.0;  // speedup / threads (1.0 = perfect scaling)
+};
+
+// Run workload(pool) with 1, 2, 4, ... max_threads threads, keeping the best of
+// `repeats` runs for each. The workload runs on a worker of a pool of exactly
+// that many threads (so the 1-thread run has no helpers at all) and must pass
+// the pool on to the parallel algorithms.
+template <typename Workload>
+std::vector<scaling_point> measure_scaling(std::size_t max_threads, Workload&& workload, int repeats = 3) {
+    std::vector<scaling_point> points;
+    for (std::size_t threads = 1; threads <= std::max<std::size_t>(max_threads, 1); threads *= 2) {
+        thread_pool pool(threads);
+        double best = 0.0;
+        for (int r = 0; r < std::max(repeats, 1); ++r) {
+            double seconds = pool.submit([&] {
+                                     auto start = std::chrono::steady_clock::now();
+                                     workload(pool);
+                                     return std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+                                         .count();
+                                 })
+                                 .get();
+            if (r == 0 || seconds < best) best = seconds;
+        }
+        scaling_point point;
+        point.threads = threads;
+        point.seconds = best;
+        point.speedup = points.empty() ? 1.0 : points.front().seconds / best;
+        point.efficiency = point.speedup / static_cast<double>(threads);
+        points.push_back(point);
+    }
+    return points;
+}
+
+inline void print_scaling_report(std::ostream& out, const std::vector<scaling_point>& points) {
+    out << "  threads     seconds   speedup   efficiency\n";
+    for (const scaling_point& p : points) {
+        out << "  " << std::setw(7) << p.threads << std::fixed << std::setprecision(4) << std::setw(12) << p.seconds
+            << std::setprecision(2) << std::setw(9) << p.speedup << "x" << std::setprecision(0) << std::setw(11)
+            << p.efficiency * 100.0 << "%" << std::defaultfloat << std::setprecision(6) << "\n";
+    }
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+// Parallel processing of large text files.
+//
+// The text is cut into byte ranges of about chunk_bytes that always end just
+// after a '\n', so no line (and no word) straddles two ranges. Ranges are
+// handed to pool workers on demand (parallel_reduce, so a slow range does not
+// hold up the others); each worker folds its ranges into its own accumulator
+// with the user's callback, and the accumulators are merged at the end.
+//
+//   split_at_lines          - the line-aligned ranges of a text
+//   text_source             - a file as one string_view: mapped when possible
+//                             (every worker reads the page cache directly),
+//                             read into memory otherwise (pipes, /proc)
+//   parallel_text_reduce    - body(range, acc) -> acc per range, combine(a, b)
+//   parallel_count_text     - lines, words and bytes, like wc
+//   parallel_word_frequencies
+//                           - occurrences of every word, keyed by views into
+//                             the text
+//
+// Usage:
+//   text_source log("access.log");
+//   text_counts counts = parallel_count_text(log.text());
+//
+//   uint64_t errors = parallel_text_reduce(log.text(), uint64_t(0),
+//       [](std::string_view lines, uint64_t n) { return n + count_matches(lines, "ERROR"); },
+//       std::plus<>());
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "line_reader.hpp"   // mapped_file
+#include "parallel_for.hpp"  // parallel_reduce, reduce_mode, shared_thread_pool
+#include "simd_kernels.hpp"  // simd_kernels().find_byte / byte_mask
+#include "tokenizer.hpp"     // tokenizer, count_tokens
+
+struct parallel_text_options {
+    std::size_t chunk_bytes = 4 << 20;      // Target range size; a longer line stays whole
+    reduce_mode mode = reduce_mode::fast;   // fast: one accumulator per thread; deterministic: one per range
+};
+
+// --- SECTION 1: Line-Aligned Ranges ---
+
+// Ranges of about chunk_bytes covering `text` in order; each ends right after
+// a '\n' except possibly the last. Finding a boundary costs one short scan.
+inline std::vector<std::string_view> split_at_lines(std::string_view text, std::size_t chunk_bytes) {
+    std::vector<std::string_view> ranges;
+    chunk_bytes = std::max<std::size_t>(chunk_bytes, 1);
+    auto find_byte = simd_kernels().find_byte;
+    const auto* data = reinterpret_cast<const uint8_t*>(text.data());
+    std::size_t begin = 0;
+    while (begin < text.size()) {
+        std::size_t end = begin + chunk_bytes;
+        if (end >= text.size()) {
+            end = text.size();
+        } else {
+            // find_byte returns the length searched when there is no match
+            end += find_byte(data + end, text.size() - end, '\n');
+            end = std::min(end + 1, text.size());
+        }
+        ranges.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
+    return ranges;
+}
+
+// --- SECTION 2: Text Sources ---
+
+// A whole file as one contiguous string_view, valid while the source lives
+class text_source {
+public:
+    // Throws std::system_error if the file cannot be opened or read
+    explicit text_source(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw std::system_error(errno, std::generic_category(), "text_source: open " + path);
+        try {
+            load(fd);
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+        ::close(fd);
+    }
+
+    std::string_view text() const noexcept { return text_; }
+    bool mapped() const noexcept { return map_.data() != nullptr; }
+
+private:
+    void load(int fd) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            map_ = mapped_file(fd, static_cast<std::size_t>(st.st_size));
+            text_ = map_.view();
+            return;
+        }
+        char block[1 << 16];  // Pipes, terminals and /proc files (which report size 0)
+        for (;;) {
+            ssize_t n = ::read(fd, block, sizeof block);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) throw std::system_error(errno, std::generic_category(), "text_source: read");
+            if (n == 0) break;
+            buffer_.append(block, static_cast<std::size_t>(n));
+        }
+        text_ = buffer_;
+    }
+
+    mapped_file map_;
+    std::string buffer_;
+    std::string_view text_;
+};
+
+// --- SECTION 3: parallel_text_reduce ---
+
+// body(std::string_view lines, T accumulator) -> T folds one line-aligned range
+// into an accumulator; combine(T, T) -> T merges two and must be associative.
+// With reduce_mode::fast (the default) each participating thread keeps one
+// accumulator, so heavy results (maps, histograms) are merged once per thread.
+template <typename T, typename Body, typename Combine>
+T parallel_text_reduce(std::string_view text, T identity, Body&& body, Combine&& combine,
+                       parallel_text_options options = {}, thread_pool& pool = shared_thread_pool()) {
+    std::vector<std::string_view> ranges = split_at_lines(text, options.chunk_bytes);
+    return parallel_reduce(
+        index_range{0, ranges.size()}, 1, std::move(identity),
+        [&](index_range r, T accumulator) {
+            for (std::size_t i = r.begin; i < r.end; ++i) accumulator = body(ranges[i], std::move(accumulator));
+            return accumulator;
+        },
+        std::forward<Combine>(combine), options.mode, pool);
+}
+
+// --- SECTION 4: Reference Tasks ---
+
+struct text_counts {
+    uint64_t lines = 0;  // A last line without '\n' counts too
+    uint64_t words = 0;  // Runs of non-whitespace bytes
+    uint64_t bytes = 0;
+
+    text_counts& operator+=(const text_counts& other) noexcept {
+        lines += other.lines;
+        words += other.words;
+        bytes += other.bytes;
+        return *this;
+    }
+
+    friend text_counts operator+(text_counts a, const text_counts& b) noexcept { return a += b; }
+};
+
+// '\n' count of one range, 4 KiB of newline bitmap at a time
+inline uint64_t count_lines(std::string_view text) {
+    auto byte_mask = simd_kernels().byte_mask;
+    const auto* data = reinterpret_cast<const uint8_t*>(text.data());
+    uint64_t bits[4096 / 64];
+    uint64_t lines = 0;
+    for (std::size_t at = 0; at < text.size(); at += 4096) {
+        std::size_t n = std::min<std::size_t>(4096, text.size() - at);
+        byte_mask(data + at, n, '\n', bits);
+        for (std::size_t w = 0; w < (n + 63) / 64; ++w) lines += static_cast<uint64_t>(__builtin_popcountll(bits[w]));
+    }
+    if (!text.empty() && text.back() != '\n') ++lines;
+    return lines;
+}
+
+inline text_counts count_text(std::string_view text) {
+    text_counts counts;
+    counts.lines = count_lines(text);
+    counts.words = count_tokens(text);  // Whitespace-separated, like operator>>
+    counts.bytes = text.size();
+    return counts;
+}
+
+inline text_counts parallel_count_text(std::string_view text, parallel_text_options options = {},
+                                       thread_pool& pool = shared_thread_pool()) {
+    return parallel_text_reduce(
+        text, text_counts{}, [](std::string_view lines, text_counts acc) { return acc += count_text(lines); },
+        std::plus<>(), options, pool);
+}
+
+// Keys are views into `text`: keep its source alive while using the map
+using word_frequency_map = std::unordered_map<std::string_view, uint64_t>;
+
+inline word_frequency_map parallel_word_frequencies(std::string_view text, parallel_text_options options = {},
+                                                    thread_pool& pool = shared_thread_pool()) {
+    return parallel_text_reduce(
+        text, word_frequency_map{},
+        [](std::string_view lines, word_frequency_map counts) {
+            tokenizer(lines).for_each([&](std::string_view word) { ++counts[word]; });
+            return counts;
+        },
+        [](word_frequency_map a, word_frequency_map b) {
+            if (a.size() < b.size()) std::swap(a, b);  // Merge the smaller map into the larger
+            for (const auto& [word, count] : b) a[word] += count;
+            return a;
+        },
+        options, pool);
+}
@@ -3,8 +3,28 @@
 #include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <cstdio>
 #include <functional>
+#include <iomanip>
+#include <map>
+#include <memory_resource>
+#include <optional>
+#include <random>
+#include <string>
 #include <unordered_map>
+#include <unistd.h>          // sysconf() for the page size
+
+#ifdef __GLIBC__
+#include <malloc.h>          // malloc_trim() so each RSS measurement starts clean
+#endif
+
+#include "arena_allocator.hpp"  // Monotonic arena, size-class pool and pmr adapters
+
+#include "benchmark.hpp"     // run_benchmark() and do_not_optimize()
+#include "simd_kernels.hpp"  // Vectorized kernels with runtime ISA dispatch
+#include "small_vector.hpp"  // small_vector and growable_vector with growth policies
+#include "tokenizer.hpp"     // delimiter_set, tokenizer_detail::class_mask_for
 
 // Function to demonstrate the use of efficient data structures (unordered_map vs map)
 void map_vs_unordered_map() {
@@ -31,6 +51,114 @@ void map_vs_unordered_map() {
     std::cout << "std::unordered_map insertions took: " << unordered_map_duration.count() << " seconds\n";
 }
 
+// Resident set size of this process in KiB, read from /proc/self/statm
+long current_rss_kb() {
+    long pages_total = 0, pages_resident = 0;
+    if (FILE* statm = std::fopen("/proc/self/statm", "r")) {
+        if (std::fscanf(statm, "%ld %ld", &pages_total, &pages_resident) != 2) pages_resident = 0;
+        std::fclose(statm);
+    }
+    return pages_resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Insert 1M keys, then tear the container down, timing both phases
+template <typename Map, typename Teardown>
+void time_inserts_and_teardown(const char* name, Map& map, Teardown teardown, long rss_before) {
+    const int COUNT = 1000000;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < COUNT; ++i) {
+        map[i] = i;
+    }
+    auto middle = std::chrono::high_resolution_clock::now();
+    long rss_grown = current_rss_kb() - rss_before;
+    teardown();
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double> insert_duration = middle - start;
+    std::chrono::duration<double> teardown_duration = end - middle;
+    std::cout << "  " << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(4)
+              << "insert " << insert_duration.count() << " s, teardown " << std::setprecision(6)
+              << teardown_duration.count() << " s, RSS +" << rss_grown / 1024 << " MiB\n" << std::defaultfloat;
+}
+
+// Give freed heap memory back to the OS so RSS deltas are comparable
+void trim_heap() {
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+}
+
+// Function to compare the default allocator with arena allocation for node containers
+void arena_allocation_benchmark() {
+    std::cout << "Performance Test: arena allocation for node-based containers\n";
+
+    std::cout << "std::map<int, int>:\n";
+    {
+        trim_heap();
+        long rss = current_rss_kb();
+        std::optional<std::map<int, int>> map(std::in_place);
+        time_inserts_and_teardown("default allocator", *map, [&] { map.reset(); }, rss);
+    }
+    {
+        // Destructor still walks every node, but each deallocate is a no-op
+        trim_heap();
+        long rss = current_rss_kb();
+        arena_resource arena;
+        std::optional<std::pmr::map<int, int>> map(std::in_place, &arena);
+        time_inserts_and_teardown("monotonic arena, normal destructor", *map, [&] {
+            map.reset();
+            arena.release();
+        }, rss);
+    }
+    {
+        // The map lives inside the arena and is dropped with it: O(1) teardown
+        trim_heap();
+        long rss = current_rss_kb();
+        arena_resource arena;
+        auto* map = make_in_arena<std::pmr::map<int, int>>(arena);
+        time_inserts_and_teardown("monotonic arena, release()", *map, [&] { arena.release(); }, rss);
+    }
+    {
+        trim_heap();
+        long rss = current_rss_kb();
+        pool_resource pool;
+        auto* map = make_in_arena<std::pmr::map<int, int>>(pool);
+        time_inserts_and_teardown("size-class pool, release()", *map, [&] { pool.release(); }, rss);
+    }
+    {
+        trim_heap();
+        long rss = current_rss_kb();
+        std::pmr::monotonic_buffer_resource upstream;
+        std::optional<std::pmr::map<int, int>> map(std::in_place, &upstream);
+        time_inserts_and_teardown("std::pmr::monotonic_buffer_resource", *map, [&] {
+            map.reset();
+            upstream.release();
+        }, rss);
+    }
+
+    std::cout << "std::unordered_map<int, int>:\n";
+    {
+        trim_heap();
+        long rss = current_rss_kb();
+        std::optional<std::unordered_map<int, int>> map(std::in_place);
+        time_inserts_and_teardown("default allocator", *map, [&] { map.reset(); }, rss);
+    }
+    {
+        trim_heap();
+        long rss = current_rss_kb();
+        arena_resource arena;
+        auto* map = make_in_arena<std::pmr::unordered_map<int, int>>(arena);
+        time_inserts_and_teardown("monotonic arena, release()", *map, [&] { arena.release(); }, rss);
+    }
+    {
+        trim_heap();
+        long rss = current_rss_kb();
+        pool_resource pool;
+        auto* map = make_in_arena<std::pmr::unordered_map<int, int>>(pool);
+        time_inserts_and_teardown("size-class pool, release()", *map, [&] { pool.release(); }, rss);
+    }
+}
+
 // Function to demonstrate the impact of reserving space in vectors
 void vector_reserving() {
     std::cout << "Performance Test: vector reserving\n";
@@ -57,20 +185,92 @@ void vector_reserving() {
     std::cout << "With reserving space: " << duration2.count() << " seconds\n";
 }
 
+// Function to compare small_vector and growth policies against std::vector
+void small_vector_and_growth_policies() {
+    std::cout << "Performance Test: small_vector and growth policies\n";
+
+    // One large vector: growth policy and in-place growth matter most here
+    const int SIZE = 1000000;
+    const size_t ITERATIONS = 20;
+    std::cout << "Appending " << SIZE << " ints to one vector:\n";
+    run_benchmark("std::vector", ITERATIONS, [&] {
+        std::vector<int> v;
+        for (int i = 0; i < SIZE; ++i) v.push_back(i);
+        do_not_optimize(v.data());
+    });
+    run_benchmark("std::vector + reserve", ITERATIONS, [&] {
+        std::vector<int> v;
+        v.reserve(SIZE);
+        for (int i = 0; i < SIZE; ++i) v.push_back(i);
+        do_not_optimize(v.data());
+    });
+    run_benchmark("growable_vector (x2, realloc/mremap)", ITERATIONS, [&] {
+        growable_vector<int, growth_factor<2>> v;
+        for (int i = 0; i < SIZE; ++i) v.push_back(i);
+        do_not_optimize(v.data());
+    });
+    run_benchmark("growable_vector (x1.5)", ITERATIONS, [&] {
+        growable_vector<int, growth_factor<3, 2>> v;
+        for (int i = 0; i < SIZE; ++i) v.push_back(i);
+        do_not_optimize(v.data());
+    });
+    run_benchmark("growable_vector + reserve", ITERATIONS, [&] {
+        growable_vector<int> v;
+        v.reserve(SIZE);
+        for (int i = 0; i < SIZE; ++i) v.push_back(i);
+        do_not_optimize(v.data());
+    });
+
+    // Many short-lived small vectors: small_vector never touches the heap
+    const int COUNT = 100000;
+    const int SMALL = 8;
+    std::cout << "Building " << COUNT << " vectors of " << SMALL << " ints:\n";
+    run_benchmark("std::vector", 10, [&] {
+        for (int n = 0; n < COUNT; ++n) {
+            std::vector<int> v;
+            for (int i = 0; i < SMALL; ++i) v.push_back(i);
+            do_not_optimize(v.data());
+        }
+    });
+    run_benchmark("std::vector + reserve", 10, [&] {
+        for (int n = 0; n < COUNT; ++n) {
+            std::vector<int> v;
+            v.reserve(SMALL);
+            for (int i = 0; i < SMALL; ++i) v.push_back(i);
+            do_not_optimize(v.data());
+        }
+    });
+    run_benchmark("small_vector<int, 16>", 10, [&] {
+        for (int n = 0; n < COUNT; ++n) {
+            small_vector<int, 16> v;
+            for (int i = 0; i < SMALL; ++i) v.push_back(i);
+            do_not_optimize(v.data());
+        }
+    });
+    run_benchmark("small_vector<int, 4> (spills)", 10, [&] {
+        for (int n = 0; n < COUNT; ++n) {
+            small_vector<int, 4> v;
+            for (int i = 0; i < SMALL; ++i) v.push_back(i);
+            do_not_optimize(v.data());
+        }
+    });
+}
+
 // Function to demonstrate the impact of loop unrolling
 void loop_unrolling() {
     std::cout << "Performance Test: loop unrolling\n";
     const int SIZE = 1000000;
-    int sum = 0;
+    long long sum = 0;  // The sum of 0..999999 does not fit in an int
 
     // Without loop unrolling
     auto start = std::chrono::high_resolution_clock::now();
     for (int i = 0; i < SIZE; ++i) {
         sum += i;
     }
+    do_not_optimize(sum);
     auto end = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> duration1 = end - start;
-    std::cout << "Without loop unrolling: " << duration1.count() << " seconds\n";
+    std::cout << "Without loop unrolling: " << duration1.count() << " seconds (sum = " << sum << ")\n";
 
     // With loop unrolling (manual)
     sum = 0;
@@ -81,9 +281,363 @@ void loop_unrolling() {
         sum += i + 2;
         sum += i + 3;
     }
+    do_not_optimize(sum);
     end = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> duration2 = end - start;
-    std::cout << "With loop unrolling: " << duration2.count() << " seconds\n";
+    std::cout << "With loop unrolling: " << duration2.count() << " seconds (sum = " << sum << ")\n";
+}
+
+// --- Baselines for the SIMD kernels ---
+// "scalar" loops are compiled with auto-vectorization switched off, "unrolled" loops
+// additionally use independent accumulators (the manual technique shown above), and
+// the "auto-vectorized" baselines are the plain simd_scalar:: loops, which GCC and
+// Clang vectorize on their own at -O2/-O3 where the loop allows it.
+#if defined(__GNUC__) && !defined(__clang__)
+#define NO_AUTO_VECTORIZE __attribute__((optimize("no-tree-vectorize")))
+#else
+#define NO_AUTO_VECTORIZE
+#endif
+
+NO_AUTO_VECTORIZE int64_t scalar_sum(const int32_t* data, size_t n) {
+    int64_t total = 0;
+    for (size_t i = 0; i < n; ++i) total += data[i];
+    return total;
+}
+
+NO_AUTO_VECTORIZE int64_t unrolled_sum(const int32_t* data, size_t n) {
+    int64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += data[i];
+        s1 += data[i + 1];
+        s2 += data[i + 2];
+        s3 += data[i + 3];
+    }
+    for (; i < n; ++i) s0 += data[i];
+    return (s0 + s1) + (s2 + s3);
+}
+
+NO_AUTO_VECTORIZE float scalar_dot(const float* a, const float* b, size_t n) {
+    float total = 0.0f;
+    for (size_t i = 0; i < n; ++i) total += a[i] * b[i];
+    return total;
+}
+
+NO_AUTO_VECTORIZE float unrolled_dot(const float* a, const float* b, size_t n) {
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < n; ++i) s0 += a[i] * b[i];
+    return (s0 + s1) + (s2 + s3);
+}
+
+NO_AUTO_VECTORIZE void scalar_axpy(float a, const float* x, float* y, size_t n) {
+    for (size_t i = 0; i < n; ++i) y[i] += a * x[i];
+}
+
+NO_AUTO_VECTORIZE void unrolled_axpy(float a, const float* x, float* y, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        y[i] += a * x[i];
+        y[i + 1] += a * x[i + 1];
+        y[i + 2] += a * x[i + 2];
+        y[i + 3] += a * x[i + 3];
+    }
+    for (; i < n; ++i) y[i] += a * x[i];
+}
+
+NO_AUTO_VECTORIZE minmax_result scalar_min_max(const int32_t* data, size_t n) {
+    minmax_result r{INT32_MAX, INT32_MIN};
+    for (size_t i = 0; i < n; ++i) {
+        r.min = std::min(r.min, data[i]);
+        r.max = std::max(r.max, data[i]);
+    }
+    return r;
+}
+
+NO_AUTO_VECTORIZE minmax_result unrolled_min_max(const int32_t* data, size_t n) {
+    int32_t lo0 = INT32_MAX, lo1 = INT32_MAX, hi0 = INT32_MIN, hi1 = INT32_MIN;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        lo0 = std::min(lo0, data[i]);
+        hi0 = std::max(hi0, data[i]);
+        lo1 = std::min(lo1, data[i + 1]);
+        hi1 = std::max(hi1, data[i + 1]);
+    }
+    for (; i < n; ++i) {
+        lo0 = std::min(lo0, data[i]);
+        hi0 = std::max(hi0, data[i]);
+    }
+    return {std::min(lo0, lo1), std::max(hi0, hi1)};
+}
+
+NO_AUTO_VECTORIZE size_t scalar_count_if(const int32_t* data, size_t n, compare_op op, int32_t value) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) count += simd_scalar::compare(data[i], op, value) ? 1 : 0;
+    return count;
+}
+
+NO_AUTO_VECTORIZE size_t unrolled_count_if(const int32_t* data, size_t n, compare_op op, int32_t value) {
+    size_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        c0 += simd_scalar::compare(data[i], op, value) ? 1 : 0;
+        c1 += simd_scalar::compare(data[i + 1], op, value) ? 1 : 0;
+        c2 += simd_scalar::compare(data[i + 2], op, value) ? 1 : 0;
+        c3 += simd_scalar::compare(data[i + 3], op, value) ? 1 : 0;
+    }
+    for (; i < n; ++i) c0 += simd_scalar::compare(data[i], op, value) ? 1 : 0;
+    return c0 + c1 + c2 + c3;
+}
+
+NO_AUTO_VECTORIZE void scalar_prefix_sum(const int32_t* in, int32_t* out, size_t n) {
+    uint32_t running = 0;
+    for (size_t i = 0; i < n; ++i) {
+        running += static_cast<uint32_t>(in[i]);
+        out[i] = static_cast<int32_t>(running);
+    }
+}
+
+// Unrolling cannot break the running-sum dependency, it only saves loop overhead
+NO_AUTO_VECTORIZE void unrolled_prefix_sum(const int32_t* in, int32_t* out, size_t n) {
+    uint32_t running = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        uint32_t a = running + static_cast<uint32_t>(in[i]);
+        uint32_t b = a + static_cast<uint32_t>(in[i + 1]);
+        uint32_t c = b + static_cast<uint32_t>(in[i + 2]);
+        running = c + static_cast<uint32_t>(in[i + 3]);
+        out[i] = static_cast<int32_t>(a);
+        out[i + 1] = static_cast<int32_t>(b);
+        out[i + 2] = static_cast<int32_t>(c);
+        out[i + 3] = static_cast<int32_t>(running);
+    }
+    for (; i < n; ++i) {
+        running += static_cast<uint32_t>(in[i]);
+        out[i] = static_cast<int32_t>(running);
+    }
+}
+
+NO_AUTO_VECTORIZE void scalar_histogram(const uint8_t* data, size_t n, uint32_t* counts) {
+    std::fill(counts, counts + 256, 0u);
+    for (size_t i = 0; i < n; ++i) counts[data[i]]++;
+}
+
+NO_AUTO_VECTORIZE void unrolled_histogram(const uint8_t* data, size_t n, uint32_t* counts) {
+    std::fill(counts, counts + 256, 0u);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        counts[data[i]]++;
+        counts[data[i + 1]]++;
+        counts[data[i + 2]]++;
+        counts[data[i + 3]]++;
+    }
+    for (; i < n; ++i) counts[data[i]]++;
+}
+
+// find_byte and byte_mask of one tier against simd_scalar on lengths around the
+// 16/32/64-byte block sizes (so every tail path runs), from unaligned starts, for a
+// byte that matches often, one that never does and one that matches only at the end
+bool byte_kernels_match(const simd_kernel_table& k, const std::vector<uint8_t>& bytes) {
+    const size_t lengths[] = {0, 1, 15, 16, 17, 31, 32, 33, 63, 64, 65, 100, 127, 128, 129, 1000, 4095, 4096, 4097};
+    const uint64_t sentinel = 0x5A5A5A5A5A5A5A5Aull;
+    std::vector<uint8_t> buffer(bytes.begin(), bytes.begin() + 4097 + 8);  // Values 0..15
+    std::vector<uint64_t> bits(4097 / 64 + 2), expected_bits(4097 / 64 + 2);
+    for (size_t offset : {0, 1, 7}) {
+        for (size_t n : lengths) {
+            const uint8_t* data = buffer.data() + offset;
+            const size_t words = (n + 63) / 64;
+            for (int variant = 0; variant < 3; ++variant) {
+                uint8_t value = variant == 0 ? 3 : 200;
+                if (variant == 2 && n > 0) buffer[offset + n - 1] = 200;
+                std::fill(bits.begin(), bits.end(), sentinel);
+                k.byte_mask(data, n, value, bits.data());
+                simd_scalar::byte_mask(data, n, value, expected_bits.data());
+                bool match = k.find_byte(data, n, value) == simd_scalar::find_byte(data, n, value) &&
+                             std::equal(bits.begin(), bits.begin() + words, expected_bits.begin()) &&
+                             bits[words] == sentinel;  // Exactly (n + 63) / 64 words written
+                if (variant == 2 && n > 0) buffer[offset + n - 1] = bytes[offset + n - 1];
+                if (!match) return false;
+            }
+        }
+    }
+    return true;
+}
+
+// The tokenizer's delimiter classification for one tier against the scalar kernel,
+// on the same lengths and offsets: whitespace and a short set (nibble-table
+// lookups), and ten bytes with distinct high nibbles (the compare-each-byte path)
+bool class_kernels_match(isa_level isa, const std::vector<uint8_t>& bytes) {
+    const size_t lengths[] = {0, 1, 15, 16, 17, 31, 32, 33, 63, 64, 65, 100, 127, 128, 129, 1000, 4095, 4096, 4097};
+    const uint64_t sentinel = 0x5A5A5A5A5A5A5A5Aull;
+    std::string wide;
+    for (int c = 0; c < 10; ++c) wide += static_cast<char>(c * 0x11);
+    const delimiter_set sets[] = {delimiter_set::whitespace(), delimiter_set(",;\n"), delimiter_set(wide)};
+    // Values 0..15 hit whitespace; the same values times 0x11 hit every high nibble
+    std::vector<uint8_t> low(bytes.begin(), bytes.begin() + 4097 + 8), spread(low);
+    for (uint8_t& b : spread) b = static_cast<uint8_t>(b * 0x11);
+    std::vector<uint64_t> bits(4097 / 64 + 2), expected_bits(4097 / 64 + 2);
+    tokenizer_detail::class_mask_fn class_mask = tokenizer_detail::class_mask_for(isa);
+    for (const delimiter_set& set : sets) {
+        for (const std::vector<uint8_t>* buffer : {&low, &spread}) {
+            for (size_t offset : {0, 1, 7}) {
+                for (size_t n : lengths) {
+                    const uint8_t* data = buffer->data() + offset;
+                    const size_t words = (n + 63) / 64;
+                    std::fill(bits.begin(), bits.end(), sentinel);
+                    class_mask(data, n, set, bits.data());
+                    tokenizer_detail::class_mask_scalar(data, n, set, expected_bits.data());
+                    if (!std::equal(bits.begin(), bits.begin() + words, expected_bits.begin()) ||
+                        bits[words] != sentinel) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Function to benchmark each SIMD kernel against the scalar, unrolled and
+// auto-vectorized baselines, and against every instruction set this CPU supports
+void simd_kernels_benchmark() {
+    std::cout << "Performance Test: SIMD kernels (runtime dispatch selected "
+              << isa_name(simd_kernels().isa) << ")\n";
+
+    const size_t SIZE = 1 << 16;  // 256 KiB per array, so the data stays in L2
+    const size_t ITERATIONS = 500;
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int32_t> int_dist(-1000000, 1000000);
+    std::uniform_real_distribution<float> float_dist(-1.0f, 1.0f);
+    std::vector<int32_t> ints(SIZE);
+    std::vector<int32_t> prefix(SIZE);
+    std::vector<float> xs(SIZE), ys(SIZE);
+    std::vector<uint8_t> bytes(SIZE);
+    for (size_t i = 0; i < SIZE; ++i) {
+        ints[i] = int_dist(rng);
+        xs[i] = float_dist(rng);
+        ys[i] = float_dist(rng);
+        bytes[i] = static_cast<uint8_t>(rng() % 16);  // Skewed like text, so bins repeat often
+    }
+    uint32_t counts[256];
+
+    // Every SIMD instruction set the CPU supports, up to the one dispatch selected
+    // (the scalar tier is the same code as the auto-vectorized baseline)
+    std::vector<simd_kernel_table> tiers;
+    for (int level = 1; level <= static_cast<int>(simd_kernels().isa); ++level) {
+        tiers.push_back(simd_kernels_for(static_cast<isa_level>(level)));
+    }
+
+    // Check every tier against the scalar reference before timing anything
+    bool all_match = true;
+    const int64_t expected_sum = scalar_sum(ints.data(), SIZE);
+    const minmax_result expected_mm = scalar_min_max(ints.data(), SIZE);
+    const size_t expected_count = scalar_count_if(ints.data(), SIZE, compare_op::greater, 0);
+    const float expected_dot = scalar_dot(xs.data(), ys.data(), SIZE);
+    std::vector<int32_t> expected_prefix(SIZE);
+    scalar_prefix_sum(ints.data(), expected_prefix.data(), SIZE);
+    uint32_t expected_counts[256];
+    scalar_histogram(bytes.data(), SIZE, expected_counts);
+    for (const auto& k : tiers) {
+        minmax_result mm = k.min_max(ints.data(), SIZE);
+        k.prefix_sum(ints.data(), prefix.data(), SIZE);
+        k.histogram(bytes.data(), SIZE, counts);
+        bool match = k.sum(ints.data(), SIZE) == expected_sum && mm.min == expected_mm.min &&
+                     mm.max == expected_mm.max &&
+                     k.count_if(ints.data(), SIZE, compare_op::greater, 0) == expected_count &&
+                     std::fabs(k.dot(xs.data(), ys.data(), SIZE) - expected_dot) < 1e-2f &&
+                     prefix == expected_prefix && std::equal(counts, counts + 256, expected_counts) &&
+                     byte_kernels_match(k, bytes) && class_kernels_match(k.isa, bytes);
+        std::cout << "  " << isa_name(k.isa) << " kernels " << (match ? "match" : "DO NOT match")
+                  << " the scalar reference\n";
+        all_match = all_match && match;
+    }
+    if (!all_match) {
+        std::cerr << "SIMD kernel mismatch, skipping timings\n";
+        return;
+    }
+
+    const double int_bytes = SIZE * sizeof(int32_t);
+    const double float_bytes = SIZE * sizeof(float);
+
+    std::cout << "sum (int32 -> int64):\n";
+    run_benchmark("scalar", ITERATIONS, [&] { do_not_optimize(scalar_sum(ints.data(), SIZE)); }, int_bytes);
+    run_benchmark("unrolled", ITERATIONS, [&] { do_not_optimize(unrolled_sum(ints.data(), SIZE)); }, int_bytes);
+    run_benchmark("auto-vectorized", ITERATIONS, [&] { do_not_optimize(simd_scalar::sum(ints.data(), SIZE)); }, int_bytes);
+    for (const auto& k : tiers) {
+        run_benchmark(isa_name(k.isa), ITERATIONS, [&] { do_not_optimize(k.sum(ints.data(), SIZE)); }, int_bytes);
+    }
+
+    std::cout << "dot (float):\n";
+    run_benchmark("scalar", ITERATIONS, [&] { do_not_optimize(scalar_dot(xs.data(), ys.data(), SIZE)); }, 2 * float_bytes);
+    run_benchmark("unrolled", ITERATIONS, [&] { do_not_optimize(unrolled_dot(xs.data(), ys.data(), SIZE)); }, 2 * float_bytes);
+    run_benchmark("auto-vectorized", ITERATIONS,
+                  [&] { do_not_optimize(simd_scalar::dot(xs.data(), ys.data(), SIZE)); }, 2 * float_bytes);
+    for (const auto& k : tiers) {
+        run_benchmark(isa_name(k.isa), ITERATIONS, [&] { do_not_optimize(k.dot(xs.data(), ys.data(), SIZE)); }, 2 * float_bytes);
+    }
+
+    // A tiny factor keeps y bounded over many iterations
+    const float a = 1e-7f;
+    std::cout << "axpy (float):\n";
+    run_benchmark("scalar", ITERATIONS, [&] { scalar_axpy(a, xs.data(), ys.data(), SIZE); clobber_memory(); }, 3 * float_bytes);
+    run_benchmark("unrolled", ITERATIONS, [&] { unrolled_axpy(a, xs.data(), ys.data(), SIZE); clobber_memory(); }, 3 * float_bytes);
+    run_benchmark("auto-vectorized", ITERATIONS,
+                  [&] { simd_scalar::axpy(a, xs.data(), ys.data(), SIZE); clobber_memory(); }, 3 * float_bytes);
+    for (const auto& k : tiers) {
+        run_benchmark(isa_name(k.isa), ITERATIONS, [&] { k.axpy(a, xs.data(), ys.data(), SIZE); clobber_memory(); }, 3 * float_bytes);
+    }
+
+    std::cout << "min/max (int32):\n";
+    run_benchmark("scalar", ITERATIONS, [&] { do_not_optimize(scalar_min_max(ints.data(), SIZE)); }, int_bytes);
+    run_benchmark("unrolled", ITERATIONS, [&] { do_not_optimize(unrolled_min_max(ints.data(), SIZE)); }, int_bytes);
+    run_benchmark("auto-vectorized", ITERATIONS, [&] { do_not_optimize(simd_scalar::min_max(ints.data(), SIZE)); }, int_bytes);
+    for (const auto& k : tiers) {
+        run_benchmark(isa_name(k.isa), ITERATIONS, [&] { do_not_optimize(k.min_max(ints.data(), SIZE)); }, int_bytes);
+    }
+
+    std::cout << "count_if (int32 > 0):\n";
+    run_benchmark("scalar", ITERATIONS,
+                  [&] { do_not_optimize(scalar_count_if(ints.data(), SIZE, compare_op::greater, 0)); }, int_bytes);
+    run_benchmark("unrolled", ITERATIONS,
+                  [&] { do_not_optimize(unrolled_count_if(ints.data(), SIZE, compare_op::greater, 0)); }, int_bytes);
+    run_benchmark("auto-vectorized", ITERATIONS,
+                  [&] { do_not_optimize(simd_scalar::count_if(ints.data(), SIZE, compare_op::greater, 0)); }, int_bytes);
+    for (const auto& k : tiers) {
+        run_benchmark(isa_name(k.isa), ITERATIONS,
+                      [&] { do_not_optimize(k.count_if(ints.data(), SIZE, compare_op::greater, 0)); }, int_bytes);
+    }
+
+    std::cout << "prefix sum (int32):\n";
+    run_benchmark("scalar", ITERATIONS, [&] { scalar_prefix_sum(ints.data(), prefix.data(), SIZE); clobber_memory(); }, 2 * int_bytes);
+    run_benchmark("unrolled", ITERATIONS, [&] { unrolled_prefix_sum(ints.data(), prefix.data(), SIZE); clobber_memory(); }, 2 * int_bytes);
+    run_benchmark("auto-vectorized", ITERATIONS,
+                  [&] { simd_scalar::prefix_sum(ints.data(), prefix.data(), SIZE); clobber_memory(); }, 2 * int_bytes);
+    for (const auto& k : tiers) {
+        run_benchmark(isa_name(k.isa), ITERATIONS,
+                      [&] { k.prefix_sum(ints.data(), prefix.data(), SIZE); clobber_memory(); }, 2 * int_bytes);
+    }
+
+    std::cout << "histogram (uint8, 256 bins):\n";
+    run_benchmark("scalar", ITERATIONS, [&] { scalar_histogram(bytes.data(), SIZE, counts); clobber_memory(); }, SIZE);
+    run_benchmark("unrolled", ITERATIONS, [&] { unrolled_histogram(bytes.data(), SIZE, counts); clobber_memory(); }, SIZE);
+    run_benchmark("auto-vectorized", ITERATIONS,
+                  [&] { simd_scalar::histogram(bytes.data(), SIZE, counts); clobber_memory(); }, SIZE);
+    for (const auto& k : tiers) {
+        run_benchmark(isa_name(k.isa), ITERATIONS, [&] { k.histogram(bytes.data(), SIZE, counts); clobber_memory(); }, SIZE);
+    }
+#ifdef SIMD_KERNELS_X86
+    if (simd_kernels().isa == isa_level::avx512 && simd_avx512::has_conflict_detection()) {
+        run_benchmark("avx512 conflict detection", ITERATIONS,
+                      [&] { simd_avx512::histogram_conflict(bytes.data(), SIZE, counts); clobber_memory(); }, SIZE);
+    }
+#endif
 }
 
 // Function to demonstrate memoization for improving recursive performance
@@ -125,8 +679,11 @@ int main() {
     std::cout << "Demonstrating Performance Tuning Techniques in C++:\n";
 
     map_vs_unordered_map();
+    arena_allocation_benchmark();
     vector_reserving();
+    small_vector_and_growth_policies();
     loop_unrolling();
+    simd_kernels_benchmark();
     memoization_example();
     precomputation_example();
 
@@ -0,0 +1,521 @@
+#pragma once
+
+// Multi-stage pipelines: read -> parse -> transform -> aggregate -> write.
+//
+//   make_pipeline(name, source)   - serial source: std::optional<T>() until nullopt
+//   .then(name, threads, fn)      - stage T -> U, or T -> std::optional<U> to drop items
+//   .sink(name, threads, fn)      - last stage, T -> void; returns the runnable pipeline
+//   pipeline::run()               - runs every stage on its own threads until the
+//                                   source is exhausted and all items have drained
+//   pipeline_report::print()      - per-stage throughput, utilization, channel
+//                                   occupancy and time blocked on each side
+//
+// Stages are connected by bounded mpmc_queue channels. A full channel stalls
+// the stage feeding it (backpressure), so memory stays bounded however uneven
+// the stages are; the waiting either spins then sleeps on a futex (block) or
+// spins and yields (spin, lowest latency when there are spare cores).
+//
+// Items move in batches: a worker pops up to batch_size items with one CAS,
+// processes them and pushes its results with one CAS, which amortizes the
+// channel cost over the batch and keeps the data in cache.
+//
+// Every item carries the sequence number the source gave it. In ordered mode
+// a stage with one thread (and so the sink, if it has one thread) sees items
+// in source order: parallel stages work in any order and the serial stage
+// re-sequences its input in a small heap. A dropped item still travels on as
+// an empty slot so nobody waits for it. In unordered mode items flow through
+// as they complete and drops vanish.
+//
+// Each stage owns `threads` dedicated threads rather than pool workers: a
+// stage blocked on a full channel must not hold a worker the stage downstream
+// needs to drain it. A pipeline runs once; an exception escaping a stage
+// function terminates the program.
+//
+// Usage:
+//   pipeline_options options;
+//   options.order = pipeline_order::ordered;
+//   pipeline p = make_pipeline("ingest", [&] { return next_line(); }, options)
+//                    .then("parse", 4, [](std::string line) { return parse(line); })
+//                    .then("filter", 2, [](record r) -> std::optional<record> { ... })
+//                    .sink("write", 1, [&](record r) { out << r; });
+//   p.run().print(std::cout);
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <queue>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "futex.hpp"       // cpu_relax, default_spin_iterations
+#include "mpmc_queue.hpp"  // Bounded channels between stages
+
+enum class pipeline_order {
+    unordered,  // Items leave each stage as soon as they are done
+    ordered     // Serial stages see items in source order
+};
+
+enum class pipeline_wait {
+    block,  // Spin briefly, then sleep on a futex
+    spin    // Spin, yielding the CPU between attempts; never sleeps
+};
+
+struct pipeline_options {
+    std::size_t channel_capacity = 1024;  // Items per channel, rounded up to a power of two
+    std::size_t batch_size = 64;          // Items moved per channel operation
+    pipeline_order order = pipeline_order::unordered;
+    pipeline_wait wait = pipeline_wait::block;
+};
+
+// --- SECTION 1: Reports ---
+
+struct pipeline_stage_report {
+    std::string name;
+    std::size_t threads = 0;
+    uint64_t items_in = 0;
+    uint64_t items_out = 0;
+    double busy_seconds = 0;       // In the stage function, summed over threads
+    double input_wait_seconds = 0;  // Starved: waiting for the channel upstream
+    double output_wait_seconds = 0; // Backpressure: waiting for room downstream
+    double mean_occupancy = 0;     // Input channel fill (0..1) seen at each pop
+    uint64_t batches = 0;
+
+    // Fraction of the stage's thread-time spent doing work
+    double utilization(double seconds) const {
+        return seconds > 0 && threads > 0 ? busy_seconds / (seconds * static_cast<double>(threads)) : 0;
+    }
+};
+
+struct pipeline_report {
+    std::string name;
+    double seconds = 0;
+    std::vector<pipeline_stage_report> stages;
+
+    // The stage with the highest utilization: adding threads there (or making
+    // it cheaper) is what raises the pipeline's throughput
+    const pipeline_stage_report* bottleneck() const {
+        const pipeline_stage_report* worst = nullptr;
+        for (const pipeline_stage_report& s : stages) {
+            if (!worst || s.utilization(seconds) > worst->utilization(seconds)) worst = &s;
+        }
+        return worst;
+    }
+
+    void print(std::ostream& out) const {
+        out << "Pipeline '" << name << "': " << std::fixed << std::setprecision(3) << seconds * 1e3 << " ms\n"
+            << "  " << std::left << std::setw(12) << "stage" << std::right << std::setw(8) << "threads" << std::setw(11)
+            << "items in" << std::setw(11) << "items/s" << std::setw(8) << "util" << std::setw(8) << "fill"
+            << std::setw(10) << "batch" << std::setw(12) << "starved ms" << std::setw(12) << "blocked ms" << "\n";
+        for (const pipeline_stage_report& s : stages) {
+            uint64_t items = s.items_in != 0 ? s.items_in : s.items_out;  // The source only produces
+            out << "  " << std::left << std::setw(12) << s.name << std::right << std::setw(8) << s.threads
+                << std::setw(11) << items << std::setw(11) << std::setprecision(0)
+                << (seconds > 0 ? static_cast<double>(items) / seconds : 0.0) << std::setprecision(2)
+                << std::setw(7) << s.utilization(seconds) * 100 << "%" << std::setw(7) << s.mean_occupancy * 100
+                << "%" << std::setw(10) << std::setprecision(1)
+                << (s.batches ? static_cast<double>(items) / static_cast<double>(s.batches) : 0.0)
+                << std::setw(12) << std::setprecision(3) << s.input_wait_seconds * 1e3 << std::setw(12)
+                << s.output_wait_seconds * 1e3 << "\n";
+        }
+        if (const pipeline_stage_report* b = bottleneck()) out << "  bottleneck: " << b->name << "\n";
+        out << std::defaultfloat << std::setprecision(6);
+    }
+};
+
+// --- SECTION 2: Channels ---
+
+namespace pipeline_detail {
+
+using clock = std::chrono::steady_clock;
+
+inline double seconds_between(clock::time_point a, clock::time_point b) {
+    return std::chrono::duration<double>(b - a).count();
+}
+
+inline constexpr uint64_t end_of_stream = ~uint64_t(0);
+
+// One item plus its source sequence number. An empty value is a dropped item
+// (ordered mode only); seq == end_of_stream tells one consumer thread to stop.
+template <typename T>
+struct envelope {
+    uint64_t seq = 0;
+    std::optional<T> value;
+};
+
+// What one stage thread measures; merged into the stage totals when it exits
+struct counters {
+    uint64_t items_in = 0;
+    uint64_t items_out = 0;
+    uint64_t batches = 0;
+    double busy = 0;
+    double input_wait = 0;
+    double output_wait = 0;
+    double occupancy_sum = 0;
+};
+
+inline void spin_pause(std::size_t& spins) {
+    if (spins++ < default_spin_iterations(std::size_t(1) << 16)) {
+        cpu_relax();
+    } else {
+        std::this_thread::yield();
+    }
+}
+
+template <typename T>
+class channel {
+public:
+    channel(std::size_t capacity, pipeline_wait wait) : queue_(capacity), wait_(wait) {}
+
+    // Set when the next stage is attached: how many end markers to send
+    std::size_t consumers = 1;
+
+    // Moves all `count` items in, stalling while the channel is full
+    void push(envelope<T>* items, std::size_t count, counters& c) {
+        std::size_t pushed = queue_.try_push_bulk(std::make_move_iterator(items), count);
+        if (pushed == count) return;
+        clock::time_point start = clock::now();
+        items += pushed;
+        count -= pushed;
+        if (wait_ == pipeline_wait::block) {
+            queue_.push_bulk(std::make_move_iterator(items), count);
+        } else {
+            std::size_t spins = 0;
+            while (count > 0) {
+                pushed = queue_.try_push_bulk(std::make_move_iterator(items), count);
+                if (pushed == 0) spin_pause(spins);
+                items += pushed;
+                count -= pushed;
+            }
+        }
+        c.output_wait += seconds_between(start, clock::now());
+    }
+
+    // Takes between 1 and max_count items, waiting while the channel is empty
+    std::size_t pop(envelope<T>* out, std::size_t max_count, counters& c) {
+        c.occupancy_sum += static_cast<double>(queue_.size_approx()) / static_cast<double>(queue_.capacity());
+        std::size_t n = queue_.try_pop_bulk(out, max_count);
+        if (n != 0) return n;
+        clock::time_point start = clock::now();
+        if (wait_ == pipeline_wait::block) {
+            n = queue_.pop_bulk(out, max_count);
+        } else {
+            std::size_t spins = 0;
+            while ((n = queue_.try_pop_bulk(out, max_count)) == 0) spin_pause(spins);
+        }
+        c.input_wait += seconds_between(start, clock::now());
+        return n;
+    }
+
+    void push_end_markers() {
+        counters ignored;
+        std::vector<envelope<T>> markers(consumers);
+        for (envelope<T>& m : markers) m.seq = end_of_stream;
+        push(markers.data(), markers.size(), ignored);
+    }
+
+private:
+    mpmc_queue<envelope<T>> queue_;
+    pipeline_wait wait_;
+};
+
+// --- SECTION 3: Stages ---
+
+class stage_base {
+public:
+    stage_base(std::string name, std::size_t threads) : name_(std::move(name)), threads_(std::max<std::size_t>(threads, 1)) {}
+    virtual ~stage_base() = default;
+
+    virtual void start(std::vector<std::thread>& threads) = 0;
+
+    std::size_t threads() const noexcept { return threads_; }
+
+    pipeline_stage_report report() const {
+        pipeline_stage_report r;
+        r.name = name_;
+        r.threads = threads_;
+        r.items_in = total_.items_in;
+        r.items_out = total_.items_out;
+        r.batches = total_.batches;
+        r.busy_seconds = total_.busy;
+        r.input_wait_seconds = total_.input_wait;
+        r.output_wait_seconds = total_.output_wait;
+        r.mean_occupancy = total_.batches ? total_.occupancy_sum / static_cast<double>(total_.batches) : 0;
+        return r;
+    }
+
+protected:
+    void merge(const counters& c) {
+        std::lock_guard<futex_mutex> lock(merge_mutex_);
+        total_.items_in += c.items_in;
+        total_.items_out += c.items_out;
+        total_.batches += c.batches;
+        total_.busy += c.busy;
+        total_.input_wait += c.input_wait;
+        total_.output_wait += c.output_wait;
+        total_.occupancy_sum += c.occupancy_sum;
+    }
+
+    std::string name_;
+    std::size_t threads_;
+
+private:
+    futex_mutex merge_mutex_;
+    counters total_;
+};
+
+template <typename Out, typename Fn>
+class source_stage final : public stage_base {
+public:
+    source_stage(std::string name, Fn fn, channel<Out>* out, std::size_t batch_size)
+        : stage_base(std::move(name), 1), fn_(std::move(fn)), out_(out), batch_size_(batch_size) {}
+
+    void start(std::vector<std::thread>& threads) override {
+        threads.emplace_back([this] { run(); });
+    }
+
+private:
+    void run() {
+        counters c;
+        std::vector<envelope<Out>> batch(batch_size_);
+        uint64_t seq = 0;
+        bool exhausted = false;
+        while (!exhausted) {
+            clock::time_point start = clock::now();
+            std::size_t n = 0;
+            while (n < batch_size_) {
+                std::optional<Out> item = fn_();
+                if (!item) {
+                    exhausted = true;
+                    break;
+                }
+                batch[n].seq = seq++;
+                batch[n].value = std::move(item);
+                ++n;
+            }
+            c.busy += seconds_between(start, clock::now());
+            if (n == 0) break;
+            c.items_out += n;
+            ++c.batches;
+            out_->push(batch.data(), n, c);
+        }
+        merge(c);
+        out_->push_end_markers();
+    }
+
+    Fn fn_;
+    channel<Out>* out_;
+    std::size_t batch_size_;
+};
+
+// A transform (Out != void) or the sink (Out == void). All threads of a stage
+// share one fn, so it must be safe to call concurrently when threads > 1.
+template <typename In, typename Out, typename Fn>
+class worker_stage final : public stage_base {
+    using out_item = std::conditional_t<std::is_void_v<Out>, char, Out>;  // char: placeholder for the sink
+
+public:
+    worker_stage(std::string name, std::size_t threads, Fn fn, channel<In>* in, channel<out_item>* out,
+                 const pipeline_options& options)
+        : stage_base(std::move(name), threads),
+          fn_(std::move(fn)),
+          in_(in),
+          out_(out),
+          batch_size_(options.batch_size),
+          ordered_(options.order == pipeline_order::ordered),
+          resequence_(ordered_ && threads_ == 1),
+          running_(threads_) {}
+
+    void start(std::vector<std::thread>& threads) override {
+        for (std::size_t i = 0; i < threads_; ++i) threads.emplace_back([this] { run(); });
+    }
+
+private:
+    struct later_first {
+        bool operator()(const envelope<In>& a, const envelope<In>& b) const { return a.seq > b.seq; }
+    };
+
+    void run() {
+        counters c;
+        std::vector<envelope<In>> input(batch_size_);
+        std::vector<envelope<out_item>> output;
+        output.reserve(batch_size_);
+        std::priority_queue<envelope<In>, std::vector<envelope<In>>, later_first> pending;
+        uint64_t next_seq = 0;
+
+        for (bool done = false; !done;) {
+            std::size_t n = in_->pop(input.data(), batch_size_, c);
+            ++c.batches;
+            clock::time_point start = clock::now();
+            for (std::size_t i = 0; i < n; ++i) {
+                if (input[i].seq == end_of_stream) {
+                    // Everything after our marker is other threads' markers: hand them back
+                    if (i + 1 < n) in_->push(input.data() + i + 1, n - i - 1, c);
+                    done = true;
+                    break;
+                }
+                if (!resequence_) {
+                    process(input[i], output, c);
+                    continue;
+                }
+                pending.push(std::move(input[i]));
+                while (!pending.empty() && pending.top().seq == next_seq) {
+                    // top() is const only to protect the heap order; it is popped right after
+                    process(const_cast<envelope<In>&>(pending.top()), output, c);
+                    pending.pop();
+                    ++next_seq;
+                }
+            }
+            c.busy += seconds_between(start, clock::now());
+            flush(output, c);
+        }
+
+        merge(c);
+        if (running_.fetch_sub(1, std::memory_order_acq_rel) == 1 && out_) out_->push_end_markers();
+    }
+
+    void process(envelope<In>& item, std::vector<envelope<out_item>>& output, counters& c) {
+        if (item.value) {
+            ++c.items_in;
+            if constexpr (std::is_void_v<Out>) {
+                fn_(std::move(*item.value));
+                return;
+            } else if constexpr (std::is_same_v<std::invoke_result_t<Fn&, In&&>, std::optional<Out>>) {
+                std::optional<Out> result = fn_(std::move(*item.value));
+                if (!result && !ordered_) return;  // Dropped; ordered mode keeps the empty slot
+                if (result) ++c.items_out;
+                output.push_back({item.seq, std::move(result)});
+            } else {
+                output.push_back({item.seq, std::optional<Out>(fn_(std::move(*item.value)))});
+                ++c.items_out;
+            }
+        } else if (out_) {
+            output.push_back({item.seq, std::nullopt});  // Dropped upstream: pass the placeholder on
+        }
+        if (output.size() >= batch_size_) flush(output, c);
+    }
+
+    void flush(std::vector<envelope<out_item>>& output, counters& c) {
+        if (output.empty()) return;
+        out_->push(output.data(), output.size(), c);
+        output.clear();
+    }
+
+    Fn fn_;
+    channel<In>* in_;
+    channel<out_item>* out_;  // nullptr for the sink
+    std::size_t batch_size_;
+    bool ordered_;
+    bool resequence_;
+    std::atomic<std::size_t> running_;
+};
+
+template <typename T>
+struct unwrap_optional {
+    using type = T;
+};
+template <typename T>
+struct unwrap_optional<std::optional<T>> {
+    using type = T;
+};
+
+// Stages and channels of one pipeline; the builders add to it
+struct pipeline_state {
+    std::string name;
+    pipeline_options options;
+    std::vector<std::unique_ptr<stage_base>> stages;
+    std::vector<std::shared_ptr<void>> channels;  // Type-erased owners
+};
+
+}  // namespace pipeline_detail
+
+// --- SECTION 4: Builder ---
+
+class pipeline {
+public:
+    explicit pipeline(std::unique_ptr<pipeline_detail::pipeline_state> state) : state_(std::move(state)) {}
+
+    // Runs every stage to completion; call once
+    pipeline_report run() {
+        std::vector<std::thread> threads;
+        auto start = pipeline_detail::clock::now();
+        for (auto& stage : state_->stages) stage->start(threads);
+        for (std::thread& t : threads) t.join();
+
+        pipeline_report report;
+        report.name = state_->name;
+        report.seconds = pipeline_detail::seconds_between(start, pipeline_detail::clock::now());
+        for (const auto& stage : state_->stages) report.stages.push_back(stage->report());
+        return report;
+    }
+
+private:
+    std::unique_ptr<pipeline_detail::pipeline_state> state_;
+};
+
+// Pipeline under construction whose last stage produces T
+template <typename T>
+class pipeline_builder {
+public:
+    pipeline_builder(std::unique_ptr<pipeline_detail::pipeline_state> state, pipeline_detail::channel<T>* tail)
+        : state_(std::move(state)), tail_(tail) {}
+
+    // fn(T) -> U adds a stage producing U; fn(T) -> std::optional<U> may drop items
+    template <typename Fn>
+    auto then(std::string name, std::size_t threads, Fn fn) && {
+        using result = std::invoke_result_t<Fn&, T&&>;
+        using out_type = typename pipeline_detail::unwrap_optional<result>::type;
+        static_assert(!std::is_void_v<out_type>, "use sink() for the last stage");
+
+        auto out = std::make_shared<pipeline_detail::channel<out_type>>(state_->options.channel_capacity,
+                                                                       state_->options.wait);
+        attach<out_type>(std::move(name), threads, std::move(fn), out.get());
+        state_->channels.push_back(out);
+        return pipeline_builder<out_type>(std::move(state_), out.get());
+    }
+
+    // fn(T) consumes the items; with one thread in ordered mode it sees them in source order
+    template <typename Fn>
+    pipeline sink(std::string name, std::size_t threads, Fn fn) && {
+        attach<void>(std::move(name), threads, std::move(fn), static_cast<pipeline_detail::channel<char>*>(nullptr));
+        return pipeline(std::move(state_));
+    }
+
+private:
+    template <typename Out, typename Fn, typename OutItem>
+    void attach(std::string name, std::size_t threads, Fn fn, pipeline_detail::channel<OutItem>* out) {
+        using stage = pipeline_detail::worker_stage<T, Out, Fn>;
+        auto s = std::make_unique<stage>(std::move(name), threads, std::move(fn), tail_, out, state_->options);
+        tail_->consumers = s->threads();
+        state_->stages.push_back(std::move(s));
+    }
+
+    std::unique_ptr<pipeline_detail::pipeline_state> state_;
+    pipeline_detail::channel<T>* tail_;
+};
+
+// source() returns std::optional<T>; std::nullopt ends the stream
+template <typename Fn>
+auto make_pipeline(std::string name, Fn source, pipeline_options options = {}) {
+    using out_type = typename pipeline_detail::unwrap_optional<std::invoke_result_t<Fn&>>::type;
+    options.batch_size = std::max<std::size_t>(options.batch_size, 1);
+    options.channel_capacity = std::max(options.channel_capacity, options.batch_size);
+
+    auto state = std::make_unique<pipeline_detail::pipeline_state>();
+    state->name = std::move(name);
+    state->options = options;
+    auto out = std::make_shared<pipeline_detail::channel<out_type>>(options.channel_capacity, options.wait);
+    state->stages.push_back(std::make_unique<pipeline_detail::source_stage<out_type, Fn>>(
+        "source", std::move(source), out.get(), options.batch_size));
+    state->channels.push_back(out);
+    return pipeline_builder<out_type>(std::move(state), out.get());
+}
@@ -0,0 +1,354 @@
+#pragma once
+
+// Drop-in std::mutex replacement that measures its own contention.
+//
+// Compile with -DENABLE_MUTEX_PROFILING to turn it on, e.g.
+//   g++ -std=c++20 -O2 -pthread -rdynamic -DENABLE_MUTEX_PROFILING threading_advanced.cpp
+// Without the define profiled_mutex *is* a futex_mutex (the spin-then-park
+// mutex from futex.hpp; it only adds a constructor taking a name) and the
+// report functions print a one-line note, so the demos can use it
+// unconditionally. -rdynamic lets backtrace_symbols()
+// print function names for call sites.
+//
+// What is recorded per mutex:
+//   - acquisitions, and how many of them found the mutex already locked
+//   - a power-of-two histogram of wait times (contended acquisitions only)
+//   - a power-of-two histogram of hold times (lock to unlock)
+//   - the call site that held the mutex longest
+//
+// All statistics are written while the mutex itself is held, so they need no
+// extra synchronization; the writer uses relaxed load+store so a report taken
+// from another thread reads them without tearing. The cost is two
+// steady_clock reads per acquisition (about 20-40 ns) and one more when the
+// mutex is contended.
+//
+// Statistics live in records that are never freed, so a global mutex can be
+// reported from an atexit handler after it has been destroyed. That makes the
+// profiler meant for long-lived mutexes (globals, members of long-lived
+// objects), not for mutexes created in a loop.
+//
+// Usage:
+//   profiled_mutex mtx{"mtx"};
+//   std::lock_guard<profiled_mutex> guard(mtx);    // or unique_lock, scoped_lock
+//   profiled_mutex_report(std::cout);              // any time
+//   profiled_mutex_report_at_exit();               // when the process exits
+//   profiled_mutex_report_on_signal(SIGUSR1);      // kill -USR1 <pid>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+#include "futex.hpp"  // futex_mutex; futex_wait / futex_wake for the signal reporter
+
+#ifdef ENABLE_MUTEX_PROFILING
+#include <thread>
+
+#if defined(__GLIBC__)
+#include <execinfo.h>  // backtrace_symbols()
+#endif
+inline constexpr bool mutex_profiling_enabled = true;
+#else
+inline constexpr bool mutex_profiling_enabled = false;
+#endif
+
+// Bucket i counts durations of [2^(i-1), 2^i) nanoseconds; the last bucket is open-ended
+inline constexpr int mutex_histogram_buckets = 36;
+
+namespace profiled_mutex_detail {
+
+// Short human-readable duration: 850 ns, 12.3 us, 4.56 ms, 1.20 s
+inline std::string format_duration(uint64_t ns) {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(ns < 1000 ? 0 : 2);
+    if (ns < 1000) {
+        text << ns << " ns";
+    } else if (ns < 1000000) {
+        text << static_cast<double>(ns) / 1e3 << " us";
+    } else if (ns < 1000000000) {
+        text << static_cast<double>(ns) / 1e6 << " ms";
+    } else {
+        text << static_cast<double>(ns) / 1e9 << " s";
+    }
+    return text.str();
+}
+
+inline void print_histogram(std::ostream& out, const char* title, const uint64_t (&histogram)[mutex_histogram_buckets]) {
+    out << "    " << title << ":\n";
+    uint64_t largest = *std::max_element(histogram, histogram + mutex_histogram_buckets);
+    for (int b = 0; b < mutex_histogram_buckets; ++b) {
+        if (histogram[b] == 0) continue;
+        uint64_t low = b == 0 ? 0 : uint64_t(1) << (b - 1);
+        std::string high = b == mutex_histogram_buckets - 1 ? std::string("inf")
+                                                            : format_duration((uint64_t(1) << b) - 1);
+        int bar = static_cast<int>(histogram[b] * 40 / largest);
+        out << "      " << std::setw(10) << format_duration(low) << " .. " << std::left << std::setw(10) << high
+            << std::right << std::setw(10) << histogram[b] << " " << std::string(std::max(bar, 1), '#') << "\n";
+    }
+}
+
+}  // namespace profiled_mutex_detail
+
+// --- SECTION 1: Statistics Records ---
+
+// Plain snapshot of one mutex's counters, as returned by profiled_mutex::stats()
+struct mutex_profile {
+    std::string name;
+    uint64_t acquisitions = 0;
+    uint64_t contended = 0;
+    uint64_t total_wait_ns = 0;
+    uint64_t max_wait_ns = 0;
+    uint64_t total_hold_ns = 0;
+    uint64_t max_hold_ns = 0;
+    void* longest_hold_site = nullptr;  // Return address of the lock() call
+    uint64_t wait_histogram[mutex_histogram_buckets] = {};
+    uint64_t hold_histogram[mutex_histogram_buckets] = {};
+    bool destroyed = false;
+
+    double contention_ratio() const {
+        return acquisitions ? static_cast<double>(contended) / static_cast<double>(acquisitions) : 0.0;
+    }
+};
+
+struct mutex_profile_record {
+    const char* name = "mutex";
+    std::atomic<uint64_t> acquisitions{0};
+    std::atomic<uint64_t> contended{0};
+    std::atomic<uint64_t> total_wait_ns{0};
+    std::atomic<uint64_t> max_wait_ns{0};
+    std::atomic<uint64_t> total_hold_ns{0};
+    std::atomic<uint64_t> max_hold_ns{0};
+    std::atomic<void*> longest_hold_site{nullptr};
+    std::atomic<uint64_t> wait_histogram[mutex_histogram_buckets] = {};
+    std::atomic<uint64_t> hold_histogram[mutex_histogram_buckets] = {};
+    std::atomic<bool> destroyed{false};
+    mutex_profile_record* next = nullptr;
+
+    // Only called by the thread holding the mutex
+    static void bump(std::atomic<uint64_t>& counter, uint64_t amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+    static void raise(std::atomic<uint64_t>& maximum, uint64_t value) {
+        if (value > maximum.load(std::memory_order_relaxed)) maximum.store(value, std::memory_order_relaxed);
+    }
+    static int bucket_of(uint64_t ns) { return std::min<int>(std::bit_width(ns), mutex_histogram_buckets - 1); }
+
+    void on_acquire(bool was_contended, uint64_t wait_ns) {
+        bump(acquisitions, 1);
+        if (!was_contended) return;
+        bump(contended, 1);
+        bump(total_wait_ns, wait_ns);
+        raise(max_wait_ns, wait_ns);
+        bump(wait_histogram[bucket_of(wait_ns)], 1);
+    }
+
+    void on_release(uint64_t hold_ns, void* site) {
+        bump(total_hold_ns, hold_ns);
+        bump(hold_histogram[bucket_of(hold_ns)], 1);
+        if (hold_ns > max_hold_ns.load(std::memory_order_relaxed)) {
+            max_hold_ns.store(hold_ns, std::memory_order_relaxed);
+            longest_hold_site.store(site, std::memory_order_relaxed);
+        }
+    }
+
+    mutex_profile snapshot() const {
+        mutex_profile profile;
+        profile.name = name;
+        profile.acquisitions = acquisitions.load(std::memory_order_relaxed);
+        profile.contended = contended.load(std::memory_order_relaxed);
+        profile.total_wait_ns = total_wait_ns.load(std::memory_order_relaxed);
+        profile.max_wait_ns = max_wait_ns.load(std::memory_order_relaxed);
+        profile.total_hold_ns = total_hold_ns.load(std::memory_order_relaxed);
+        profile.max_hold_ns = max_hold_ns.load(std::memory_order_relaxed);
+        profile.longest_hold_site = longest_hold_site.load(std::memory_order_relaxed);
+        for (int b = 0; b < mutex_histogram_buckets; ++b) {
+            profile.wait_histogram[b] = wait_histogram[b].load(std::memory_order_relaxed);
+            profile.hold_histogram[b] = hold_histogram[b].load(std::memory_order_relaxed);
+        }
+        profile.destroyed = destroyed.load(std::memory_order_relaxed);
+        return profile;
+    }
+};
+
+// Every record ever created, newest first (a lock-free list that only grows)
+inline std::atomic<mutex_profile_record*>& mutex_profile_records() {
+    static std::atomic<mutex_profile_record*> head{nullptr};  // Constant-initialized
+    return head;
+}
+
+inline mutex_profile_record* mutex_profile_register(const char* name) {
+    auto* record = new mutex_profile_record();
+    record->name = name;
+    auto& head = mutex_profile_records();
+    mutex_profile_record* first = head.load(std::memory_order_relaxed);
+    do {
+        record->next = first;
+    } while (!head.compare_exchange_weak(first, record, std::memory_order_release, std::memory_order_relaxed));
+    return record;
+}
+
+// --- SECTION 2: The Mutex ---
+
+#ifdef ENABLE_MUTEX_PROFILING
+
+class profiled_mutex {
+public:
+    using clock = std::chrono::steady_clock;
+
+    // The name appears in reports; it must outlive the process (a string literal)
+    explicit profiled_mutex(const char* name = "mutex") : record_(mutex_profile_register(name)) {}
+    ~profiled_mutex() { record_->destroyed.store(true, std::memory_order_relaxed); }
+
+    profiled_mutex(const profiled_mutex&) = delete;
+    profiled_mutex& operator=(const profiled_mutex&) = delete;
+
+    // Kept out of line so the return address is the caller's call site (with
+    // lock_guard / unique_lock inlined, the function that took the lock)
+    [[gnu::noinline]] void lock() {
+        void* site = __builtin_return_address(0);
+        bool contended = !mutex_.try_lock();
+        uint64_t wait_ns = 0;
+        if (contended) {
+            clock::time_point start = clock::now();
+            mutex_.lock();
+            wait_ns = nanoseconds_since(start);
+        }
+        acquired(site, contended, wait_ns);
+    }
+
+    [[gnu::noinline]] bool try_lock() {
+        void* site = __builtin_return_address(0);
+        if (!mutex_.try_lock()) return false;
+        acquired(site, false, 0);
+        return true;
+    }
+
+    void unlock() {
+        record_->on_release(nanoseconds_since(acquired_at_), holder_site_);
+        mutex_.unlock();
+    }
+
+    mutex_profile stats() const { return record_->snapshot(); }
+
+private:
+    static uint64_t nanoseconds_since(clock::time_point start) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count());
+    }
+
+    // Runs with the mutex held, so holder_site_ and acquired_at_ need no atomics
+    void acquired(void* site, bool contended, uint64_t wait_ns) {
+        record_->on_acquire(contended, wait_ns);
+        holder_site_ = site;
+        acquired_at_ = clock::now();
+    }
+
+    futex_mutex mutex_;
+    mutex_profile_record* record_;
+    void* holder_site_ = nullptr;
+    clock::time_point acquired_at_{};
+};
+
+#else
+
+// Profiling disabled: exactly a futex_mutex, with a constructor that ignores the name
+class profiled_mutex : public futex_mutex {
+public:
+    constexpr explicit profiled_mutex(const char* = "mutex") noexcept {}
+
+    mutex_profile stats() const { return {}; }
+};
+
+#endif  // ENABLE_MUTEX_PROFILING
+
+// --- SECTION 3: Reports ---
+
+// Best-effort symbol for a code address ("binary(function+0x1c) [0x...]")
+inline std::string mutex_profile_symbolize(void* address) {
+    if (!address) return "unknown";
+#if defined(ENABLE_MUTEX_PROFILING) && defined(__GLIBC__)
+    if (char** symbols = backtrace_symbols(&address, 1)) {
+        std::string text = symbols[0];
+        std::free(symbols);
+        return text;
+    }
+#endif
+    std::ostringstream text;
+    text << address;
+    return text.str();
+}
+
+inline void profiled_mutex_report(std::ostream& out, bool include_idle = false) {
+    if (!mutex_profiling_enabled) {
+        out << "Mutex profiling is disabled (compile with -DENABLE_MUTEX_PROFILING)\n";
+        return;
+    }
+    using profiled_mutex_detail::format_duration;
+    out << "--- Mutex contention report ---\n";
+    for (mutex_profile_record* r = mutex_profile_records().load(std::memory_order_acquire); r; r = r->next) {
+        mutex_profile p = r->snapshot();
+        if (p.acquisitions == 0 && !include_idle) continue;
+        out << p.name << (p.destroyed ? " (destroyed)" : "") << ": " << p.acquisitions << " acquisitions, "
+            << p.contended << " contended (" << std::fixed << std::setprecision(1) << p.contention_ratio() * 100.0
+            << "%)" << std::defaultfloat << std::setprecision(6) << "\n"
+            << "  wait: " << format_duration(p.total_wait_ns) << " total, " << format_duration(p.max_wait_ns)
+            << " max\n"
+            << "  hold: " << format_duration(p.total_hold_ns) << " total, " << format_duration(p.max_hold_ns)
+            << " max, longest at " << mutex_profile_symbolize(p.longest_hold_site) << "\n";
+        if (p.contended) profiled_mutex_detail::print_histogram(out, "wait time (contended only)", p.wait_histogram);
+        if (p.acquisitions) profiled_mutex_detail::print_histogram(out, "hold time", p.hold_histogram);
+    }
+}
+
+// Print the report from an atexit handler (once, however often this is called)
+inline void profiled_mutex_report_at_exit(std::ostream& out = std::cerr) {
+    static std::ostream* target = nullptr;
+    static std::once_flag registered;
+    target = &out;
+    std::call_once(registered, [] { std::atexit([] { profiled_mutex_report(*target); }); });
+}
+
+// Print the report whenever the process receives `signal_number`. The handler
+// itself only bumps a futex word (async-signal-safe); a background thread that
+// sleeps on that word does the formatting and I/O.
+inline void profiled_mutex_report_on_signal(int signal_number = SIGUSR1, std::ostream& out = std::cerr) {
+#ifdef ENABLE_MUTEX_PROFILING
+    static std::atomic<uint32_t> requests{0};
+    static std::ostream* target = nullptr;
+    static std::once_flag started;
+    target = &out;
+    std::call_once(started, [] {
+        std::thread([] {
+            uint32_t seen = requests.load(std::memory_order_acquire);
+            for (;;) {
+                futex_wait(requests, seen);
+                uint32_t now = requests.load(std::memory_order_acquire);
+                if (now == seen) continue;  // Spurious wake-up
+                seen = now;
+                profiled_mutex_report(*target);
+                target->flush();
+            }
+        }).detach();
+    });
+
+    struct sigaction action {};
+    action.sa_handler = [](int) {
+        requests.fetch_add(1, std::memory_order_release);
+        futex_wake(requests);
+    };
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(signal_number, &action, nullptr);
+#else
+    (void)signal_number;
+    (void)out;
+#endif
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+// Sequence lock for small, read-mostly, trivially copyable state.
+//
+// A reader-writer lock still makes every reader write the lock word, so the
+// readers of one rwlock keep stealing its cache line from each other. A seqlock
+// readers never write anything shared:
+//
+//   writer: sequence -> odd, write the data, sequence -> even
+//   reader: read sequence, copy the data, read sequence again; if it was odd
+//           or has changed, a writer interfered and the copy is retried
+//
+// Reads are wait-free with no writer, and scale with the number of cores. A
+// steady stream of writers can starve readers, so this is only for state that
+// is read far more often than it is written. Writers are serialized by a
+// spinlock on the sequence word itself (an odd value means "locked").
+//
+// The data is kept as an array of 64-bit atomic words and copied with relaxed
+// atomic loads and stores, so a reader racing a writer reads torn but
+// well-defined values (which it then throws away) instead of causing a data race.
+//
+// Usage:
+//   struct position { double x, y, z; };
+//   seqlock<position> current;
+//   current.store({1, 2, 3});            // writer
+//   position p = current.load();         // any number of readers
+//   current.update([](position& p) { p.x += 1; });  // read-modify-write
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+#include "futex.hpp"  // cpu_relax, cache_line_size
+
+template <typename T>
+class seqlock {
+    static_assert(std::is_trivially_copyable_v<T>, "seqlock copies T byte-wise");
+    static_assert(std::is_default_constructible_v<T>, "load() returns a T built from the copied bytes");
+
+public:
+    seqlock() : seqlock(T{}) {}
+    explicit seqlock(const T& initial) { write_words(initial); }
+
+    seqlock(const seqlock&) = delete;
+    seqlock& operator=(const seqlock&) = delete;
+
+    // A consistent copy of the value, retrying while a write is in progress
+    T load() const noexcept {
+        T value;
+        for (std::size_t spin = 0; !try_load(value); ++spin) {
+            backoff(spin);
+        }
+        return value;
+    }
+
+    // One attempt; false if a writer was active (value is then unspecified)
+    bool try_load(T& value) const noexcept {
+        uint64_t before = sequence_.load(std::memory_order_acquire);
+        if (before & 1) return false;
+        uint64_t words[word_count];
+        for (std::size_t i = 0; i < word_count; ++i) {
+            words[i] = words_[i].load(std::memory_order_relaxed);
+        }
+        // Keeps the data loads above from moving below the second sequence read
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence_.load(std::memory_order_relaxed) != before) return false;
+        std::memcpy(&value, words, sizeof(T));
+        return true;
+    }
+
+    void store(const T& value) noexcept {
+        uint64_t sequence = lock_writer();
+        write_words(value);
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    // Read-modify-write under the writer lock: fn(T&) edits a private copy
+    // that is then published as one update
+    template <typename Fn>
+    void update(Fn&& fn) {
+        uint64_t sequence = lock_writer();
+        T value = read_words();  // No other writer can be active
+        fn(value);
+        write_words(value);
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    // Number of completed writes so far
+    uint64_t version() const noexcept { return sequence_.load(std::memory_order_acquire) / 2; }
+
+private:
+    static constexpr std::size_t word_count = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    static void backoff(std::size_t spin) {
+        if (spin < default_spin_iterations()) {
+            cpu_relax();
+        } else {
+            std::this_thread::yield();  // The writer may need our CPU to finish
+        }
+    }
+
+    // Make the sequence odd, waiting for any other writer to finish first.
+    // Returns the (even) value it had before.
+    uint64_t lock_writer() noexcept {
+        uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+        for (std::size_t spin = 0;; ++spin) {
+            // Acquire pairs with the previous writer's release of the sequence, so
+            // update()'s read of the data sees everything that writer stored
+            if (!(sequence & 1) && sequence_.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire,
+                                                                   std::memory_order_relaxed)) {
+                break;
+            }
+            backoff(spin);
+            sequence = sequence_.load(std::memory_order_relaxed);
+        }
+        // Readers that see any of the new data must also see the odd sequence
+        std::atomic_thread_fence(std::memory_order_release);
+        return sequence;
+    }
+
+    void write_words(const T& value) noexcept {
+        uint64_t words[word_count] = {};
+        std::memcpy(words, &value, sizeof(T));
+        for (std::size_t i = 0; i < word_count; ++i) {
+            words_[i].store(words[i], std::memory_order_relaxed);
+        }
+    }
+
+    T read_words() const noexcept {
+        uint64_t words[word_count];
+        for (std::size_t i = 0; i < word_count; ++i) {
+            words[i] = words_[i].load(std::memory_order_relaxed);
+        }
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+    alignas(cache_line_size) std::atomic<uint64_t> sequence_{0};
+    std::atomic<uint64_t> words_[word_count];
+};
@@ -0,0 +1,235 @@
+#pragma once
+
+// Contention-free counters for statistics and metrics.
+//
+// A single std::atomic<int> incremented by every thread puts one cache line in
+// the middle of all of them: each increment has to pull the line over in
+// exclusive state, so throughput drops as cores are added. These counters
+// split the value into shards on separate cache lines. Writers touch only
+// their own shard; read() adds the shards up (a consistent total once the
+// writers are done, a close-enough snapshot while they run).
+//
+//   sharded_counter  - shard chosen per thread (round-robin at first use);
+//                      relaxed fetch_add, which is uncontended in practice
+//   percpu_counter   - shard chosen by the CPU the thread runs on. On
+//                      x86-64 Linux with glibc's restartable sequences
+//                      (rseq) the increment is a plain, non-atomic add that
+//                      the kernel restarts if the thread is preempted or
+//                      migrated. Otherwise it falls back to sched_getcpu()
+//                      plus a relaxed fetch_add.
+//
+// Usage:
+//   sharded_counter requests;
+//   requests.increment();            // any thread, any time
+//   int64_t total = requests.read(); // sum of all shards
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "futex.hpp"  // cache_line_size
+
+#if defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(__x86_64__) && defined(__GLIBC__) && __has_include(<sys/rseq.h>)
+#include <sys/rseq.h>
+#if defined(RSEQ_SIG)
+#define SHARDED_COUNTER_HAVE_RSEQ 1
+#endif
+#endif
+
+namespace counter_detail {
+
+struct alignas(cache_line_size) shard {
+    std::atomic<int64_t> value{0};
+};
+
+inline std::size_t round_up_pow2(std::size_t n) {
+    std::size_t result = 1;
+    while (result < n) result <<= 1;
+    return result;
+}
+
+inline std::size_t configured_cpus() {
+#if defined(__linux__)
+    long configured = sysconf(_SC_NPROCESSORS_CONF);
+    if (configured > 0) return static_cast<std::size_t>(configured);
+#endif
+    unsigned online = std::thread::hardware_concurrency();
+    return online ? online : 1;
+}
+
+inline int64_t sum(const shard* shards, std::size_t count) {
+    int64_t total = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        total += shards[i].value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+inline void clear(shard* shards, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        shards[i].value.store(0, std::memory_order_relaxed);
+    }
+}
+
+#if defined(SHARDED_COUNTER_HAVE_RSEQ)
+
+// This thread's rseq area, registered by glibc at thread start (size 0 if
+// registration was disabled, e.g. with GLIBC_TUNABLES=glibc.pthread.rseq=0)
+inline bool rseq_available() noexcept { return __rseq_size > 0; }
+
+inline struct rseq* rseq_area() noexcept {
+    return reinterpret_cast<struct rseq*>(static_cast<char*>(__builtin_thread_pointer()) + __rseq_offset);
+}
+
+// *target += amount, as a restartable sequence pinned to `cpu`. The kernel
+// checks, whenever it preempts, migrates or signals the thread, whether the
+// instruction pointer is inside [start, commit); if so it resumes at the
+// abort label instead. Returns false if aborted or no longer on `cpu`.
+//
+// Layout (after librseq): a struct rseq_cs descriptor in the __rseq_cs
+// section, a store of its address into rseq->rseq_cs to arm the sequence,
+// the cpu_id check, and the single committing instruction. The abort
+// handler must be preceded by RSEQ_SIG so the kernel can verify it.
+inline bool rseq_add(int64_t* target, int64_t amount, int cpu) noexcept {
+    asm volatile goto(
+        ".pushsection __rseq_cs, \"aw\"\n\t"
+        ".balign 32\n\t"
+        "3:\n\t"
+        ".long 0x0, 0x0\n\t"               // version, flags
+        ".quad 1f, (2f - 1f), 4f\n\t"      // start_ip, post_commit_offset, abort_ip
+        ".popsection\n\t"
+        "leaq 3b(%%rip), %%rax\n\t"
+        "movq %%rax, %%fs:8(%[rseq_offset])\n\t"  // rseq->rseq_cs = &descriptor
+        "1:\n\t"
+        "cmpl %[cpu], %%fs:4(%[rseq_offset])\n\t"  // rseq->cpu_id == cpu ?
+        "jnz 4f\n\t"
+        "addq %[amount], %[target]\n\t"    // Commit: one plain add, no lock prefix
+        "2:\n\t"
+        ".pushsection __rseq_failure, \"ax\"\n\t"
+        ".byte 0x0f, 0xb9, 0x3d\n\t"       // ud1 prefix, so the signature disassembles cleanly
+        ".long %c[signature]\n\t"
+        "4:\n\t"
+        "jmp %l[aborted]\n\t"
+        ".popsection\n\t"
+        :
+        : [cpu] "r"(cpu), [rseq_offset] "r"(__rseq_offset), [target] "m"(*target), [amount] "er"(amount),
+          [signature] "i"(RSEQ_SIG)
+        : "memory", "cc", "rax"
+        : aborted);
+    return true;
+aborted:
+    return false;
+}
+
+#else
+
+inline bool rseq_available() noexcept { return false; }
+
+#endif
+
+}  // namespace counter_detail
+
+// --- SECTION 1: Per-Thread Sharded Counter ---
+
+class sharded_counter {
+public:
+    // Default: one shard per hardware thread (rounded up to a power of two)
+    explicit sharded_counter(std::size_t shards = 0)
+        : count_(counter_detail::round_up_pow2(shards ? shards : counter_detail::configured_cpus())),
+          shards_(new counter_detail::shard[count_]) {}
+
+    void add(int64_t amount) noexcept {
+        shards_[thread_slot() & (count_ - 1)].value.fetch_add(amount, std::memory_order_relaxed);
+    }
+    void increment() noexcept { add(1); }
+    sharded_counter& operator++() noexcept {
+        add(1);
+        return *this;
+    }
+    sharded_counter& operator+=(int64_t amount) noexcept {
+        add(amount);
+        return *this;
+    }
+
+    int64_t read() const noexcept { return counter_detail::sum(shards_.get(), count_); }
+    void reset() noexcept { counter_detail::clear(shards_.get(), count_); }
+    std::size_t shard_count() const noexcept { return count_; }
+
+private:
+    // Threads are numbered in the order they first touch any sharded_counter,
+    // so the first N threads always land on N different shards
+    static std::size_t thread_slot() noexcept {
+        static std::atomic<std::size_t> next_slot{0};
+        static thread_local const std::size_t slot = next_slot.fetch_add(1, std::memory_order_relaxed);
+        return slot;
+    }
+
+    std::size_t count_;
+    std::unique_ptr<counter_detail::shard[]> shards_;
+};
+
+// --- SECTION 2: Per-CPU Counter (rseq when available) ---
+
+class percpu_counter {
+public:
+    // One shard per configured CPU plus an overflow shard (see add())
+    percpu_counter()
+        : count_(counter_detail::configured_cpus()), shards_(new counter_detail::shard[count_ + 1]) {}
+
+    void add(int64_t amount) noexcept {
+#if defined(SHARDED_COUNTER_HAVE_RSEQ)
+        if (counter_detail::rseq_available()) {
+            for (;;) {
+                int cpu = static_cast<int>(
+                    reinterpret_cast<volatile uint32_t&>(counter_detail::rseq_area()->cpu_id));
+                if (static_cast<std::size_t>(cpu) >= count_) break;  // Hot-plugged CPU
+                // The shard is only ever written by code running on its CPU, inside a
+                // restartable sequence, so no lock prefix is needed
+                auto* target = reinterpret_cast<int64_t*>(&shards_[cpu].value);
+                if (counter_detail::rseq_add(target, amount, cpu)) return;
+            }
+            // Never mix atomic and rseq updates on one shard: the overflow shard is
+            // only updated with fetch_add
+            shards_[count_].value.fetch_add(amount, std::memory_order_relaxed);
+            return;
+        }
+#endif
+        shards_[current_cpu() % count_].value.fetch_add(amount, std::memory_order_relaxed);
+    }
+    void increment() noexcept { add(1); }
+    percpu_counter& operator++() noexcept {
+        add(1);
+        return *this;
+    }
+    percpu_counter& operator+=(int64_t amount) noexcept {
+        add(amount);
+        return *this;
+    }
+
+    int64_t read() const noexcept { return counter_detail::sum(shards_.get(), count_ + 1); }
+    void reset() noexcept { counter_detail::clear(shards_.get(), count_ + 1); }
+    std::size_t shard_count() const noexcept { return count_; }
+
+    // True when increments take the rseq fast path in this process
+    static bool uses_rseq() noexcept { return counter_detail::rseq_available(); }
+
+private:
+    static std::size_t current_cpu() noexcept {
+#if defined(__linux__)
+        int cpu = sched_getcpu();
+        return cpu >= 0 ? static_cast<std::size_t>(cpu) : 0;
+#else
+        return 0;
+#endif
+    }
+
+    std::size_t count_;
+    std::unique_ptr<counter_detail::shard[]> shards_;
+};
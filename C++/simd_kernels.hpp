@@ -0,0 +1,841 @@
+#pragma once
+
+// Vectorized kernels with runtime instruction-set dispatch.
+//
+// Every kernel exists in a scalar, SSE2, AVX2 and AVX-512 flavour. The AVX2 and
+// AVX-512 versions are compiled with __attribute__((target(...))), so the program
+// itself can be built without -mavx2 and still run on any x86-64 CPU: the best
+// version is picked once at startup from cpuid (see detect_isa()).
+//
+// Kernels:
+//   simd_sum         - sum of int32 values, accumulated in 64 bits (no overflow)
+//   simd_dot         - float dot product
+//   simd_axpy        - y[i] += a * x[i]
+//   simd_min_max     - minimum and maximum of int32 values
+//   simd_count_if    - number of int32 values that compare <, == or > a value
+//   simd_prefix_sum  - inclusive prefix sum of int32 values (wraps like unsigned)
+//   simd_histogram   - 256-bin histogram of bytes
+//   simd_find_byte   - index of the first occurrence of a byte (memchr)
+//   simd_byte_mask   - bitmap of every position holding a byte (bit i = data[i] matches)
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SIMD_KERNELS_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+// Instruction set levels, ordered from least to most capable
+enum class isa_level { scalar = 0, sse2 = 1, avx2 = 2, avx512 = 3 };
+
+inline const char* isa_name(isa_level isa) {
+    switch (isa) {
+        case isa_level::scalar: return "scalar";
+        case isa_level::sse2:   return "sse2";
+        case isa_level::avx2:   return "avx2";
+        case isa_level::avx512: return "avx512";
+    }
+    return "unknown";
+}
+
+enum class compare_op { less, equal, greater };
+
+struct minmax_result {
+    int32_t min;
+    int32_t max;
+};
+
+// --- SECTION 1: CPU Feature Detection ---
+
+struct cpu_features {
+    bool sse2 = false;
+    bool sse42 = false;  // Includes the crc32 instruction (CRC32C)
+    bool avx2 = false;
+    bool fma = false;
+    bool avx512f = false;
+    bool avx512cd = false;
+    bool avx512vpopcntdq = false;
+    bool avx512bw = false;
+};
+
+// Query cpuid directly. AVX registers are only usable if the OS saves them on a
+// context switch, which is reported through XGETBV, so check that as well.
+inline cpu_features detect_cpu_features() {
+    cpu_features features;
+#ifdef SIMD_KERNELS_X86
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return features;
+    }
+    features.sse2 = (edx & bit_SSE2) != 0;
+    features.sse42 = (ecx & bit_SSE4_2) != 0;
+    bool osxsave = (ecx & bit_OSXSAVE) != 0;
+    bool fma = (ecx & bit_FMA) != 0;
+
+    uint64_t xcr0 = 0;
+    if (osxsave) {
+        unsigned lo = 0, hi = 0;
+        asm volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+        xcr0 = (static_cast<uint64_t>(hi) << 32) | lo;
+    }
+    bool os_avx = (xcr0 & 0x6) == 0x6;        // XMM and YMM state
+    bool os_avx512 = (xcr0 & 0xE6) == 0xE6;   // plus opmask and ZMM state
+
+    if (__get_cpuid_max(0, nullptr) >= 7) {
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        features.avx2 = os_avx && (ebx & bit_AVX2) != 0;
+        features.fma = os_avx && fma;
+        features.avx512f = os_avx512 && (ebx & bit_AVX512F) != 0;
+        features.avx512cd = os_avx512 && (ebx & bit_AVX512CD) != 0;
+        features.avx512vpopcntdq = os_avx512 && (ecx & bit_AVX512VPOPCNTDQ) != 0;
+        features.avx512bw = os_avx512 && (ebx & bit_AVX512BW) != 0;
+    }
+#endif
+    return features;
+}
+
+// Highest level supported by this CPU. The SIMD_KERNELS_ISA environment variable
+// (scalar, sse2, avx2, avx512) can lower it, which is handy for comparing tiers.
+inline isa_level detect_isa() {
+    cpu_features f = detect_cpu_features();
+    isa_level best = isa_level::scalar;
+    if (f.sse2) best = isa_level::sse2;
+    if (f.avx2 && f.fma) best = isa_level::avx2;
+    if (f.avx512f && f.avx2 && f.fma) best = isa_level::avx512;
+
+    if (const char* requested = std::getenv("SIMD_KERNELS_ISA")) {
+        for (isa_level level : {isa_level::scalar, isa_level::sse2, isa_level::avx2, isa_level::avx512}) {
+            if (std::string(requested) == isa_name(level) && level < best) {
+                best = level;
+            }
+        }
+    }
+    return best;
+}
+
+// --- SECTION 2: Scalar Kernels (reference implementations) ---
+
+namespace simd_scalar {
+
+inline int64_t sum(const int32_t* data, std::size_t n) {
+    int64_t total = 0;
+    for (std::size_t i = 0; i < n; ++i) total += data[i];
+    return total;
+}
+
+inline float dot(const float* a, const float* b, std::size_t n) {
+    float total = 0.0f;
+    for (std::size_t i = 0; i < n; ++i) total += a[i] * b[i];
+    return total;
+}
+
+inline void axpy(float a, const float* x, float* y, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) y[i] += a * x[i];
+}
+
+inline minmax_result min_max(const int32_t* data, std::size_t n) {
+    minmax_result r{std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::min()};
+    for (std::size_t i = 0; i < n; ++i) {
+        if (data[i] < r.min) r.min = data[i];
+        if (data[i] > r.max) r.max = data[i];
+    }
+    return r;
+}
+
+inline bool compare(int32_t lhs, compare_op op, int32_t rhs) {
+    switch (op) {
+        case compare_op::less:    return lhs < rhs;
+        case compare_op::equal:   return lhs == rhs;
+        case compare_op::greater: return lhs > rhs;
+    }
+    return false;
+}
+
+inline std::size_t count_if(const int32_t* data, std::size_t n, compare_op op, int32_t value) {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < n; ++i) count += compare(data[i], op, value) ? 1 : 0;
+    return count;
+}
+
+// Unsigned arithmetic keeps wrap-around well defined
+inline void prefix_sum(const int32_t* in, int32_t* out, std::size_t n) {
+    uint32_t running = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        running += static_cast<uint32_t>(in[i]);
+        out[i] = static_cast<int32_t>(running);
+    }
+}
+
+inline void histogram(const uint8_t* data, std::size_t n, uint32_t* counts) {
+    std::memset(counts, 0, 256 * sizeof(uint32_t));
+    for (std::size_t i = 0; i < n; ++i) counts[data[i]]++;
+}
+
+inline std::size_t find_byte(const uint8_t* data, std::size_t n, uint8_t value) {
+    for (std::size_t i = 0; i < n; ++i) {
+        if (data[i] == value) return i;
+    }
+    return n;
+}
+
+inline void byte_mask(const uint8_t* data, std::size_t n, uint8_t value, uint64_t* bits) {
+    std::memset(bits, 0, (n + 63) / 64 * sizeof(uint64_t));
+    for (std::size_t i = 0; i < n; ++i) {
+        bits[i / 64] |= static_cast<uint64_t>(data[i] == value) << (i % 64);
+    }
+}
+
+}  // namespace simd_scalar
+
+#ifdef SIMD_KERNELS_X86
+
+// --- SECTION 3: SSE2 Kernels (baseline for every x86-64 CPU) ---
+
+namespace simd_sse2 {
+
+// SSE2 has no 32->64 bit sign extension, so interleave each value with its sign
+inline int64_t sum(const int32_t* data, std::size_t n) {
+    __m128i acc = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i sign = _mm_srai_epi32(v, 31);
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, sign));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(v, sign));
+    }
+    alignas(16) int64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    int64_t total = lanes[0] + lanes[1];
+    for (; i < n; ++i) total += data[i];
+    return total;
+}
+
+// Two independent accumulators hide the latency of the add
+inline float dot(const float* a, const float* b, std::size_t n) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, _mm_add_ps(acc0, acc1));
+    float total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < n; ++i) total += a[i] * b[i];
+    return total;
+}
+
+inline void axpy(float a, const float* x, float* y, std::size_t n) {
+    __m128 va = _mm_set1_ps(a);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 vy = _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(va, _mm_loadu_ps(x + i)));
+        _mm_storeu_ps(y + i, vy);
+    }
+    for (; i < n; ++i) y[i] += a * x[i];
+}
+
+// SSE2 has no 32-bit min/max, so select with compare masks
+inline __m128i select(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+inline minmax_result min_max(const int32_t* data, std::size_t n) {
+    minmax_result r{std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::min()};
+    std::size_t i = 0;
+    if (n >= 4) {
+        __m128i vmin = _mm_set1_epi32(r.min);
+        __m128i vmax = _mm_set1_epi32(r.max);
+        for (; i + 4 <= n; i += 4) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            vmin = select(_mm_cmplt_epi32(v, vmin), v, vmin);
+            vmax = select(_mm_cmpgt_epi32(v, vmax), v, vmax);
+        }
+        alignas(16) int32_t mins[4], maxs[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(mins), vmin);
+        _mm_store_si128(reinterpret_cast<__m128i*>(maxs), vmax);
+        for (int lane = 0; lane < 4; ++lane) {
+            if (mins[lane] < r.min) r.min = mins[lane];
+            if (maxs[lane] > r.max) r.max = maxs[lane];
+        }
+    }
+    for (; i < n; ++i) {
+        if (data[i] < r.min) r.min = data[i];
+        if (data[i] > r.max) r.max = data[i];
+    }
+    return r;
+}
+
+inline __m128i compare(__m128i v, compare_op op, __m128i value) {
+    switch (op) {
+        case compare_op::less:    return _mm_cmplt_epi32(v, value);
+        case compare_op::equal:   return _mm_cmpeq_epi32(v, value);
+        case compare_op::greater: return _mm_cmpgt_epi32(v, value);
+    }
+    return _mm_setzero_si128();
+}
+
+// Matching lanes are all ones (-1), so subtracting the mask counts them
+inline std::size_t count_if(const int32_t* data, std::size_t n, compare_op op, int32_t value) {
+    __m128i vvalue = _mm_set1_epi32(value);
+    std::size_t count = 0;
+    std::size_t i = 0;
+    while (i + 4 <= n) {
+        // Flush the 32-bit lane counters before they could overflow
+        std::size_t block_end = n - i > (std::size_t(1) << 32) ? i + (std::size_t(1) << 32) : n;
+        __m128i counts = _mm_setzero_si128();
+        for (; i + 4 <= block_end; i += 4) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            counts = _mm_sub_epi32(counts, compare(v, op, vvalue));
+        }
+        alignas(16) uint32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), counts);
+        count += std::size_t(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+    }
+    for (; i < n; ++i) count += simd_scalar::compare(data[i], op, value) ? 1 : 0;
+    return count;
+}
+
+// In-register scan: add the vector shifted by one and then two lanes
+inline void prefix_sum(const int32_t* in, int32_t* out, std::size_t n) {
+    __m128i running = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+        v = _mm_add_epi32(v, running);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), v);
+        running = _mm_shuffle_epi32(v, 0xFF);  // Broadcast the last lane
+    }
+    uint32_t carry = static_cast<uint32_t>(_mm_cvtsi128_si32(running));
+    for (; i < n; ++i) {
+        carry += static_cast<uint32_t>(in[i]);
+        out[i] = static_cast<int32_t>(carry);
+    }
+}
+
+// A histogram is a scatter, which SSE2 cannot do. The usual trick is to spread
+// consecutive bytes over several sub-tables so that increments of the same bin do
+// not wait on each other, and to read the input 8 bytes at a time.
+inline void histogram(const uint8_t* data, std::size_t n, uint32_t* counts) {
+    uint32_t tables[4][256] = {};
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        tables[0][word & 0xFF]++;
+        tables[1][(word >> 8) & 0xFF]++;
+        tables[2][(word >> 16) & 0xFF]++;
+        tables[3][(word >> 24) & 0xFF]++;
+        tables[0][(word >> 32) & 0xFF]++;
+        tables[1][(word >> 40) & 0xFF]++;
+        tables[2][(word >> 48) & 0xFF]++;
+        tables[3][word >> 56]++;
+    }
+    for (; i < n; ++i) tables[0][data[i]]++;
+    for (int bin = 0; bin < 256; ++bin) {
+        counts[bin] = tables[0][bin] + tables[1][bin] + tables[2][bin] + tables[3][bin];
+    }
+}
+
+// Compare 16 bytes at a time and turn the result into a bit mask; the first
+// set bit is the match. The main loop ORs four compares so the common "no
+// match in these 64 bytes" case costs a single movemask and branch. Loads
+// never run past data + n, which may be the last byte of a mapping.
+inline std::size_t find_byte(const uint8_t* data, std::size_t n, uint8_t value) {
+    const __m128i needle = _mm_set1_epi8(static_cast<char>(value));
+    std::size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m128i c0 = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), needle);
+        __m128i c1 = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 16)), needle);
+        __m128i c2 = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 32)), needle);
+        __m128i c3 = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 48)), needle);
+        if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(c0, c1), _mm_or_si128(c2, c3))) != 0) {
+            uint64_t mask = static_cast<uint64_t>(_mm_movemask_epi8(c0)) |
+                            static_cast<uint64_t>(_mm_movemask_epi8(c1)) << 16 |
+                            static_cast<uint64_t>(_mm_movemask_epi8(c2)) << 32 |
+                            static_cast<uint64_t>(_mm_movemask_epi8(c3)) << 48;
+            return i + static_cast<std::size_t>(__builtin_ctzll(mask));
+        }
+    }
+    for (; i + 16 <= n; i += 16) {
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), needle));
+        if (mask != 0) return i + static_cast<std::size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+    }
+    for (; i < n; ++i) {
+        if (data[i] == value) return i;
+    }
+    return n;
+}
+
+// The same compares as find_byte, but every 64-byte block's matches are stored
+// as one word instead of stopping at the first. Callers then walk the matches
+// with count-trailing-zeros, which costs no call and no loop per match.
+inline void byte_mask(const uint8_t* data, std::size_t n, uint8_t value, uint64_t* bits) {
+    const __m128i needle = _mm_set1_epi8(static_cast<char>(value));
+    std::size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        auto mask16 = [&](std::size_t offset) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + offset));
+            return static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle))));
+        };
+        bits[i / 64] = mask16(0) | mask16(16) << 16 | mask16(32) << 32 | mask16(48) << 48;
+    }
+    if (i < n) simd_scalar::byte_mask(data + i, n - i, value, bits + i / 64);
+}
+
+}  // namespace simd_sse2
+
+// --- SECTION 4: AVX2 Kernels ---
+
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma,popcnt")))
+
+namespace simd_avx2 {
+
+SIMD_TARGET_AVX2 inline int64_t sum(const int32_t* data, std::size_t n) {
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        acc0 = _mm256_add_epi64(acc0, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        acc1 = _mm256_add_epi64(acc1, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+    alignas(32) int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(acc0, acc1));
+    int64_t total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < n; ++i) total += data[i];
+    return total;
+}
+
+SIMD_TARGET_AVX2 inline float dot(const float* a, const float* b, std::size_t n) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps();
+    __m256 acc3 = _mm256_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+        acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16), acc2);
+        acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24), acc3);
+    }
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    }
+    __m256 acc = _mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3));
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+    float total = _mm_cvtss_f32(half);
+    for (; i < n; ++i) total += a[i] * b[i];
+    return total;
+}
+
+SIMD_TARGET_AVX2 inline void axpy(float a, const float* x, float* y, std::size_t n) {
+    __m256 va = _mm256_set1_ps(a);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(y + i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+    }
+    for (; i < n; ++i) y[i] += a * x[i];
+}
+
+SIMD_TARGET_AVX2 inline minmax_result min_max(const int32_t* data, std::size_t n) {
+    minmax_result r{std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::min()};
+    std::size_t i = 0;
+    if (n >= 8) {
+        __m256i vmin = _mm256_set1_epi32(r.min);
+        __m256i vmax = _mm256_set1_epi32(r.max);
+        for (; i + 8 <= n; i += 8) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            vmin = _mm256_min_epi32(vmin, v);
+            vmax = _mm256_max_epi32(vmax, v);
+        }
+        alignas(32) int32_t mins[8], maxs[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(mins), vmin);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(maxs), vmax);
+        for (int lane = 0; lane < 8; ++lane) {
+            if (mins[lane] < r.min) r.min = mins[lane];
+            if (maxs[lane] > r.max) r.max = maxs[lane];
+        }
+    }
+    for (; i < n; ++i) {
+        if (data[i] < r.min) r.min = data[i];
+        if (data[i] > r.max) r.max = data[i];
+    }
+    return r;
+}
+
+// Compress the compare result to one bit per lane and count the bits
+SIMD_TARGET_AVX2 inline std::size_t count_if(const int32_t* data, std::size_t n, compare_op op, int32_t value) {
+    __m256i vvalue = _mm256_set1_epi32(value);
+    std::size_t count = 0;
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i mask;
+        switch (op) {
+            case compare_op::less:    mask = _mm256_cmpgt_epi32(vvalue, v); break;
+            case compare_op::equal:   mask = _mm256_cmpeq_epi32(v, vvalue); break;
+            default:                  mask = _mm256_cmpgt_epi32(v, vvalue); break;
+        }
+        count += static_cast<std::size_t>(__builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(mask))));
+    }
+    for (; i < n; ++i) count += simd_scalar::compare(data[i], op, value) ? 1 : 0;
+    return count;
+}
+
+// Byte shifts only work inside each 128-bit half, so scan the halves separately
+// and then carry the low half's total into the high half
+SIMD_TARGET_AVX2 inline void prefix_sum(const int32_t* in, int32_t* out, std::size_t n) {
+    __m256i running = _mm256_setzero_si256();
+    const __m256i last_lane = _mm256_set1_epi32(7);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        v = _mm256_add_epi32(v, _mm256_slli_si256(v, 4));
+        v = _mm256_add_epi32(v, _mm256_slli_si256(v, 8));
+        __m256i half_totals = _mm256_shuffle_epi32(v, 0xFF);
+        v = _mm256_add_epi32(v, _mm256_permute2x128_si256(half_totals, half_totals, 0x08));
+        v = _mm256_add_epi32(v, running);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), v);
+        running = _mm256_permutevar8x32_epi32(v, last_lane);
+    }
+    uint32_t carry = static_cast<uint32_t>(_mm256_cvtsi256_si32(running));
+    for (; i < n; ++i) {
+        carry += static_cast<uint32_t>(in[i]);
+        out[i] = static_cast<int32_t>(carry);
+    }
+}
+
+// AVX2 has gathers but no scatters, so the multi-table approach is still the fastest
+SIMD_TARGET_AVX2 inline void histogram(const uint8_t* data, std::size_t n, uint32_t* counts) {
+    simd_sse2::histogram(data, n, counts);
+}
+
+SIMD_TARGET_AVX2 inline std::size_t find_byte(const uint8_t* data, std::size_t n, uint8_t value) {
+    const __m256i needle = _mm256_set1_epi8(static_cast<char>(value));
+    std::size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m256i c0 = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), needle);
+        __m256i c1 = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 32)), needle);
+        if (!_mm256_testz_si256(_mm256_or_si256(c0, c1), _mm256_or_si256(c0, c1))) {
+            uint64_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(c0)) |
+                            static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(c1))) << 32;
+            return i + static_cast<std::size_t>(__builtin_ctzll(mask));
+        }
+    }
+    return i + simd_sse2::find_byte(data + i, n - i, value);
+}
+
+SIMD_TARGET_AVX2 inline void byte_mask(const uint8_t* data, std::size_t n, uint8_t value, uint64_t* bits) {
+    const __m256i needle = _mm256_set1_epi8(static_cast<char>(value));
+    std::size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m256i c0 = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), needle);
+        __m256i c1 = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 32)), needle);
+        bits[i / 64] = static_cast<uint32_t>(_mm256_movemask_epi8(c0)) |
+                       static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(c1))) << 32;
+    }
+    if (i < n) simd_scalar::byte_mask(data + i, n - i, value, bits + i / 64);
+}
+
+}  // namespace simd_avx2
+
+// --- SECTION 5: AVX-512 Kernels ---
+
+#define SIMD_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma,popcnt")))
+#define SIMD_TARGET_AVX512_HISTOGRAM __attribute__((target("avx512f,avx512cd,avx512vpopcntdq")))
+#define SIMD_TARGET_AVX512_BW __attribute__((target("avx512f,avx512bw,avx2,popcnt")))
+
+// GCC 12's avx512fintrin.h builds casts and reductions on _mm512_undefined_*()
+// values, and -Wall reports each use as uninitialized once they are inlined here
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+namespace simd_avx512 {
+
+SIMD_TARGET_AVX512 inline int64_t sum(const int32_t* data, std::size_t n) {
+    __m512i acc0 = _mm512_setzero_si512();
+    __m512i acc1 = _mm512_setzero_si512();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_loadu_si512(data + i);
+        acc0 = _mm512_add_epi64(acc0, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(v)));
+        acc1 = _mm512_add_epi64(acc1, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(v, 1)));
+    }
+    int64_t total = _mm512_reduce_add_epi64(_mm512_add_epi64(acc0, acc1));
+    // Masked load for the tail instead of a scalar loop
+    if (i < n) {
+        __mmask16 tail = static_cast<__mmask16>((1u << (n - i)) - 1);
+        __m512i v = _mm512_maskz_loadu_epi32(tail, data + i);
+        total += _mm512_reduce_add_epi64(_mm512_cvtepi32_epi64(_mm512_castsi512_si256(v)));
+        total += _mm512_reduce_add_epi64(_mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(v, 1)));
+    }
+    return total;
+}
+
+SIMD_TARGET_AVX512 inline float dot(const float* a, const float* b, std::size_t n) {
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16), acc1);
+    }
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+    }
+    if (i < n) {
+        __mmask16 tail = static_cast<__mmask16>((1u << (n - i)) - 1);
+        acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tail, a + i), _mm512_maskz_loadu_ps(tail, b + i), acc1);
+    }
+    return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+
+SIMD_TARGET_AVX512 inline void axpy(float a, const float* x, float* y, std::size_t n) {
+    __m512 va = _mm512_set1_ps(a);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(y + i, _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i)));
+    }
+    if (i < n) {
+        __mmask16 tail = static_cast<__mmask16>((1u << (n - i)) - 1);
+        __m512 vy = _mm512_fmadd_ps(va, _mm512_maskz_loadu_ps(tail, x + i), _mm512_maskz_loadu_ps(tail, y + i));
+        _mm512_mask_storeu_ps(y + i, tail, vy);
+    }
+}
+
+SIMD_TARGET_AVX512 inline minmax_result min_max(const int32_t* data, std::size_t n) {
+    __m512i vmin = _mm512_set1_epi32(std::numeric_limits<int32_t>::max());
+    __m512i vmax = _mm512_set1_epi32(std::numeric_limits<int32_t>::min());
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_loadu_si512(data + i);
+        vmin = _mm512_min_epi32(vmin, v);
+        vmax = _mm512_max_epi32(vmax, v);
+    }
+    if (i < n) {
+        // Masked-off lanes keep their previous value, so they do not affect the result
+        __mmask16 tail = static_cast<__mmask16>((1u << (n - i)) - 1);
+        __m512i v = _mm512_maskz_loadu_epi32(tail, data + i);
+        vmin = _mm512_mask_min_epi32(vmin, tail, vmin, v);
+        vmax = _mm512_mask_max_epi32(vmax, tail, vmax, v);
+    }
+    return {_mm512_reduce_min_epi32(vmin), _mm512_reduce_max_epi32(vmax)};
+}
+
+// AVX-512 compares produce a bit mask directly. The predicate has to be an
+// immediate, so each comparison gets its own instantiation.
+template <int Predicate>
+SIMD_TARGET_AVX512 inline std::size_t count_if_impl(const int32_t* data, std::size_t n, int32_t value) {
+    __m512i vvalue = _mm512_set1_epi32(value);
+    std::size_t count = 0;
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __mmask16 m = _mm512_cmp_epi32_mask(_mm512_loadu_si512(data + i), vvalue, Predicate);
+        count += static_cast<std::size_t>(__builtin_popcount(m));
+    }
+    if (i < n) {
+        __mmask16 tail = static_cast<__mmask16>((1u << (n - i)) - 1);
+        __mmask16 m = _mm512_mask_cmp_epi32_mask(tail, _mm512_maskz_loadu_epi32(tail, data + i), vvalue, Predicate);
+        count += static_cast<std::size_t>(__builtin_popcount(m));
+    }
+    return count;
+}
+
+SIMD_TARGET_AVX512 inline std::size_t count_if(const int32_t* data, std::size_t n, compare_op op, int32_t value) {
+    switch (op) {
+        case compare_op::less:    return count_if_impl<_MM_CMPINT_LT>(data, n, value);
+        case compare_op::equal:   return count_if_impl<_MM_CMPINT_EQ>(data, n, value);
+        case compare_op::greater: return count_if_impl<_MM_CMPINT_NLE>(data, n, value);
+    }
+    return 0;
+}
+
+// valignd shifts across the whole register, so this is a plain log2(16)-step scan
+SIMD_TARGET_AVX512 inline void prefix_sum(const int32_t* in, int32_t* out, std::size_t n) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i last_lane = _mm512_set1_epi32(15);
+    __m512i running = zero;
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_loadu_si512(in + i);
+        v = _mm512_add_epi32(v, _mm512_alignr_epi32(v, zero, 15));  // Shift up by 1 lane
+        v = _mm512_add_epi32(v, _mm512_alignr_epi32(v, zero, 14));  // by 2 lanes
+        v = _mm512_add_epi32(v, _mm512_alignr_epi32(v, zero, 12));  // by 4 lanes
+        v = _mm512_add_epi32(v, _mm512_alignr_epi32(v, zero, 8));   // by 8 lanes
+        v = _mm512_add_epi32(v, running);
+        _mm512_storeu_si512(out + i, v);
+        running = _mm512_permutexvar_epi32(last_lane, v);
+    }
+    uint32_t carry = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm512_castsi512_si128(running)));
+    for (; i < n; ++i) {
+        carry += static_cast<uint32_t>(in[i]);
+        out[i] = static_cast<int32_t>(carry);
+    }
+}
+
+// Gather the current counts, add how often each bin occurs in this vector and
+// scatter them back. vpconflictd marks, for every lane, the earlier lanes with the
+// same bin; the scatter lets the highest lane win, and that lane has seen all
+// duplicates, so popcount(conflicts) + 1 is exactly the increment it must apply.
+// Gather/scatter throughput is low on current cores, so dispatch still uses the
+// sub-table version; this one is kept for comparison (and for wider bin types).
+SIMD_TARGET_AVX512_HISTOGRAM inline void histogram_conflict(const uint8_t* data, std::size_t n, uint32_t* counts) {
+    std::memset(counts, 0, 256 * sizeof(uint32_t));
+    const __m512i one = _mm512_set1_epi32(1);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i bins = _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+        __m512i conflicts = _mm512_conflict_epi32(bins);
+        __m512i increment = _mm512_add_epi32(_mm512_popcnt_epi32(conflicts), one);
+        __m512i current = _mm512_i32gather_epi32(bins, counts, 4);
+        _mm512_i32scatter_epi32(counts, bins, _mm512_add_epi32(current, increment), 4);
+    }
+    for (; i < n; ++i) counts[data[i]]++;
+}
+
+inline bool has_conflict_detection() {
+    static const bool supported = [] {
+        cpu_features f = detect_cpu_features();
+        return f.avx512cd && f.avx512vpopcntdq;
+    }();
+    return supported;
+}
+
+inline void histogram(const uint8_t* data, std::size_t n, uint32_t* counts) {
+    simd_sse2::histogram(data, n, counts);
+}
+
+// Byte compares into a mask register need AVX512BW. The tail is a masked load,
+// which does not fault on the masked-off bytes past the end.
+SIMD_TARGET_AVX512_BW inline std::size_t find_byte_bw(const uint8_t* data, std::size_t n, uint8_t value) {
+    const __m512i needle = _mm512_set1_epi8(static_cast<char>(value));
+    std::size_t i = 0;
+    for (; i + 128 <= n; i += 128) {
+        __mmask64 m0 = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(data + i), needle);
+        __mmask64 m1 = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(data + i + 64), needle);
+        if ((m0 | m1) != 0) {
+            return i + static_cast<std::size_t>(m0 != 0 ? __builtin_ctzll(m0) : 64 + __builtin_ctzll(m1));
+        }
+    }
+    for (; i < n; i += 64) {
+        __mmask64 valid = n - i >= 64 ? ~__mmask64(0) : (__mmask64(1) << (n - i)) - 1;
+        __mmask64 m = _mm512_mask_cmpeq_epi8_mask(valid, _mm512_maskz_loadu_epi8(valid, data + i), needle);
+        if (m != 0) return i + static_cast<std::size_t>(__builtin_ctzll(m));
+    }
+    return n;
+}
+
+SIMD_TARGET_AVX512_BW inline void byte_mask_bw(const uint8_t* data, std::size_t n, uint8_t value, uint64_t* bits) {
+    const __m512i needle = _mm512_set1_epi8(static_cast<char>(value));
+    std::size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        bits[i / 64] = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(data + i), needle);
+    }
+    if (i < n) {
+        __mmask64 valid = (__mmask64(1) << (n - i)) - 1;
+        bits[i / 64] = _mm512_mask_cmpeq_epi8_mask(valid, _mm512_maskz_loadu_epi8(valid, data + i), needle);
+    }
+}
+
+inline bool has_byte_compare() {
+    static const bool supported = detect_cpu_features().avx512bw;
+    return supported;
+}
+
+inline std::size_t find_byte(const uint8_t* data, std::size_t n, uint8_t value) {
+    return has_byte_compare() ? find_byte_bw(data, n, value) : simd_avx2::find_byte(data, n, value);
+}
+
+inline void byte_mask(const uint8_t* data, std::size_t n, uint8_t value, uint64_t* bits) {
+    if (has_byte_compare()) {
+        byte_mask_bw(data, n, value, bits);
+    } else {
+        simd_avx2::byte_mask(data, n, value, bits);
+    }
+}
+
+}  // namespace simd_avx512
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif  // SIMD_KERNELS_X86
+
+// --- SECTION 6: Runtime Dispatch ---
+
+// One function pointer per kernel, filled in for a single instruction set
+struct simd_kernel_table {
+    isa_level isa;
+    int64_t (*sum)(const int32_t*, std::size_t);
+    float (*dot)(const float*, const float*, std::size_t);
+    void (*axpy)(float, const float*, float*, std::size_t);
+    minmax_result (*min_max)(const int32_t*, std::size_t);
+    std::size_t (*count_if)(const int32_t*, std::size_t, compare_op, int32_t);
+    void (*prefix_sum)(const int32_t*, int32_t*, std::size_t);
+    void (*histogram)(const uint8_t*, std::size_t, uint32_t*);
+    std::size_t (*find_byte)(const uint8_t*, std::size_t, uint8_t);
+    void (*byte_mask)(const uint8_t*, std::size_t, uint8_t, uint64_t*);
+};
+
+#define SIMD_KERNEL_TABLE(level, ns)                                                                  \
+    simd_kernel_table{level, ns::sum, ns::dot, ns::axpy, ns::min_max, ns::count_if, ns::prefix_sum, \
+                      ns::histogram, ns::find_byte, ns::byte_mask}
+
+// Kernels for a specific level (used by benchmarks to compare tiers). The caller
+// must make sure the CPU supports the requested level.
+inline simd_kernel_table simd_kernels_for(isa_level isa) {
+#ifdef SIMD_KERNELS_X86
+    switch (isa) {
+        case isa_level::avx512: return SIMD_KERNEL_TABLE(isa_level::avx512, simd_avx512);
+        case isa_level::avx2:   return SIMD_KERNEL_TABLE(isa_level::avx2, simd_avx2);
+        case isa_level::sse2:   return SIMD_KERNEL_TABLE(isa_level::sse2, simd_sse2);
+        case isa_level::scalar: break;
+    }
+#endif
+    (void)isa;
+    return SIMD_KERNEL_TABLE(isa_level::scalar, simd_scalar);
+}
+
+#undef SIMD_KERNEL_TABLE
+
+// Kernels for the best level of this CPU, resolved once on first use
+inline const simd_kernel_table& simd_kernels() {
+    static const simd_kernel_table table = simd_kernels_for(detect_isa());
+    return table;
+}
+
+inline int64_t simd_sum(const int32_t* data, std::size_t n) { return simd_kernels().sum(data, n); }
+inline float simd_dot(const float* a, const float* b, std::size_t n) { return simd_kernels().dot(a, b, n); }
+inline void simd_axpy(float a, const float* x, float* y, std::size_t n) { simd_kernels().axpy(a, x, y, n); }
+inline minmax_result simd_min_max(const int32_t* data, std::size_t n) { return simd_kernels().min_max(data, n); }
+inline std::size_t simd_count_if(const int32_t* data, std::size_t n, compare_op op, int32_t value) {
+    return simd_kernels().count_if(data, n, op, value);
+}
+inline void simd_prefix_sum(const int32_t* in, int32_t* out, std::size_t n) { simd_kernels().prefix_sum(in, out, n); }
+inline void simd_histogram(const uint8_t* data, std::size_t n, uint32_t* counts) {
+    simd_kernels().histogram(data, n, counts);
+}
+// Index of the first `value` in data[0, n), or n if there is none
+inline std::size_t simd_find_byte(const uint8_t* data, std::size_t n, uint8_t value) {
+    return simd_kernels().find_byte(data, n, value);
+}
+// Sets bit i % 64 of bits[i / 64] iff data[i] == value; fills (n + 63) / 64 words
+inline void simd_byte_mask(const uint8_t* data, std::size_t n, uint8_t value, uint64_t* bits) {
+    simd_kernels().byte_mask(data, n, value, bits);
+}
@@ -0,0 +1,458 @@
+#pragma once
+
+// Vector variants for avoiding reallocation costs.
+//
+//   small_vector<T, N>             - keeps up to N elements inline (no heap allocation
+//                                    at all for small sizes) and spills to the heap
+//   growable_vector<T, Growth>     - heap vector with a pluggable growth policy
+//
+// Both grow trivially relocatable types (see is_trivially_relocatable) with
+// realloc(), and growable_vector moves very large buffers with mremap(), which
+// remaps the pages instead of copying the bytes.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// A type is trivially relocatable if moving it to a new address and forgetting the
+// old copy is the same as memcpy. Every trivially copyable type qualifies; types
+// like std::unique_ptr do as well and can opt in by specializing this trait.
+template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+namespace vector_detail {
+
+// malloc/realloc only guarantee max_align_t alignment
+template <typename T>
+inline constexpr bool use_realloc = is_trivially_relocatable_v<T> && alignof(T) <= alignof(std::max_align_t);
+
+}  // namespace vector_detail
+
+// --- SECTION 1: Growth Policies ---
+
+// Multiply the capacity by Num/Den. 2/1 is what libstdc++ and libc++ use, 3/2 is
+// what MSVC and folly use: a factor below the golden ratio lets a later allocation
+// fit into the space freed by earlier ones.
+template <std::size_t Num, std::size_t Den = 1>
+struct growth_factor {
+    static_assert(Num > Den, "growth factor must be greater than 1");
+
+    static std::size_t next_capacity(std::size_t current, std::size_t required) {
+        std::size_t grown = current / Den * Num + (current % Den) * Num / Den;
+        return std::max({grown, required, std::size_t(4)});
+    }
+};
+
+// Grow by a fixed number of elements (linear growth, quadratic total copying)
+template <std::size_t Increment>
+struct growth_increment {
+    static std::size_t next_capacity(std::size_t current, std::size_t required) {
+        return std::max(current + Increment, required);
+    }
+};
+
+namespace vector_detail {
+
+template <typename T>
+void destroy(T* first, std::size_t n) {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+        for (std::size_t i = 0; i < n; ++i) first[i].~T();
+    }
+}
+
+// Move [first, first + n) to uninitialized memory at dest and destroy the source.
+// Every element is built at dest before any source is destroyed: a type whose
+// move can throw is copied instead, so if a copy throws, the copies made so far
+// are destroyed and the source is left exactly as it was.
+template <typename T>
+void relocate(T* first, std::size_t n, T* dest) {
+    if constexpr (is_trivially_relocatable_v<T>) {
+        if (n) std::memcpy(static_cast<void*>(dest), static_cast<const void*>(first), n * sizeof(T));
+    } else {
+        std::size_t built = 0;
+        try {
+            for (; built < n; ++built) ::new (static_cast<void*>(dest + built)) T(std::move_if_noexcept(first[built]));
+        } catch (...) {
+            destroy(dest, built);
+            throw;
+        }
+        destroy(first, n);
+    }
+}
+
+inline std::size_t page_size() {
+#ifdef __linux__
+    static const std::size_t size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+#else
+    return 4096;
+#endif
+}
+
+}  // namespace vector_detail
+
+// --- SECTION 2: growable_vector ---
+
+template <typename T, typename Growth = growth_factor<2>>
+class growable_vector {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    // Buffers at least this large are allocated with mmap and grown with mremap
+    static constexpr std::size_t mremap_threshold = std::size_t(1) << 20;
+
+    growable_vector() = default;
+
+    growable_vector(std::initializer_list<T> init) {
+        reserve(init.size());
+        for (const T& value : init) push_back(value);
+    }
+
+    growable_vector(const growable_vector& other) {
+        reserve(other.size_);
+        try {
+            std::uninitialized_copy(other.begin(), other.end(), data_);
+        } catch (...) {
+            release(data_, capacity_, mapped_);  // No destructor runs for a throwing constructor
+            throw;
+        }
+        size_ = other.size_;
+    }
+
+    growable_vector(growable_vector&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr)),
+          size_(std::exchange(other.size_, 0)),
+          capacity_(std::exchange(other.capacity_, 0)),
+          mapped_(std::exchange(other.mapped_, false)) {}
+
+    growable_vector& operator=(growable_vector other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    ~growable_vector() {
+        vector_detail::destroy(data_, size_);
+        release(data_, capacity_, mapped_);
+    }
+
+    void swap(growable_vector& other) noexcept {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(mapped_, other.mapped_);
+    }
+
+    T* data() noexcept { return data_; }
+    const T* data() const noexcept { return data_; }
+    size_type size() const noexcept { return size_; }
+    size_type capacity() const noexcept { return capacity_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    T& operator[](size_type i) noexcept { return data_[i]; }
+    const T& operator[](size_type i) const noexcept { return data_[i]; }
+    T& back() noexcept { return data_[size_ - 1]; }
+    iterator begin() noexcept { return data_; }
+    iterator end() noexcept { return data_ + size_; }
+    const_iterator begin() const noexcept { return data_; }
+    const_iterator end() const noexcept { return data_ + size_; }
+
+    void reserve(size_type new_capacity) {
+        if (new_capacity > capacity_) reallocate(new_capacity);
+    }
+
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (size_ == capacity_) {
+            // Build the element first: args may refer to an element of this vector
+            T tmp(std::forward<Args>(args)...);
+            reallocate(Growth::next_capacity(capacity_, size_ + 1));
+            ::new (static_cast<void*>(data_ + size_)) T(std::move(tmp));
+        } else {
+            ::new (static_cast<void*>(data_ + size_)) T(std::forward<Args>(args)...);
+        }
+        return data_[size_++];
+    }
+
+    void pop_back() noexcept { data_[--size_].~T(); }
+
+    void clear() noexcept {
+        vector_detail::destroy(data_, size_);
+        size_ = 0;
+    }
+
+    void resize(size_type new_size) {
+        reserve(new_size);
+        for (size_type i = size_; i < new_size; ++i) ::new (static_cast<void*>(data_ + i)) T();
+        if (new_size < size_) vector_detail::destroy(data_ + new_size, size_ - new_size);
+        size_ = new_size;
+    }
+
+    // True while the buffer lives in its own mapping (grown with mremap)
+    bool uses_mremap() const noexcept { return mapped_; }
+
+private:
+    void reallocate(size_type new_capacity) {
+        if (new_capacity > max_size()) throw std::length_error("growable_vector too large");
+        if constexpr (vector_detail::use_realloc<T>) {
+            reallocate_trivial(new_capacity);
+        } else {
+            T* fresh = static_cast<T*>(::operator new(new_capacity * sizeof(T), std::align_val_t(alignof(T))));
+            try {
+                vector_detail::relocate(data_, size_, fresh);
+            } catch (...) {
+                release(fresh, new_capacity, false);  // The old buffer is untouched
+                throw;
+            }
+            release(data_, capacity_, false);
+            data_ = fresh;
+            capacity_ = new_capacity;
+        }
+    }
+
+    // realloc() can often extend the block in place; mremap() moves a large
+    // mapping by editing page tables instead of copying every byte
+    void reallocate_trivial(size_type new_capacity) {
+        std::size_t bytes = new_capacity * sizeof(T);
+#ifdef __linux__
+        // Only switch to a mapping when growing: a single up-front reserve() gains
+        // nothing from mremap and would pay for fresh zeroed pages every time
+        if (bytes >= mremap_threshold && (mapped_ || size_ > 0)) {
+            std::size_t page = vector_detail::page_size();
+            bytes = (bytes + page - 1) / page * page;
+            void* fresh = MAP_FAILED;
+            if (mapped_) {
+                fresh = mremap(data_, capacity_ * sizeof(T), bytes, MREMAP_MAYMOVE);
+            } else {
+                fresh = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (fresh != MAP_FAILED) {
+                    if (size_) std::memcpy(fresh, static_cast<void*>(data_), size_ * sizeof(T));
+                    std::free(data_);
+                }
+            }
+            if (fresh == MAP_FAILED) throw std::bad_alloc();
+            data_ = static_cast<T*>(fresh);
+            capacity_ = bytes / sizeof(T);
+            mapped_ = true;
+            return;
+        }
+#endif
+        void* fresh = std::realloc(static_cast<void*>(data_), bytes);
+        if (!fresh) throw std::bad_alloc();
+        data_ = static_cast<T*>(fresh);
+        capacity_ = new_capacity;
+    }
+
+    static void release(T* data, size_type capacity, bool mapped) {
+        if (!data) return;
+#ifdef __linux__
+        if (mapped) {
+            munmap(static_cast<void*>(data), capacity * sizeof(T));
+            return;
+        }
+#endif
+        (void)mapped;
+        if constexpr (vector_detail::use_realloc<T>) {
+            std::free(data);
+        } else {
+            ::operator delete(data, capacity * sizeof(T), std::align_val_t(alignof(T)));
+        }
+    }
+
+    static constexpr size_type max_size() noexcept { return std::size_t(-1) / 2 / sizeof(T); }
+
+    T* data_ = nullptr;
+    size_type size_ = 0;
+    size_type capacity_ = 0;
+    bool mapped_ = false;
+};
+
+// --- SECTION 3: small_vector ---
+
+template <typename T, std::size_t N, typename Growth = growth_factor<2>>
+class small_vector {
+    static_assert(N > 0, "use growable_vector for a vector without inline storage");
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    static constexpr size_type inline_capacity = N;
+
+    small_vector() noexcept = default;
+
+    small_vector(std::initializer_list<T> init) {
+        reserve(init.size());
+        for (const T& value : init) push_back(value);
+    }
+
+    small_vector(const small_vector& other) {
+        reserve(other.size_);
+        try {
+            std::uninitialized_copy(other.begin(), other.end(), data_);
+        } catch (...) {
+            free_heap();
+            throw;
+        }
+        size_ = other.size_;
+    }
+
+    // A heap buffer can be stolen; inline elements have to be moved one by one
+    small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        take(std::move(other));
+    }
+
+    small_vector& operator=(const small_vector& other) {
+        if (this != &other) {
+            small_vector copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    small_vector& operator=(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        if (this != &other) {
+            vector_detail::destroy(data_, size_);
+            free_heap();
+            data_ = inline_data();
+            capacity_ = N;
+            size_ = 0;
+            take(std::move(other));
+        }
+        return *this;
+    }
+
+    ~small_vector() {
+        vector_detail::destroy(data_, size_);
+        free_heap();
+    }
+
+    T* data() noexcept { return data_; }
+    const T* data() const noexcept { return data_; }
+    size_type size() const noexcept { return size_; }
+    size_type capacity() const noexcept { return capacity_; }
+    bool empty() const noexcept { return size_ == 0; }
+    bool is_inline() const noexcept { return data_ == inline_data(); }
+
+    T& operator[](size_type i) noexcept { return data_[i]; }
+    const T& operator[](size_type i) const noexcept { return data_[i]; }
+    T& back() noexcept { return data_[size_ - 1]; }
+    iterator begin() noexcept { return data_; }
+    iterator end() noexcept { return data_ + size_; }
+    const_iterator begin() const noexcept { return data_; }
+    const_iterator end() const noexcept { return data_ + size_; }
+
+    void reserve(size_type new_capacity) {
+        if (new_capacity > capacity_) grow_to(new_capacity);
+    }
+
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (size_ == capacity_) {
+            T tmp(std::forward<Args>(args)...);
+            grow_to(Growth::next_capacity(capacity_, size_ + 1));
+            ::new (static_cast<void*>(data_ + size_)) T(std::move(tmp));
+        } else {
+            ::new (static_cast<void*>(data_ + size_)) T(std::forward<Args>(args)...);
+        }
+        return data_[size_++];
+    }
+
+    void pop_back() noexcept { data_[--size_].~T(); }
+
+    void clear() noexcept {
+        vector_detail::destroy(data_, size_);
+        size_ = 0;
+    }
+
+    void resize(size_type new_size) {
+        reserve(new_size);
+        for (size_type i = size_; i < new_size; ++i) ::new (static_cast<void*>(data_ + i)) T();
+        if (new_size < size_) vector_detail::destroy(data_ + new_size, size_ - new_size);
+        size_ = new_size;
+    }
+
+private:
+    T* inline_data() noexcept { return std::launder(reinterpret_cast<T*>(inline_storage_)); }
+    const T* inline_data() const noexcept { return std::launder(reinterpret_cast<const T*>(inline_storage_)); }
+
+    void grow_to(size_type new_capacity) {
+        if (new_capacity > max_size()) throw std::length_error("small_vector too large");
+        if constexpr (vector_detail::use_realloc<T>) {
+            // Once on the heap, realloc() may extend the block without copying
+            void* fresh = is_inline() ? std::malloc(new_capacity * sizeof(T))
+                                      : std::realloc(static_cast<void*>(data_), new_capacity * sizeof(T));
+            if (!fresh) throw std::bad_alloc();
+            if (is_inline() && size_) std::memcpy(fresh, static_cast<void*>(data_), size_ * sizeof(T));
+            data_ = static_cast<T*>(fresh);
+        } else {
+            T* fresh = static_cast<T*>(::operator new(new_capacity * sizeof(T), std::align_val_t(alignof(T))));
+            try {
+                vector_detail::relocate(data_, size_, fresh);
+            } catch (...) {
+                ::operator delete(fresh, new_capacity * sizeof(T), std::align_val_t(alignof(T)));
+                throw;
+            }
+            free_heap();
+            data_ = fresh;
+        }
+        capacity_ = new_capacity;
+    }
+
+    void free_heap() noexcept {
+        if (is_inline()) return;
+        if constexpr (vector_detail::use_realloc<T>) {
+            std::free(data_);
+        } else {
+            ::operator delete(data_, capacity_ * sizeof(T), std::align_val_t(alignof(T)));
+        }
+    }
+
+    static constexpr size_type max_size() noexcept { return std::size_t(-1) / 2 / sizeof(T); }
+
+    // Expects *this to be empty and inline. If copying an inline element throws,
+    // *this stays empty and `other` keeps all of its elements.
+    void take(small_vector&& other) {
+        if (other.is_inline()) {
+            vector_detail::relocate(other.data_, other.size_, data_);
+            size_ = other.size_;
+        } else {
+            data_ = other.data_;
+            size_ = other.size_;
+            capacity_ = other.capacity_;
+            other.data_ = other.inline_data();
+            other.capacity_ = N;
+        }
+        other.size_ = 0;
+    }
+
+    T* data_ = inline_data();
+    size_type size_ = 0;
+    size_type capacity_ = N;
+    alignas(T) unsigned char inline_storage_[N * sizeof(T)];
+};
@@ -0,0 +1,181 @@
+#pragma once
+
+// Wait-free single-producer / single-consumer ring buffer.
+//
+// Exactly one thread may call the producer functions and exactly one (other)
+// thread the consumer functions. Every operation finishes in a bounded number
+// of steps: there are no CAS loops, only one acquire load of the other side's
+// index when its cached copy is exhausted, and one release store to publish.
+//
+//   - capacity is a power of two; indices run freely and are masked on access
+//   - each side caches the other side's index, so in steady state the shared
+//     cache line is only touched once per batch, not once per element
+//   - reserve()/commit() hand out raw slots for in-place construction, so a
+//     producer can build N elements directly in the ring and publish once
+//   - peek()/release() hand the consumer a contiguous span of ready elements
+//
+// Usage:
+//   spsc_ring<message> ring(4096);
+//   auto slots = ring.reserve(64);                         // producer
+//   for (std::size_t i = 0; i < slots.size; ++i) new (slots.data + i) message(...);
+//   ring.commit(slots.size);
+//   auto ready = ring.peek(64);                            // consumer
+//   for (std::size_t i = 0; i < ready.size; ++i) handle(ready.data[i]);
+//   ring.release(ready.size);
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <thread>
+#include <utility>
+
+#include "futex.hpp"  // cpu_relax, cache_line_size, default_spin_iterations
+
+template <typename T>
+class spsc_ring {
+public:
+    // Contiguous run of slots. For reserve() the slots are uninitialized memory;
+    // for peek() they hold constructed elements. A run never wraps around the end
+    // of the ring, so it may be shorter than requested even when more is free.
+    struct span {
+        T* data;
+        std::size_t size;
+    };
+
+    explicit spsc_ring(std::size_t capacity)
+        : capacity_(round_up_capacity(capacity)), mask_(capacity_ - 1), slots_(allocator().allocate(capacity_)) {}
+
+    spsc_ring(const spsc_ring&) = delete;
+    spsc_ring& operator=(const spsc_ring&) = delete;
+
+    ~spsc_ring() {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        for (std::size_t pos = head_.load(std::memory_order_relaxed); pos != tail; ++pos) {
+            slots_[pos & mask_].~T();
+        }
+        allocator().deallocate(slots_, capacity_);
+    }
+
+    std::size_t capacity() const noexcept { return capacity_; }
+
+    // --- Producer side ---
+
+    // Up to max_count free slots the producer may construct elements in
+    span reserve(std::size_t max_count) noexcept {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t free = capacity_ - (tail - head_cache_);
+        if (free < max_count) {
+            head_cache_ = head_.load(std::memory_order_acquire);  // Only now touch the consumer's line
+            free = capacity_ - (tail - head_cache_);
+        }
+        std::size_t index = tail & mask_;
+        std::size_t count = std::min({max_count, free, capacity_ - index});
+        return {slots_ + index, count};
+    }
+
+    // Publish the first `count` reserved slots, which must now hold constructed elements
+    void commit(std::size_t count) noexcept {
+        tail_.store(tail_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    template <typename... Args>
+    bool try_emplace(Args&&... args) {
+        span slot = reserve(1);
+        if (slot.size == 0) return false;
+        ::new (static_cast<void*>(slot.data)) T(std::forward<Args>(args)...);
+        commit(1);
+        return true;
+    }
+
+    bool try_push(const T& value) { return try_emplace(value); }
+    bool try_push(T&& value) { return try_emplace(std::move(value)); }
+
+    // Spin until there is room (yielding once spinning stops paying off)
+    template <typename... Args>
+    void emplace(Args&&... args) {
+        for (std::size_t spin = 0; !try_emplace(std::forward<Args>(args)...); ++spin) {
+            backoff(spin);
+        }
+    }
+
+    void push(const T& value) { emplace(value); }
+    void push(T&& value) { emplace(std::move(value)); }
+
+    // --- Consumer side ---
+
+    // Up to max_count elements that are ready to be read, oldest first
+    span peek(std::size_t max_count) noexcept {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        std::size_t ready = tail_cache_ - head;
+        if (ready < max_count) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);  // Only now touch the producer's line
+            ready = tail_cache_ - head;
+        }
+        std::size_t index = head & mask_;
+        std::size_t count = std::min({max_count, ready, capacity_ - index});
+        return {slots_ + index, count};
+    }
+
+    // Destroy the first `count` peeked elements and hand their slots back
+    void release(std::size_t count) noexcept {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < count; ++i) {
+            slots_[(head + i) & mask_].~T();
+        }
+        head_.store(head + count, std::memory_order_release);
+    }
+
+    bool try_pop(T& out) {
+        span ready = peek(1);
+        if (ready.size == 0) return false;
+        out = std::move(*ready.data);
+        release(1);
+        return true;
+    }
+
+    T pop() {
+        T value;
+        for (std::size_t spin = 0; !try_pop(value); ++spin) {
+            backoff(spin);
+        }
+        return value;
+    }
+
+    // Only exact when called from the producer or the consumer thread
+    std::size_t size_approx() const noexcept {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+private:
+    using allocator = std::allocator<T>;
+
+    static std::size_t round_up_capacity(std::size_t capacity) {
+        std::size_t result = 2;
+        while (result < capacity) result <<= 1;
+        return result;
+    }
+
+    // The other thread needs a CPU to make progress; stop spinning after a while
+    // (immediately on a uniprocessor) and give it ours
+    static void backoff(std::size_t spin) {
+        if (spin < default_spin_iterations()) {
+            cpu_relax();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    const std::size_t capacity_;
+    const std::size_t mask_;
+    T* const slots_;
+
+    // Producer-owned line: its index plus its private copy of the consumer's
+    alignas(cache_line_size) std::atomic<std::size_t> tail_{0};
+    std::size_t head_cache_ = 0;
+
+    // Consumer-owned line: its index plus its private copy of the producer's
+    alignas(cache_line_size) std::atomic<std::size_t> head_{0};
+    std::size_t tail_cache_ = 0;
+};
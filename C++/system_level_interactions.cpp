@@ -9,6 +9,10 @@
 #include <ctime>        // For time-related functions
 #include <thread>       // For threading (C++11)
 #include <mutex>        // For synchronization
+#include <future>       // For promise/future
+#include <chrono>       // For durations
+
+#include "timer_wheel.hpp"  // For many timers on one thread
 
 using namespace std;
 
@@ -90,8 +94,18 @@ void memoryManagement() {
 void sleepAndTime() {
     cout << "--- SECTION 4: Sleep and Time Management ---" << endl;
 
-    cout << "Sleeping for 3 seconds..." << endl;
-    sleep(3);  // Sleep for 3 seconds
+    // sleep() parks a whole thread per wait. A timer wheel keeps any number of
+    // pending timers on one driver thread, at a few dozen bytes each.
+    cout << "Setting timers for 1, 2 and 3 seconds..." << endl;
+    promise<void> done;  // Declared first: it must outlive the wheel's driver thread
+    timer_wheel timers;
+    for (int seconds = 1; seconds <= 3; ++seconds) {
+        timers.schedule_after(chrono::seconds(seconds), [seconds, &done] {
+            cout << "Timer fired after " << seconds << " second(s)" << endl;
+            if (seconds == 3) done.set_value();
+        });
+    }
+    done.get_future().wait();
     cout << "Woke up!" << endl;
 
     // Get the current system time
@@ -0,0 +1,356 @@
+#pragma once
+
+// Reusable dependency graph of tasks, run on a thread_pool.
+//
+//   task_graph            - nodes and edges, built once and run any number of times
+//   graph_task            - handle to a node: precede(), succeed(), name()
+//   emplace()             - plain task, void()
+//   emplace_condition()   - int() task; only the successor with that index runs
+//   emplace_subgraph()    - runs another task_graph to completion as one node
+//   run() / run_n()       - execute on a pool; the caller helps until it is done
+//   print_timing()        - per-node start, duration, runs and worker of the last run
+//   print_critical_path() - the longest chain of dependent work in the last run
+//
+// Every node has an atomic counter of unfinished (strong) predecessors. A
+// finishing node decrements its successors' counters; the ones that reach zero
+// are ready. All but one go to the pool and the last runs right away on the
+// same thread, so a chain of nodes costs no queue round-trips. Counters are
+// re-armed at the start of every run, and when a node starts (for loops).
+//
+// Edges leaving a condition node are weak: they do not count as dependencies,
+// and the condition schedules the selected successor directly. That allows
+// loops ("retry until valid") and branches. A node with only weak incoming
+// edges runs only when a condition picks it.
+//
+// One run at a time per graph, and a graph is a subgraph of at most one node
+// that may run concurrently. An exception thrown by a node stops its
+// successors from being scheduled and is rethrown by run() once the nodes
+// already scheduled have finished.
+//
+// Usage:
+//   task_graph graph("batch");
+//   graph_task a = graph.emplace("A", [] { load(); });
+//   graph_task b = graph.emplace("B", [] { left(); });
+//   graph_task c = graph.emplace("C", [] { right(); });
+//   graph_task d = graph.emplace("D", [] { merge(); });
+//   a.precede(b, c);    // B and C need A
+//   d.succeed(b, c);    // D needs B and C
+//   graph.run_n(100);
+//   graph.print_critical_path(std::cout);
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "parallel_for.hpp"  // task_group, shared_thread_pool
+#include "thread_pool.hpp"
+
+class task_graph;
+
+// --- SECTION 1: Node Handles ---
+
+class graph_task {
+public:
+    graph_task() = default;
+
+    // This task runs before every one of `others`
+    template <typename... Tasks>
+    graph_task& precede(const Tasks&... others);
+
+    // This task runs after every one of `others`
+    template <typename... Tasks>
+    graph_task& succeed(const Tasks&... others);
+
+    const std::string& name() const;
+    uint32_t index() const noexcept { return index_; }
+    bool valid() const noexcept { return graph_ != nullptr; }
+
+private:
+    friend class task_graph;
+    graph_task(task_graph* graph, uint32_t index) : graph_(graph), index_(index) {}
+
+    task_graph* graph_ = nullptr;
+    uint32_t index_ = 0;
+};
+
+// --- SECTION 2: The Graph ---
+
+class task_graph {
+public:
+    using clock = std::chrono::steady_clock;
+
+    explicit task_graph(std::string name = "graph") : name_(std::move(name)) {}
+
+    task_graph(const task_graph&) = delete;
+    task_graph& operator=(const task_graph&) = delete;
+
+    template <typename Fn>
+    graph_task emplace(std::string name, Fn&& fn) {
+        node& n = add_node(std::move(name), node_kind::work);
+        n.work = std::forward<Fn>(fn);
+        return {this, static_cast<uint32_t>(nodes_.size() - 1)};
+    }
+
+    // fn returns the index (in precede() order) of the successor to run next;
+    // any other value ends this branch
+    template <typename Fn>
+    graph_task emplace_condition(std::string name, Fn&& fn) {
+        node& n = add_node(std::move(name), node_kind::condition);
+        n.condition = std::forward<Fn>(fn);
+        return {this, static_cast<uint32_t>(nodes_.size() - 1)};
+    }
+
+    // `graph` must outlive this one; it runs on the same pool
+    graph_task emplace_subgraph(std::string name, task_graph& graph) {
+        node& n = add_node(std::move(name), node_kind::subgraph);
+        n.subgraph = &graph;
+        return {this, static_cast<uint32_t>(nodes_.size() - 1)};
+    }
+
+    void add_edge(graph_task from, graph_task to) {
+        node& source = *nodes_[from.index()];
+        node& target = *nodes_[to.index()];
+        source.successors.push_back(to.index());
+        target.has_predecessors = true;
+        if (source.kind != node_kind::condition) target.strong_predecessors++;
+    }
+
+    // Execute the whole graph once. The calling thread runs ready nodes too.
+    void run(thread_pool& pool = shared_thread_pool()) {
+        // A branch that was not taken (or failed) last time can leave counters half-way down
+        for (auto& n : nodes_) {
+            n->pending.store(n->strong_predecessors, std::memory_order_relaxed);
+            n->runs = 0;
+            n->busy_ns = 0;
+        }
+        run_start_ = clock::now();
+        task_group group(pool);
+        for (uint32_t i = 0; i < nodes_.size(); ++i) {
+            if (!nodes_[i]->has_predecessors) group.run([this, &group, i] { execute(group, i); });
+        }
+        group.wait();
+        run_ns_ = nanoseconds_since_start(clock::now());
+    }
+
+    void run_n(std::size_t times, thread_pool& pool = shared_thread_pool()) {
+        for (std::size_t i = 0; i < times; ++i) run(pool);
+    }
+
+    const std::string& name() const noexcept { return name_; }
+    std::size_t size() const noexcept { return nodes_.size(); }
+    const std::string& node_name(uint32_t index) const { return nodes_[index]->name; }
+
+    // Timing of one node in the last run (times relative to the start of the run)
+    struct node_timing {
+        std::string name;
+        uint32_t runs = 0;       // More than one for nodes inside a loop
+        int64_t first_start_ns = 0;
+        int64_t last_end_ns = 0;
+        int64_t busy_ns = 0;     // Sum over all runs
+        int worker = -1;         // Pool worker of the last run; -1 = the thread that called run()
+    };
+
+    std::vector<node_timing> timings() const {
+        std::vector<node_timing> result;
+        for (const auto& n : nodes_) {
+            result.push_back({n->name, n->runs, n->first_start_ns, n->last_end_ns, n->busy_ns, n->worker});
+        }
+        return result;
+    }
+
+    void print_timing(std::ostream& out) const {
+        std::vector<node_timing> rows = timings();
+        std::stable_sort(rows.begin(), rows.end(),
+                         [](const node_timing& a, const node_timing& b) { return a.first_start_ns < b.first_start_ns; });
+        out << "Task graph '" << name_ << "': last run took " << std::fixed << std::setprecision(3) << run_ns_ / 1e6
+            << " ms\n"
+            << "  " << std::left << std::setw(20) << "node" << std::right << std::setw(6) << "runs" << std::setw(12)
+            << "start ms" << std::setw(12) << "busy ms" << std::setw(12) << "end ms" << std::setw(8) << "worker\n";
+        for (const node_timing& row : rows) {
+            out << "  " << std::left << std::setw(20) << row.name << std::right << std::setw(6) << row.runs;
+            if (row.runs == 0) {
+                out << std::setw(12) << "-" << std::setw(12) << "-" << std::setw(12) << "-" << std::setw(8) << "-"
+                    << "\n";
+                continue;
+            }
+            out << std::setw(12) << row.first_start_ns / 1e6 << std::setw(12) << row.busy_ns / 1e6 << std::setw(12)
+                << row.last_end_ns / 1e6 << std::setw(8);
+            if (row.worker < 0) {
+                out << "caller";
+            } else {
+                out << row.worker;
+            }
+            out << "\n";
+        }
+        out << std::defaultfloat << std::setprecision(6);
+    }
+
+    // Longest chain of dependent nodes, weighted by their busy time in the last
+    // run. No schedule can finish faster than this path, and total work / path
+    // bounds the speedup any number of threads can give.
+    std::vector<uint32_t> critical_path() const {
+        std::size_t n = nodes_.size();
+        std::vector<int64_t> longest(n, -1);  // Busy time of the longest path starting at a node
+        std::vector<uint32_t> next(n, UINT32_MAX);
+        std::vector<uint8_t> state(n, 0);     // 0 new, 1 on the DFS stack, 2 done
+        for (uint32_t i = 0; i < n; ++i) longest_path_from(i, longest, next, state);
+
+        uint32_t best = UINT32_MAX;
+        for (uint32_t i = 0; i < n; ++i) {
+            if (nodes_[i]->runs > 0 && (best == UINT32_MAX || longest[i] > longest[best])) best = i;
+        }
+        std::vector<uint32_t> path;
+        for (uint32_t i = best; i != UINT32_MAX; i = next[i]) path.push_back(i);
+        return path;
+    }
+
+    void print_critical_path(std::ostream& out) const {
+        std::vector<uint32_t> path = critical_path();
+        int64_t span = 0, work = 0;
+        for (uint32_t i : path) span += nodes_[i]->busy_ns;
+        for (const auto& n : nodes_) work += n->busy_ns;
+        out << "Critical path of '" << name_ << "':";
+        for (std::size_t k = 0; k < path.size(); ++k) {
+            out << (k ? " -> " : " ") << nodes_[path[k]]->name;
+        }
+        out << "\n"
+            << std::fixed << std::setprecision(3) << "  path " << span / 1e6 << " ms, total work " << work / 1e6
+            << " ms, wall " << run_ns_ / 1e6 << " ms; at most " << std::setprecision(2)
+            << (span > 0 ? static_cast<double>(work) / static_cast<double>(span) : 0.0)
+            << "x faster than serial with any number of threads" << std::defaultfloat << std::setprecision(6)
+            << "\n";
+    }
+
+private:
+    enum class node_kind { work, condition, subgraph };
+
+    struct node {
+        std::string name;
+        node_kind kind = node_kind::work;
+        std::function<void()> work;
+        std::function<int()> condition;
+        task_graph* subgraph = nullptr;
+        std::vector<uint32_t> successors;
+        uint32_t strong_predecessors = 0;
+        bool has_predecessors = false;
+
+        std::atomic<uint32_t> pending{0};  // Strong predecessors still running in this round
+
+        // Written only by the thread running the node; read after run() returns
+        uint32_t runs = 0;
+        int64_t first_start_ns = 0;
+        int64_t last_end_ns = 0;
+        int64_t busy_ns = 0;
+        int worker = -1;
+    };
+
+    node& add_node(std::string name, node_kind kind) {
+        nodes_.push_back(std::make_unique<node>());
+        node& n = *nodes_.back();
+        n.name = std::move(name);
+        n.kind = kind;
+        return n;
+    }
+
+    int64_t nanoseconds_since_start(clock::time_point when) const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(when - run_start_).count();
+    }
+
+    // Run node `index`, then keep going with one of the successors it made
+    // ready; the others are handed to the pool
+    void execute(task_group& group, uint32_t index) {
+        for (;;) {
+            node& n = *nodes_[index];
+            // Re-arm before the body so a loop back to this node starts a new round
+            n.pending.store(n.strong_predecessors, std::memory_order_relaxed);
+
+            clock::time_point start = clock::now();
+            int choice = -1;
+            switch (n.kind) {
+                case node_kind::work:
+                    n.work();
+                    break;
+                case node_kind::condition:
+                    choice = n.condition();
+                    break;
+                case node_kind::subgraph:
+                    n.subgraph->run(group.pool());
+                    break;
+            }
+            clock::time_point end = clock::now();
+            if (n.runs++ == 0) n.first_start_ns = nanoseconds_since_start(start);
+            n.last_end_ns = nanoseconds_since_start(end);
+            n.busy_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+            n.worker = group.pool().current_worker_index();
+
+            uint32_t continue_with = UINT32_MAX;
+            auto ready = [&](uint32_t successor) {
+                if (continue_with == UINT32_MAX) {
+                    continue_with = successor;
+                } else {
+                    group.run([this, &group, successor] { execute(group, successor); });
+                }
+            };
+            if (n.kind == node_kind::condition) {
+                if (choice >= 0 && static_cast<std::size_t>(choice) < n.successors.size()) {
+                    ready(n.successors[choice]);
+                }
+            } else {
+                for (uint32_t successor : n.successors) {
+                    if (nodes_[successor]->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) ready(successor);
+                }
+            }
+            if (continue_with == UINT32_MAX) return;
+            index = continue_with;
+        }
+    }
+
+    // Memoized DFS; an edge back to a node on the stack closes a loop and is skipped
+    int64_t longest_path_from(uint32_t i, std::vector<int64_t>& longest, std::vector<uint32_t>& next,
+                              std::vector<uint8_t>& state) const {
+        if (state[i] == 2) return longest[i];
+        state[i] = 1;
+        int64_t best_tail = 0;
+        for (uint32_t successor : nodes_[i]->successors) {
+            if (state[successor] == 1 || nodes_[successor]->runs == 0) continue;
+            int64_t tail = longest_path_from(successor, longest, next, state);
+            if (next[i] == UINT32_MAX || tail > best_tail) {
+                best_tail = tail;
+                next[i] = successor;
+            }
+        }
+        state[i] = 2;
+        longest[i] = nodes_[i]->busy_ns + best_tail;
+        return longest[i];
+    }
+
+    std::string name_;
+    std::vector<std::unique_ptr<node>> nodes_;
+    clock::time_point run_start_{};
+    int64_t run_ns_ = 0;
+};
+
+// --- SECTION 3: Handle Methods ---
+
+template <typename... Tasks>
+graph_task& graph_task::precede(const Tasks&... others) {
+    (graph_->add_edge(*this, others), ...);
+    return *this;
+}
+
+template <typename... Tasks>
+graph_task& graph_task::succeed(const Tasks&... others) {
+    (graph_->add_edge(others, *this), ...);
+    return *this;
+}
+
+inline const std::string& graph_task::name() const { return graph_->node_name(index_); }
@@ -0,0 +1,533 @@
+#pragma once
+
+// Persistent work-stealing thread pool.
+//
+//   - a fixed set of worker threads, created once
+//   - one Chase-Lev deque per worker: the owner pushes and pops at the bottom
+//     (LIFO, cache-friendly), idle workers steal from the top (FIFO)
+//   - tasks submitted from outside the pool go to a shared injection queue
+//   - idle workers spin briefly, then park on a futex-backed atomic wait
+//   - optional pinning of workers to CPUs (compact or spread over cores and
+//     NUMA nodes); pinned workers steal from their own node before others
+//   - submit() returns a std::future, bulk() runs fn(i) for a whole index range
+//   - shutdown() (also run by the destructor) finishes queued work, then joins
+//
+// Usage:
+//   thread_pool pool;                             // one worker per hardware thread
+//   auto f = pool.submit([] { return 6 * 7; });
+//   pool.bulk(1000, [&](std::size_t i) { out[i] = work(i); }).wait();
+//
+//   thread_pool_options pinned;
+//   pinned.placement = thread_placement::spread;   // One worker per core, all nodes
+//   pinned.on_worker_start = [&](std::size_t i) { local[i] = first_touch_buffer<float>(n); };
+//   thread_pool numa_pool(pinned);
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "cpu_topology.hpp"  // thread_placement, pin_current_thread
+#include "futex.hpp"         // cpu_relax, cache_line_size, default_spin_iterations
+
+// --- SECTION 1: Chase-Lev Work-Stealing Deque ---
+
+// Lock-free deque from "Dynamic Circular Work-Stealing Deque" (Chase & Lev, 2005)
+// with the C11 memory orderings of Le, Pop, Cohen & Zappa Nardelli (2013).
+// Only the owning thread may call push() and pop(); any thread may call steal().
+template <typename T>
+class chase_lev_deque {
+    static_assert(std::is_trivially_copyable_v<T>, "elements are copied with atomic loads and stores");
+
+public:
+    explicit chase_lev_deque(std::size_t capacity = 256) {
+        std::size_t size = 1;
+        while (size < capacity) size <<= 1;
+        buffers_.push_back(std::make_unique<ring>(size));
+        buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+    }
+
+    chase_lev_deque(const chase_lev_deque&) = delete;
+    chase_lev_deque& operator=(const chase_lev_deque&) = delete;
+
+    void push(T value) {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_acquire);
+        ring* a = buffer_.load(std::memory_order_relaxed);
+        if (b - t > static_cast<int64_t>(a->size) - 1) {
+            a = grow(a, t, b);
+        }
+        a->put(b, value);
+        bottom_.store(b + 1, std::memory_order_release);  // Publishes the slot to thieves
+    }
+
+    bool pop(T& out) {
+        int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        ring* a = buffer_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        if (t > b) {  // Empty
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        out = a->get(b);
+        if (t == b) {
+            // Last element: race against thieves for it
+            bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    bool steal(T& out) {
+        int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) return false;
+        ring* a = buffer_.load(std::memory_order_acquire);
+        T value = a->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return false;  // Lost the race to the owner or another thief
+        }
+        out = value;
+        return true;
+    }
+
+    // Approximate: only exact when no other thread is using the deque
+    std::size_t size() const {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        return b > t ? static_cast<std::size_t>(b - t) : 0;
+    }
+
+private:
+    struct ring {
+        explicit ring(std::size_t n) : size(n), mask(n - 1), slots(new std::atomic<T>[n]) {}
+        T get(int64_t i) const { return slots[static_cast<std::size_t>(i) & mask].load(std::memory_order_relaxed); }
+        void put(int64_t i, T v) { slots[static_cast<std::size_t>(i) & mask].store(v, std::memory_order_relaxed); }
+
+        std::size_t size;
+        std::size_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+    // Thieves may still be reading the old ring, so it is kept alive until the
+    // deque is destroyed (rings double in size, so this at most doubles memory)
+    ring* grow(ring* old, int64_t t, int64_t b) {
+        auto bigger = std::make_unique<ring>(old->size * 2);
+        for (int64_t i = t; i < b; ++i) bigger->put(i, old->get(i));
+        ring* raw = bigger.get();
+        buffers_.push_back(std::move(bigger));
+        buffer_.store(raw, std::memory_order_release);
+        return raw;
+    }
+
+    alignas(cache_line_size) std::atomic<int64_t> top_{0};     // Written by thieves
+    alignas(cache_line_size) std::atomic<int64_t> bottom_{0};  // Written by the owner
+    std::atomic<ring*> buffer_{nullptr};
+    std::vector<std::unique_ptr<ring>> buffers_;  // Owner only
+};
+
+// --- SECTION 2: Tasks ---
+
+struct pool_task {
+    virtual ~pool_task() = default;
+    virtual void run() = 0;
+};
+
+template <typename Fn>
+struct pool_task_impl final : pool_task {
+    explicit pool_task_impl(Fn&& f) : fn(std::move(f)) {}
+    void run() override { fn(); }
+    Fn fn;
+};
+
+template <typename Fn>
+pool_task* make_pool_task(Fn&& fn) {
+    return new pool_task_impl<std::decay_t<Fn>>(std::forward<Fn>(fn));
+}
+
+// --- SECTION 3: The Pool ---
+
+struct thread_pool_options {
+    std::size_t threads = 0;               // 0 = std::thread::hardware_concurrency()
+    std::size_t spin_iterations = default_spin_iterations(4096);  // Pause rounds before parking; 0 on one CPU
+    thread_placement placement = thread_placement::none;  // Pin worker i to placement_order()[i]
+    bool steal_same_node_first = true;     // Pinned workers try victims on their own node first
+    // Runs on each worker after pinning and before it takes any task: the place
+    // to allocate per-worker data so it is first-touched on the worker's node.
+    // An exception escaping it terminates the program.
+    std::function<void(std::size_t worker_index)> on_worker_start;
+};
+
+class thread_pool {
+public:
+    explicit thread_pool(thread_pool_options options = {}) : options_(options) {
+        std::size_t count = options_.threads;
+        if (count == 0) count = std::max(1u, std::thread::hardware_concurrency());
+        workers_.reserve(count);
+        const cpu_topology& topology = cpu_topology::system();
+        std::vector<int> cpus = placement_order(topology, options_.placement);
+        for (std::size_t i = 0; i < count; ++i) {
+            workers_.push_back(std::make_unique<worker>());
+            if (!cpus.empty()) {
+                workers_[i]->cpu = cpus[i % cpus.size()];
+                workers_[i]->node = topology.node_of(workers_[i]->cpu);
+            }
+        }
+        assign_victims();
+        for (std::size_t i = 0; i < count; ++i) {
+            workers_[i]->thread = std::thread([this, i] { worker_loop(i); });
+        }
+    }
+
+    explicit thread_pool(std::size_t threads) : thread_pool(with_threads(threads)) {}
+
+    ~thread_pool() { shutdown(); }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    std::size_t size() const noexcept { return workers_.size(); }
+
+    // Run fn(args...) on the pool; the future carries the result or exception
+    template <typename Fn, typename... Args>
+    auto submit(Fn&& fn, Args&&... args) -> std::future<std::invoke_result_t<Fn, Args...>> {
+        using result_type = std::invoke_result_t<Fn, Args...>;
+        std::packaged_task<result_type()> job(
+            [fn = std::forward<Fn>(fn), ... args = std::forward<Args>(args)]() mutable {
+                return std::invoke(std::move(fn), std::move(args)...);
+            });
+        std::future<result_type> result = job.get_future();
+        enqueue(make_pool_task(std::move(job)));
+        return result;
+    }
+
+    // Fire-and-forget: cheaper than submit() because no shared state is created.
+    // An exception escaping fn terminates the program, as with std::thread.
+    template <typename Fn>
+    void post(Fn&& fn) {
+        enqueue(make_pool_task(std::forward<Fn>(fn)));
+    }
+
+    // Bulk submission: runs fn(i) for every i in [0, count) as `count` tasks
+    // enqueued together (one lock, one wake-up round). The future becomes ready
+    // when all of them finished; it rethrows the first exception, if any.
+    template <typename Fn>
+    std::future<void> bulk(std::size_t count, Fn fn) {
+        struct bulk_state {
+            explicit bulk_state(std::size_t n, Fn&& f) : remaining(n), fn(std::move(f)) {}
+            std::atomic<std::size_t> remaining;
+            std::atomic<bool> failed{false};
+            std::exception_ptr error;
+            std::promise<void> done;
+            Fn fn;
+        };
+        auto state = std::make_shared<bulk_state>(count, std::move(fn));
+        std::future<void> result = state->done.get_future();
+        if (count == 0) {
+            state->done.set_value();
+            return result;
+        }
+
+        std::vector<pool_task*> tasks;
+        tasks.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            tasks.push_back(make_pool_task([state, i] {
+                try {
+                    state->fn(i);
+                } catch (...) {
+                    if (!state->failed.exchange(true)) state->error = std::current_exception();
+                }
+                if (state->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    if (state->error) {
+                        state->done.set_exception(state->error);
+                    } else {
+                        state->done.set_value();
+                    }
+                }
+            }));
+        }
+        enqueue_batch(tasks);
+        return result;
+    }
+
+    // Stop accepting work, let the workers drain every queue, then join them.
+    // Submitting from outside the pool while shutdown() runs is not supported.
+    void shutdown() {
+        if (stopping_.exchange(true)) return;
+        wake_all();
+        for (auto& w : workers_) {
+            if (w->thread.joinable()) w->thread.join();
+        }
+    }
+
+    // CPU worker i is pinned to (-1 if unpinned) and its NUMA node (0 if unpinned)
+    int worker_cpu(std::size_t i) const noexcept { return workers_[i]->cpu; }
+    int worker_node(std::size_t i) const noexcept { return workers_[i]->node; }
+
+    // Index of the calling worker in this pool, or -1 for outside threads
+    int current_worker_index() const noexcept { return current_pool == this ? current_index : -1; }
+
+    // Run one queued task on the calling thread if there is one. Lets a thread that
+    // waits for pool work help out instead of blocking.
+    bool try_run_one() {
+        int self = current_worker_index();
+        pool_task* task = nullptr;
+        if (find_task(self < 0 ? 0 : static_cast<std::size_t>(self), self >= 0, task)) {
+            execute(task, self >= 0 ? workers_[self].get() : nullptr);
+            return true;
+        }
+        return false;
+    }
+
+    struct worker_stats {
+        uint64_t executed = 0;
+        uint64_t stolen = 0;
+        uint64_t stolen_remote = 0;  // Part of `stolen` taken from another node
+        uint64_t parked = 0;
+    };
+
+    std::vector<worker_stats> stats() const {
+        std::vector<worker_stats> result;
+        for (const auto& w : workers_) {
+            result.push_back({w->executed.load(std::memory_order_relaxed), w->stolen.load(std::memory_order_relaxed),
+                              w->stolen_remote.load(std::memory_order_relaxed),
+                              w->parked.load(std::memory_order_relaxed)});
+        }
+        return result;
+    }
+
+private:
+    struct alignas(cache_line_size) worker {
+        chase_lev_deque<pool_task*> deque;
+        std::thread thread;
+        int cpu = -1;
+        int node = 0;
+        std::vector<std::size_t> near_victims;  // Other workers on the same node
+        std::vector<std::size_t> far_victims;   // Workers on other nodes
+        std::atomic<uint64_t> executed{0};
+        std::atomic<uint64_t> stolen{0};
+        std::atomic<uint64_t> stolen_remote{0};
+        std::atomic<uint64_t> parked{0};
+    };
+
+    // Stealing across nodes moves the task's data over the interconnect, so a
+    // pinned worker only looks at remote deques once its own node has nothing.
+    // Unpinned workers have no fixed node and treat every other worker as near.
+    void assign_victims() {
+        bool by_node = options_.placement != thread_placement::none && options_.steal_same_node_first;
+        for (std::size_t i = 0; i < workers_.size(); ++i) {
+            for (std::size_t j = 0; j < workers_.size(); ++j) {
+                if (j == i) continue;
+                if (!by_node || workers_[j]->node == workers_[i]->node) {
+                    workers_[i]->near_victims.push_back(j);
+                } else {
+                    workers_[i]->far_victims.push_back(j);
+                }
+            }
+        }
+    }
+
+    static thread_pool_options with_threads(std::size_t threads) {
+        thread_pool_options options;
+        options.threads = threads;
+        return options;
+    }
+
+    static inline thread_local const thread_pool* current_pool = nullptr;
+    static inline thread_local int current_index = -1;
+
+    void check_running() const {
+        if (stopping_.load(std::memory_order_relaxed)) {
+            throw std::runtime_error("thread_pool: submit after shutdown");
+        }
+    }
+
+    // Workers push onto their own deque; everyone else uses the injection queue
+    void enqueue(pool_task* task) {
+        int self = current_worker_index();
+        if (self >= 0) {
+            workers_[self]->deque.push(task);
+        } else {
+            std::unique_ptr<pool_task> guard(task);
+            check_running();
+            std::lock_guard<std::mutex> lock(injection_mutex_);
+            injection_.push_back(guard.release());
+            injection_size_.fetch_add(1, std::memory_order_relaxed);
+        }
+        notify(1);
+    }
+
+    void enqueue_batch(const std::vector<pool_task*>& tasks) {
+        int self = current_worker_index();
+        if (self >= 0) {
+            for (pool_task* task : tasks) workers_[self]->deque.push(task);
+        } else {
+            if (stopping_.load(std::memory_order_relaxed)) {
+                for (pool_task* task : tasks) delete task;
+                throw std::runtime_error("thread_pool: submit after shutdown");
+            }
+            std::lock_guard<std::mutex> lock(injection_mutex_);
+            injection_.insert(injection_.end(), tasks.begin(), tasks.end());
+            injection_size_.fetch_add(tasks.size(), std::memory_order_relaxed);
+        }
+        notify(tasks.size());
+    }
+
+    bool pop_injection(pool_task*& task) {
+        if (injection_size_.load(std::memory_order_relaxed) == 0) return false;
+        std::lock_guard<std::mutex> lock(injection_mutex_);
+        if (injection_.empty()) return false;
+        task = injection_.front();
+        injection_.pop_front();
+        injection_size_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Own deque first, then the injection queue, then steal from the others
+    // (same node before remote ones) starting at a per-thread pseudo-random
+    // victim to spread contention
+    bool find_task(std::size_t self, bool is_worker, pool_task*& task) {
+        if (is_worker && workers_[self]->deque.pop(task)) return true;
+        if (pop_injection(task)) return true;
+        if (!is_worker) {
+            std::size_t n = workers_.size();
+            std::size_t start = next_random() % n;
+            for (std::size_t k = 0; k < n; ++k) {
+                if (workers_[(start + k) % n]->deque.steal(task)) return true;
+            }
+            return false;
+        }
+        worker& me = *workers_[self];
+        if (steal_from(me.near_victims, task)) {
+            me.stolen.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        if (steal_from(me.far_victims, task)) {
+            me.stolen.fetch_add(1, std::memory_order_relaxed);
+            me.stolen_remote.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    bool steal_from(const std::vector<std::size_t>& victims, pool_task*& task) {
+        std::size_t n = victims.size();
+        if (n == 0) return false;
+        std::size_t start = next_random() % n;
+        for (std::size_t k = 0; k < n; ++k) {
+            if (workers_[victims[(start + k) % n]]->deque.steal(task)) return true;
+        }
+        return false;
+    }
+
+    void execute(pool_task* task, worker* w) {
+        task->run();
+        delete task;
+        if (w) w->executed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void worker_loop(std::size_t index) {
+        current_pool = this;
+        current_index = static_cast<int>(index);
+        worker& self = *workers_[index];
+        if (self.cpu >= 0) pin_current_thread(self.cpu);
+        if (options_.on_worker_start) options_.on_worker_start(index);
+
+        for (;;) {
+            pool_task* task = nullptr;
+            if (find_task(index, true, task)) {
+                execute(task, &self);
+                continue;
+            }
+
+            // Idle: spin for a while, new work usually arrives within microseconds
+            bool found = false;
+            for (std::size_t spin = 0; spin < options_.spin_iterations && !found; ++spin) {
+                cpu_relax();
+                if ((spin & 63) == 63) found = has_visible_work();
+            }
+            if (found) continue;
+
+            if (stopping_.load(std::memory_order_acquire) && !has_visible_work()) {
+                return;  // Shutdown and nothing left: every queue has been drained
+            }
+            park(self);
+        }
+    }
+
+    bool has_visible_work() const {
+        if (injection_size_.load(std::memory_order_relaxed) > 0) return true;
+        for (const auto& w : workers_) {
+            if (w->deque.size() > 0) return true;
+        }
+        return false;
+    }
+
+    // Eventcount protocol: announce the sleeper, re-check for work, then wait on
+    // the epoch read *before* the re-check. A producer pushes, then bumps the
+    // epoch if anyone sleeps, so either we see its task or the wait returns.
+    void park(worker& self) {
+        uint32_t epoch = wake_epoch_.load(std::memory_order_acquire);
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);  // Pairs with the fence in notify()
+        if (has_visible_work() || stopping_.load(std::memory_order_seq_cst)) {
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+            return;
+        }
+        self.parked.fetch_add(1, std::memory_order_relaxed);
+        wake_epoch_.wait(epoch, std::memory_order_acquire);
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void notify(std::size_t count) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_relaxed) == 0) return;
+        wake_epoch_.fetch_add(1, std::memory_order_release);
+        if (count == 1) {
+            wake_epoch_.notify_one();
+        } else {
+            wake_epoch_.notify_all();
+        }
+    }
+
+    void wake_all() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        wake_epoch_.fetch_add(1, std::memory_order_release);
+        wake_epoch_.notify_all();
+    }
+
+    static std::size_t next_random() {
+        static thread_local uint64_t state =
+            0x9E3779B97F4A7C15ull ^ std::hash<std::thread::id>{}(std::this_thread::get_id());
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return static_cast<std::size_t>(state);
+    }
+
+    thread_pool_options options_;
+    std::vector<std::unique_ptr<worker>> workers_;
+
+    std::mutex injection_mutex_;
+    std::deque<pool_task*> injection_;
+    alignas(cache_line_size) std::atomic<std::size_t> injection_size_{0};
+
+    alignas(cache_line_size) std::atomic<uint32_t> wake_epoch_{0};
+    std::atomic<uint32_t> sleepers_{0};
+    std::atomic<bool> stopping_{false};
+};
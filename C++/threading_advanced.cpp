@@ -7,18 +7,131 @@
 #include <future>
 #include <chrono>
 #include <functional>
+#include <deque>
+#include <algorithm>
+#include <iomanip>
+#include <shared_mutex>
+#include <fstream>
 
-// Mutex for thread synchronization
-std::mutex mtx;
+#include "thread_pool.hpp"  // Persistent work-stealing thread pool
+#include "cpu_topology.hpp"  // Thread pinning and first-touch buffers
+#include "mpmc_queue.hpp"   // Lock-free bounded MPMC queue
+#include "sharded_counter.hpp"  // Per-thread / per-CPU counters
+#include "coroutine_runtime.hpp"  // task<T>, when_all, schedulers, timers
+#include "profiled_mutex.hpp"  // Contention profiling (compile with -DENABLE_MUTEX_PROFILING)
+#include "seqlock.hpp"  // Sequence lock for read-mostly state
+#include "benchmark.hpp"  // do_not_optimize
+#include "parallel_for.hpp"  // parallel_for, parallel_invoke, parallel_reduce
+#include "timer_wheel.hpp"  // Hierarchical timer wheel
+#include "async_logger.hpp"  // Logging off the critical path
+#include "task_graph.hpp"  // Dependency graphs of tasks
+#include "fiber.hpp"  // Fibers with blocking mutex/condvar/channel
+#include "pipeline.hpp"  // Multi-stage pipelines with backpressure
+
+// Mutex for thread synchronization (a spin-then-park futex_mutex unless profiling is enabled)
+profiled_mutex mtx{"mtx"};
 
 // Shared resource for thread manipulation
 int shared_resource = 0;
 
-// Function to increment the shared resource in a thread-safe way
+// Function to increment the shared resource in a thread-safe way. The message
+// goes to the async logger after the lock is released: the caller only copies
+// two ints, the console write happens on the logger's own thread.
 void thread_safe_increment(int thread_id) {
-    std::lock_guard<std::mutex> guard(mtx);  // Lock the mutex to ensure safe access
-    shared_resource++;
-    std::cout << "Thread " << thread_id << " incremented shared_resource to " << shared_resource << "\n";
+    int value;
+    {
+        std::lock_guard<profiled_mutex> guard(mtx);  // Lock the mutex to ensure safe access
+        value = ++shared_resource;
+    }
+    default_logger().info("Thread {} incremented shared_resource to {}", thread_id, value);
+}
+
+// Hammer mtx from several threads so the profiler has contention to report:
+// short critical sections most of the time, an occasional long one
+void mutex_contention_example(int num_threads) {
+    constexpr int LOCKS_PER_THREAD = 20000;
+    std::cout << "Contending for mtx with " << num_threads << " threads\n";
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([] {
+            for (int i = 0; i < LOCKS_PER_THREAD; ++i) {
+                std::lock_guard<profiled_mutex> guard(mtx);
+                shared_resource++;
+                if (i % 1000 == 0) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));  // Slow path while holding the lock
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    std::cout << "shared_resource is now " << shared_resource << "\n";
+    profiled_mutex_report(std::cout);
+}
+
+// Caller-side cost of one log line: formatting into a stream under a mutex
+// versus handing the arguments to the async logger. Both write to /dev/null so
+// only the logging path itself is measured.
+void logger_benchmark(int num_threads) {
+    const int LINES = 100000;  // Per thread
+    std::ofstream null_sink("/dev/null");
+    std::cout << "Logger benchmark: " << num_threads << " threads x " << LINES << " lines\n";
+
+    // Each thread times every call with the TSC and keeps the samples
+    auto run = [&](const char* name, auto log_line, auto finish) {
+        std::vector<std::vector<uint64_t>> samples(num_threads, std::vector<uint64_t>(LINES));
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t] {
+                for (int i = 0; i < LINES; ++i) {
+                    uint64_t before = tsc_clock::now();
+                    log_line(t, i);
+                    samples[t][i] = tsc_clock::now() - before;
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        std::chrono::duration<double> callers = std::chrono::steady_clock::now() - start;
+        finish();
+        std::chrono::duration<double> total = std::chrono::steady_clock::now() - start;
+
+        std::vector<uint64_t> all;
+        for (const auto& per_thread : samples) all.insert(all.end(), per_thread.begin(), per_thread.end());
+        std::sort(all.begin(), all.end());
+        auto percentile_ns = [&](double p) {
+            return all[static_cast<std::size_t>(p * (all.size() - 1))] * tsc_clock::ns_per_tick();
+        };
+        std::cout << "  " << std::left << std::setw(22) << name << std::right << std::fixed << std::setprecision(1)
+                  << "median " << percentile_ns(0.5) << " ns, p99 " << percentile_ns(0.99) << " ns, p99.9 "
+                  << percentile_ns(0.999) << " ns; callers done in " << std::setprecision(3) << callers.count()
+                  << " s, written in " << total.count() << " s" << std::defaultfloat << std::setprecision(6)
+                  << "\n";
+    };
+
+    std::mutex stream_mutex;
+    run(
+        "mutex + ostream",
+        [&](int t, int i) {
+            std::lock_guard<std::mutex> lock(stream_mutex);
+            null_sink << "Thread " << t << " line " << i << " value " << i * 0.5 << "\n";
+        },
+        [&] { null_sink.flush(); });
+
+    for (log_overflow overflow : {log_overflow::drop, log_overflow::block}) {
+        async_logger_options options;
+        options.sink = &null_sink;
+        options.overflow = overflow;
+        async_logger logger(options);
+        run(
+            overflow == log_overflow::drop ? "async_logger (drop)" : "async_logger (block)",
+            [&](int t, int i) { logger.info("Thread {} line {} value {}", t, i, i * 0.5); },
+            [&] { logger.flush(); });
+        std::cout << "    " << logger.written() << " written, " << logger.dropped() << " dropped\n";
+    }
 }
 
 // Example of using thread pool (simple implementation)
@@ -27,31 +140,173 @@ void worker_task(int id) {
     std::cout << "Worker thread " << id << " finished work\n";
 }
 
-// Function to demonstrate a simple thread pool
+// Function to demonstrate a thread pool: the workers are created once and reused
+// for every task, instead of creating and joining a std::thread per task
 void thread_pool_example(int num_threads) {
     std::cout << "Starting thread pool example with " << num_threads << " threads\n";
-    std::vector<std::thread> thread_pool;
+    thread_pool pool(num_threads);
+
+    std::vector<std::future<void>> results;
     for (int i = 0; i < num_threads; ++i) {
-        thread_pool.push_back(std::thread(worker_task, i));
+        results.push_back(pool.submit(worker_task, i));
     }
 
-    // Wait for all threads to finish
-    for (auto& t : thread_pool) {
-        t.join();
+    // Wait for all tasks to finish (the workers stay alive for more work)
+    for (auto& result : results) {
+        result.get();
     }
+
+    // Tasks can return values through their futures
+    std::future<int> answer = pool.submit([](int a, int b) { return a * b; }, 6, 7);
+    std::cout << "Pool computed " << answer.get() << "\n";
     std::cout << "Thread pool example finished\n";
 }
 
-// Function to demonstrate atomic operations
+// Busy work of roughly one microsecond, the kind of task a pool should make cheap
+void microsecond_task() {
+    auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(1);
+    while (std::chrono::steady_clock::now() < until) {
+    }
+}
+
+void print_tasks_per_second(const char* name, int tasks, std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "  " << name << ": " << elapsed.count() << " seconds, "
+              << static_cast<long long>(tasks / elapsed.count()) << " tasks/sec\n";
+}
+
+// Function to compare the throughput of different ways to run many tiny tasks
+void thread_pool_benchmark(int num_threads) {
+    const int TASKS = 20000;
+    std::cout << "Thread pool benchmark: " << TASKS << " tasks of ~1us on " << num_threads << " threads\n";
+
+    // The old thread_pool_example approach: one new std::thread per task, in batches
+    auto start = std::chrono::steady_clock::now();
+    for (int done = 0; done < TASKS; done += num_threads) {
+        std::vector<std::thread> batch;
+        for (int i = 0; i < num_threads; ++i) {
+            batch.push_back(std::thread(microsecond_task));
+        }
+        for (auto& t : batch) {
+            t.join();
+        }
+    }
+    print_tasks_per_second("thread per task", TASKS, start);
+
+    // std::async with launch::async also starts a thread per call
+    start = std::chrono::steady_clock::now();
+    for (int done = 0; done < TASKS; done += num_threads) {
+        std::vector<std::future<void>> batch;
+        for (int i = 0; i < num_threads; ++i) {
+            batch.push_back(std::async(std::launch::async, microsecond_task));
+        }
+        for (auto& f : batch) {
+            f.get();
+        }
+    }
+    print_tasks_per_second("std::async", TASKS, start);
+
+    thread_pool pool(num_threads);
+
+    // One future per task
+    start = std::chrono::steady_clock::now();
+    std::vector<std::future<void>> futures;
+    futures.reserve(TASKS);
+    for (int i = 0; i < TASKS; ++i) {
+        futures.push_back(pool.submit(microsecond_task));
+    }
+    for (auto& f : futures) {
+        f.get();
+    }
+    print_tasks_per_second("thread_pool::submit", TASKS, start);
+
+    // All tasks enqueued at once with a single future for the whole batch
+    start = std::chrono::steady_clock::now();
+    pool.bulk(TASKS, [](std::size_t) { microsecond_task(); }).get();
+    print_tasks_per_second("thread_pool::bulk", TASKS, start);
+
+    // Tasks spawned from inside the pool land on the worker's own deque and are stolen
+    start = std::chrono::steady_clock::now();
+    pool.submit([&pool] {
+        for (int i = 0; i < TASKS; ++i) {
+            pool.post(microsecond_task);
+        }
+    }).get();
+    while (pool.try_run_one()) {
+    }
+    pool.shutdown();  // Finishes every queued task before returning
+    print_tasks_per_second("nested post + stealing", TASKS, start);
+
+    uint64_t stolen = 0;
+    for (const auto& s : pool.stats()) {
+        stolen += s.stolen;
+    }
+    std::cout << "  tasks stolen between workers: " << stolen << "\n";
+}
+
+// Function to compare pinned and unpinned workers on a memory-bound job. Each
+// worker sweeps its own buffer, allocated first-touch by that worker so the
+// pages sit on its node; an unpinned worker can be moved away from them.
+void placement_benchmark(int num_threads) {
+    const cpu_topology& topology = cpu_topology::system();
+    const std::size_t WORDS = 1 << 20;  // 8 MiB per worker, more than a core's cache
+    const int SWEEPS = 32;              // Per worker
+    std::cout << "Placement benchmark: " << num_threads << " workers on " << topology.cpu_count() << " CPUs, "
+              << topology.core_count() << " cores, " << topology.node_count() << " NUMA node(s)\n";
+
+    const std::pair<const char*, thread_placement> placements[] = {{"unpinned", thread_placement::none},
+                                                                   {"compact", thread_placement::compact},
+                                                                   {"spread", thread_placement::spread}};
+    for (const auto& [name, placement] : placements) {
+        std::vector<first_touch_buffer<uint64_t>> buffers(num_threads);
+        std::vector<int> home_cpu(num_threads, -1);
+        std::atomic<int> moved{0};
+
+        thread_pool_options options;
+        options.threads = num_threads;
+        options.placement = placement;
+        options.on_worker_start = [&](std::size_t i) {
+            buffers[i] = first_touch_buffer<uint64_t>(WORDS);
+            for (std::size_t w = 0; w < WORDS; ++w) buffers[i][w] = w;
+            home_cpu[i] = current_cpu();
+        };
+        thread_pool pool(options);
+
+        auto start = std::chrono::steady_clock::now();
+        pool.bulk(num_threads * SWEEPS, [&](std::size_t) {
+            int self = pool.current_worker_index();
+            uint64_t sum = 0;
+            for (uint64_t value : buffers[self]) sum += value;
+            do_not_optimize(sum);
+            if (current_cpu() != home_cpu[self]) moved.fetch_add(1, std::memory_order_relaxed);
+        }).get();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        uint64_t stolen = 0, remote = 0;
+        for (const auto& s : pool.stats()) {
+            stolen += s.stolen;
+            remote += s.stolen_remote;
+        }
+        double bytes = static_cast<double>(num_threads) * SWEEPS * WORDS * sizeof(uint64_t);
+        std::cout << "  " << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(4)
+                  << elapsed.count() << " seconds, " << std::setprecision(2) << bytes / elapsed.count() / 1e9
+                  << " GB/s, " << moved.load() << " sweeps away from the worker's first CPU, " << stolen
+                  << " steals (" << remote << " cross-node)" << std::defaultfloat << std::setprecision(6) << "\n";
+    }
+}
+
+// Function to demonstrate atomic operations. Ten threads hammering one
+// std::atomic<int> all fight over the same cache line; a sharded counter gives
+// each thread its own line and only adds the shards up when read.
 void atomic_operations() {
-    std::atomic<int> counter(0);
+    sharded_counter counter;
 
-    // Launching multiple threads to increment the atomic counter
+    // Launching multiple threads to increment the sharded counter
     std::vector<std::thread> threads;
     for (int i = 0; i < 10; ++i) {
         threads.push_back(std::thread([&counter]() {
             for (int j = 0; j < 1000; ++j) {
-                counter++;
+                counter.increment();  // Relaxed add on this thread's own shard
             }
         }));
     }
@@ -61,31 +316,776 @@ void atomic_operations() {
         t.join();
     }
 
-    std::cout << "Final atomic counter value: " << counter.load() << "\n";
+    std::cout << "Final atomic counter value: " << counter.read() << "\n";
+}
+
+// Increments per second for `threads` threads sharing one counter
+template <typename Counter, typename Increment>
+double counter_increments_per_second(int threads, long long per_thread, Counter& counter, Increment increment) {
+    std::vector<std::thread> workers;
+    std::atomic<bool> go{false};
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&] {
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (long long j = 0; j < per_thread; ++j) {
+                increment(counter);
+            }
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& t : workers) {
+        t.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return threads * per_thread / elapsed.count();
+}
+
+// Function to compare counter designs from 1 thread up to 2x the hardware threads
+void counter_scaling_benchmark() {
+    const long long PER_THREAD = 2000000;
+    int max_threads = static_cast<int>(std::max(4u, 2 * std::thread::hardware_concurrency()));
+    std::cout << "Counter scaling benchmark (million increments/sec, " << PER_THREAD << " per thread, rseq "
+              << (percpu_counter::uses_rseq() ? "available" : "unavailable") << ")\n";
+    std::cout << "  threads   std::atomic   sharded_counter   percpu_counter\n";
+
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        std::atomic<long long> shared{0};
+        sharded_counter sharded;
+        percpu_counter percpu;
+        double shared_rate = counter_increments_per_second(threads, PER_THREAD, shared, [](auto& c) { c++; });
+        double sharded_rate = counter_increments_per_second(threads, PER_THREAD, sharded, [](auto& c) { c.increment(); });
+        double percpu_rate = counter_increments_per_second(threads, PER_THREAD, percpu, [](auto& c) { c.increment(); });
+
+        long long expected = threads * PER_THREAD;
+        bool correct = shared.load() == expected && sharded.read() == expected && percpu.read() == expected;
+        std::cout << "  " << std::setw(7) << threads << std::fixed << std::setprecision(1) << std::setw(14)
+                  << shared_rate / 1e6 << std::setw(18) << sharded_rate / 1e6 << std::setw(17) << percpu_rate / 1e6
+                  << (correct ? "" : "  (COUNT MISMATCH)") << std::defaultfloat << std::setprecision(6) << "\n";
+    }
+}
+
+// A small piece of shared state that is read far more often than it is written.
+// Writers keep value == 2 * updates, so a torn read would be easy to spot.
+struct resource_snapshot {
+    long long value = 0;
+    long long updates = 0;
+    int last_writer = -1;
+};
+
+// Function to demonstrate a seqlock: readers take consistent snapshots without
+// locking, writers publish whole-struct updates
+void seqlock_example() {
+    seqlock<resource_snapshot> snapshot;
+    std::atomic<bool> writing{true};
+    std::atomic<long long> torn_reads{0};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&] {
+            while (writing.load(std::memory_order_relaxed)) {
+                resource_snapshot s = snapshot.load();  // Never blocks a writer, never writes shared memory
+                if (s.value != 2 * s.updates) torn_reads.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    std::vector<std::thread> writers;
+    for (int id = 0; id < 2; ++id) {
+        writers.emplace_back([&snapshot, id] {
+            for (int i = 0; i < 10000; ++i) {
+                snapshot.update([id](resource_snapshot& s) {
+                    s.value += 2;
+                    s.updates++;
+                    s.last_writer = id;
+                });
+            }
+        });
+    }
+    for (auto& t : writers) {
+        t.join();
+    }
+    writing.store(false);
+    for (auto& t : readers) {
+        t.join();
+    }
+
+    resource_snapshot last = snapshot.load();
+    std::cout << "Seqlock snapshot: value " << last.value << " after " << last.updates << " updates (last by writer "
+              << last.last_writer << "), torn reads seen: " << torn_reads.load() << "\n";
+}
+
+// Reads per second for `readers` threads while one writer updates every ~20us
+template <typename Read, typename Write>
+double reads_per_second(int readers, Read read, Write write) {
+    const auto RUN_TIME = std::chrono::milliseconds(200);
+    std::atomic<bool> go{false};
+    std::atomic<bool> stop{false};
+    std::atomic<long long> total_reads{0};
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < readers; ++i) {
+        threads.emplace_back([&] {
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            long long reads = 0;
+            long long checksum = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                checksum += read().value;
+                ++reads;
+            }
+            total_reads.fetch_add(reads, std::memory_order_relaxed);
+            do_not_optimize(checksum);
+        });
+    }
+    threads.emplace_back([&] {
+        while (!go.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        while (!stop.load(std::memory_order_relaxed)) {
+            write();
+            std::this_thread::sleep_for(std::chrono::microseconds(20));
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(RUN_TIME);
+    stop.store(true);
+    for (auto& t : threads) {
+        t.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return total_reads.load() / elapsed.count();
+}
+
+// Function to compare snapshot reads through a mutex, a shared_mutex and a seqlock
+// from 1 reader up to 2x the hardware threads, with one writer running throughout
+void seqlock_scaling_benchmark() {
+    int max_readers = static_cast<int>(std::max(4u, 2 * std::thread::hardware_concurrency()));
+    std::cout << "Reader scaling benchmark (million snapshot reads/sec, one writer)\n";
+    std::cout << "  readers    std::mutex   std::shared_mutex   seqlock\n";
+
+    auto bump = [](resource_snapshot& s) {
+        s.value += 2;
+        s.updates++;
+    };
+    for (int readers = 1; readers <= max_readers; readers *= 2) {
+        resource_snapshot locked_state;
+        std::mutex mutex;
+        double mutex_rate = reads_per_second(
+            readers,
+            [&] {
+                std::lock_guard<std::mutex> lock(mutex);
+                return locked_state;
+            },
+            [&] {
+                std::lock_guard<std::mutex> lock(mutex);
+                bump(locked_state);
+            });
+
+        resource_snapshot shared_state;
+        std::shared_mutex shared_mutex;
+        double shared_rate = reads_per_second(
+            readers,
+            [&] {
+                std::shared_lock<std::shared_mutex> lock(shared_mutex);  // Still a locked add on a shared line
+                return shared_state;
+            },
+            [&] {
+                std::unique_lock<std::shared_mutex> lock(shared_mutex);
+                bump(shared_state);
+            });
+
+        seqlock<resource_snapshot> sequenced;
+        double seqlock_rate = reads_per_second(
+            readers, [&] { return sequenced.load(); }, [&] { sequenced.update(bump); });
+
+        std::cout << "  " << std::setw(7) << readers << std::fixed << std::setprecision(1) << std::setw(14)
+                  << mutex_rate / 1e6 << std::setw(20) << shared_rate / 1e6 << std::setw(10) << seqlock_rate / 1e6
+                  << std::defaultfloat << std::setprecision(6) << "\n";
+    }
 }
 
-// Function to demonstrate condition variables for thread synchronization
-void producer(std::vector<int>& buffer, std::mutex& mtx, std::condition_variable& cv) {
+// Function to demonstrate the timer wheel: the same "finish after 500 ms" as
+// worker_task, but no thread sleeps while the timers are pending
+void timer_wheel_example(int num_timers) {
+    thread_pool pool(2);
+    timer_wheel_options options;
+    options.pool = &pool;
+    timer_wheel timers(options);
+
+    std::atomic<int> finished{0};
+    std::vector<timer_id> ids;
+    for (int i = 0; i < num_timers; ++i) {
+        ids.push_back(timers.schedule_after(std::chrono::milliseconds(500), [i, &finished] {
+            std::lock_guard<profiled_mutex> guard(mtx);
+            std::cout << "Timer " << i << " finished work\n";
+            finished++;
+        }));
+    }
+    bool cancelled = timers.cancel(ids.back());  // O(1), no scan of the pending timers
+    std::cout << "Timer " << num_timers - 1 << (cancelled ? " cancelled" : " already fired") << ", "
+              << timers.pending() << " pending\n";
+    while (timers.pending() > 0 || finished < num_timers - (cancelled ? 1 : 0)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+// One million concurrent timers: insert and cancel cost, memory, and how late
+// the callbacks run compared to their deadlines
+void timer_wheel_benchmark(std::chrono::nanoseconds tick, const char* tick_name) {
+    const int TIMERS = 1000000;
+    const int SPREAD_MS = 1000;  // Deadlines spread over one second
+    thread_pool pool(4);
+    timer_wheel_options options;
+    options.tick = tick;
+    options.pool = &pool;
+    timer_wheel timers(options);
+
+    // Shared context keeps each callback's captures small enough for std::function's inline buffer
+    struct context {
+        std::vector<timer_wheel::clock::time_point> deadlines;
+        std::vector<int64_t> lateness_ns;
+        std::atomic<int> fired{0};
+    } ctx;
+    ctx.deadlines.resize(TIMERS);
+    ctx.lateness_ns.resize(TIMERS);
+    context* shared = &ctx;
+
+    std::vector<timer_id> ids(TIMERS);
+    auto base = timer_wheel::clock::now() + std::chrono::milliseconds(500);  // Inserting takes a while
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < TIMERS; ++i) {
+        // Spread deadlines evenly, with a stride so neighbours do not share slots
+        auto offset = std::chrono::microseconds((static_cast<long long>(i) * 7919 % TIMERS) * SPREAD_MS * 1000 / TIMERS);
+        ctx.deadlines[i] = base + offset;
+        ids[i] = timers.schedule_at(ctx.deadlines[i], [shared, i] {
+            shared->lateness_ns[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         timer_wheel::clock::now() - shared->deadlines[i])
+                                         .count();
+            shared->fired.fetch_add(1, std::memory_order_release);
+        });
+    }
+    std::chrono::duration<double> insert_time = std::chrono::steady_clock::now() - start;
+    std::size_t memory = timers.memory_bytes();
+
+    // Cancel every tenth timer
+    start = std::chrono::steady_clock::now();
+    int cancelled = 0;
+    for (int i = 0; i < TIMERS; i += 10) {
+        cancelled += timers.cancel(ids[i]) ? 1 : 0;
+    }
+    std::chrono::duration<double> cancel_time = std::chrono::steady_clock::now() - start;
+
+    while (ctx.fired.load(std::memory_order_acquire) < TIMERS - cancelled) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    std::vector<int64_t> lateness;
+    lateness.reserve(TIMERS);
+    for (int i = 0; i < TIMERS; ++i) {
+        if (i % 10 != 0) lateness.push_back(ctx.lateness_ns[i]);
+    }
+    std::sort(lateness.begin(), lateness.end());
+    auto percentile_us = [&](double p) {
+        return lateness[static_cast<std::size_t>(p * (lateness.size() - 1))] / 1000.0;
+    };
+    std::cout << "Timer wheel, " << tick_name << " ticks: " << TIMERS << " timers over " << SPREAD_MS << " ms\n"
+              << std::fixed << std::setprecision(1) << "  insert: " << insert_time.count() * 1e9 / TIMERS
+              << " ns/timer, cancel: " << cancel_time.count() * 1e9 / (TIMERS / 10) << " ns/timer\n"
+              << "  memory: " << memory / (1024.0 * 1024.0) << " MiB (" << memory / TIMERS
+              << " bytes/timer); a sleeping thread per timer would reserve "
+              << TIMERS * 8.0 / 1024.0 << " GiB of stack\n"
+              << "  lateness: min " << percentile_us(0.0) << " us, median " << percentile_us(0.5) << " us, p99 "
+              << percentile_us(0.99) << " us, max " << percentile_us(1.0) << " us" << std::defaultfloat
+              << std::setprecision(6) << "\n";
+}
+
+// Busy work whose cost grows with i: row i of a triangular loop nest
+long long triangular_row(std::size_t i) {
+    long long sum = 0;
+    for (std::size_t j = 0; j <= i; ++j) {
+        sum += static_cast<long long>(i ^ j);
+    }
+    do_not_optimize(sum);
+    return sum;
+}
+
+// Function to compare loop schedules on uneven work, show nesting, and report
+// how the deterministic and fast reductions behave
+void parallel_for_example() {
+    const std::size_t ROWS = 20000;
+    std::cout << "parallel_for on a triangular loop (" << ROWS << " rows, cost grows with the row)\n";
+    const std::pair<const char*, loop_schedule> schedules[] = {{"static_blocks", loop_schedule::static_blocks},
+                                                                {"dynamic", loop_schedule::dynamic},
+                                                                {"guided", loop_schedule::guided}};
+    for (const auto& [name, schedule] : schedules) {
+        std::atomic<long long> total{0};
+        auto start = std::chrono::steady_clock::now();
+        parallel_for(
+            {0, ROWS}, 64,
+            [&](index_range rows) {
+                long long local = 0;
+                for (std::size_t i = rows.begin; i < rows.end; ++i) local += triangular_row(i);
+                total.fetch_add(local, std::memory_order_relaxed);
+            },
+            schedule);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "  " << std::left << std::setw(14) << name << std::right << elapsed.count() << " seconds\n";
+    }
+
+    // Nested loops share the same workers: the inner loops only spread onto idle ones
+    std::atomic<long long> cells{0};
+    parallel_for({0, 100}, 1, [&](std::size_t) {
+        parallel_for({0, 1000}, 100, [&](index_range r) { cells.fetch_add(r.size(), std::memory_order_relaxed); });
+    });
+    std::cout << "  nested parallel_for visited " << cells.load() << " cells\n";
+
+    // A float sum depends on the order of additions: only the deterministic mode
+    // gives the same bits on every run and every thread count
+    std::vector<float> values(1 << 22);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        values[i] = 1.0f / static_cast<float>(i % 1000 + 1);
+    }
+    auto sum_range = [&](index_range r, float acc) {
+        for (std::size_t i = r.begin; i < r.end; ++i) acc += values[i];
+        return acc;
+    };
+    for (reduce_mode mode : {reduce_mode::deterministic, reduce_mode::fast}) {
+        std::cout << "  " << (mode == reduce_mode::deterministic ? "deterministic" : "fast") << " sums:";
+        for (int run = 0; run < 3; ++run) {
+            float sum = parallel_reduce({0, values.size()}, 1 << 14, 0.0f, sum_range, std::plus<>(), mode);
+            std::cout << " " << std::setprecision(9) << sum;
+        }
+        std::cout << std::setprecision(6) << "\n";
+    }
+
+    std::cout << "  scaling of the triangular loop (dynamic schedule):\n";
+    std::vector<scaling_point> points =
+        measure_scaling(std::max(4u, std::thread::hardware_concurrency()), [&](thread_pool& pool) {
+            parallel_for({0, ROWS}, 64, [](std::size_t i) { triangular_row(i); }, loop_schedule::dynamic, pool);
+        });
+    print_scaling_report(std::cout, points);
+}
+
+// Busy-wait for a while: stands in for a step of a batch job
+void simulated_step(std::chrono::microseconds duration) {
+    auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end) {
+    }
+}
+
+// Function to run a batch job as a task graph instead of fire-and-join:
+//   load -> {parse_left, parse_right} -> merge -> validate --(retry)--> merge
+//                                                          \--(ok)--> publish (subgraph)
+// The graph is built once and run many times; the validation fails twice
+// per run to show a conditional loop.
+void task_graph_example() {
+    using std::chrono::microseconds;
+    task_graph publish("publish");
+    graph_task compress = publish.emplace("compress", [] { simulated_step(microseconds(300)); });
+    graph_task index = publish.emplace("index", [] { simulated_step(microseconds(200)); });
+    graph_task upload = publish.emplace("upload", [] { simulated_step(microseconds(100)); });
+    upload.succeed(compress, index);
+
+    task_graph job("batch job");
+    int attempts = 0;
+    graph_task load = job.emplace("load", [&] {
+        attempts = 0;
+        simulated_step(microseconds(200));
+    });
+    graph_task left = job.emplace("parse_left", [] { simulated_step(microseconds(800)); });
+    graph_task right = job.emplace("parse_right", [] { simulated_step(microseconds(400)); });
+    graph_task merge = job.emplace("merge", [] { simulated_step(microseconds(150)); });
+    graph_task validate = job.emplace_condition("validate", [&] { return ++attempts < 3 ? 0 : 1; });
+    graph_task publish_step = job.emplace_subgraph("publish", publish);
+    load.precede(left, right);         // Both parsers need the loaded input
+    merge.succeed(left, right);        // merge needs both parsers
+    merge.precede(validate);
+    validate.precede(merge, publish_step);  // 0: merge again, 1: publish
+
+    const int RUNS = 50;
+    auto start = std::chrono::steady_clock::now();
+    job.run_n(RUNS);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Task graph ran " << RUNS << " times in " << elapsed.count() << " seconds (" << attempts
+              << " validation attempts in the last run)\n";
+    job.print_timing(std::cout);
+    job.print_critical_path(std::cout);
+    publish.print_critical_path(std::cout);
+}
+
+// Producer/consumer through a bounded lock-free queue. Items come out in the
+// order they went in (FIFO); a vector with back()/pop_back() hands them out LIFO.
+void producer(mpmc_queue<int>& queue) {
     for (int i = 0; i < 5; ++i) {
         std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        queue.push(i);  // Wakes a sleeping consumer, no mutex or notify_all needed
+        std::cout << "Produced " << i << "\n";
+    }
+}
+
+void consumer(mpmc_queue<int>& queue) {
+    for (int i = 0; i < 5; ++i) {
+        int data = queue.pop();  // Spins briefly, then sleeps on a futex until an item arrives
+        std::cout << "Consumed " << data << "\n";
+    }
+}
+
+// The classic mutex + condition_variable queue, kept as the benchmark baseline
+template <typename T>
+class locked_queue {
+public:
+    explicit locked_queue(std::size_t capacity) : capacity_(capacity) {}
+
+    void push(T value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return items_.size() < capacity_; });
+        items_.push_back(std::move(value));
+        lock.unlock();
+        not_empty_.notify_one();
+    }
+
+    T pop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return !items_.empty(); });
+        T value = std::move(items_.front());
+        items_.pop_front();
+        lock.unlock();
+        not_full_.notify_one();
+        return value;
+    }
+
+private:
+    std::size_t capacity_;
+    std::deque<T> items_;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+};
+
+// Run `producers` threads pushing and `consumers` threads popping `items` values in
+// total and report queue operations (one push + one pop per item) per second
+template <typename Push, typename Pop>
+void run_queue_benchmark(const char* name, int producers, int consumers, long long items, Push push, Pop pop) {
+    std::atomic<long long> checksum{0};
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([=] {
+            for (long long i = p; i < items; i += producers) push(i);
+        });
+    }
+    for (int c = 0; c < consumers; ++c) {
+        long long share = items / consumers + (c < items % consumers ? 1 : 0);
+        threads.emplace_back([=, &checksum] {
+            long long sum = 0;
+            for (long long i = 0; i < share; ++i) sum += pop();
+            checksum.fetch_add(sum, std::memory_order_relaxed);
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    bool correct = checksum.load() == items * (items - 1) / 2;  // Every value popped exactly once
+    std::cout << "  " << name << ": " << elapsed.count() << " seconds, "
+              << static_cast<long long>(2 * items / elapsed.count()) << " ops/sec"
+              << (correct ? "" : "  (CHECKSUM MISMATCH)") << "\n";
+}
+
+// Function to compare the lock-free queue with the mutex-based queue under contention
+void mpmc_queue_benchmark(int producers, int consumers) {
+    const long long ITEMS = 2000000;
+    const std::size_t CAPACITY = 1024;
+    std::cout << "MPMC queue benchmark: " << producers << " producers, " << consumers << " consumers, "
+              << ITEMS << " items, capacity " << CAPACITY << "\n";
+
+    locked_queue<long long> locked(CAPACITY);
+    run_queue_benchmark("mutex + condition_variable", producers, consumers, ITEMS,
+                        [&](long long v) { locked.push(v); }, [&] { return locked.pop(); });
+
+    mpmc_queue<long long> queue(CAPACITY);
+    run_queue_benchmark("mpmc_queue push/pop", producers, consumers, ITEMS,
+                        [&](long long v) { queue.push(v); }, [&] { return queue.pop(); });
+
+    // Bulk transfer: each CAS moves up to 32 items
+    const long long BATCH = 32;
+    std::atomic<long long> checksum{0};
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            long long batch[BATCH];
+            std::size_t n = 0;
+            for (long long i = p; i < ITEMS; i += producers) {
+                batch[n++] = i;
+                if (n == BATCH) {
+                    queue.push_bulk(batch, n);
+                    n = 0;
+                }
+            }
+            queue.push_bulk(batch, n);
+        });
+    }
+    for (int c = 0; c < consumers; ++c) {
+        long long share = ITEMS / consumers + (c < ITEMS % consumers ? 1 : 0);
+        threads.emplace_back([&, share] {
+            long long batch[BATCH];
+            long long sum = 0;
+            for (long long taken = 0; taken < share;) {
+                std::size_t n = queue.pop_bulk(batch, static_cast<std::size_t>(std::min(BATCH, share - taken)));
+                for (std::size_t i = 0; i < n; ++i) sum += batch[i];
+                taken += static_cast<long long>(n);
+            }
+            checksum.fetch_add(sum, std::memory_order_relaxed);
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    bool correct = checksum.load() == ITEMS * (ITEMS - 1) / 2;
+    std::cout << "  mpmc_queue push_bulk/pop_bulk: " << elapsed.count() << " seconds, "
+              << static_cast<long long>(2 * ITEMS / elapsed.count()) << " ops/sec"
+              << (correct ? "" : "  (CHECKSUM MISMATCH)") << "\n";
+}
+
+// The producer/consumer pair again, written in the same blocking style but as
+// fibers: a full or empty channel suspends only the fiber, never a worker thread
+void fiber_producer(fiber_channel<int>& channel) {
+    for (int i = 0; i < 5; ++i) {
+        this_fiber::sleep_for(std::chrono::milliseconds(100));  // The worker runs other fibers meanwhile
+        channel.push(i);
+        std::cout << "Fiber produced " << i << "\n";
+    }
+    channel.close();
+}
+
+void fiber_consumer(fiber_channel<int>& channel) {
+    while (std::optional<int> data = channel.pop()) {  // Ends once the channel is closed and empty
+        std::cout << "Fiber consumed " << *data << "\n";
+    }
+}
+
+// Resident set size in bytes, read from /proc/self/statm
+std::size_t resident_bytes() {
+    std::ifstream statm("/proc/self/statm");
+    std::size_t pages_total = 0, pages_resident = 0;
+    statm >> pages_total >> pages_resident;
+    return pages_resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+}
+
+// Function to measure fiber switches, 10^5 blocked fibers and channel throughput
+void fiber_benchmark(int num_threads) {
+    std::cout << "Fiber benchmark on " << num_threads << " workers\n";
+    auto seconds_since = [](std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    // Two fibers yielding to each other on one worker: each yield switches to
+    // the worker and from there to the other fiber
+    {
+        const int YIELDS = 1000000;
+        fiber_scheduler single(1);
+        auto start = std::chrono::steady_clock::now();
+        for (int f = 0; f < 2; ++f) {
+            single.spawn([] {
+                for (int i = 0; i < YIELDS; ++i) this_fiber::yield();
+            });
+        }
+        single.wait();
+        std::cout << "  yield: " << seconds_since(start) * 1e9 / (4.0 * YIELDS) << " ns per context switch\n";
+    }
+
+    // Ping-pong through two capacity-1 queues: fibers on one worker vs two threads
+    {
+        const int ROUNDS = 100000;
+        fiber_scheduler single(1);
+        fiber_channel<int> ping(1), pong(1);
+        auto start = std::chrono::steady_clock::now();
+        single.spawn([&] {
+            for (int i = 0; i < ROUNDS; ++i) {
+                ping.push(i);
+                pong.pop();
+            }
+        });
+        single.spawn([&] {
+            for (int i = 0; i < ROUNDS; ++i) {
+                ping.pop();
+                pong.push(i);
+            }
+        });
+        single.wait();
+        std::cout << "  fiber_channel ping-pong: " << seconds_since(start) * 1e9 / ROUNDS << " ns per round trip\n";
+
+        locked_queue<int> thread_ping(1), thread_pong(1);
+        start = std::chrono::steady_clock::now();
+        std::thread echo([&] {
+            for (int i = 0; i < ROUNDS; ++i) thread_pong.push(thread_ping.pop());
+        });
+        for (int i = 0; i < ROUNDS; ++i) {
+            thread_ping.push(i);
+            thread_pong.pop();
+        }
+        echo.join();
+        std::cout << "  thread + condition_variable ping-pong: " << seconds_since(start) * 1e9 / ROUNDS
+                  << " ns per round trip\n";
+    }
+
+    fiber_scheduler scheduler(static_cast<std::size_t>(num_threads));
+
+    // 10^5 fibers that all block on one condition, then are released together.
+    // As threads this would reserve 100000 x 8 MiB of stack and 100000 kernel tasks.
+    const int FIBERS = 100000;
+    for (int round = 0; round < 2; ++round) {  // The second round reuses the pooled stacks
+        fiber_mutex mutex;
+        fiber_condition_variable released;
+        bool go = false;
+        long long finished = 0;
+        std::atomic<int> waiting{0};
+        std::size_t rss_before = resident_bytes();
+        // stats().switches is cumulative: the previous round's starts and wake-ups are already in it
+        const uint64_t switches_before = scheduler.stats().switches;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < FIBERS; ++i) {
+            scheduler.spawn([&] {
+                std::unique_lock<fiber_mutex> lock(mutex);
+                waiting.fetch_add(1, std::memory_order_relaxed);  // go stays false until all are counted
+                released.wait(lock, [&] { return go; });
+                ++finished;
+            });
+        }
+        double spawn_seconds = seconds_since(start);
+        // Until every fiber has started and blocked. A resumption can also be a
+        // fiber_mutex hand-off, so the switch count alone could end this early.
+        while (scheduler.stats().switches < switches_before + FIBERS ||
+               waiting.load(std::memory_order_relaxed) < FIBERS) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::size_t rss_blocked = resident_bytes();
+        auto release = std::chrono::steady_clock::now();
         {
-            std::lock_guard<std::mutex> lock(mtx);
-            buffer.push_back(i);
-            std::cout << "Produced " << i << "\n";
+            std::lock_guard<fiber_mutex> lock(mutex);
+            go = true;
         }
-        cv.notify_all();  // Notify the consumer that data is available
+        released.notify_all();
+        scheduler.wait();
+        std::cout << "  " << FIBERS << " blocked fibers (" << (round == 0 ? "new" : "pooled")
+                  << " stacks): spawn " << spawn_seconds * 1e9 / FIBERS << " ns each, "
+                  << (rss_blocked - std::min(rss_blocked, rss_before)) / FIBERS << " bytes resident each, all released in "
+                  << seconds_since(release) * 1000 << " ms, " << finished << " finished\n";
+    }
+    fiber_scheduler::statistics stats = scheduler.stats();
+    std::cout << "  stacks: " << stats.stacks_guarded << " with guard page, " << stats.stacks_unguarded
+              << " without (vm.max_map_count limit); " << stats.stolen << " fibers stolen\n";
+
+    // Many producer and consumer fibers sharing one channel
+    const int PRODUCERS = 8, CONSUMERS = 8;
+    const long long ITEMS = 1000000;
+    fiber_channel<long long> channel(1024);
+    std::atomic<int> producers_left{PRODUCERS};
+    std::atomic<long long> checksum{0};
+    auto start = std::chrono::steady_clock::now();
+    for (int p = 0; p < PRODUCERS; ++p) {
+        scheduler.spawn([&, p] {
+            for (long long i = p; i < ITEMS; i += PRODUCERS) channel.push(i);
+            if (producers_left.fetch_sub(1) == 1) channel.close();
+        });
     }
+    for (int c = 0; c < CONSUMERS; ++c) {
+        scheduler.spawn([&] {
+            long long sum = 0;
+            while (std::optional<long long> v = channel.pop()) sum += *v;
+            checksum.fetch_add(sum, std::memory_order_relaxed);
+        });
+    }
+    scheduler.wait();
+    double elapsed = seconds_since(start);
+    std::cout << "  fiber_channel " << PRODUCERS << " -> " << CONSUMERS << " fibers: "
+              << static_cast<long long>(2 * ITEMS / elapsed) << " ops/sec"
+              << (checksum.load() == ITEMS * (ITEMS - 1) / 2 ? "" : "  (CHECKSUM MISMATCH)") << "\n";
 }
 
-void consumer(std::vector<int>& buffer, std::mutex& mtx, std::condition_variable& cv) {
-    for (int i = 0; i < 5; ++i) {
-        std::unique_lock<std::mutex> lock(mtx);
-        cv.wait(lock, [&buffer]() { return !buffer.empty(); });
+// One parsed input line of the pipeline example
+struct sensor_reading {
+    long id = 0;
+    int sensor = 0;
+    double celsius = 0;
+};
 
-        int data = buffer.back();
-        buffer.pop_back();
-        std::cout << "Consumed " << data << "\n";
+// read -> parse -> transform -> aggregate -> write, once per mode. The source
+// stands in for reading a file and the write stage appends to a string.
+void pipeline_example() {
+    const long LINES = 200000;
+    std::cout << "Pipeline example: " << LINES << " CSV lines through 5 stages\n";
+
+    pipeline_report last;
+    for (pipeline_order order : {pipeline_order::unordered, pipeline_order::ordered}) {
+        for (std::size_t batch : {1, 64}) {
+            pipeline_options options;
+            options.order = order;
+            options.batch_size = batch;
+            options.channel_capacity = 256;
+
+            long next = 0;
+            double sums[8] = {};
+            long counts[8] = {};
+            std::string written;
+            bool in_order = true;
+            long last_id = -1;
+
+            pipeline p =
+                make_pipeline(
+                    "sensors",
+                    [&]() -> std::optional<std::string> {
+                        if (next == LINES) return std::nullopt;
+                        long id = next++;
+                        return std::to_string(id) + "," + std::to_string(id % 8) + "," + std::to_string(id % 400 / 10.0);
+                    },
+                    options)
+                    .then("parse", 2,
+                          [](std::string line) {
+                              sensor_reading r;
+                              std::size_t first = line.find(','), second = line.find(',', first + 1);
+                              r.id = std::stol(line.substr(0, first));
+                              r.sensor = std::stoi(line.substr(first + 1, second - first - 1));
+                              r.celsius = std::stod(line.substr(second + 1));
+                              return r;
+                          })
+                    .then("transform", 3,
+                          [](sensor_reading r) -> std::optional<sensor_reading> {
+                              if (r.celsius < 1.0) return std::nullopt;  // Drop implausible readings
+                              double smoothed = r.celsius;
+                              for (int i = 0; i < 200; ++i) smoothed = smoothed * 0.99 + r.celsius * 0.01;
+                              do_not_optimize(smoothed);
+                              r.celsius = smoothed;
+                              return r;
+                          })
+                    .then("aggregate", 1,
+                          [&](sensor_reading r) {
+                              in_order = in_order && r.id > last_id;
+                              last_id = r.id;
+                              sums[r.sensor] += r.celsius;
+                              ++counts[r.sensor];
+                              return std::to_string(r.id) + "," + std::to_string(sums[r.sensor] / counts[r.sensor]) + "\n";
+                          })
+                    .sink("write", 1, [&](std::string line) { written += line; });
+
+            last = p.run();
+            const pipeline_stage_report* bottleneck = last.bottleneck();
+            std::cout << "  " << (order == pipeline_order::ordered ? "ordered" : "unordered") << ", batch " << batch
+                      << ": " << static_cast<long long>(LINES / last.seconds) << " lines/sec, " << written.size()
+                      << " bytes written, " << (in_order ? "in source order" : "out of order") << ", bottleneck "
+                      << (bottleneck ? bottleneck->name : "-") << "\n";
+        }
     }
+    last.print(std::cout);
 }
 
 // Function to demonstrate async tasks with future and promise
@@ -114,36 +1114,242 @@ void async_example() {
     std::cout << "Async example finished\n";
 }
 
-int main() {
-    // Demonstrate thread-safe shared resource increment
-    std::cout << "Demonstrating thread-safe increment\n";
-    std::vector<std::thread> threads;
-    for (int i = 0; i < 5; ++i) {
-        threads.push_back(std::thread(thread_safe_increment, i));
+// The same producer/consumer hand-off as async_example, written with coroutines:
+// while the value is "being computed" no thread is blocked or sleeping, the
+// coroutine is parked in the timer service and resumed on a pool worker.
+task<int> compute_answer(pool_scheduler& sched, timer_service& timers) {
+    co_await sched.schedule();                                  // Continue on a pool thread
+    co_await timers.sleep_for(std::chrono::milliseconds(200));  // Suspends; no thread sleeps
+    co_return 42;
+}
+
+task<int> coroutine_main(pool_scheduler& sched, timer_service& timers) {
+    task<int> answer = compute_answer(sched, timers);
+    std::cout << "Coroutine doing some work while the answer is computed...\n";
+    co_return co_await answer;  // Suspends this coroutine, not a thread
+}
+
+void coroutine_async_example() {
+    std::cout << "Starting coroutine async example\n";
+    thread_pool pool(2);
+    pool_scheduler sched(pool);
+    timer_service timers(&sched);
+    int value = sync_wait(coroutine_main(sched, timers));  // Blocks only this demo's main thread
+    std::cout << "Coroutine result: " << value << "\n";
+    std::cout << "Coroutine async example finished\n";
+}
+
+// Leaf work for the fan-out/fan-in benchmark (a few microseconds)
+long long leaf_work(int seed) {
+    long long sum = 0;
+    for (int i = 0; i < 2000; ++i) {
+        sum += (seed * 31 + i) % 7;
     }
+    return sum;
+}
 
-    for (auto& t : threads) {
-        t.join();
+task<long long> leaf_task(pool_scheduler& sched, int seed) {
+    co_await sched.schedule();
+    co_return leaf_work(seed);
+}
+
+task<long long> fan_out_fan_in(pool_scheduler& sched, int count) {
+    std::vector<task<long long>> children;
+    children.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        children.push_back(leaf_task(sched, i));
+    }
+    long long total = 0;
+    for (long long value : co_await when_all(std::move(children))) {
+        total += value;
+    }
+    co_return total;
+}
+
+task<void> locked_increment(pool_scheduler& sched, async_mutex& mutex, long long& shared) {
+    co_await sched.schedule();
+    auto guard = co_await mutex.scoped_lock();
+    ++shared;
+}
+
+task<void> sleeper(timer_service& timers, std::chrono::milliseconds delay) {
+    co_await timers.sleep_for(delay);
+}
+
+// Holds the mutex until `gate` is released, so every queue_for_lock task
+// started after it queues up behind it
+task<void> lock_holder(async_mutex& mutex, async_semaphore& gate) {
+    auto guard = co_await mutex.scoped_lock();
+    co_await gate.acquire();
+}
+
+task<void> queue_for_lock(async_mutex& mutex, long long& shared) {
+    co_await mutex.lock();
+    ++shared;
+    mutex.unlock();  // Wakes the next waiter without nesting it on this stack
+}
+
+task<void> open_gate(async_semaphore& gate) {
+    gate.release();
+    co_return;
+}
+
+// Function to compare futures and coroutines for fan-out/fan-in workloads
+void coroutine_benchmark(int num_threads) {
+    const int FAN_OUT = 2000;
+    std::cout << "Fan-out/fan-in benchmark: " << FAN_OUT << " subtasks on " << num_threads << " threads\n";
+    long long expected = 0;
+    for (int i = 0; i < FAN_OUT; ++i) {
+        expected += leaf_work(i);
+    }
+
+    auto report = [&](const char* name, long long total, std::chrono::steady_clock::time_point start) {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "  " << name << ": " << elapsed.count() << " seconds, "
+                  << static_cast<long long>(FAN_OUT / elapsed.count()) << " subtasks/sec"
+                  << (total == expected ? "" : "  (WRONG RESULT)") << "\n";
+    };
+
+    // One std::async (one thread) per subtask
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::future<long long>> futures;
+    for (int i = 0; i < FAN_OUT; ++i) {
+        futures.push_back(std::async(std::launch::async, leaf_work, i));
+    }
+    long long total = 0;
+    for (auto& f : futures) {
+        total += f.get();
     }
+    report("std::async + future", total, start);
+
+    thread_pool pool(num_threads);
+    pool_scheduler sched(pool);
+
+    // Pool tasks, each with its own std::future (shared state allocation, blocking get)
+    start = std::chrono::steady_clock::now();
+    futures.clear();
+    for (int i = 0; i < FAN_OUT; ++i) {
+        futures.push_back(pool.submit(leaf_work, i));
+    }
+    total = 0;
+    for (auto& f : futures) {
+        total += f.get();
+    }
+    report("thread_pool::submit + future", total, start);
+
+    // Coroutines on the same pool, joined with when_all
+    start = std::chrono::steady_clock::now();
+    total = sync_wait(fan_out_fan_in(sched, FAN_OUT));
+    report("task<T> + when_all", total, start);
+
+    // Many more in-flight operations than threads: 10000 concurrent 50 ms sleeps
+    const int SLEEPERS = 10000;
+    timer_service timers(&sched);
+    std::vector<task<void>> sleepers;
+    for (int i = 0; i < SLEEPERS; ++i) {
+        sleepers.push_back(sleeper(timers, std::chrono::milliseconds(50)));
+    }
+    start = std::chrono::steady_clock::now();
+    sync_wait(when_all(std::move(sleepers)));
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "  " << SLEEPERS << " concurrent 50 ms coroutine sleeps finished in " << elapsed.count()
+              << " seconds\n";
+
+    // when_any: the fastest of three
+    std::vector<task<void>> racers;
+    racers.push_back(sleeper(timers, std::chrono::milliseconds(30)));
+    racers.push_back(sleeper(timers, std::chrono::milliseconds(5)));
+    racers.push_back(sleeper(timers, std::chrono::milliseconds(20)));
+    std::cout << "  when_any winner: sleeper #" << sync_wait(when_any(std::move(racers))).first << "\n";
+
+    // async_mutex: coroutines waiting for the lock are suspended, not blocking a worker
+    async_mutex mutex;
+    long long shared = 0;
+    std::vector<task<void>> increments;
+    for (int i = 0; i < 1000; ++i) {
+        increments.push_back(locked_increment(sched, mutex, shared));
+    }
+    sync_wait(when_all(std::move(increments)));
+    std::cout << "  async_mutex protected counter: " << shared << "\n";
+
+    // Stress: 100000 coroutines queued on one lock, handed down the queue when
+    // it is released. Each unlock resumes the next waiter, so this only works
+    // because those resumes run one after another instead of nesting.
+    const int WAITERS = 100000;
+    async_semaphore gate(0);
+    shared = 0;
+    std::vector<task<void>> queued;
+    queued.push_back(lock_holder(mutex, gate));
+    for (int i = 0; i < WAITERS; ++i) {
+        queued.push_back(queue_for_lock(mutex, shared));
+    }
+    queued.push_back(open_gate(gate));
+    start = std::chrono::steady_clock::now();
+    sync_wait(when_all(std::move(queued)));
+    elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "  " << WAITERS << " queued async_mutex waiters: counter " << shared << " in " << elapsed.count()
+              << " seconds" << (shared == WAITERS ? "" : "  (WRONG RESULT)") << "\n";
+}
+
+int main() {
+    // With profiling enabled, `kill -USR1 <pid>` prints the mutex report while running
+    profiled_mutex_report_on_signal(SIGUSR1);
+
+    // Demonstrate thread-safe shared resource increment
+    std::cout << "Demonstrating thread-safe increment\n";
+    parallel_for({0, 5}, 1, [](std::size_t i) { thread_safe_increment(static_cast<int>(i)); });
+    default_logger().flush();  // Let the log lines appear before the next demo's output
+    mutex_contention_example(4);
+    logger_benchmark(4);
 
     // Demonstrate a thread pool
     thread_pool_example(4);
+    thread_pool_benchmark(4);
+    placement_benchmark(4);
 
     // Demonstrate atomic operations
     atomic_operations();
+    counter_scaling_benchmark();
+
+    // Demonstrate lock-free snapshot reads of read-mostly state
+    seqlock_example();
+    seqlock_scaling_benchmark();
+
+    // Demonstrate loop parallelism on the shared pool
+    parallel_for_example();
 
-    // Demonstrate thread synchronization using condition variables
-    std::vector<int> buffer;
-    std::mutex mtx;
-    std::condition_variable cv;
-    std::thread producer_thread(producer, std::ref(buffer), std::ref(mtx), std::ref(cv));
-    std::thread consumer_thread(consumer, std::ref(buffer), std::ref(mtx), std::ref(cv));
+    // Demonstrate a dependency graph re-run many times
+    task_graph_example();
+
+    // Demonstrate many timeouts sharing one timer thread
+    timer_wheel_example(4);
+    timer_wheel_benchmark(std::chrono::milliseconds(1), "1 ms");
+    timer_wheel_benchmark(std::chrono::microseconds(1), "1 us");
+
+    // Demonstrate a producer/consumer pair connected by a lock-free FIFO queue
+    mpmc_queue<int> queue(16);
+    std::thread producer_thread(producer, std::ref(queue));
+    std::thread consumer_thread(consumer, std::ref(queue));
 
     producer_thread.join();
     consumer_thread.join();
+    mpmc_queue_benchmark(8, 8);
+
+    // Demonstrate the same pair as fibers, then fiber switch and scaling costs
+    fiber_scheduler fibers(2);
+    fiber_channel<int> channel(16);
+    fibers.spawn([&] { fiber_producer(channel); });
+    fibers.spawn([&] { fiber_consumer(channel); });
+    fibers.wait();
+    fiber_benchmark(4);
+
+    // Demonstrate a multi-stage pipeline with bounded channels between the stages
+    pipeline_example();
 
     // Demonstrate async tasks with future and promise
     async_example();
+    coroutine_async_example();
+    coroutine_benchmark(4);
 
     return 0;
 }
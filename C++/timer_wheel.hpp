@@ -0,0 +1,364 @@
+#pragma once
+
+// Hashed hierarchical timer wheel for very large numbers of timeouts.
+//
+// A sleeping thread per timeout costs a stack and a kernel task each, and a
+// binary heap costs O(log n) per insert and cannot cancel cheaply. A timer
+// wheel hashes each timer into a slot by its expiry tick instead:
+//
+//   - 6 levels of 64 slots. Level 0 slots are one tick wide, level 1 slots 64
+//     ticks, level 2 4096 ticks, ... (2^36 ticks in total: about 19 hours at
+//     1 us ticks, 2 years at 1 ms ticks). Timers beyond that wait in an
+//     overflow slot that is re-hashed once per 2^36 ticks.
+//   - a timer goes into the level of the highest base-64 digit in which its
+//     expiry differs from the current tick, so insert is O(1)
+//   - each slot is a vector of node indices and every node remembers its
+//     position in it, so cancel is an O(1) swap-with-last. Walking a slot
+//     reads nodes through independent loads that can be prefetched, which is
+//     much faster than chasing linked-list pointers through a large pool.
+//   - when the current tick reaches a higher-level slot, its timers cascade
+//     down to lower levels; each timer cascades at most once per level
+//   - a 64-bit occupancy mask per level finds the next tick with work in O(1),
+//     so the driver thread sleeps until then instead of waking every tick
+//   - all timers due in one pass are collected under the lock and dispatched
+//     afterwards, in batches of `dispatch_batch` callbacks per pool task
+//
+// Timers never fire early: a deadline is rounded up to the next tick.
+//
+// Usage:
+//   thread_pool pool;
+//   timer_wheel timers({.tick = std::chrono::milliseconds(1), .pool = &pool});
+//   timer_id id = timers.schedule_after(std::chrono::seconds(5), [] { on_timeout(); });
+//   timers.cancel(id);                            // O(1); false if it already fired
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+// Identifies one scheduled timer. A stale id (timer fired or was cancelled, and
+// its node reused) is recognized by the generation and simply not found.
+struct timer_id {
+    uint32_t index = std::numeric_limits<uint32_t>::max();
+    uint32_t generation = 0;
+};
+
+struct timer_wheel_options {
+    std::chrono::nanoseconds tick = std::chrono::milliseconds(1);  // Resolution: e.g. 1 ms or 1 us
+    thread_pool* pool = nullptr;       // Where callbacks run; nullptr = on the thread that expires them
+    std::size_t dispatch_batch = 256;  // Callbacks per pool task
+    bool start_thread = true;          // false: drive the wheel yourself with advance()
+};
+
+class timer_wheel {
+public:
+    using clock = std::chrono::steady_clock;
+    using callback = std::function<void()>;
+
+    static constexpr int levels = 6;
+    static constexpr int slot_bits = 6;
+    static constexpr int slots_per_level = 1 << slot_bits;
+
+    explicit timer_wheel(timer_wheel_options options = {})
+        : options_(options), start_(clock::now()) {
+        if (options_.tick <= std::chrono::nanoseconds::zero()) options_.tick = std::chrono::nanoseconds(1);
+        options_.dispatch_batch = std::max<std::size_t>(options_.dispatch_batch, 1);
+        if (options_.start_thread) driver_ = std::thread([this] { run(); });
+    }
+
+    // Timers that have not fired yet are dropped without running
+    ~timer_wheel() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        if (driver_.joinable()) driver_.join();
+    }
+
+    timer_wheel(const timer_wheel&) = delete;
+    timer_wheel& operator=(const timer_wheel&) = delete;
+
+    timer_id schedule_at(clock::time_point deadline, callback fn) {
+        uint64_t expiry = ticks_until(deadline);
+        timer_id id;
+        bool earlier_than_planned;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            expiry = std::max(expiry, now_ + 1);  // The current tick has already been processed
+            uint32_t index = allocate_node();
+            node& n = nodes_[index];
+            n.expiry = expiry;
+            n.fn = std::move(fn);
+            place(index);
+            ++pending_;
+            id = {index, n.generation};
+            earlier_than_planned = expiry < planned_wake_;
+        }
+        if (earlier_than_planned) wake_.notify_one();  // The driver sleeps too long otherwise
+        return id;
+    }
+
+    template <typename Rep, typename Period>
+    timer_id schedule_after(std::chrono::duration<Rep, Period> delay, callback fn) {
+        return schedule_at(clock::now() + std::chrono::duration_cast<clock::duration>(delay), std::move(fn));
+    }
+
+    // O(1). Returns false if the timer already fired (or is firing) or was cancelled.
+    bool cancel(timer_id id) {
+        callback dropped;  // Destroyed outside the lock: captures may be expensive to destroy
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (id.index >= nodes_.size()) return false;
+        node& n = nodes_[id.index];
+        if (n.generation != id.generation || n.slot == free_slot) return false;
+        unlink(id.index);
+        dropped = std::move(n.fn);
+        free_node(id.index);
+        --pending_;
+        return true;
+    }
+
+    // Expire every timer due at `now` and dispatch the callbacks. Used by the
+    // driver thread, or called directly when start_thread is false. Returns
+    // how many timers expired.
+    std::size_t advance(clock::time_point now = clock::now()) {
+        std::vector<callback> expired;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            collect_expired(ticks_at(now), expired);
+        }
+        dispatch(expired);
+        return expired.size();
+    }
+
+    std::size_t pending() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pending_;
+    }
+
+    // Heap memory held by the wheel: timer nodes (live and free) and slot
+    // vectors, not counting whatever the callbacks themselves allocated
+    std::size_t memory_bytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::size_t bytes = nodes_.capacity() * sizeof(node);
+        for (const auto& slot : slots_) bytes += slot.capacity() * sizeof(uint32_t);
+        return bytes;
+    }
+
+    std::chrono::nanoseconds tick() const noexcept { return options_.tick; }
+
+private:
+    static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+    static constexpr uint16_t free_slot = std::numeric_limits<uint16_t>::max();
+    static constexpr uint64_t slot_mask = slots_per_level - 1;
+
+    static constexpr std::size_t prefetch_distance = 8;
+
+    struct node {
+        uint64_t expiry = 0;  // Absolute tick
+        uint32_t position = npos;  // Index in its slot vector; next free node while free
+        uint32_t generation = 0;
+        uint16_t slot = free_slot;  // level * slots_per_level + slot index
+        callback fn;
+    };
+
+    // Deadlines round up (never fire early), "now" rounds down
+    uint64_t ticks_until(clock::time_point deadline) const {
+        if (deadline <= start_) return 0;
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - start_);
+        return static_cast<uint64_t>((elapsed + options_.tick - std::chrono::nanoseconds(1)) / options_.tick);
+    }
+    uint64_t ticks_at(clock::time_point now) const {
+        if (now <= start_) return 0;
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_) / options_.tick);
+    }
+    clock::time_point time_of(uint64_t tick) const {
+        return start_ + std::chrono::duration_cast<clock::duration>(options_.tick * tick);
+    }
+
+    static uint64_t digit(uint64_t tick, int level) { return (tick >> (slot_bits * level)) & slot_mask; }
+
+    uint32_t allocate_node() {
+        if (free_list_ != npos) {
+            uint32_t index = free_list_;
+            free_list_ = nodes_[index].position;
+            return index;
+        }
+        nodes_.emplace_back();
+        return static_cast<uint32_t>(nodes_.size() - 1);
+    }
+
+    void free_node(uint32_t index) {
+        node& n = nodes_[index];
+        n.slot = free_slot;
+        n.generation++;
+        n.position = free_list_;
+        free_list_ = index;
+    }
+
+    // Hash a node into its slot; its expiry must be >= now_. Expiries whose
+    // digits above the top level differ from now_ go to the overflow slot
+    // (levels * slots_per_level, tracked as bit 0 of occupied_[levels]).
+    void place(uint32_t index) {
+        node& n = nodes_[index];
+        uint64_t differing = n.expiry ^ now_;
+        int level = differing == 0 ? 0 : (63 - std::countl_zero(differing)) / slot_bits;
+        uint64_t slot = 0;
+        if (level < levels) {
+            slot = digit(n.expiry, level);
+        } else {
+            level = levels;
+        }
+        n.slot = static_cast<uint16_t>(level * slots_per_level + slot);
+        std::vector<uint32_t>& entries = slots_[n.slot];
+        n.position = static_cast<uint32_t>(entries.size());
+        entries.push_back(index);
+        occupied_[level] |= uint64_t(1) << slot;
+    }
+
+    void unlink(uint32_t index) {
+        node& n = nodes_[index];
+        std::vector<uint32_t>& entries = slots_[n.slot];
+        uint32_t moved = entries.back();
+        entries[n.position] = moved;
+        nodes_[moved].position = n.position;
+        entries.pop_back();
+        if (entries.empty()) occupied_[n.slot / slots_per_level] &= ~(uint64_t(1) << (n.slot % slots_per_level));
+    }
+
+    // Empty a slot and run fn(index) for each of its nodes. fn may place nodes
+    // back into the same slot (overflow timers that still do not fit).
+    template <typename Fn>
+    void drain_slot(int level, uint64_t slot, Fn fn) {
+        std::vector<uint32_t>& entries = slots_[level * slots_per_level + slot];
+        occupied_[level] &= ~(uint64_t(1) << slot);
+        drained_.swap(entries);
+        for (std::size_t i = 0; i < drained_.size(); ++i) {
+            if (i + prefetch_distance < drained_.size()) {
+                __builtin_prefetch(&nodes_[drained_[i + prefetch_distance]]);
+            }
+            fn(drained_[i]);
+        }
+        drained_.clear();
+        if (entries.empty()) drained_.swap(entries);  // Give the slot its capacity back
+    }
+
+    // The next tick after now_ at which something happens: a level-0 slot
+    // expires, a higher-level slot cascades, or the overflow list is re-hashed.
+    // The maximum uint64_t if the wheel is empty.
+    uint64_t next_event_tick() const {
+        uint64_t best = std::numeric_limits<uint64_t>::max();
+        if (occupied_[levels]) best = ((now_ >> (slot_bits * levels)) + 1) << (slot_bits * levels);
+        for (int level = 0; level < levels; ++level) {
+            uint64_t mask = occupied_[level];
+            if (mask == 0) continue;
+            uint64_t current = digit(now_, level);
+            // Occupied slots after the current one in this rotation, else wrap around
+            uint64_t after = current == slot_mask ? 0 : mask & (~uint64_t(0) << (current + 1));
+            uint64_t rotations = 0;
+            uint64_t slot;
+            if (after) {
+                slot = static_cast<uint64_t>(std::countr_zero(after));
+            } else {
+                slot = static_cast<uint64_t>(std::countr_zero(mask));
+                rotations = 1;
+            }
+            int shift = slot_bits * level;
+            uint64_t base = (now_ >> (shift + slot_bits)) << (shift + slot_bits);  // Digits above this level
+            uint64_t tick = base + ((rotations * slots_per_level + slot) << shift);
+            best = std::min(best, tick);
+        }
+        return best;
+    }
+
+    // Move now_ forward to `target`, jumping straight between ticks that have
+    // work, cascading higher levels and collecting due callbacks
+    void collect_expired(uint64_t target, std::vector<callback>& expired) {
+        while (now_ < target) {
+            uint64_t next = next_event_tick();
+            if (next > target) {
+                now_ = target;
+                break;
+            }
+            now_ = next;
+            // Cascade every level whose lower digits just wrapped to zero, highest
+            // first, so timers can fall through several levels in one tick
+            int top = 0;
+            while (top < levels && digit(now_, top) == 0) ++top;
+            for (int level = top; level >= 1; --level) {
+                drain_slot(level, level == levels ? 0 : digit(now_, level), [this](uint32_t index) { place(index); });
+            }
+            drain_slot(0, digit(now_, 0), [&](uint32_t index) {
+                expired.push_back(std::move(nodes_[index].fn));
+                free_node(index);
+                --pending_;
+            });
+        }
+    }
+
+    void dispatch(std::vector<callback>& expired) {
+        if (expired.empty()) return;
+        if (!options_.pool) {
+            for (callback& fn : expired) fn();
+            return;
+        }
+        std::size_t batch = options_.dispatch_batch;
+        for (std::size_t first = 0; first < expired.size(); first += batch) {
+            std::size_t last = std::min(expired.size(), first + batch);
+            std::vector<callback> group(std::make_move_iterator(expired.begin() + first),
+                                        std::make_move_iterator(expired.begin() + last));
+            options_.pool->post([group = std::move(group)]() mutable {
+                for (callback& fn : group) fn();
+            });
+        }
+    }
+
+    void run() {
+        std::vector<callback> expired;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            collect_expired(ticks_at(clock::now()), expired);
+            if (!expired.empty()) {
+                lock.unlock();
+                dispatch(expired);
+                expired.clear();
+                lock.lock();
+                continue;
+            }
+            planned_wake_ = next_event_tick();
+            if (planned_wake_ == std::numeric_limits<uint64_t>::max()) {
+                wake_.wait(lock);
+            } else {
+                wake_.wait_until(lock, time_of(planned_wake_));
+            }
+            planned_wake_ = 0;  // Awake: inserts need not notify
+        }
+    }
+
+    timer_wheel_options options_;
+    const clock::time_point start_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::vector<node> nodes_;
+    uint32_t free_list_ = npos;
+    std::vector<uint32_t> slots_[levels * slots_per_level + 1];  // The last one is the overflow slot
+    std::vector<uint32_t> drained_;  // Scratch for drain_slot
+    uint64_t occupied_[levels + 1] = {};
+    uint64_t now_ = 0;  // Last processed tick
+    std::size_t pending_ = 0;
+    uint64_t planned_wake_ = 0;  // Tick the driver sleeps until (0 = not sleeping)
+    bool stopping_ = false;
+    std::thread driver_;
+};
@@ -0,0 +1,554 @@
+#pragma once
+
+// Allocation-free tokenizing of text that is already in memory.
+//
+// `stream >> word` runs the stream sentry and the locale's ctype facet for
+// every byte and builds a new std::string for every token (and a stringstream
+// starts by copying the whole text). tokenizer classifies 64 bytes at a time
+// instead: one vector compare (or two table shuffles) per 32 or 64 bytes turns
+// a window of text into a bitmap of delimiter positions, and each token is
+// then found with two count-trailing-zeros. Tokens are std::string_views into
+// the text, so nothing is copied or allocated.
+//
+//   delimiter_set  - any set of bytes; whitespace() matches operator>> in the
+//                    "C" locale (' ', '\t', '\n', '\v', '\f', '\r')
+//   tokenizer      - the tokens of a text, either operator>>-style (runs of
+//                    delimiters collapse) or split-style (every delimiter ends
+//                    a field, so "a,,b" has an empty field); next(), range-for,
+//                    or for_each(fn), the fastest of the three
+//   count_tokens   - number of tokens from the bitmaps alone (popcount of the
+//                    token starts; no per-token work at all)
+//   csv_reader     - RFC 4180 fields: quoted fields may hold separators,
+//                    newlines and doubled quotes. Quotes are tracked with a
+//                    prefix XOR over the quote bitmap, so quoted text costs no
+//                    more than plain text.
+//
+// Classification, per instruction set (picked with simd_kernels().isa, so the
+// SIMD_KERNELS_ISA environment variable applies here too):
+//   scalar   - a 256-bit membership table, one lookup per byte
+//   sse2     - one compare per delimiter byte, 16 bytes at a time
+//   avx2     - low/high nibble lookup with vpshufb, 32 bytes at a time: any
+//              set whose bytes share at most 8 distinct high nibbles costs two
+//              shuffles whatever its size (larger sets fall back to compares)
+//   avx512   - the same lookup with avx512bw, 64 bytes and one mask at a time
+//
+// Usage:
+//   for (std::string_view word : tokenizer(text)) ++counts[word];
+//   tokenizer(text).for_each([&](std::string_view word) { ++counts[word]; });
+//
+//   tokenizer fields(line, delimiter_set(",;"), {.skip_empty = false});
+//
+//   csv_reader csv(text);
+//   std::string scratch;
+//   for (csv_field field; csv.next(field);) {
+//       std::string_view value = csv.value(field, scratch);  // "" collapsed only when present
+//       if (field.end_of_record) ...
+//   }
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "simd_kernels.hpp"  // isa_level, simd_kernels(), simd_avx512::has_byte_compare
+
+// --- SECTION 1: Delimiter Sets ---
+
+class delimiter_set {
+public:
+    explicit delimiter_set(std::string_view bytes) {
+        for (char c : bytes) add(static_cast<uint8_t>(c));
+    }
+
+    static const delimiter_set& whitespace() {
+        static const delimiter_set set(" \t\n\v\f\r");
+        return set;
+    }
+
+    bool contains(uint8_t c) const noexcept { return (table_[c / 64] >> (c % 64)) & 1; }
+
+    // The bytes in the set, in the order they were added (no duplicates)
+    std::string_view bytes() const noexcept { return {bytes_, count_}; }
+
+    // True if the nibble tables describe the set exactly (at most 8 high nibbles)
+    bool has_nibble_tables() const noexcept { return high_nibble_bits_ <= 8; }
+
+    // Byte c is in the set iff low_nibbles()[c & 15] & high_nibbles()[c >> 4] != 0
+    const uint8_t* low_nibbles() const noexcept { return low_nibbles_; }
+    const uint8_t* high_nibbles() const noexcept { return high_nibbles_; }
+
+private:
+    void add(uint8_t c) {
+        if (contains(c)) return;
+        table_[c / 64] |= uint64_t(1) << (c % 64);
+        bytes_[count_++] = static_cast<char>(c);
+
+        // Every distinct high nibble gets one of the 8 bits; the low nibble
+        // table records which high nibbles each low nibble appears with
+        uint8_t high = c >> 4;
+        if (high_nibbles_[high] == 0) {
+            if (high_nibble_bits_ < 8) high_nibbles_[high] = static_cast<uint8_t>(1u << high_nibble_bits_);
+            ++high_nibble_bits_;
+        }
+        low_nibbles_[c & 15] |= high_nibbles_[high];
+    }
+
+    uint64_t table_[4] = {};
+    char bytes_[256] = {};
+    std::size_t count_ = 0;
+    alignas(16) uint8_t low_nibbles_[16] = {};
+    alignas(16) uint8_t high_nibbles_[16] = {};
+    unsigned high_nibble_bits_ = 0;
+};
+
+// --- SECTION 2: Classification Kernels ---
+
+namespace tokenizer_detail {
+
+// Every kernel sets bit i % 64 of bits[i / 64] iff set.contains(data[i]) and
+// fills (n + 63) / 64 words; bits past n are zero.
+
+inline void class_mask_scalar(const uint8_t* data, std::size_t n, const delimiter_set& set, uint64_t* bits) {
+    for (std::size_t w = 0; w < (n + 63) / 64; ++w) {
+        uint64_t word = 0;
+        for (std::size_t i = w * 64, end = std::min(n, i + 64); i < end; ++i) {
+            word |= static_cast<uint64_t>(set.contains(data[i])) << (i % 64);
+        }
+        bits[w] = word;
+    }
+}
+
+#ifdef SIMD_KERNELS_X86
+
+inline void class_mask_sse2(const uint8_t* data, std::size_t n, const delimiter_set& set, uint64_t* bits) {
+    std::string_view members = set.bytes();
+    std::size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        uint64_t word = 0;
+        for (std::size_t part = 0; part < 64; part += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + part));
+            __m128i hit = _mm_setzero_si128();
+            for (char c : members) hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+            word |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(hit))) << part;
+        }
+        bits[i / 64] = word;
+    }
+    if (i < n) class_mask_scalar(data + i, n - i, set, bits + i / 64);
+}
+
+// Member bits of 32 bytes: the shuffles look up both nibbles of every byte
+SIMD_TARGET_AVX2 inline uint32_t class_mask_32(__m256i v, __m256i low_table, __m256i high_table) {
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    __m256i low = _mm256_shuffle_epi8(low_table, _mm256_and_si256(v, nibble));
+    __m256i high = _mm256_shuffle_epi8(high_table, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+    __m256i miss = _mm256_cmpeq_epi8(_mm256_and_si256(low, high), _mm256_setzero_si256());
+    return ~static_cast<uint32_t>(_mm256_movemask_epi8(miss));
+}
+
+SIMD_TARGET_AVX2 inline void class_mask_avx2(const uint8_t* data, std::size_t n, const delimiter_set& set,
+                                             uint64_t* bits) {
+    if (!set.has_nibble_tables()) return class_mask_sse2(data, n, set, bits);
+    const __m256i low_table =
+        _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(set.low_nibbles())));
+    const __m256i high_table =
+        _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(set.high_nibbles())));
+    std::size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 32));
+        bits[i / 64] = class_mask_32(v0, low_table, high_table) |
+                       static_cast<uint64_t>(class_mask_32(v1, low_table, high_table)) << 32;
+    }
+    if (i < n) class_mask_scalar(data + i, n - i, set, bits + i / 64);
+}
+
+SIMD_TARGET_AVX512_BW inline void class_mask_avx512(const uint8_t* data, std::size_t n, const delimiter_set& set,
+                                                    uint64_t* bits) {
+    if (!set.has_nibble_tables()) return class_mask_sse2(data, n, set, bits);
+    // The zero-masked broadcast: GCC 12's unmasked one starts from _mm512_undefined_epi32(),
+    // which -Wall reports as uninitialized once inlined
+    const __m512i low_table =
+        _mm512_maskz_broadcast_i32x4(0xFFFF, _mm_load_si128(reinterpret_cast<const __m128i*>(set.low_nibbles())));
+    const __m512i high_table =
+        _mm512_maskz_broadcast_i32x4(0xFFFF, _mm_load_si128(reinterpret_cast<const __m128i*>(set.high_nibbles())));
+    const __m512i nibble = _mm512_set1_epi8(0x0F);
+    for (std::size_t i = 0; i < n; i += 64) {
+        __mmask64 valid = n - i >= 64 ? ~__mmask64(0) : (__mmask64(1) << (n - i)) - 1;
+        __m512i v = _mm512_maskz_loadu_epi8(valid, data + i);
+        __m512i low = _mm512_shuffle_epi8(low_table, _mm512_and_si512(v, nibble));
+        __m512i high = _mm512_shuffle_epi8(high_table, _mm512_and_si512(_mm512_srli_epi16(v, 4), nibble));
+        bits[i / 64] = _mm512_mask_test_epi8_mask(valid, low, high);
+    }
+}
+
+#endif  // SIMD_KERNELS_X86
+
+using class_mask_fn = void (*)(const uint8_t*, std::size_t, const delimiter_set&, uint64_t*);
+
+inline class_mask_fn class_mask_for(isa_level isa) {
+#ifdef SIMD_KERNELS_X86
+    switch (isa) {
+        case isa_level::avx512:
+            if (simd_avx512::has_byte_compare()) return class_mask_avx512;
+            return class_mask_avx2;
+        case isa_level::avx2:   return class_mask_avx2;
+        case isa_level::sse2:   return class_mask_sse2;
+        case isa_level::scalar: break;
+    }
+#endif
+    (void)isa;
+    return class_mask_scalar;
+}
+
+inline class_mask_fn class_mask() {
+    static const class_mask_fn kernel = class_mask_for(simd_kernels().isa);
+    return kernel;
+}
+
+// Bit i of the result is the XOR of bits 0..i of x: 1 from an opening quote up
+// to (not including) its closing quote
+inline uint64_t prefix_xor(uint64_t x) noexcept {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+// Positions of the set bits of one window's bitmap, popped in order: each pop
+// is a count-trailing-zeros and a clear-lowest-bit, with no scan in between
+class bit_queue {
+public:
+    static constexpr std::size_t window = 4096;  // Bytes per bitmap
+    static constexpr std::size_t none = static_cast<std::size_t>(-1);
+
+    uint64_t* words() noexcept { return words_; }
+
+    // Start popping words()[0, (size + 63) / 64), which describe bytes [begin, begin + size)
+    void reset(std::size_t begin, std::size_t size) noexcept {
+        begin_ = begin;
+        count_ = (size + 63) / 64;
+        next_ = 0;
+        current_ = 0;
+    }
+
+    // Position of the next set bit, or none when the window has no more
+    std::size_t pop() noexcept {
+        while (current_ == 0) {
+            if (next_ == count_) return none;
+            current_ = words_[next_++];
+        }
+        std::size_t at = begin_ + (next_ - 1) * 64 + static_cast<std::size_t>(__builtin_ctzll(current_));
+        current_ &= current_ - 1;
+        return at;
+    }
+
+    // fn(position) for every remaining bit, with the queue state in registers
+    template <typename Fn>
+    void drain(Fn&& fn) {
+        uint64_t current = current_;
+        for (std::size_t next = next_;; current = words_[next++]) {
+            for (; current != 0; current &= current - 1) {
+                fn(begin_ + (next - 1) * 64 + static_cast<std::size_t>(__builtin_ctzll(current)));
+            }
+            if (next == count_) break;
+        }
+        current_ = 0;
+        next_ = count_;
+    }
+
+private:
+    std::size_t begin_ = 0;
+    std::size_t count_ = 0;
+    std::size_t next_ = 0;
+    uint64_t current_ = 0;
+    uint64_t words_[window / 64];
+};
+
+}  // namespace tokenizer_detail
+
+// --- SECTION 3: Tokenizer ---
+
+struct tokenizer_options {
+    // true: like operator>>, runs of delimiters separate tokens and no token
+    // is empty. false: like a split, every delimiter ends a field, so the
+    // fields of "a,,b," are "a", "", "b" and "" (and "" has one empty field).
+    bool skip_empty = true;
+};
+
+class tokenizer {
+public:
+    static constexpr std::size_t window = tokenizer_detail::bit_queue::window;  // Bytes classified per kernel call
+
+    // Tokens are views into `text`, which must outlive them
+    explicit tokenizer(std::string_view text, const delimiter_set& delimiters = delimiter_set::whitespace(),
+                       tokenizer_options options = {})
+        : text_(text), delimiters_(delimiters), options_(options), class_mask_(tokenizer_detail::class_mask()) {}
+
+    // The next token; false when there are no more
+    bool next(std::string_view& token) {
+        if (options_.skip_empty) {
+            // Boundaries alternate between token starts and token ends
+            std::size_t start = next_boundary();
+            if (start == text_.size()) return false;
+            std::size_t end = next_boundary();
+            token = text_.substr(start, end - start);
+            return true;
+        }
+        if (done_) return false;
+        std::size_t end = next_boundary();  // Every delimiter ends a field
+        token = text_.substr(pos_, end - pos_);
+        done_ = end == text_.size();
+        pos_ = end + 1;
+        return true;
+    }
+
+    // fn(std::string_view) for every remaining token. Faster than next() or
+    // range-for: the boundary loop keeps its state in registers and fn is
+    // inlined into it.
+    template <typename Fn>
+    void for_each(Fn&& fn) {
+        const char* data = text_.data();
+        if (options_.skip_empty) {
+            std::size_t start = tokenizer_detail::bit_queue::none;  // Start of the open token
+            for (;;) {
+                boundaries_.drain([&](std::size_t at) {
+                    if (start == tokenizer_detail::bit_queue::none) {
+                        start = at;
+                    } else {
+                        fn(std::string_view(data + start, at - start));
+                        start = tokenizer_detail::bit_queue::none;
+                    }
+                });
+                if (end_ == text_.size()) break;
+                build();
+            }
+            if (start != tokenizer_detail::bit_queue::none) fn(text_.substr(start));
+            return;
+        }
+        if (done_) return;
+        std::size_t pos = pos_;
+        for (;;) {
+            boundaries_.drain([&](std::size_t at) {
+                fn(std::string_view(data + pos, at - pos));
+                pos = at + 1;
+            });
+            if (end_ == text_.size()) break;
+            build();
+        }
+        fn(text_.substr(pos));  // The last field, empty after a trailing delimiter
+        pos_ = text_.size();
+        done_ = true;
+    }
+
+    // Input iterator over the remaining tokens, for range-for
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view*;
+        using reference = const std::string_view&;
+
+        iterator() = default;
+        explicit iterator(tokenizer* owner) : owner_(owner) { ++*this; }
+
+        reference operator*() const noexcept { return token_; }
+        pointer operator->() const noexcept { return &token_; }
+
+        iterator& operator++() {
+            if (owner_ && !owner_->next(token_)) owner_ = nullptr;
+            return *this;
+        }
+
+        bool operator==(const iterator& other) const noexcept { return owner_ == other.owner_; }
+        bool operator!=(const iterator& other) const noexcept { return owner_ != other.owner_; }
+
+    private:
+        tokenizer* owner_ = nullptr;
+        std::string_view token_;
+    };
+
+    iterator begin() { return iterator(this); }
+    iterator end() { return iterator(); }
+
+private:
+    // Position of the next boundary, or the text size after the last one
+    std::size_t next_boundary() {
+        std::size_t at = boundaries_.pop();
+        while (at == tokenizer_detail::bit_queue::none) {  // Once per window: keep the per-token path inlinable
+            if (end_ == text_.size()) return text_.size();
+            build();
+            at = boundaries_.pop();
+        }
+        return at;
+    }
+
+    // Classifies the next window. Split-style, the boundaries are the
+    // delimiters themselves; operator>>-style, they are the positions whose
+    // class differs from the byte before (the start of the text counts as a
+    // delimiter), so each word holds its starts and ends with no per-token scan.
+    [[gnu::noinline]] void build() {
+        std::size_t begin = end_;
+        end_ = std::min(text_.size(), begin + window);
+        std::size_t n = end_ - begin;
+        uint64_t* bits = boundaries_.words();
+        class_mask_(reinterpret_cast<const uint8_t*>(text_.data() + begin), n, delimiters_, bits);
+        if (options_.skip_empty) {
+            for (std::size_t w = 0; w < (n + 63) / 64; ++w) {
+                uint64_t delimiters = bits[w];
+                bits[w] = delimiters ^ (delimiters << 1 | previous_);
+                previous_ = delimiters >> 63;
+            }
+            // Padding past the end reads as "not a delimiter": drop a start there
+            if (n % 64 != 0) bits[n / 64] &= (uint64_t(1) << (n % 64)) - 1;
+        }
+        boundaries_.reset(begin, n);
+    }
+
+    std::string_view text_;
+    delimiter_set delimiters_;
+    tokenizer_options options_;
+    tokenizer_detail::class_mask_fn class_mask_;
+    std::size_t pos_ = 0;        // Split-style: start of the next field
+    bool done_ = false;
+    std::size_t end_ = 0;        // End of the classified text
+    uint64_t previous_ = 1;      // Bit 63 of the last word classified
+    tokenizer_detail::bit_queue boundaries_;
+};
+
+// Number of tokens (operator>>-style) without producing them: a token starts
+// wherever a non-delimiter follows a delimiter or the start of the text
+inline uint64_t count_tokens(std::string_view text, const delimiter_set& delimiters = delimiter_set::whitespace()) {
+    auto class_mask = tokenizer_detail::class_mask();
+    uint64_t bits[tokenizer::window / 64];
+    uint64_t tokens = 0;
+    uint64_t previous = 1;  // Bit 63 of the previous word; the start of the text counts as a delimiter
+    for (std::size_t at = 0; at < text.size(); at += tokenizer::window) {
+        std::size_t n = std::min(tokenizer::window, text.size() - at);
+        class_mask(reinterpret_cast<const uint8_t*>(text.data() + at), n, delimiters, bits);
+        for (std::size_t w = 0; w < (n + 63) / 64; ++w) {
+            uint64_t valid = n - w * 64 >= 64 ? ~uint64_t(0) : (uint64_t(1) << (n - w * 64)) - 1;
+            uint64_t starts = ~bits[w] & (bits[w] << 1 | previous) & valid;
+            tokens += static_cast<uint64_t>(__builtin_popcountll(starts));
+            previous = bits[w] >> 63;
+        }
+    }
+    return tokens;
+}
+
+// --- SECTION 4: CSV Reader ---
+
+struct csv_options {
+    char separator = ',';
+    char quote = '"';
+};
+
+struct csv_field {
+    std::string_view text;       // Without the surrounding quotes; doubled quotes are still doubled
+    bool quoted = false;         // The field was one quoted string
+    bool escaped = false;        // Quoted and holds doubled quotes (see csv_reader::value)
+    bool end_of_record = false;  // Last field of its record
+};
+
+// Fields of RFC 4180 text: records end at '\n' (a '\r' before it is dropped),
+// fields at the separator, and both are ignored inside quotes. A field that is
+// not exactly one quoted string (a"b, "a"b) is returned as it is.
+class csv_reader {
+public:
+    static constexpr std::size_t window = tokenizer_detail::bit_queue::window;
+
+    explicit csv_reader(std::string_view text, csv_options options = {})
+        : text_(text), options_(options), byte_mask_(simd_kernels().byte_mask) {}
+
+    // The next field; false at the end of the text. Throws std::runtime_error
+    // if the text ends inside a quoted field.
+    bool next(csv_field& field) {
+        if (done_ || (pos_ == text_.size() && !field_pending_)) {
+            done_ = true;
+            return false;
+        }
+        std::size_t end = next_structural();
+        if (end == text_.size() && in_quotes_) throw std::runtime_error("csv_reader: unterminated quoted field");
+
+        std::string_view raw = text_.substr(pos_, end - pos_);
+        bool newline = end < text_.size() && text_[end] == '\n';
+        if (newline && !raw.empty() && raw.back() == '\r') raw.remove_suffix(1);
+        field.quoted = raw.size() >= 2 && raw.front() == options_.quote && raw.back() == options_.quote;
+        if (field.quoted) raw = raw.substr(1, raw.size() - 2);
+        field.escaped = field.quoted && raw.find(options_.quote) != std::string_view::npos;
+        field.text = raw;
+        field.end_of_record = end == text_.size() || newline;
+
+        records_ += field.end_of_record;
+        field_pending_ = end < text_.size() && !newline;  // A separator: another field follows, maybe empty
+        done_ = end == text_.size();
+        pos_ = done_ ? end : end + 1;
+        return true;
+    }
+
+    // The field's value: its text, or the text with doubled quotes collapsed
+    // into `scratch` (reuse it across fields to avoid allocating)
+    std::string_view value(const csv_field& field, std::string& scratch) const {
+        if (!field.escaped) return field.text;
+        scratch.clear();
+        for (std::size_t i = 0; i < field.text.size(); ++i) {
+            scratch += field.text[i];
+            if (field.text[i] == options_.quote && i + 1 < field.text.size() && field.text[i + 1] == options_.quote) ++i;
+        }
+        return scratch;
+    }
+
+    // Records completed so far
+    uint64_t records() const noexcept { return records_; }
+
+private:
+    // Next separator or newline outside quotes, or the text size after the last one
+    std::size_t next_structural() {
+        std::size_t at = structural_.pop();
+        while (at == tokenizer_detail::bit_queue::none) {  // Once per window: keep the per-token path inlinable
+            if (end_ == text_.size()) return text_.size();
+            build();
+            at = structural_.pop();
+        }
+        return at;
+    }
+
+    // Classifies the window after the current one. Windows are built strictly
+    // in order, because whether a byte is quoted depends on every quote before it.
+    [[gnu::noinline]] void build() {
+        std::size_t begin = end_;
+        end_ = std::min(text_.size(), begin + window);
+        std::size_t n = end_ - begin;
+        const auto* data = reinterpret_cast<const uint8_t*>(text_.data() + begin);
+        uint64_t* bits = structural_.words();
+        uint64_t quotes[window / 64], separators[window / 64];
+        byte_mask_(data, n, static_cast<uint8_t>(options_.quote), quotes);
+        byte_mask_(data, n, static_cast<uint8_t>(options_.separator), separators);
+        byte_mask_(data, n, '\n', bits);
+        uint64_t carry = in_quotes_ ? ~uint64_t(0) : 0;
+        for (std::size_t w = 0; w < (n + 63) / 64; ++w) {
+            uint64_t inside = tokenizer_detail::prefix_xor(quotes[w]) ^ carry;
+            bits[w] = (bits[w] | separators[w]) & ~inside;
+            carry = inside >> 63 ? ~uint64_t(0) : 0;  // Padding bits past n are zero, so bit 63 is the state at n
+        }
+        in_quotes_ = carry != 0;
+        structural_.reset(begin, n);
+    }
+
+    std::string_view text_;
+    csv_options options_;
+    void (*byte_mask_)(const uint8_t*, std::size_t, uint8_t, uint64_t*);
+    std::size_t pos_ = 0;
+    bool field_pending_ = false;
+    bool done_ = false;
+    bool in_quotes_ = false;  // At end_
+    uint64_t records_ = 0;
+    std::size_t end_ = 0;  // End of the classified text
+    tokenizer_detail::bit_queue structural_;  // Separators and newlines outside quotes
+};